@@ -210,6 +210,21 @@ index_opts_decode(struct index_opts *opts, const char *map,
 			  "bloom_fpr must be greater than 0 and "
 			  "less than or equal to 1");
 	}
+	if (opts->compaction_strategy == compaction_strategy_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS, "compaction_strategy must be "
+			  "either 'tiered', 'leveled' or 'time_window'");
+	}
+	if (opts->compaction_window <= 0) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS,
+			  "compaction_window must be greater than 0");
+	}
+	if (opts->blob_threshold < 0) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS,
+			  "blob_threshold must be greater than or equal to 0");
+	}
 }
 
 /**
@@ -523,6 +538,10 @@ space_def_new_from_tuple(struct tuple *tuple, uint32_t errcode,
 	}
 	if (opts.is_view && opts.sql == NULL)
 		tnt_raise(ClientError, ER_VIEW_MISSING_SQL);
+	if (opts.memory_quota < 0) {
+		tnt_raise(ClientError, errcode, tt_cstr(name, name_len),
+			  "memory_quota must be non-negative");
+	}
 	struct space_def *def =
 		space_def_new_xc(id, uid, exact_field_count, name, name_len,
 				 engine_name, engine_name_len, &opts, fields,
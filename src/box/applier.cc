@@ -30,13 +30,16 @@
  */
 #include "applier.h"
 
+#include <fcntl.h>
 #include <msgpuck.h>
+#include <zstd.h>
 
 #include "xlog.h"
 #include "fiber.h"
 #include "fiber_cond.h"
 #include "coio.h"
 #include "coio_buf.h"
+#include "coio_task.h"
 #include "xstream.h"
 #include "wal.h"
 #include "xrow.h"
@@ -48,6 +51,8 @@
 #include "error.h"
 #include "session.h"
 #include "cfg.h"
+#include "box.h"
+#include "coio_file.h"
 
 STRS(applier_state, applier_STATE);
 
@@ -269,6 +274,229 @@ done:
 	applier_set_state(applier, APPLIER_READY);
 }
 
+enum {
+	/** Size of data received at once for a checkpoint file. */
+	APPLIER_JOIN_FILE_CHUNK_SIZE = 256 * 1024,
+};
+
+/** A checkpoint file received on JOIN. */
+struct applier_join_file {
+	/** Link in the list of received files. */
+	struct rlist in_files;
+	/** Set if the file starts with an xlog meta. */
+	bool is_xlog;
+	/** Path the file is received to. */
+	char *tmp_path;
+	/** Path to the file in the engine directory. */
+	char path[0];
+};
+
+/** Check if a file path ends with the given extension. */
+static bool
+applier_path_has_ext(const char *path, const char *ext)
+{
+	size_t len = strlen(path);
+	size_t ext_len = strlen(ext);
+	return len > ext_len && strcmp(path + len - ext_len, ext) == 0;
+}
+
+/**
+ * Check if a checkpoint file has an xlog meta, which stores
+ * the instance UUID. Vinyl blobs are the only checkpoint files
+ * that don't.
+ */
+static bool
+applier_join_file_is_xlog(const char *path)
+{
+	static const char *xlog_exts[] = {
+		".snap", ".vylog", ".run", ".index",
+	};
+	for (size_t i = 0; i < lengthof(xlog_exts); i++) {
+		if (applier_path_has_ext(path, xlog_exts[i]))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Create a checkpoint file received on JOIN. @a name is
+ * <engine>/<path relative to the engine directory>, see
+ * relay_initial_join_files().
+ */
+static struct applier_join_file *
+applier_join_file_new(const char *name, uint32_t name_len)
+{
+	const char *sep = (const char *)memchr(name, '/', name_len);
+	const char *dir = NULL;
+	if (sep != NULL)
+		dir = box_engine_dir(tt_cstr(name, sep - name));
+	const char *rel_path = sep != NULL ? sep + 1 : name + name_len;
+	uint32_t rel_path_len = name + name_len - rel_path;
+	/* Don't let the master write outside the engine directory. */
+	if (dir == NULL || rel_path_len == 0 || *rel_path == '/' ||
+	    memmem(rel_path, rel_path_len, "..", 2) != NULL ||
+	    memchr(rel_path, '\0', rel_path_len) != NULL) {
+		tnt_raise(IllegalParams, "invalid join file name '%.*s'",
+			  (int)name_len, name);
+	}
+	char path[PATH_MAX];
+	int path_len = snprintf(path, sizeof(path), "%s/%.*s", dir,
+				(int)rel_path_len, rel_path);
+	if (path_len >= (int)sizeof(path)) {
+		tnt_raise(IllegalParams, "invalid join file name '%.*s'",
+			  (int)name_len, name);
+	}
+	size_t size = sizeof(struct applier_join_file) + 2 * (path_len + 1) +
+		      strlen(inprogress_suffix);
+	struct applier_join_file *file =
+		(struct applier_join_file *)malloc(size);
+	if (file == NULL)
+		tnt_raise(OutOfMemory, size, "malloc", "applier_join_file");
+	memcpy(file->path, path, path_len + 1);
+	file->tmp_path = file->path + path_len + 1;
+	sprintf(file->tmp_path, "%s%s", path, inprogress_suffix);
+	file->is_xlog = applier_join_file_is_xlog(path);
+	return file;
+}
+
+/** Create the directories a checkpoint file is put to. */
+static void
+applier_join_file_mkdir(struct applier_join_file *file)
+{
+	char *path = file->path;
+	for (char *sep = strchr(path + 1, '/'); sep != NULL;
+	     sep = strchr(sep + 1, '/')) {
+		*sep = '\0';
+		int rc = coio_mkdir(path, 0777);
+		*sep = '/';
+		if (rc != 0 && errno != EEXIST) {
+			tnt_raise(SystemError, "failed to create directory "
+				  "for '%s'", path);
+		}
+	}
+}
+
+/**
+ * Receive the content of a checkpoint file. It follows
+ * the file header row in the stream, so some of it may
+ * have been read ahead into the input buffer.
+ *
+ * The instance UUID stored in xlog files is replaced with
+ * ours, otherwise we wouldn't be able to recover from them.
+ */
+static void
+applier_join_file_recv(struct applier *applier,
+		       struct applier_join_file *file, uint64_t size)
+{
+	struct ev_io *coio = &applier->io;
+	struct ibuf *ibuf = &applier->ibuf;
+	applier_join_file_mkdir(file);
+	int fd = coio_file_open(file->tmp_path,
+				O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		tnt_raise(SystemError, "failed to create file '%s'",
+			  file->tmp_path);
+	}
+	auto fd_guard = make_scoped_guard([=] { coio_file_close(fd); });
+
+	if (file->is_xlog) {
+		size_t meta_len = MIN(size, (uint64_t)XLOG_META_LEN_MAX);
+		if (ibuf_used(ibuf) < meta_len)
+			coio_breadn(coio, ibuf, meta_len - ibuf_used(ibuf));
+		if (xlog_meta_set_instance_uuid(ibuf->rpos,
+						ibuf->rpos + meta_len,
+						&INSTANCE_UUID) != 0)
+			diag_raise();
+	}
+	off_t offset = 0;
+	while (size > 0) {
+		if (ibuf_used(ibuf) == 0) {
+			ibuf_reset(ibuf);
+			coio_breadn(coio, ibuf,
+				    MIN(size, (uint64_t)
+					APPLIER_JOIN_FILE_CHUNK_SIZE));
+			applier->last_row_time = ev_monotonic_now(loop());
+		}
+		size_t len = MIN(size, (uint64_t)ibuf_used(ibuf));
+		while (len > 0) {
+			ssize_t n = coio_pwrite(fd, ibuf->rpos, len, offset);
+			if (n < 0) {
+				tnt_raise(SystemError, "failed to write "
+					  "file '%s'", file->tmp_path);
+			}
+			ibuf->rpos += n;
+			offset += n;
+			size -= n;
+			len -= n;
+		}
+	}
+	if (coio_fsync(fd) != 0) {
+		tnt_raise(SystemError, "failed to sync file '%s'",
+			  file->tmp_path);
+	}
+}
+
+/**
+ * Receive checkpoint files sent by the master on JOIN instead
+ * of checkpoint rows and put them to the engine directories.
+ * The files are renamed from temporary names only after all
+ * of them have been received, snapshots last, so that an
+ * interrupted join doesn't leave a checkpoint to recover from.
+ */
+static void
+applier_join_files(struct applier *applier)
+{
+	struct ev_io *coio = &applier->io;
+	struct ibuf *ibuf = &applier->ibuf;
+	RLIST_HEAD(files);
+	auto files_guard = make_scoped_guard([&] {
+		struct applier_join_file *file, *tmp;
+		rlist_foreach_entry_safe(file, &files, in_files, tmp)
+			free(file);
+	});
+	uint64_t file_count = 0;
+	uint64_t total_size = 0;
+	struct xrow_header row;
+	while (true) {
+		coio_read_xrow(coio, ibuf, &row);
+		applier->last_row_time = ev_monotonic_now(loop());
+		if (row.type == IPROTO_JOIN_FILE) {
+			const char *name;
+			uint32_t name_len;
+			uint64_t size;
+			xrow_decode_join_file_xc(&row, &name, &name_len, &size);
+			struct applier_join_file *file =
+				applier_join_file_new(name, name_len);
+			rlist_add_tail_entry(&files, file, in_files);
+			applier_join_file_recv(applier, file, size);
+			file_count++;
+			total_size += size;
+		} else if (row.type == IPROTO_OK) {
+			break; /* end of stream */
+		} else if (iproto_type_is_error(row.type)) {
+			xrow_decode_error_xc(&row);  /* rethrow error */
+		} else {
+			tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+				  (uint32_t) row.type);
+		}
+	}
+	for (int pass = 0; pass < 2; pass++) {
+		struct applier_join_file *file;
+		rlist_foreach_entry(file, &files, in_files) {
+			bool is_snap = applier_path_has_ext(file->path,
+							    ".snap");
+			if (is_snap != (pass == 1))
+				continue;
+			if (coio_rename(file->tmp_path, file->path) != 0) {
+				tnt_raise(SystemError, "failed to rename "
+					  "'%s'", file->tmp_path);
+			}
+		}
+	}
+	say_info("%llu checkpoint files received, %.1f MB",
+		 (unsigned long long)file_count, total_size / 1e6);
+}
+
 /**
  * Execute and process JOIN request (bootstrap the instance).
  */
@@ -279,8 +507,9 @@ applier_join(struct applier *applier)
 	struct ev_io *coio = &applier->io;
 	struct ibuf *ibuf = &applier->ibuf;
 	struct xrow_header row;
-	xrow_encode_join_xc(&row, &INSTANCE_UUID);
+	xrow_encode_join_xc(&row, &INSTANCE_UUID, applier->join_files);
 	coio_write_xrow(coio, &row);
+	applier->join_files = false;
 
 	/**
 	 * Tarantool < 1.7.0: if JOIN is successful, there is no "OK"
@@ -301,7 +530,8 @@ applier_join(struct applier *applier)
 		 * Used to initialize the replica's initial
 		 * vclock in bootstrap_from_master()
 		 */
-		xrow_decode_vclock_xc(&row, &replicaset.vclock);
+		xrow_decode_join_response_xc(&row, &replicaset.vclock,
+					     &applier->join_files);
 	}
 
 	applier_set_state(applier, APPLIER_INITIAL_JOIN);
@@ -311,30 +541,36 @@ applier_join(struct applier *applier)
 	 */
 	assert(applier->join_stream != NULL);
 	uint64_t row_count = 0;
-	while (true) {
-		coio_read_xrow(coio, ibuf, &row);
-		applier->last_row_time = ev_monotonic_now(loop());
-		if (iproto_type_is_dml(row.type)) {
-			xstream_write_xc(applier->join_stream, &row);
-			if (++row_count % 100000 == 0)
-				say_info("%.1fM rows received", row_count / 1e6);
-		} else if (row.type == IPROTO_OK) {
-			if (applier->version_id < version_id(1, 7, 0)) {
-				/*
-				 * This is the start vclock if the
-				 * server is 1.6. Since we have
-				 * not initialized replication
-				 * vclock yet, do it now. In 1.7+
-				 * this vclock is not used.
-				 */
-				xrow_decode_vclock_xc(&row, &replicaset.vclock);
+	if (applier->join_files) {
+		applier_join_files(applier);
+	} else {
+		while (true) {
+			coio_read_xrow(coio, ibuf, &row);
+			applier->last_row_time = ev_monotonic_now(loop());
+			if (iproto_type_is_dml(row.type)) {
+				xstream_write_xc(applier->join_stream, &row);
+				if (++row_count % 100000 == 0)
+					say_info("%.1fM rows received",
+						 row_count / 1e6);
+			} else if (row.type == IPROTO_OK) {
+				if (applier->version_id < version_id(1, 7, 0)) {
+					/*
+					 * This is the start vclock if the
+					 * server is 1.6. Since we have
+					 * not initialized replication
+					 * vclock yet, do it now. In 1.7+
+					 * this vclock is not used.
+					 */
+					xrow_decode_vclock_xc(
+						&row, &replicaset.vclock);
+				}
+				break; /* end of stream */
+			} else if (iproto_type_is_error(row.type)) {
+				xrow_decode_error_xc(&row);  /* rethrow error */
+			} else {
+				tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+					  (uint32_t) row.type);
 			}
-			break; /* end of stream */
-		} else if (iproto_type_is_error(row.type)) {
-			xrow_decode_error_xc(&row);  /* rethrow error */
-		} else {
-			tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
-				  (uint32_t) row.type);
 		}
 	}
 	say_info("initial data received");
@@ -379,6 +615,109 @@ applier_join(struct applier *applier)
 	applier_set_state(applier, APPLIER_READY);
 }
 
+static ssize_t
+applier_decompress_f(va_list ap)
+{
+	ZSTD_DStream *zstream = va_arg(ap, ZSTD_DStream *);
+	char *dst = va_arg(ap, char *);
+	size_t dst_size = va_arg(ap, size_t);
+	const char *src = va_arg(ap, const char *);
+	size_t src_size = va_arg(ap, size_t);
+	ZSTD_inBuffer input = {src, src_size, 0};
+	ZSTD_outBuffer output = {dst, dst_size, 0};
+	while (input.pos < input.size) {
+		size_t rc = ZSTD_decompressStream(zstream, &output, &input);
+		if (ZSTD_isError(rc)) {
+			diag_set(ClientError, ER_DECOMPRESSION,
+				 ZSTD_getErrorName(rc));
+			return -1;
+		}
+		if (output.pos == output.size) {
+			diag_set(ClientError, ER_DECOMPRESSION,
+				 "invalid frame size");
+			return -1;
+		}
+	}
+	return output.pos;
+}
+
+/**
+ * Unpack a frame of compressed rows into the applier buffer.
+ * Frames are parts of a single zstd stream started on
+ * SUBSCRIBE, each one flushed by the master so that it unpacks
+ * into whole rows. Decompression is done in a coio thread so
+ * as not to stall tx while the frame is large.
+ */
+static void
+applier_decompress_rows(struct applier *applier, struct xrow_header *row)
+{
+	struct ibuf *zbuf = &applier->zbuf;
+	assert(ibuf_used(zbuf) == 0);
+	const char *data;
+	uint32_t size;
+	xrow_decode_compressed_rows_xc(row, &data, &size);
+	if (applier->zstream == NULL) {
+		applier->zstream = ZSTD_createDStream();
+		if (applier->zstream == NULL) {
+			tnt_raise(ClientError, ER_DECOMPRESSION,
+				  "failed to create context");
+		}
+		ZSTD_initDStream(applier->zstream);
+	}
+	/*
+	 * The master never packs more than XROW_COMPRESSED_ROWS_MAX
+	 * bytes in a frame. Leave room for one more byte to tell
+	 * a full buffer from an oversized frame.
+	 */
+	size_t len = XROW_COMPRESSED_ROWS_MAX + 1;
+	ibuf_reset(zbuf);
+	if (ibuf_reserve(zbuf, len) == NULL)
+		tnt_raise(OutOfMemory, len, "ibuf", "compressed rows");
+	ssize_t rc = coio_call(applier_decompress_f, applier->zstream,
+			       zbuf->wpos, len, data, (size_t) size);
+	if (rc < 0)
+		diag_raise();
+	zbuf->wpos += rc;
+}
+
+/**
+ * Read the next row of the replication stream. The master may
+ * pack rows into compressed frames if asked so on SUBSCRIBE,
+ * in which case rows are returned from the unpacked frame until
+ * it is exhausted.
+ */
+static void
+applier_read_row(struct applier *applier, struct xrow_header *row)
+{
+	struct ibuf *zbuf = &applier->zbuf;
+	while (ibuf_used(zbuf) == 0) {
+		/*
+		 * Tarantool < 1.7.7 does not send periodic heartbeat
+		 * messages so we can't assume that if we haven't heard
+		 * from the master for quite a while the connection is
+		 * broken - the master might just be idle.
+		 */
+		if (applier->version_id < version_id(1, 7, 7)) {
+			coio_read_xrow(&applier->io, &applier->ibuf, row);
+		} else {
+			double timeout = replication_disconnect_timeout();
+			coio_read_xrow_timeout_xc(&applier->io, &applier->ibuf,
+						  row, timeout);
+		}
+		if (row->type != IPROTO_COMPRESSED_ROWS)
+			return;
+		applier_decompress_rows(applier, row);
+	}
+	const char *pos = zbuf->rpos;
+	if (mp_typeof(*pos) != MP_UINT || mp_check_uint(pos, zbuf->wpos) > 0)
+		tnt_raise(ClientError, ER_INVALID_MSGPACK, "packet length");
+	uint32_t len = mp_decode_uint(&pos);
+	if (len > (uint32_t) (zbuf->wpos - pos))
+		tnt_raise(ClientError, ER_INVALID_MSGPACK, "packet length");
+	xrow_header_decode_xc(row, &pos, pos + len);
+	zbuf->rpos = (char *) pos;
+}
+
 /**
  * Execute and process SUBSCRIBE request (follow updates from a master).
  */
@@ -398,8 +737,11 @@ applier_subscribe(struct applier *applier)
 	vclock_create(&vclock);
 	vclock_copy(&vclock, &replicaset.vclock);
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
-				 &vclock);
+				 &vclock, replication_compression);
 	coio_write_xrow(coio, &row);
+	/* The master starts a new compression stream. */
+	if (applier->zstream != NULL)
+		ZSTD_initDStream(applier->zstream);
 
 	/* Read SUBSCRIBE response */
 	if (applier->version_id >= version_id(1, 6, 7)) {
@@ -510,18 +852,7 @@ applier_subscribe(struct applier *applier)
 			applier_set_state(applier, APPLIER_FOLLOW);
 		}
 
-		/*
-		 * Tarantool < 1.7.7 does not send periodic heartbeat
-		 * messages so we can't assume that if we haven't heard
-		 * from the master for quite a while the connection is
-		 * broken - the master might just be idle.
-		 */
-		if (applier->version_id < version_id(1, 7, 7)) {
-			coio_read_xrow(coio, ibuf, &row);
-		} else {
-			double timeout = replication_disconnect_timeout();
-			coio_read_xrow_timeout_xc(coio, ibuf, &row, timeout);
-		}
+		applier_read_row(applier, &row);
 
 		if (iproto_type_is_error(row.type))
 			xrow_decode_error_xc(&row);  /* error */
@@ -584,6 +915,8 @@ applier_subscribe(struct applier *applier)
 			fiber_cond_signal(&applier->writer_cond);
 		if (ibuf_used(ibuf) == 0)
 			ibuf_reset(ibuf);
+		if (ibuf_used(&applier->zbuf) == 0)
+			ibuf_reset(&applier->zbuf);
 		fiber_gc();
 	}
 }
@@ -601,6 +934,7 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 	coio_close(loop(), &applier->io);
 	/* Clear all unparsed input. */
 	ibuf_reinit(&applier->ibuf);
+	ibuf_reinit(&applier->zbuf);
 	fiber_gc();
 }
 
@@ -743,6 +1077,7 @@ applier_new(const char *uri, struct xstream *join_stream,
 	}
 	coio_create(&applier->io, -1);
 	ibuf_create(&applier->ibuf, &cord()->slabc, 1024);
+	ibuf_create(&applier->zbuf, &cord()->slabc, 1024);
 
 	/* uri_parse() sets pointers to applier->source buffer */
 	snprintf(applier->source, sizeof(applier->source), "%s", uri);
@@ -766,6 +1101,9 @@ applier_delete(struct applier *applier)
 {
 	assert(applier->reader == NULL && applier->writer == NULL);
 	ibuf_destroy(&applier->ibuf);
+	ibuf_destroy(&applier->zbuf);
+	if (applier->zstream != NULL)
+		ZSTD_freeDStream(applier->zstream);
 	assert(applier->io.fd == -1);
 	trigger_destroy(&applier->on_state);
 	fiber_cond_destroy(&applier->resume_cond);
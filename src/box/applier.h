@@ -36,6 +36,7 @@
 #include <tarantool_ev.h>
 
 #include <small/ibuf.h>
+#include <zstd.h>
 
 #include "fiber_cond.h"
 #include "trigger.h"
@@ -107,6 +108,13 @@ struct applier {
 	struct ev_io io;
 	/** Input buffer */
 	struct ibuf ibuf;
+	/** Rows unpacked from a compressed frame, not applied yet. */
+	struct ibuf zbuf;
+	/**
+	 * Decompression stream of the current subscription,
+	 * created on the first compressed frame.
+	 */
+	ZSTD_DStream *zstream;
 	/** Triggers invoked on state change */
 	struct rlist on_state;
 	/**
@@ -120,6 +128,12 @@ struct applier {
 	struct xstream *join_stream;
 	/** xstream to process rows during final JOIN and SUBSCRIBE */
 	struct xstream *subscribe_stream;
+	/**
+	 * Set before JOIN to ask the master for checkpoint files
+	 * instead of checkpoint rows. Updated on JOIN response to
+	 * reflect whether the master is going to send the files.
+	 */
+	bool join_files;
 };
 
 /**
@@ -47,6 +47,7 @@
 #include "main.h"
 #include "tuple.h"
 #include "tuple_format.h"
+#include "tuple_convert.h"
 #include "session.h"
 #include "schema.h"
 #include "engine.h"
@@ -473,6 +474,17 @@ box_check_replication_sync_lag(void)
 	return lag;
 }
 
+static int
+box_check_replication_compression(void)
+{
+	int level = cfg_geti("replication_compression");
+	if (level < 0) {
+		tnt_raise(ClientError, ER_CFG, "replication_compression",
+			  "the value must be greater or equal to 0");
+	}
+	return level;
+}
+
 static double
 box_check_replication_sync_timeout(void)
 {
@@ -532,6 +544,43 @@ box_check_checkpoint_count(int checkpoint_count)
 	}
 }
 
+static double
+box_check_checkpoint_recovery_time(double recovery_time)
+{
+	if (recovery_time < 0) {
+		tnt_raise(ClientError, ER_CFG, "checkpoint_recovery_time",
+			  "the value must not be less than 0");
+	}
+	return recovery_time;
+}
+
+static void
+box_check_memtx_checkpoint_delta_max(int delta_max)
+{
+	if (delta_max < 0) {
+		tnt_raise(ClientError, ER_CFG, "memtx_checkpoint_delta_max",
+			  "the value must not be negative");
+	}
+}
+
+static void
+box_check_memtx_checkpoint_threads(int thread_count)
+{
+	if (thread_count < 1) {
+		tnt_raise(ClientError, ER_CFG, "memtx_checkpoint_threads",
+			  "the value must not be less than one");
+	}
+}
+
+static void
+box_check_memtx_defrag_threshold(double threshold)
+{
+	if (threshold < 0 || threshold >= 1) {
+		tnt_raise(ClientError, ER_CFG, "memtx_defrag_threshold",
+			  "the value must be >= 0 and < 1");
+	}
+}
+
 static int64_t
 box_check_wal_max_rows(int64_t wal_max_rows)
 {
@@ -574,6 +623,24 @@ box_check_vinyl_memory(int64_t memory)
 	return memory;
 }
 
+static void
+box_check_vinyl_max_subcompactions(int max_subcompactions)
+{
+	if (max_subcompactions < 1) {
+		tnt_raise(ClientError, ER_CFG, "vinyl_max_subcompactions",
+			  "must be greater than or equal to 1");
+	}
+}
+
+static void
+box_check_vinyl_max_subdumps(int max_subdumps)
+{
+	if (max_subdumps < 1) {
+		tnt_raise(ClientError, ER_CFG, "vinyl_max_subdumps",
+			  "must be greater than or equal to 1");
+	}
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -595,6 +662,9 @@ box_check_vinyl_options(void)
 		tnt_raise(ClientError, ER_CFG, "vinyl_write_threads",
 			  "must be greater than or equal to 2");
 	}
+	box_check_vinyl_max_subcompactions(
+		cfg_geti("vinyl_max_subcompactions"));
+	box_check_vinyl_max_subdumps(cfg_geti("vinyl_max_subdumps"));
 	if (page_size <= 0 || (range_size > 0 && page_size > range_size)) {
 		tnt_raise(ClientError, ER_CFG, "vinyl_page_size",
 			  "must be greater than 0 and less than "
@@ -628,8 +698,15 @@ box_check_config()
 	box_check_replication_connect_quorum();
 	box_check_replication_sync_lag();
 	box_check_replication_sync_timeout();
+	box_check_replication_compression();
 	box_check_readahead(cfg_geti("readahead"));
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
+	box_check_checkpoint_recovery_time(cfg_getd("checkpoint_recovery_time"));
+	box_check_memtx_checkpoint_delta_max(
+		cfg_geti("memtx_checkpoint_delta_max"));
+	box_check_memtx_checkpoint_threads(
+		cfg_geti("memtx_checkpoint_threads"));
+	box_check_memtx_defrag_threshold(cfg_getd("memtx_defrag_threshold"));
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
@@ -759,6 +836,12 @@ box_set_replication_skip_conflict(void)
 	replication_skip_conflict = cfg_geti("replication_skip_conflict");
 }
 
+void
+box_set_replication_compression(void)
+{
+	replication_compression = box_check_replication_compression();
+}
+
 void
 box_listen(void)
 {
@@ -822,6 +905,39 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+void
+box_set_memtx_checkpoint_delta_max(void)
+{
+	int delta_max = cfg_geti("memtx_checkpoint_delta_max");
+	box_check_memtx_checkpoint_delta_max(delta_max);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_checkpoint_delta_max(memtx, delta_max);
+}
+
+void
+box_set_memtx_checkpoint_threads(void)
+{
+	int thread_count = cfg_geti("memtx_checkpoint_threads");
+	box_check_memtx_checkpoint_threads(thread_count);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_checkpoint_threads(memtx, thread_count);
+}
+
+void
+box_set_memtx_defrag_threshold(void)
+{
+	double threshold = cfg_getd("memtx_defrag_threshold");
+	box_check_memtx_defrag_threshold(threshold);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_defrag_threshold(memtx, threshold);
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -860,7 +976,15 @@ void
 box_set_checkpoint_wal_threshold(void)
 {
 	int64_t threshold = cfg_geti64("checkpoint_wal_threshold");
-	wal_set_checkpoint_threshold(threshold);
+	gc_set_checkpoint_wal_threshold(threshold);
+}
+
+void
+box_set_checkpoint_recovery_time(void)
+{
+	double recovery_time = box_check_checkpoint_recovery_time(
+		cfg_getd("checkpoint_recovery_time"));
+	gc_set_checkpoint_recovery_time(recovery_time);
 }
 
 void
@@ -892,6 +1016,15 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_meta_cache(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_meta_cache(vinyl, cfg_geti64("vinyl_meta_cache"));
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -901,6 +1034,28 @@ box_set_vinyl_timeout(void)
 	vinyl_engine_set_timeout(vinyl,	cfg_getd("vinyl_timeout"));
 }
 
+void
+box_set_vinyl_max_subcompactions(void)
+{
+	int max_subcompactions = cfg_geti("vinyl_max_subcompactions");
+	box_check_vinyl_max_subcompactions(max_subcompactions);
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_max_subcompactions(vinyl, max_subcompactions);
+}
+
+void
+box_set_vinyl_max_subdumps(void)
+{
+	int max_subdumps = cfg_geti("vinyl_max_subdumps");
+	box_check_vinyl_max_subdumps(max_subdumps);
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_max_subdumps(vinyl, max_subdumps);
+}
+
 void
 box_set_net_msg_max(void)
 {
@@ -1050,41 +1205,124 @@ box_process1(struct request *request, box_tuple_t **result)
 }
 
 int
-box_select(uint32_t space_id, uint32_t index_id,
-	   int iterator, uint32_t offset, uint32_t limit,
-	   const char *key, const char *key_end,
-	   struct port *port)
+box_process_batch(struct batch_request *batch, struct tuple ***results)
 {
-	(void)key_end;
+	rmean_collect(rmean_box, IPROTO_BATCH, 1);
+	uint32_t count = batch->request_count;
+	/*
+	 * The results must survive a failed commit, which frees
+	 * the fiber region, to be unreferenced.
+	 */
+	struct tuple **result = (struct tuple **)
+		calloc(count, sizeof(*result));
+	if (result == NULL && count > 0) {
+		diag_set(OutOfMemory, sizeof(*result) * count,
+			 "calloc", "result");
+		return -1;
+	}
+	struct xrow_header *rows = (struct xrow_header *)
+		region_alloc(&fiber()->gc, sizeof(*rows) * count);
+	if (rows == NULL && count > 0) {
+		diag_set(OutOfMemory, sizeof(*rows) * count,
+			 "region", "rows");
+		free(result);
+		return -1;
+	}
+	if (box_txn_begin() != 0) {
+		free(result);
+		return -1;
+	}
+	const char *pos = batch->requests;
+	mp_decode_array(&pos);
+	uint32_t i;
+	for (i = 0; i < count; i++) {
+		struct request request;
+		/*
+		 * Batched rows are written to WAL as is, so they
+		 * must live until the transaction is committed.
+		 */
+		struct xrow_header *row = &rows[i];
+		if (xrow_decode_batch_item(&pos, batch->requests_end,
+					   row, &request) != 0)
+			goto rollback;
+		row->sync = batch->header->sync;
+		if (box_process1(&request, &result[i]) != 0)
+			goto rollback;
+		if (result[i] != NULL)
+			tuple_ref(result[i]);
+	}
+	assert(pos == batch->requests_end);
+	if (box_txn_commit() != 0)
+		goto fail;
+	*results = result;
+	return 0;
+rollback:
+	txn_rollback();
+fail:
+	for (uint32_t j = 0; j < i; j++) {
+		if (result[j] != NULL)
+			tuple_unref(result[j]);
+	}
+	free(result);
+	return -1;
+}
 
+/**
+ * Look up the space and the index a SELECT is addressed to,
+ * check access and validate the iterator type and the key.
+ * On success @a key points past the key array header.
+ */
+static struct index *
+box_select_prepare(uint32_t space_id, uint32_t index_id, int iterator,
+		   const char **key, uint32_t *part_count,
+		   struct space **space)
+{
 	rmean_collect(rmean_box, IPROTO_SELECT, 1);
 
 	if (iterator < 0 || iterator >= iterator_type_MAX) {
 		diag_set(ClientError, ER_ILLEGAL_PARAMS,
 			 "Invalid iterator type");
 		diag_log();
-		return -1;
+		return NULL;
 	}
 
-	struct space *space = space_cache_find(space_id);
-	if (space == NULL)
-		return -1;
-	if (access_check_space(space, PRIV_R) != 0)
-		return -1;
-	struct index *index = index_find(space, index_id);
+	*space = space_cache_find(space_id);
+	if (*space == NULL)
+		return NULL;
+	if (access_check_space(*space, PRIV_R) != 0)
+		return NULL;
+	struct index *index = index_find(*space, index_id);
 	if (index == NULL)
-		return -1;
+		return NULL;
 
 	enum iterator_type type = (enum iterator_type) iterator;
-	uint32_t part_count = key ? mp_decode_array(&key) : 0;
-	if (key_validate(index->def, type, key, part_count))
-		return -1;
+	*part_count = *key ? mp_decode_array(key) : 0;
+	if (key_validate(index->def, type, *key, *part_count))
+		return NULL;
 
 	ERROR_INJECT(ERRINJ_TESTING, {
 		diag_set(ClientError, ER_INJECTION, "ERRINJ_TESTING");
-		return -1;
+		return NULL;
 	});
+	return index;
+}
+
+/** Function called by box_select_iterate() for each found tuple. */
+typedef int (*box_select_f)(struct tuple *tuple, void *ctx);
 
+/**
+ * Iterate over tuples matching a SELECT and pass those within
+ * @a offset and @a limit to @a cb.
+ *
+ * \retval >= 0 the number of tuples passed to @a cb
+ * \retval -1 on error
+ */
+static inline int
+box_select_iterate(struct space *space, struct index *index,
+		   enum iterator_type type, const char *key,
+		   uint32_t part_count, uint32_t offset, uint32_t limit,
+		   box_select_f cb, void *ctx)
+{
 	struct txn *txn;
 	if (txn_begin_ro_stmt(space, &txn) != 0)
 		return -1;
@@ -1096,11 +1334,11 @@ box_select(uint32_t space_id, uint32_t index_id,
 		return -1;
 	}
 
-	int rc = 0;
+	/* Let the index skip the offset without iterating, if it can. */
+	int rc = iterator_skip(it, &offset);
 	uint32_t found = 0;
 	struct tuple *tuple;
-	port_tuple_create(port);
-	while (found < limit) {
+	while (rc == 0 && found < limit) {
 		rc = iterator_next(it, &tuple);
 		if (rc != 0 || tuple == NULL)
 			break;
@@ -1108,7 +1346,7 @@ box_select(uint32_t space_id, uint32_t index_id,
 			offset--;
 			continue;
 		}
-		rc = port_tuple_add(port, tuple);
+		rc = cb(tuple, ctx);
 		if (rc != 0)
 			break;
 		found++;
@@ -1116,14 +1354,122 @@ box_select(uint32_t space_id, uint32_t index_id,
 	iterator_delete(it);
 
 	if (rc != 0) {
-		port_destroy(port);
 		txn_rollback_stmt();
 		return -1;
 	}
 	txn_commit_ro_stmt(txn);
+	return found;
+}
+
+static int
+box_select_add_to_port(struct tuple *tuple, void *ctx)
+{
+	return port_tuple_add((struct port *)ctx, tuple);
+}
+
+/**
+ * Collect tuples matching a SELECT into @a port. Tuples are
+ * referenced, so the iterator is allowed to yield.
+ */
+static int
+box_select_to_port(struct space *space, struct index *index,
+		   enum iterator_type type, const char *key,
+		   uint32_t part_count, uint32_t offset, uint32_t limit,
+		   struct port *port)
+{
+	port_tuple_create(port);
+	if (box_select_iterate(space, index, type, key, part_count,
+			       offset, limit, box_select_add_to_port,
+			       port) < 0) {
+		port_destroy(port);
+		return -1;
+	}
 	return 0;
 }
 
+int
+box_select(uint32_t space_id, uint32_t index_id,
+	   int iterator, uint32_t offset, uint32_t limit,
+	   const char *key, const char *key_end,
+	   struct port *port)
+{
+	(void)key_end;
+
+	struct space *space;
+	uint32_t part_count;
+	struct index *index = box_select_prepare(space_id, index_id, iterator,
+						 &key, &part_count, &space);
+	if (index == NULL)
+		return -1;
+	return box_select_to_port(space, index, (enum iterator_type) iterator,
+				  key, part_count, offset, limit, port);
+}
+
+/** Context of box_select_add_to_obuf(). */
+struct box_select_obuf_ctx {
+	/** Buffer to encode tuples to. */
+	struct obuf *out;
+	/** Size of tuples encoded to @out so far. */
+	size_t copied;
+	/** Max size to encode to @out, see box_select_to_obuf(). */
+	size_t copy_max;
+	/** Port collecting tuples once @copy_max is exceeded. */
+	struct port *tail;
+};
+
+static int
+box_select_add_to_obuf(struct tuple *tuple, void *arg)
+{
+	struct box_select_obuf_ctx *ctx = (struct box_select_obuf_ctx *)arg;
+	if (ctx->copied > ctx->copy_max)
+		return port_tuple_add(ctx->tail, tuple);
+	int rc = tuple_to_obuf(tuple, ctx->out);
+	ERROR_INJECT(ERRINJ_PORT_DUMP, {
+		diag_set(OutOfMemory, tuple_size(tuple), "obuf_dup", "data");
+		rc = -1;
+	});
+	if (rc != 0)
+		return -1;
+	ctx->copied += tuple->bsize;
+	return 0;
+}
+
+int
+box_select_to_obuf(uint32_t space_id, uint32_t index_id,
+		   int iterator, uint32_t offset, uint32_t limit,
+		   const char *key, const char *key_end, struct obuf *out,
+		   size_t copy_max, struct port *tail)
+{
+	(void)key_end;
+
+	port_tuple_create(tail);
+
+	struct space *space;
+	uint32_t part_count;
+	struct index *index = box_select_prepare(space_id, index_id, iterator,
+						 &key, &part_count, &space);
+	if (index == NULL)
+		return -1;
+	/*
+	 * Memtx iterators never yield, so found tuples can be
+	 * encoded into the output buffer as is, without taking
+	 * references and allocating port entries.
+	 */
+	assert(space_is_memtx(space));
+	struct box_select_obuf_ctx ctx;
+	ctx.out = out;
+	ctx.copied = 0;
+	ctx.copy_max = copy_max;
+	ctx.tail = tail;
+	int found = box_select_iterate(space, index,
+				       (enum iterator_type) iterator,
+				       key, part_count, offset, limit,
+				       box_select_add_to_obuf, &ctx);
+	if (found < 0)
+		port_destroy(tail);
+	return found;
+}
+
 int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -1400,6 +1746,28 @@ box_process_auth(struct auth_request *request, const char *salt)
 	authenticate(user, len, salt, request->scramble);
 }
 
+static int
+box_check_local_data(struct space *space, void *arg)
+{
+	bool *has_local_data = (bool *)arg;
+	struct index *pk = space_index(space, 0);
+	if (space_group_id(space) == GROUP_LOCAL &&
+	    pk != NULL && index_size(pk) > 0) {
+		*has_local_data = true;
+		return 1;
+	}
+	return 0;
+}
+
+/** Check if any replica local space has data. */
+static bool
+box_has_local_data(void)
+{
+	bool has_local_data = false;
+	space_foreach(box_check_local_data, &has_local_data);
+	return has_local_data;
+}
+
 void
 box_process_join(struct ev_io *io, struct xrow_header *header)
 {
@@ -1409,8 +1777,8 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 *
 	 * Replica => Master
 	 *
-	 * => JOIN { INSTANCE_UUID: replica_uuid }
-	 * <= OK { VCLOCK: start_vclock }
+	 * => JOIN { INSTANCE_UUID: replica_uuid, [JOIN_FILES: true] }
+	 * <= OK { VCLOCK: start_vclock, [JOIN_FILES: true] }
 	 *    Replica has enough permissions and master is ready for JOIN.
 	 *     - start_vclock - vclock of the latest master's checkpoint.
 	 *
@@ -1421,6 +1789,19 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 *    use REPLICA_ID, LSN and other fields for internal purposes.
 	 *    ...
 	 * <= INSERT
+	 *
+	 *    Alternatively, if the replica sets JOIN_FILES in the
+	 *    request and the master responds with JOIN_FILES too,
+	 *    initial data is sent as checkpoint files:
+	 *
+	 * <= JOIN_FILE { FILE_NAME: name, FILE_SIZE: size }, raw data
+	 *    ...
+	 *    The file name is <engine>/<path relative to the engine
+	 *    directory>, the header is followed by `size` bytes of the
+	 *    file content.
+	 *    ...
+	 * <= JOIN_FILE { FILE_NAME: name, FILE_SIZE: size }, raw data
+	 *
 	 * <= OK { VCLOCK: stop_vclock } - end of initial JOIN stage.
 	 *     - `stop_vclock` - master's vclock when it's done
 	 *     done sending rows from the snapshot (i.e. vclock
@@ -1448,7 +1829,8 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 
 	/* Decode JOIN request */
 	struct tt_uuid instance_uuid = uuid_nil;
-	xrow_decode_join_xc(header, &instance_uuid);
+	bool join_files = false;
+	xrow_decode_join_xc(header, &instance_uuid, &join_files);
 
 	/* Check that bootstrap has been finished */
 	if (!is_box_configured)
@@ -1503,9 +1885,21 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 			  tt_uuid_str(&instance_uuid));
 	auto gc_guard = make_scoped_guard([&]{ gc_unref_checkpoint(&gc); });
 
+	/*
+	 * Checkpoint files contain data of replica local spaces,
+	 * which must not be sent to the replica. Fall back on
+	 * sending rows if there's any.
+	 */
+	if (join_files && box_has_local_data()) {
+		say_info("replica %s asked for checkpoint files, "
+			 "sending rows because of replica local data",
+			 tt_uuid_str(&instance_uuid));
+		join_files = false;
+	}
+
 	/* Respond to JOIN request with start_vclock. */
 	struct xrow_header row;
-	xrow_encode_vclock_xc(&row, &start_vclock);
+	xrow_encode_join_response_xc(&row, &start_vclock, join_files);
 	row.sync = header->sync;
 	coio_write_xrow(io, &row);
 
@@ -1513,9 +1907,13 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 		 tt_uuid_str(&instance_uuid), sio_socketname(io->fd));
 
 	/*
-	 * Initial stream: feed replica with dirty data from engines.
+	 * Initial stream: feed replica with dirty data from engines
+	 * or with checkpoint files if it asked so.
 	 */
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	if (join_files)
+		relay_initial_join_files(io->fd, header->sync, &start_vclock);
+	else
+		relay_initial_join(io->fd, header->sync, &start_vclock);
 	say_info("initial data sent.");
 
 	/**
@@ -1572,9 +1970,11 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	struct tt_uuid replicaset_uuid = uuid_nil, replica_uuid = uuid_nil;
 	struct vclock replica_clock;
 	uint32_t replica_version_id;
+	uint32_t compression = 0;
 	vclock_create(&replica_clock);
 	xrow_decode_subscribe_xc(header, &replicaset_uuid, &replica_uuid,
-				 &replica_clock, &replica_version_id);
+				 &replica_clock, &replica_version_id,
+				 &compression);
 
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&replica_uuid, &INSTANCE_UUID))
@@ -1648,7 +2048,7 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * indefinitely).
 	 */
 	relay_subscribe(replica, io->fd, header->sync, &replica_clock,
-			replica_version_id);
+			replica_version_id, compression);
 }
 
 void
@@ -1700,6 +2100,16 @@ box_free(void)
 	}
 }
 
+const char *
+box_engine_dir(const char *engine_name)
+{
+	if (strcmp(engine_name, "memtx") == 0)
+		return cfg_gets("memtx_dir");
+	if (strcmp(engine_name, "vinyl") == 0)
+		return cfg_gets("vinyl_dir");
+	return NULL;
+}
+
 static void
 engine_init()
 {
@@ -1733,7 +2143,10 @@ engine_init()
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_meta_cache();
 	box_set_vinyl_timeout();
+	box_set_vinyl_max_subcompactions();
+	box_set_vinyl_max_subdumps();
 }
 
 /**
@@ -1797,13 +2210,40 @@ bootstrap_from_master(struct replica *master)
 	 */
 
 	assert(!tt_uuid_is_nil(&INSTANCE_UUID));
-	applier_resume_to_state(applier, APPLIER_INITIAL_JOIN, TIMEOUT_INFINITY);
-
 	/*
-	 * Process initial data (snapshot or dirty disk data).
+	 * Ask the master for checkpoint files if configured so,
+	 * unless it's a rebootstrap, in which case the files of
+	 * the old checkpoint are still there.
 	 */
-	engine_begin_initial_recovery_xc(NULL);
-	applier_resume_to_state(applier, APPLIER_FINAL_JOIN, TIMEOUT_INFINITY);
+	applier->join_files = cfg_getb("replication_join_files") == 1 &&
+			      gc_last_checkpoint() == NULL;
+	applier_resume_to_state(applier, APPLIER_INITIAL_JOIN, TIMEOUT_INFINITY);
+
+	if (applier->join_files) {
+		/*
+		 * Wait for the checkpoint files to be installed
+		 * and recover from them as on local recovery.
+		 * Vinyl needs the current vclock to skip rows
+		 * that have been dumped, see local_recovery().
+		 */
+		struct vclock checkpoint_vclock;
+		vclock_copy(&checkpoint_vclock, &replicaset.vclock);
+		applier_resume_to_state(applier, APPLIER_FINAL_JOIN,
+					TIMEOUT_INFINITY);
+		struct memtx_engine *memtx;
+		memtx = (struct memtx_engine *)engine_by_name("memtx");
+		assert(memtx != NULL);
+		memtx_engine_scan_checkpoints_xc(memtx);
+		engine_begin_initial_recovery_xc(&replicaset.vclock);
+		memtx_engine_recover_snapshot_xc(memtx, &checkpoint_vclock);
+	} else {
+		/*
+		 * Process initial data (snapshot or dirty disk data).
+		 */
+		engine_begin_initial_recovery_xc(NULL);
+		applier_resume_to_state(applier, APPLIER_FINAL_JOIN,
+					TIMEOUT_INFINITY);
+	}
 
 	/*
 	 * Process final data (WALs).
@@ -1984,10 +2424,15 @@ local_recovery(const struct tt_uuid *instance_uuid,
 	 * recovery of system spaces issue DDL events in
 	 * other engines.
 	 */
+	double start_time = ev_monotonic_time();
 	memtx_engine_recover_snapshot_xc(memtx, checkpoint_vclock);
+	double checkpoint_load_time = ev_monotonic_time() - start_time;
 
 	engine_begin_final_recovery_xc();
+	start_time = ev_monotonic_time();
 	recover_remaining_wals(recovery, &wal_stream.base, NULL, false);
+	gc_set_recovery_stat(checkpoint_load_time, recovery->wal_size_read,
+			     ev_monotonic_time() - start_time);
 	/*
 	 * Leave hot standby mode, if any, only after
 	 * acquiring the lock.
@@ -2093,6 +2538,8 @@ box_cfg_xc(void)
 	fiber_pool_create(&tx_fiber_pool, "tx",
 			  IPROTO_MSG_MAX_MIN * IPROTO_FIBER_POOL_SIZE_FACTOR,
 			  FIBER_POOL_IDLE_TIMEOUT);
+	/* Serve memtx SELECTs without a fiber switch. */
+	fiber_pool_set_direct_f(&tx_fiber_pool, iproto_tx_deliver_direct);
 	/* Add an extra endpoint for WAL wake up/rollback messages. */
 	cbus_endpoint_create(&tx_prio_endpoint, "tx_prio", tx_prio_cb, &tx_prio_endpoint);
 
@@ -2131,6 +2578,7 @@ box_cfg_xc(void)
 	box_set_replication_sync_lag();
 	box_set_replication_sync_timeout();
 	box_set_replication_skip_conflict();
+	box_set_replication_compression();
 	xstream_create(&join_stream, apply_initial_join_row);
 	xstream_create(&subscribe_stream, apply_row);
 
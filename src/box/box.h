@@ -46,6 +46,7 @@ extern "C" {
 
 struct port;
 struct request;
+struct batch_request;
 struct xrow_header;
 struct obuf;
 struct ev_io;
@@ -155,6 +156,13 @@ box_backup_start(int checkpoint_idx, box_backup_cb cb, void *cb_arg);
 void
 box_backup_stop(void);
 
+/**
+ * Return the directory where the engine with the given name
+ * stores checkpoint files, or NULL if it doesn't store any.
+ */
+const char *
+box_engine_dir(const char *engine_name);
+
 /**
  * Spit out some basic module status (master/slave, etc.
  */
@@ -199,18 +207,26 @@ void box_set_readahead(void);
 void box_set_checkpoint_count(void);
 void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
+void box_set_checkpoint_recovery_time(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_memtx_checkpoint_delta_max(void);
+void box_set_memtx_checkpoint_threads(void);
+void box_set_memtx_defrag_threshold(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
+void box_set_vinyl_meta_cache(void);
 void box_set_vinyl_timeout(void);
+void box_set_vinyl_max_subcompactions(void);
+void box_set_vinyl_max_subdumps(void);
 void box_set_replication_timeout(void);
 void box_set_replication_connect_timeout(void);
 void box_set_replication_connect_quorum(void);
 void box_set_replication_sync_lag(void);
 void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
+void box_set_replication_compression(void);
 void box_set_net_msg_max(void);
 
 extern "C" {
@@ -433,6 +449,41 @@ int
 box_process_rw(struct request *request, struct space *space,
 	       struct tuple **result);
 
+/**
+ * Execute a batch of DML requests in a single transaction,
+ * which is written to WAL as a single entry. On success
+ * @a results is set to a malloc()-ed array of
+ * batch->request_count tuples returned by the requests (NULL
+ * if a request returned nothing). The tuples are referenced:
+ * the caller must unreference them and free the array.
+ *
+ * \retval 0 on success, -1 otherwise
+ */
+int
+box_process_batch(struct batch_request *batch, struct tuple ***results);
+
+/**
+ * Execute SELECT and encode found tuples to @a out in the
+ * IPROTO_DATA array format used since Tarantool 1.6. Tuples
+ * are encoded as they are found, bypassing a port, so the
+ * function never yields and may only be used for memtx
+ * spaces.
+ *
+ * Once more than @a copy_max bytes have been copied to @a out,
+ * the rest of the result set is referenced in @a tail instead,
+ * so that it can be sent to the client right from the tuple
+ * memory. @a tail is always created as a tuple port and must be
+ * destroyed by the caller on success.
+ *
+ * \retval >= 0 the total number of tuples in @a out and @a tail
+ * \retval -1 on error, @a out may contain garbage
+ */
+int
+box_select_to_obuf(uint32_t space_id, uint32_t index_id,
+		   int iterator, uint32_t offset, uint32_t limit,
+		   const char *key, const char *key_end, struct obuf *out,
+		   size_t copy_max, struct port *tail);
+
 int
 boxk(int type, uint32_t space_id, const char *format, ...);
 
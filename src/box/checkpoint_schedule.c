@@ -56,6 +56,24 @@ checkpoint_schedule_reset(struct checkpoint_schedule *sched, double now)
 	sched->start_time = now + sched->interval;
 }
 
+int64_t
+checkpoint_recovery_wal_threshold(const struct checkpoint_recovery_stat *stat,
+				  double recovery_time)
+{
+	assert(recovery_time > 0);
+	double replay_rate = stat->wal_replay_rate;
+	if (replay_rate <= 0)
+		replay_rate = CHECKPOINT_WAL_REPLAY_RATE_DEFAULT;
+	double replay_time = recovery_time - stat->checkpoint_load_time;
+	double threshold = replay_time * replay_rate -
+			   stat->checkpoint_time * stat->wal_write_rate;
+	if (threshold < CHECKPOINT_WAL_THRESHOLD_MIN)
+		threshold = CHECKPOINT_WAL_THRESHOLD_MIN;
+	if (threshold > (double)INT64_MAX)
+		return INT64_MAX;
+	return threshold;
+}
+
 double
 checkpoint_schedule_timeout(struct checkpoint_schedule *sched, double now)
 {
@@ -31,10 +31,27 @@
  * SUCH DAMAGE.
  */
 
+#include <stdint.h>
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+enum {
+	/**
+	 * Rate of WAL replay, in bytes per second, assumed if
+	 * it hasn't been measured on local recovery.
+	 */
+	CHECKPOINT_WAL_REPLAY_RATE_DEFAULT = 16 * 1024 * 1024,
+	/**
+	 * Min size of WAL, in bytes, written between checkpoints
+	 * when checkpointing is driven by the recovery time target.
+	 * Prevents checkpointing in a loop if the target is too
+	 * tight to be met.
+	 */
+	CHECKPOINT_WAL_THRESHOLD_MIN = 16 * 1024 * 1024,
+};
+
 struct checkpoint_schedule {
 	/**
 	 * Configured interval between checkpoints, in seconds.
@@ -78,6 +95,37 @@ checkpoint_schedule_reset(struct checkpoint_schedule *sched, double now);
 double
 checkpoint_schedule_timeout(struct checkpoint_schedule *sched, double now);
 
+/**
+ * Statistics used for estimating how long it would take to
+ * recover the instance from the last checkpoint. A value is
+ * set to 0 if it is unknown.
+ */
+struct checkpoint_recovery_stat {
+	/** Time it takes to load a checkpoint, in seconds. */
+	double checkpoint_load_time;
+	/** Rate at which WAL is replayed, in bytes per second. */
+	double wal_replay_rate;
+	/** Time it takes to make a checkpoint, in seconds. */
+	double checkpoint_time;
+	/** Rate at which WAL is written, in bytes per second. */
+	double wal_write_rate;
+};
+
+/**
+ * Return the size of WAL, in bytes, that may be written since
+ * the last checkpoint before a new checkpoint has to be started
+ * so that recovery after a crash takes no longer than
+ * @recovery_time seconds.
+ *
+ * Recovery consists of loading the last checkpoint and replaying
+ * WAL written after it. Since WAL keeps being written while the
+ * next checkpoint is being made, the WAL that is going to be
+ * written during that time is subtracted from the replay budget.
+ */
+int64_t
+checkpoint_recovery_wal_threshold(const struct checkpoint_recovery_stat *stat,
+				  double recovery_time);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
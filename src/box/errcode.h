@@ -231,6 +231,7 @@ struct errcode_record {
 	/*176 */_(ER_SQL_CANT_RESOLVE_FIELD,	"Can’t resolve field '%s'") \
 	/*177 */_(ER_INDEX_EXISTS_IN_SPACE,	"Index '%s' already exists in space '%s'") \
 	/*178 */_(ER_INCONSISTENT_TYPES,	"Inconsistent types: expected %s got %s") \
+	/*179 */_(ER_SPACE_MEMORY_QUOTA,	"Memory quota exceeded for space '%s': %llu bytes used, %lld bytes allowed") \
 
 /*
  * !IMPORTANT! Please follow instructions at start of the file
@@ -114,6 +114,8 @@ gc_init(void)
 	gc_tree_new(&gc.consumers);
 	fiber_cond_create(&gc.cleanup_cond);
 	checkpoint_schedule_cfg(&gc.checkpoint_schedule, 0, 0);
+	gc.checkpoint_wal_threshold = INT64_MAX;
+	gc.checkpoint_start_time = ev_monotonic_time();
 
 	gc.cleanup_fiber = fiber_new("gc", gc_cleanup_fiber_f);
 	if (gc.cleanup_fiber == NULL)
@@ -325,6 +327,53 @@ gc_set_checkpoint_interval(double interval)
 		fiber_wakeup(gc.checkpoint_fiber);
 }
 
+/**
+ * Propagate the WAL threshold to the WAL thread, lowering
+ * it if needed to meet the recovery time target.
+ */
+static void
+gc_update_checkpoint_wal_threshold(void)
+{
+	int64_t threshold = gc.checkpoint_wal_threshold;
+	if (gc.checkpoint_recovery_time > 0) {
+		int64_t recovery_threshold = checkpoint_recovery_wal_threshold(
+			&gc.recovery_stat, gc.checkpoint_recovery_time);
+		threshold = MIN(threshold, recovery_threshold);
+	}
+	wal_set_checkpoint_threshold(threshold);
+}
+
+void
+gc_set_checkpoint_wal_threshold(int64_t threshold)
+{
+	gc.checkpoint_wal_threshold = threshold;
+	gc_update_checkpoint_wal_threshold();
+}
+
+void
+gc_set_checkpoint_recovery_time(double recovery_time)
+{
+	gc.checkpoint_recovery_time = recovery_time;
+	gc_update_checkpoint_wal_threshold();
+}
+
+void
+gc_set_recovery_stat(double checkpoint_load_time, int64_t wal_size,
+		     double wal_replay_time)
+{
+	struct checkpoint_recovery_stat *stat = &gc.recovery_stat;
+	stat->checkpoint_load_time = checkpoint_load_time;
+	/*
+	 * Replay of a few rows says nothing about the replay
+	 * rate, stick to the default in this case.
+	 */
+	if (wal_size >= CHECKPOINT_WAL_THRESHOLD_MIN && wal_replay_time > 0)
+		stat->wal_replay_rate = wal_size / wal_replay_time;
+	say_info("recovery: checkpoint loaded in %.1f s, "
+		 "%lld bytes of WAL replayed in %.1f s",
+		 checkpoint_load_time, (long long)wal_size, wal_replay_time);
+}
+
 void
 gc_add_checkpoint(const struct vclock *vclock)
 {
@@ -367,6 +416,7 @@ gc_do_checkpoint(void)
 
 	assert(!gc.checkpoint_is_in_progress);
 	gc.checkpoint_is_in_progress = true;
+	double start_time = ev_monotonic_time();
 
 	/*
 	 * We don't support DDL operations while making a checkpoint.
@@ -400,6 +450,21 @@ out:
 
 	latch_unlock(&schema_lock);
 	gc.checkpoint_is_in_progress = false;
+	if (rc == 0) {
+		/*
+		 * Update the statistics used for estimating the
+		 * recovery time and readjust the WAL threshold.
+		 */
+		struct checkpoint_recovery_stat *stat = &gc.recovery_stat;
+		stat->checkpoint_time = ev_monotonic_time() - start_time;
+		if (start_time > gc.checkpoint_start_time) {
+			stat->wal_write_rate = checkpoint.wal_size /
+				(start_time - gc.checkpoint_start_time);
+		}
+		gc.checkpoint_start_time = start_time;
+		if (gc.checkpoint_recovery_time > 0)
+			gc_update_checkpoint_wal_threshold();
+	}
 	return rc;
 }
 
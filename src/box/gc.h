@@ -127,6 +127,23 @@ struct gc_state {
 	struct fiber *checkpoint_fiber;
 	/** Schedule of periodic checkpoints. */
 	struct checkpoint_schedule checkpoint_schedule;
+	/**
+	 * Size of WAL, in bytes, that triggers checkpointing.
+	 * Configured by box.cfg.checkpoint_wal_threshold.
+	 */
+	int64_t checkpoint_wal_threshold;
+	/**
+	 * Target time of recovery from the last checkpoint,
+	 * in seconds, 0 if not set. If set, the WAL threshold
+	 * is lowered so that a checkpoint is made before
+	 * recovery could exceed the target. Configured by
+	 * box.cfg.checkpoint_recovery_time.
+	 */
+	double checkpoint_recovery_time;
+	/** Statistics used for estimating the recovery time. */
+	struct checkpoint_recovery_stat recovery_stat;
+	/** Monotonic time when the last checkpoint was started. */
+	double checkpoint_start_time;
 	/** Fiber that removes old files in the background. */
 	struct fiber *cleanup_fiber;
 	/**
@@ -231,6 +248,33 @@ gc_set_min_checkpoint_count(int min_checkpoint_count);
 void
 gc_set_checkpoint_interval(double interval);
 
+/**
+ * Set the size of WAL, in bytes, that triggers checkpointing.
+ */
+void
+gc_set_checkpoint_wal_threshold(int64_t threshold);
+
+/**
+ * Set the target time of recovery from the last checkpoint,
+ * in seconds. Setting it to 0 disables checkpointing driven
+ * by the recovery time.
+ */
+void
+gc_set_checkpoint_recovery_time(double recovery_time);
+
+/**
+ * Update the recovery time estimate with the statistics
+ * collected on local recovery.
+ *
+ * @checkpoint_load_time is the time it took to load
+ * the last checkpoint, in seconds.
+ * @wal_size is the size of replayed WAL files, in bytes.
+ * @wal_replay_time is the time it took to replay them.
+ */
+void
+gc_set_recovery_stat(double checkpoint_load_time, int64_t wal_size,
+		     double wal_replay_time);
+
 /**
  * Track an existing checkpoint in the garbage collector state.
  * Note, this function may trigger garbage collection to remove
@@ -435,6 +435,7 @@ void
 iterator_create(struct iterator *it, struct index *index)
 {
 	it->next = NULL;
+	it->skip = NULL;
 	it->free = NULL;
 	it->space_cache_version = space_cache_version;
 	it->space_id = index->def->space_id;
@@ -466,6 +467,14 @@ invalidate:
 	return 0;
 }
 
+int
+iterator_skip(struct iterator *it, uint32_t *count)
+{
+	if (it->skip == NULL || *count == 0)
+		return 0;
+	return it->skip(it, count);
+}
+
 void
 iterator_delete(struct iterator *it)
 {
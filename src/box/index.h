@@ -242,6 +242,14 @@ struct iterator {
 	 * Returns 0 on success, -1 on error.
 	 */
 	int (*next)(struct iterator *it, struct tuple **ret);
+	/**
+	 * Skip up to @a count tuples without returning them
+	 * and decrement @a count by the number of skipped
+	 * tuples. Optional, may be NULL if the index can't
+	 * skip tuples faster than by iterating over them.
+	 * Returns 0 on success, -1 on error.
+	 */
+	int (*skip)(struct iterator *it, uint32_t *count);
 	/** Destroy the iterator. */
 	void (*free)(struct iterator *);
 	/** Space cache version at the time of the last index lookup. */
@@ -277,6 +285,17 @@ iterator_create(struct iterator *it, struct index *index);
 int
 iterator_next(struct iterator *it, struct tuple **ret);
 
+/**
+ * Skip up to @a count tuples without returning them.
+ *
+ * On return @a count is decremented by the number of skipped
+ * tuples, so that the caller may skip the rest with
+ * iterator_next() if the index can't skip them all at once.
+ * Returns 0 on success, -1 on error.
+ */
+int
+iterator_skip(struct iterator *it, uint32_t *count);
+
 /**
  * Destroy an iterator instance and free associated memory.
  */
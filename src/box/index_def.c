@@ -38,6 +38,10 @@ const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
 
+const char *compaction_strategy_strs[] = {
+	"tiered", "leveled", "time_window"
+};
+
 const struct index_opts index_opts_default = {
 	/* .unique              = */ true,
 	/* .dimension           = */ 2,
@@ -47,6 +51,10 @@ const struct index_opts index_opts_default = {
 	/* .run_count_per_level = */ 2,
 	/* .run_size_ratio      = */ 3.5,
 	/* .bloom_fpr           = */ 0.05,
+	/* .compaction_strategy = */ COMPACTION_STRATEGY_TIERED,
+	/* .compaction_window   = */ 86400,
+	/* .is_covering         = */ false,
+	/* .blob_threshold      = */ 0,
 	/* .lsn                 = */ 0,
 	/* .stat                = */ NULL,
 };
@@ -61,6 +69,12 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("run_count_per_level", OPT_INT64, struct index_opts, run_count_per_level),
 	OPT_DEF("run_size_ratio", OPT_FLOAT, struct index_opts, run_size_ratio),
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
+	OPT_DEF_ENUM("compaction_strategy", compaction_strategy,
+		     struct index_opts, compaction_strategy, NULL),
+	OPT_DEF("compaction_window", OPT_FLOAT, struct index_opts,
+		compaction_window),
+	OPT_DEF("covering", OPT_BOOL, struct index_opts, is_covering),
+	OPT_DEF("blob_threshold", OPT_INT64, struct index_opts, blob_threshold),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_END,
 };
@@ -58,6 +58,30 @@ enum rtree_index_distance_type {
 };
 extern const char *rtree_index_distance_type_strs[];
 
+/** Vinyl compaction strategy. */
+enum compaction_strategy {
+	/**
+	 * Size-tiered: merge runs of similar size, keeping up to
+	 * run_count_per_level runs per level. Low write
+	 * amplification at the cost of read and space.
+	 */
+	COMPACTION_STRATEGY_TIERED,
+	/**
+	 * Leveled: keep one run per level, merge a level into
+	 * the next one when it outgrows run_size_ratio of it.
+	 * Low read and space amplification at the cost of write.
+	 */
+	COMPACTION_STRATEGY_LEVELED,
+	/**
+	 * Time window: compact only runs dumped within the same
+	 * compaction_window, never merging older windows into
+	 * newer ones. Suits append-mostly time series.
+	 */
+	COMPACTION_STRATEGY_TIME_WINDOW,
+	compaction_strategy_MAX
+};
+extern const char *compaction_strategy_strs[];
+
 /** Simple alias to represent logarithm metrics. */
 typedef int16_t log_est_t;
 
@@ -153,6 +177,30 @@ struct index_opts {
 	double run_size_ratio;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/**
+	 * Vinyl only. Policy used to decide which runs of
+	 * a range to compact.
+	 */
+	enum compaction_strategy compaction_strategy;
+	/**
+	 * Vinyl only. Width of a time window, in seconds, used
+	 * by the time window compaction strategy.
+	 */
+	double compaction_window;
+	/**
+	 * Vinyl only. If set, a secondary index stores full
+	 * tuples rather than key parts only, so reads from it
+	 * don't need to look up the primary index.
+	 */
+	bool is_covering;
+	/**
+	 * Vinyl only. Values of tuples stored in a primary or
+	 * a covering index that are at least this many bytes
+	 * long are written to separate blob files on dump and
+	 * compaction, while runs store references to them.
+	 * 0 disables key-value separation.
+	 */
+	int64_t blob_threshold;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -207,6 +255,15 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->compaction_strategy != o2->compaction_strategy)
+		return o1->compaction_strategy < o2->compaction_strategy ?
+		       -1 : 1;
+	if (o1->compaction_window != o2->compaction_window)
+		return o1->compaction_window < o2->compaction_window ? -1 : 1;
+	if (o1->is_covering != o2->is_covering)
+		return o1->is_covering < o2->is_covering ? -1 : 1;
+	if (o1->blob_threshold != o2->blob_threshold)
+		return o1->blob_threshold < o2->blob_threshold ? -1 : 1;
 	return 0;
 }
 
@@ -51,11 +51,13 @@
 
 #include "port.h"
 #include "box.h"
+#include "tuple.h"
 #include "call.h"
 #include "tuple_convert.h"
 #include "session.h"
 #include "xrow.h"
 #include "schema.h" /* schema_version */
+#include "space.h"
 #include "replication.h" /* instance_uuid */
 #include "iproto_constants.h"
 #include "rmean.h"
@@ -65,6 +67,14 @@
 enum {
 	IPROTO_SALT_SIZE = 32,
 	IPROTO_PACKET_SIZE_MAX = 2UL * 1024 * 1024 * 1024,
+	/**
+	 * Select result sets are copied to the output buffer
+	 * up to this size. The rest of a big result set is
+	 * written to the socket right from tuple memory.
+	 */
+	IPROTO_SELECT_COPY_MAX = 64 * 1024,
+	/** Max number of tuples written by one writev(). */
+	IPROTO_TAIL_IOV_MAX = 64,
 };
 
 /**
@@ -178,6 +188,8 @@ struct iproto_msg
 		struct auth_request auth;
 		/* SQL request, if this is the EXECUTE request. */
 		struct sql_request sql;
+		/** DML requests, if this is the BATCH request. */
+		struct batch_request batch;
 		/** In case of iproto parse error, saved diagnostics. */
 		struct diag diag;
 	};
@@ -213,6 +225,23 @@ struct iproto_msg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/**
+	 * Tuples of a select result set which did not fit in
+	 * IPROTO_SELECT_COPY_MAX. They follow the data written
+	 * by the message to the output buffer and are sent to
+	 * the socket right from tuple memory by the iproto
+	 * thread. The tuples are referenced until the message
+	 * brings the tail back to tx thread.
+	 */
+	struct port tail;
+	/** Size of the tail data, 0 if there is no tail. */
+	size_t tail_size;
+	/** The first tuple of the tail not sent yet. */
+	struct port_tuple_entry *tail_pos;
+	/** How much of tail_pos tuple has been sent already. */
+	size_t tail_offset;
+	/** Link in iproto_connection::tail_queue. */
+	struct stailq_entry in_tail_queue;
 };
 
 static struct mempool iproto_msg_pool;
@@ -313,6 +342,18 @@ static const struct cmsg_hop push_route[] = {
 	{ tx_end_push, NULL }
 };
 
+/** Unreference select tail tuples once they are sent. */
+static void
+tx_release_tail(struct cmsg *m);
+
+static void
+net_release_tail(struct cmsg *m);
+
+static const struct cmsg_hop release_tail_route[] = {
+	{ tx_release_tail, &net_pipe },
+	{ net_release_tail, NULL },
+};
+
 
 /* }}} */
 
@@ -455,6 +496,12 @@ struct iproto_connection
 	 *                          ...
 	 */
 	struct iproto_kharon kharon;
+	/**
+	 * Messages with select tails (see iproto_msg::tail)
+	 * which have not been written to the socket yet, in
+	 * the order of their output buffer positions.
+	 */
+	struct stailq tail_queue;
 	/**
 	 * The following fields are used exclusively by the tx thread.
 	 * Align them to prevent false-sharing.
@@ -505,9 +552,22 @@ iproto_msg_new(struct iproto_connection *con)
 		return NULL;
 	}
 	msg->connection = con;
+	msg->tail_size = 0;
 	return msg;
 }
 
+/**
+ * Send a message with a select tail back to tx thread to
+ * unreference the tail tuples. The message is deleted when
+ * it returns.
+ */
+static inline void
+iproto_msg_release_tail(struct iproto_msg *msg)
+{
+	cmsg_init(&msg->base, release_tail_route);
+	cpipe_push(&tx_pipe, &msg->base);
+}
+
 /**
  * A connection is idle when the client is gone
  * and there are no outstanding msgs in the msg queue.
@@ -587,6 +647,14 @@ iproto_connection_close(struct iproto_connection *con)
 		 */
 		con->p_ibuf->wpos -= con->parse_size;
 		cpipe_push(&tx_pipe, &con->disconnect_msg);
+		/* Select tails will never be sent. */
+		while (! stailq_empty(&con->tail_queue)) {
+			struct iproto_msg *msg =
+				stailq_shift_entry(&con->tail_queue,
+						   struct iproto_msg,
+						   in_tail_queue);
+			iproto_msg_release_tail(msg);
+		}
 	}
 	/*
 	 * If the connection has no outstanding requests in the
@@ -913,6 +981,51 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	}
 }
 
+/**
+ * writev() a select tail right from tuple memory.
+ * @retval 0 All the tail or its next portion has been written.
+ * @retval -1 The socket is not ready.
+ */
+static int
+iproto_flush_tail(struct iproto_connection *con, struct iproto_msg *msg)
+{
+	struct iovec iov[IPROTO_TAIL_IOV_MAX];
+	int iovcnt = 0;
+	size_t size = 0;
+	size_t offset = msg->tail_offset;
+	struct port_tuple_entry *pe;
+	for (pe = msg->tail_pos; pe != NULL && iovcnt < IPROTO_TAIL_IOV_MAX;
+	     pe = pe->next) {
+		uint32_t bsize;
+		const char *data = tuple_data_range(pe->tuple, &bsize);
+		iov[iovcnt].iov_base = (char *) data + offset;
+		iov[iovcnt].iov_len = bsize - offset;
+		size += bsize - offset;
+		offset = 0;
+		iovcnt++;
+	}
+	ssize_t nwr = sio_writev(con->output.fd, iov, iovcnt);
+	if (nwr < 0) {
+		if (! sio_wouldblock(errno))
+			diag_raise();
+		return -1;
+	}
+	/* Count statistics */
+	rmean_collect(rmean_net, IPROTO_SENT, nwr);
+	size_t iov_offset = 0;
+	int advance = sio_move_iov(iov, nwr, &iov_offset);
+	msg->tail_offset = advance == 0 ? msg->tail_offset + iov_offset :
+			   iov_offset;
+	while (advance-- > 0)
+		msg->tail_pos = msg->tail_pos->next;
+	if (msg->tail_pos == NULL) {
+		stailq_shift(&con->tail_queue);
+		iproto_msg_release_tail(msg);
+		return 0;
+	}
+	return (size_t) nwr == size ? 0 : -1;
+}
+
 /** writev() to the socket and handle the result. */
 
 static int
@@ -923,7 +1036,19 @@ iproto_flush(struct iproto_connection *con)
 	struct obuf_svp obuf_end = obuf_create_svp(obuf);
 	struct obuf_svp *begin = &con->wpos.svp;
 	struct obuf_svp *end = &con->wend.svp;
-	if (con->wend.obuf != obuf) {
+	struct iproto_msg *tail = stailq_empty(&con->tail_queue) ? NULL :
+		stailq_first_entry(&con->tail_queue, struct iproto_msg,
+				   in_tail_queue);
+	if (tail != NULL && tail->wpos.obuf == obuf) {
+		/*
+		 * A select tail goes right after the data its
+		 * message has written to the buffer. Flush the
+		 * buffer up to the tail, then the tail itself.
+		 */
+		if (begin->used == tail->wpos.svp.used)
+			return iproto_flush_tail(con, tail);
+		end = &tail->wpos.svp;
+	} else if (con->wend.obuf != obuf) {
 		/*
 		 * Flush the current buffer before
 		 * advancing to the next one.
@@ -1031,6 +1156,7 @@ iproto_connection_new(int fd)
 	con->is_destroy_sent = false;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
+	stailq_create(&con->tail_queue);
 	return con;
 }
 
@@ -1074,6 +1200,9 @@ tx_process_select(struct cmsg *msg);
 static void
 tx_process_sql(struct cmsg *msg);
 
+static void
+tx_process_batch(struct cmsg *msg);
+
 static void
 tx_reply_error(struct iproto_msg *msg);
 
@@ -1120,6 +1249,11 @@ static const struct cmsg_hop sql_route[] = {
 	{ net_send_msg, NULL },
 };
 
+static const struct cmsg_hop batch_route[] = {
+	{ tx_process_batch, &net_pipe },
+	{ net_send_msg, NULL },
+};
+
 static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
 	NULL,                                   /* IPROTO_OK */
 	select_route,                           /* IPROTO_SELECT */
@@ -1134,6 +1268,7 @@ static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
 	call_route,                             /* IPROTO_CALL */
 	sql_route,                              /* IPROTO_EXECUTE */
 	NULL,                                   /* IPROTO_NOP */
+	NULL,                                   /* IPROTO_BATCH */
 };
 
 static const struct cmsg_hop join_route[] = {
@@ -1193,6 +1328,11 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 			goto error;
 		cmsg_init(&msg->base, sql_route);
 		break;
+	case IPROTO_BATCH:
+		if (xrow_decode_batch(&msg->header, &msg->batch) != 0)
+			goto error;
+		cmsg_init(&msg->base, batch_route);
+		break;
 	case IPROTO_PING:
 		cmsg_init(&msg->base, misc_route);
 		break;
@@ -1441,13 +1581,71 @@ error:
 	tx_reply_error(msg);
 }
 
+/** Size of the tuple data referenced in a select tail. */
+static size_t
+iproto_tail_size(struct port *tail)
+{
+	size_t size = 0;
+	struct port_tuple_entry *pe;
+	for (pe = port_tuple(tail)->first; pe != NULL; pe = pe->next)
+		size += pe->tuple->bsize;
+	return size;
+}
+
+/**
+ * Complete a select reply which result set may end with
+ * tuples referenced in msg->tail, @a tail_size bytes total.
+ * A non-empty tail is not copied to the output buffer but
+ * sent by the iproto thread right from tuple memory, see
+ * iproto_flush_tail().
+ */
+static void
+tx_reply_select(struct iproto_msg *msg, struct obuf *out,
+		struct obuf_svp *svp, uint32_t count, size_t tail_size)
+{
+	msg->tail_size = tail_size;
+	if (tail_size == 0)
+		port_destroy(&msg->tail);
+	iproto_reply_select_with_tail(out, svp, msg->header.sync,
+				      ::schema_version, count,
+				      msg->tail_size);
+	iproto_wpos_create(&msg->wpos, out);
+}
+
+/**
+ * Fast path of SELECT from a memtx space: tuples are written
+ * straight into the connection output buffer, since nothing
+ * can yield and interleave with the reply being constructed.
+ */
+static int
+tx_process_select_inplace(struct iproto_msg *msg, struct obuf *out)
+{
+	struct request *req = &msg->dml;
+	struct obuf_svp svp;
+	if (iproto_prepare_select(out, &svp) != 0)
+		return -1;
+	int count = box_select_to_obuf(req->space_id, req->index_id,
+				       req->iterator, req->offset, req->limit,
+				       req->key, req->key_end, out,
+				       IPROTO_SELECT_COPY_MAX, &msg->tail);
+	if (count < 0) {
+		/* Discard the prepared select. */
+		obuf_rollback_to_svp(out, &svp);
+		return -1;
+	}
+	tx_reply_select(msg, out, &svp, count,
+			iproto_tail_size(&msg->tail));
+	return 0;
+}
+
 static void
 tx_process_select(struct cmsg *m)
 {
 	struct iproto_msg *msg = tx_accept_msg(m);
 	struct obuf *out;
 	struct obuf_svp svp;
-	struct port port;
+	struct space *space;
+	size_t tail_size;
 	int count;
 	int rc;
 	struct request *req = &msg->dml;
@@ -1455,29 +1653,142 @@ tx_process_select(struct cmsg *m)
 		goto error;
 
 	tx_inject_delay();
+	space = space_by_id(req->space_id);
+	if (space != NULL && space_is_memtx(space)) {
+		out = msg->connection->tx.p_obuf;
+		if (tx_process_select_inplace(msg, out) != 0)
+			goto error;
+		return;
+	}
 	rc = box_select(req->space_id, req->index_id,
 			req->iterator, req->offset, req->limit,
-			req->key, req->key_end, &port);
+			req->key, req->key_end, &msg->tail);
 	if (rc < 0)
 		goto error;
 
 	out = msg->connection->tx.p_obuf;
 	if (iproto_prepare_select(out, &svp) != 0) {
-		port_destroy(&port);
+		port_destroy(&msg->tail);
 		goto error;
 	}
+	tail_size = iproto_tail_size(&msg->tail);
+	if (tail_size > IPROTO_SELECT_COPY_MAX) {
+		/* The whole result set is sent as a tail. */
+		count = port_tuple(&msg->tail)->size;
+	} else {
+		/*
+		 * SELECT output format has not changed since
+		 * Tarantool 1.6
+		 */
+		count = port_dump_msgpack_16(&msg->tail, out);
+		port_destroy(&msg->tail);
+		if (count < 0) {
+			/* Discard the prepared select. */
+			obuf_rollback_to_svp(out, &svp);
+			goto error;
+		}
+		port_tuple_create(&msg->tail);
+		tail_size = 0;
+	}
+	tx_reply_select(msg, out, &svp, count, tail_size);
+	return;
+error:
+	tx_reply_error(msg);
+}
+
+/**
+ * Deliver a SELECT from a memtx space right in the tx cbus
+ * endpoint callback, see fiber_pool_set_direct_f(). Memtx
+ * never yields on read, so a worker fiber is of no use here.
+ * Other requests and engines are left to the fiber pool.
+ */
+bool
+iproto_tx_deliver_direct(struct cmsg *m)
+{
+	if (m->hop->f != tx_process_select)
+		return false;
+	/* The injected delay yields. */
+	ERROR_INJECT(ERRINJ_IPROTO_TX_DELAY, return false);
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct space *space = space_by_id(msg->dml.space_id);
+	if (space == NULL || !space_is_memtx(space))
+		return false;
+	struct iproto_connection *con = msg->connection;
+	tx_accept_wpos(con, &msg->wpos);
 	/*
-	 * SELECT output format has not changed since Tarantool 1.6
+	 * Check access on behalf of the connection user, then
+	 * restore the scheduler fiber credentials so that they
+	 * don't leak to other event loop callbacks.
 	 */
-	count = port_dump_msgpack_16(&port, out);
-	port_destroy(&port);
-	if (count < 0) {
-		/* Discard the prepared select. */
-		obuf_rollback_to_svp(out, &svp);
+	struct fiber *f = fiber();
+	struct session *prev_session = f->storage.session;
+	struct credentials *prev_user = f->storage.credentials;
+	fiber_set_session(f, con->session);
+	fiber_set_user(f, &con->session->credentials);
+	if (tx_check_schema(msg->header.schema_version) != 0 ||
+	    tx_process_select_inplace(msg, con->tx.p_obuf) != 0)
+		tx_reply_error(msg);
+	fiber_set_session(f, prev_session);
+	fiber_set_user(f, prev_user);
+	return true;
+}
+
+/**
+ * Encode results of a BATCH request: a tuple or nil for each
+ * batched request.
+ */
+static int
+tx_dump_batch_results(struct tuple **results, uint32_t count,
+		      struct obuf *out)
+{
+	static const char nil = (char) 0xc0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (results[i] != NULL) {
+			if (tuple_to_obuf(results[i], out) != 0)
+				return -1;
+		} else if (obuf_dup(out, &nil, sizeof(nil)) != sizeof(nil)) {
+			diag_set(OutOfMemory, sizeof(nil), "obuf_dup", "nil");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void
+tx_process_batch(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct batch_request *batch = &msg->batch;
+	struct tuple **results;
+	struct obuf *out;
+	struct obuf_svp svp;
+	int rc;
+	if (tx_check_schema(msg->header.schema_version))
 		goto error;
+
+	tx_inject_delay();
+	if (box_process_batch(batch, &results) != 0)
+		goto error;
+
+	out = msg->connection->tx.p_obuf;
+	rc = iproto_prepare_select(out, &svp);
+	if (rc == 0) {
+		rc = tx_dump_batch_results(results, batch->request_count,
+					   out);
+		if (rc != 0) {
+			/* Discard the prepared select. */
+			obuf_rollback_to_svp(out, &svp);
+		}
 	}
-	iproto_reply_select(out, &svp, msg->header.sync,
-			    ::schema_version, count);
+	for (uint32_t i = 0; i < batch->request_count; i++) {
+		if (results[i] != NULL)
+			tuple_unref(results[i]);
+	}
+	free(results);
+	if (rc != 0)
+		goto error;
+	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
+			    batch->request_count);
 	iproto_wpos_create(&msg->wpos, out);
 	return;
 error:
@@ -1712,13 +2023,39 @@ net_send_msg(struct cmsg *m)
 	}
 	con->wend = msg->wpos;
 
+	if (msg->tail_size != 0) {
+		/* The message is deleted when the tail is sent. */
+		if (evio_has_fd(&con->output)) {
+			msg->tail_pos = port_tuple(&msg->tail)->first;
+			msg->tail_offset = 0;
+			stailq_add_tail_entry(&con->tail_queue, msg,
+					      in_tail_queue);
+		} else {
+			iproto_msg_release_tail(msg);
+		}
+		msg = NULL;
+	}
 	if (evio_has_fd(&con->output)) {
 		if (! ev_is_active(&con->output))
 			ev_feed_event(con->loop, &con->output, EV_WRITE);
 	} else if (iproto_connection_is_idle(con)) {
 		iproto_connection_close(con);
 	}
-	iproto_msg_delete(msg);
+	if (msg != NULL)
+		iproto_msg_delete(msg);
+}
+
+static void
+tx_release_tail(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	port_destroy(&msg->tail);
+}
+
+static void
+net_release_tail(struct cmsg *m)
+{
+	iproto_msg_delete((struct iproto_msg *) m);
 }
 
 /**
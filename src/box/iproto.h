@@ -71,6 +71,8 @@ iproto_reset_stat(void);
 #if defined(__cplusplus)
 } /* extern "C" */
 
+struct cmsg;
+
 void
 iproto_init();
 
@@ -83,6 +85,13 @@ iproto_set_msg_max(int iproto_msg_max);
 void
 iproto_free();
 
+/**
+ * Deliver a request in the tx endpoint callback if it doesn't
+ * need a fiber, see fiber_pool_set_direct_f().
+ */
+bool
+iproto_tx_deliver_direct(struct cmsg *msg);
+
 #endif /* defined(__cplusplus) */
 
 #endif
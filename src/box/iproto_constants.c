@@ -89,6 +89,9 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 	/* 0x29 */	MP_MAP, /* IPROTO_BALLOT */
 	/* 0x2a */	MP_MAP, /* IPROTO_TUPLE_META */
 	/* 0x2b */	MP_MAP, /* IPROTO_OPTIONS */
+	/* 0x2c */	MP_ARRAY, /* IPROTO_REQUESTS */
+	/* 0x2d */	MP_UINT, /* IPROTO_COMPRESSION */
+	/* 0x2e */	MP_BOOL, /* IPROTO_JOIN_FILES */
 	/* }}} */
 };
 
@@ -107,6 +110,7 @@ const char *iproto_type_strs[] =
 	"CALL",
 	"EXECUTE",
 	NULL, /* NOP */
+	"BATCH",
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
@@ -124,6 +128,7 @@ const uint64_t iproto_body_key_map[IPROTO_TYPE_STAT_MAX] = {
 	0,                                                     /* CALL */
 	0,                                                     /* EXECUTE */
 	0,                                                     /* NOP */
+	bit(REQUESTS),                                         /* BATCH */
 };
 #undef bit
 
@@ -172,15 +177,15 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"ballot",           /* 0x29 */
 	"tuple meta",       /* 0x2a */
 	"options",          /* 0x2b */
-	NULL,               /* 0x2c */
-	NULL,               /* 0x2d */
-	NULL,               /* 0x2e */
+	"requests",         /* 0x2c */
+	"compression",      /* 0x2d */
+	"join files",       /* 0x2e */
 	NULL,               /* 0x2f */
 	"data",             /* 0x30 */
 	"error",            /* 0x31 */
 	"metadata",         /* 0x32 */
-	NULL,               /* 0x33 */
-	NULL,               /* 0x34 */
+	"file name",        /* 0x33 */
+	"file size",        /* 0x34 */
 	NULL,               /* 0x35 */
 	NULL,               /* 0x36 */
 	NULL,               /* 0x37 */
@@ -217,9 +222,18 @@ const char *vy_run_info_key_strs[VY_RUN_INFO_KEY_MAX] = {
 	"bloom filter legacy",
 	"bloom filter",
 	"stmt stat",
+	"blobs",
+	"dump time",
+	"page index",
 };
 
 const char *vy_row_index_key_strs[VY_ROW_INDEX_KEY_MAX] = {
 	NULL,
 	"row index",
 };
+
+const char *memtx_snap_info_key_strs[MEMTX_SNAP_INFO_KEY_MAX] = {
+	NULL,
+	"base spaces",
+	"chunk count",
+};
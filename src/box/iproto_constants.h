@@ -98,6 +98,21 @@ enum iproto_key {
 	IPROTO_BALLOT = 0x29,
 	IPROTO_TUPLE_META = 0x2a,
 	IPROTO_OPTIONS = 0x2b,
+	/**
+	 * IPROTO_REQUESTS: [
+	 *      [ request type, { request body } ],
+	 *      ...
+	 * ]
+	 */
+	IPROTO_REQUESTS = 0x2c,
+	/** Replication stream compression level (SUBSCRIBE). */
+	IPROTO_COMPRESSION = 0x2d,
+	/**
+	 * Set in JOIN if the replica wants to receive checkpoint
+	 * files rather than rows, and in the response to it if the
+	 * master agreed to send them.
+	 */
+	IPROTO_JOIN_FILES = 0x2e,
 
 	/* Leave a gap between request keys and response keys */
 	IPROTO_DATA = 0x30,
@@ -110,6 +125,9 @@ enum iproto_key {
 	 * ]
 	 */
 	IPROTO_METADATA = 0x32,
+	/** Name and size of a checkpoint file sent on JOIN. */
+	IPROTO_FILE_NAME = 0x33,
+	IPROTO_FILE_SIZE = 0x34,
 
 	/* Leave a gap between response keys and SQL keys. */
 	IPROTO_SQL_TEXT = 0x40,
@@ -202,6 +220,8 @@ enum iproto_type {
 	IPROTO_EXECUTE = 11,
 	/** No operation. Treated as DML, used to bump LSN. */
 	IPROTO_NOP = 12,
+	/** A batch of DML requests executed in one transaction. */
+	IPROTO_BATCH = 13,
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
@@ -215,6 +235,18 @@ enum iproto_type {
 	IPROTO_VOTE_DEPRECATED = 67,
 	/** Vote request command for master election */
 	IPROTO_VOTE = 68,
+	/**
+	 * A frame of replication rows compressed with zstd,
+	 * stored as MP_BIN in IPROTO_DATA. Frames are parts of
+	 * a single zstd stream started on SUBSCRIBE, each one
+	 * flushed so that it unpacks into whole rows.
+	 */
+	IPROTO_COMPRESSED_ROWS = 69,
+	/**
+	 * A checkpoint file sent on JOIN. The row is followed
+	 * by IPROTO_FILE_SIZE bytes of raw file content.
+	 */
+	IPROTO_JOIN_FILE = 70,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -222,6 +254,11 @@ enum iproto_type {
 	VY_INDEX_PAGE_INFO = 101,
 	/** Vinyl row index stored in .run file */
 	VY_RUN_ROW_INDEX = 102,
+	/** Vinyl page index partition bloom filter stored in .run file */
+	VY_RUN_BLOOM = 103,
+
+	/** Memtx snapshot info stored in .snap file */
+	MEMTX_SNAP_INFO = 110,
 
 	/** Non-final response type. */
 	IPROTO_CHUNK = 128,
@@ -253,12 +290,20 @@ iproto_type_name(uint32_t type)
 		return iproto_type_strs[type];
 
 	switch (type) {
+	case IPROTO_COMPRESSED_ROWS:
+		return "COMPRESSED_ROWS";
+	case IPROTO_JOIN_FILE:
+		return "JOIN_FILE";
 	case VY_INDEX_RUN_INFO:
 		return "RUNINFO";
 	case VY_INDEX_PAGE_INFO:
 		return "PAGEINFO";
 	case VY_RUN_ROW_INDEX:
 		return "ROWINDEX";
+	case VY_RUN_BLOOM:
+		return "BLOOM";
+	case MEMTX_SNAP_INFO:
+		return "SNAPINFO";
 	default:
 		return NULL;
 	}
@@ -364,6 +409,12 @@ enum vy_run_info_key {
 	VY_RUN_INFO_BLOOM = 7,
 	/** Number of statements of each type (map). */
 	VY_RUN_INFO_STMT_STAT = 8,
+	/** Blob files referenced by the run (array). */
+	VY_RUN_INFO_BLOBS = 9,
+	/** Time of the newest dump merged into the run (uint). */
+	VY_RUN_INFO_DUMP_TIME = 10,
+	/** Page index partition directory (array). */
+	VY_RUN_INFO_PAGE_INDEX = 11,
 	/** The last key in this enum + 1 */
 	VY_RUN_INFO_KEY_MAX
 };
@@ -439,6 +490,31 @@ vy_row_index_key_name(enum vy_row_index_key key)
 	return vy_row_index_key_strs[key];
 }
 
+/**
+ * Xrow keys for memtx snapshot information.
+ */
+enum memtx_snap_info_key {
+	/** Spaces a delta snapshot takes from its base (array). */
+	MEMTX_SNAP_INFO_BASE_SPACES = 1,
+	/** Number of chunk files the snapshot is split into. */
+	MEMTX_SNAP_INFO_CHUNK_COUNT = 2,
+	/** The last key in this enum + 1 */
+	MEMTX_SNAP_INFO_KEY_MAX
+};
+
+/**
+ * Return memtx snapshot info key name by @a key code.
+ * @param key key
+ */
+static inline const char *
+memtx_snap_info_key_name(enum memtx_snap_info_key key)
+{
+	if (key <= 0 || key >= MEMTX_SNAP_INFO_KEY_MAX)
+		return NULL;
+	extern const char *memtx_snap_info_key_strs[];
+	return memtx_snap_info_key_strs[key];
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif
@@ -431,6 +431,8 @@ box.schema.space.create = function(name, options)
         format = 'table',
         is_local = 'boolean',
         temporary = 'boolean',
+        memory_quota = 'number',
+        ttl_field = 'number',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -475,6 +477,8 @@ box.schema.space.create = function(name, options)
     local space_options = setmap({
         group_id = options.is_local and 1 or nil,
         temporary = options.temporary and true or nil,
+        memory_quota = options.memory_quota,
+        ttl_field = options.ttl_field,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -761,6 +765,10 @@ local index_options = {
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    covering = 'boolean',
+    blob_threshold = 'number',
+    compaction_strategy = 'string',
+    compaction_window = 'number',
 }
 
 --
@@ -866,6 +874,10 @@ box.schema.index.create = function(space_id, name, options)
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
+            covering = options.covering,
+            blob_threshold = options.blob_threshold,
+            compaction_strategy = options.compaction_strategy,
+            compaction_window = options.compaction_window,
     }
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
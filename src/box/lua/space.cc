@@ -356,6 +356,29 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_pushnumber(L, index_opts->bloom_fpr);
 			lua_setfield(L, -2, "bloom_fpr");
 
+			if (index_opts->compaction_strategy !=
+			    COMPACTION_STRATEGY_TIERED) {
+				lua_pushstring(L, compaction_strategy_strs[
+					index_opts->compaction_strategy]);
+				lua_setfield(L, -2, "compaction_strategy");
+			}
+
+			if (index_opts->compaction_strategy ==
+			    COMPACTION_STRATEGY_TIME_WINDOW) {
+				lua_pushnumber(L, index_opts->compaction_window);
+				lua_setfield(L, -2, "compaction_window");
+			}
+
+			if (index_opts->is_covering) {
+				lua_pushboolean(L, true);
+				lua_setfield(L, -2, "covering");
+			}
+
+			if (index_opts->blob_threshold > 0) {
+				lua_pushnumber(L, index_opts->blob_threshold);
+				lua_setfield(L, -2, "blob_threshold");
+			}
+
 			lua_settable(L, -3);
 		}
 		lua_setfield(L, -2, index_def->name);
@@ -34,8 +34,12 @@
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
+#include <msgpuck/msgpuck.h>
+#include <dirent.h>
 
+#include "assoc.h"
 #include "fiber.h"
+#include "cbus.h"
 #include "errinj.h"
 #include "coio_file.h"
 #include "tuple.h"
@@ -48,6 +52,8 @@
 #include "replication.h"
 #include "schema.h"
 #include "gc.h"
+#include "info.h"
+#include "box.h"
 
 /*
  * Memtx yield-in-transaction trigger: roll back the effects
@@ -185,9 +191,755 @@ memtx_engine_shutdown(struct engine *engine)
 	slab_cache_destroy(&memtx->slab_cache);
 	tuple_arena_destroy(&memtx->arena);
 	xdir_destroy(&memtx->snap_dir);
+	free(memtx->defrag_key);
 	free(memtx);
 }
 
+/**
+ * Format the name of a snapshot file. A snapshot may be split
+ * into chunks written in parallel, chunk 0 is the main file
+ * (<signature>.snap), other chunks are <signature>.<chunk>.snap.
+ */
+static void
+snap_chunk_filename(char *buf, size_t size, const char *dirname,
+		    int64_t signature, uint32_t chunk)
+{
+	if (chunk == 0) {
+		snprintf(buf, size, "%s/%020lld.snap",
+			 dirname, (long long)signature);
+	} else {
+		snprintf(buf, size, "%s/%020lld.%u.snap",
+			 dirname, (long long)signature, (unsigned)chunk);
+	}
+}
+
+/**
+ * Remove chunks of snapshots older than @a signature and, if
+ * @a orphans is set, chunks of snapshots which main file does
+ * not exist. Such chunks are left if the instance stops after
+ * renaming chunks of a snapshot, but before renaming the main
+ * file, or if garbage collection fails to remove them along
+ * with the main file. Chunks aren't indexed by the snapshot
+ * directory, so they are looked up with readdir().
+ */
+static void
+memtx_engine_collect_chunks(struct memtx_engine *memtx, int64_t signature,
+			    bool orphans)
+{
+	const char *dirname = memtx->snap_dir.dirname;
+	DIR *dh = opendir(dirname);
+	if (dh == NULL) {
+		if (errno != ENOENT)
+			say_syserror("error reading directory '%s'", dirname);
+		return;
+	}
+	struct dirent *dent;
+	while ((dent = readdir(dh)) != NULL) {
+		/* <signature>.<chunk>.snap, see snap_chunk_filename(). */
+		char *end;
+		long long chunk_signature = strtoll(dent->d_name, &end, 10);
+		if (end - dent->d_name != 20 || *end != '.')
+			continue;
+		unsigned long chunk = strtoul(end + 1, &end, 10);
+		if (chunk == 0 || strcmp(end, ".snap") != 0)
+			continue;
+		char filename[PATH_MAX];
+		if (chunk_signature >= signature) {
+			if (!orphans)
+				continue;
+			snap_chunk_filename(filename, sizeof(filename),
+					    dirname, chunk_signature, 0);
+			if (access(filename, F_OK) == 0)
+				continue;
+		}
+		snprintf(filename, sizeof(filename), "%s/%s",
+			 dirname, dent->d_name);
+		if (coio_unlink(filename) != 0)
+			say_syserror("error while removing %s", filename);
+		else
+			say_info("removed %s", filename);
+	}
+	closedir(dh);
+}
+
+enum {
+	/** Size of rows a snapshot reader decodes in a batch. */
+	SNAP_BATCH_SIZE = 1024 * 1024,
+	/** Number of batches a snapshot reader may decode ahead. */
+	SNAP_READAHEAD = 4,
+};
+
+struct snap_reader;
+
+/**
+ * A batch of rows decoded by a snapshot reader thread. Row
+ * bodies are copied to the batch, so that the rows stay valid
+ * while the reader goes on with the next batches.
+ */
+struct snap_batch {
+	/** Read request, see snap_batch_post(). */
+	struct cbus_call_msg base;
+	/** The reader the batch belongs to. */
+	struct snap_reader *reader;
+	/** Decoded rows, allocated by the reader thread. */
+	struct xrow_header *rows;
+	/** Number of rows in @rows and its capacity. */
+	uint32_t row_count;
+	uint32_t row_capacity;
+	/** The next row to return from the batch. */
+	uint32_t next_row;
+	/** Bodies of @rows and the size of the buffer. */
+	char *data;
+	size_t data_size;
+	/** Set if the end of the chunk is reached. */
+	bool is_last;
+	/** Link in snap_reader::batches. */
+	struct stailq_entry in_reader;
+};
+
+/**
+ * A thread reading a chunk of a snapshot at recovery. It reads
+ * the file, checks checksums, decompresses and decodes rows,
+ * so that tx only has to apply them, and chunks are read in
+ * parallel.
+ */
+struct snap_reader {
+	/** Thread that decodes batches. */
+	struct cord cord;
+	/** Pipe from tx to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	/** The chunk file. */
+	char filename[PATH_MAX];
+	bool force_recovery;
+	/** Cursor over the chunk, accessed only by the thread. */
+	struct xlog_cursor cursor;
+	/** A row that didn't fit in the previous batch. */
+	struct xrow_header row;
+	bool row_is_pending;
+	/** Set by the thread once the chunk is read up to the end. */
+	bool is_done;
+	/** Set if the chunk ends with an EOF marker. */
+	bool is_eof;
+	/** Batches posted to the thread, in order. */
+	struct stailq batches;
+	struct snap_batch batch_pool[SNAP_READAHEAD];
+};
+
+/**
+ * Read the next batch of rows of a chunk.
+ * Called in the reader thread.
+ */
+static int
+snap_batch_read(struct cbus_call_msg *base)
+{
+	struct snap_batch *batch = (struct snap_batch *)base;
+	struct snap_reader *reader = batch->reader;
+	batch->row_count = 0;
+	batch->next_row = 0;
+	batch->is_last = reader->is_done;
+	if (reader->is_done)
+		return 0;
+	if (reader->cursor.state == XLOG_CURSOR_NEW &&
+	    xlog_cursor_open(&reader->cursor, reader->filename) < 0)
+		return -1;
+	size_t used = 0;
+	while (true) {
+		struct xrow_header *row = &reader->row;
+		if (!reader->row_is_pending) {
+			int rc = xlog_cursor_next(&reader->cursor, row,
+						  reader->force_recovery);
+			if (rc < 0)
+				return -1;
+			if (rc > 0) {
+				reader->is_done = true;
+				reader->is_eof = xlog_cursor_is_eof(
+							&reader->cursor);
+				batch->is_last = true;
+				return 0;
+			}
+			reader->row_is_pending = true;
+		}
+		assert(row->bodycnt <= 1);
+		size_t len = row->bodycnt > 0 ? row->body[0].iov_len : 0;
+		if (used + len > batch->data_size) {
+			if (batch->row_count > 0)
+				return 0;
+			/* A row doesn't fit in an empty batch. */
+			char *data = realloc(batch->data, len);
+			if (data == NULL) {
+				diag_set(OutOfMemory, len, "realloc",
+					 "snapshot batch");
+				return -1;
+			}
+			batch->data = data;
+			batch->data_size = len;
+		}
+		if (batch->row_count == batch->row_capacity) {
+			uint32_t capacity = MAX(batch->row_capacity * 2, 1024);
+			struct xrow_header *rows = realloc(batch->rows,
+						capacity * sizeof(*rows));
+			if (rows == NULL) {
+				diag_set(OutOfMemory, capacity * sizeof(*rows),
+					 "realloc", "snapshot batch rows");
+				return -1;
+			}
+			batch->rows = rows;
+			batch->row_capacity = capacity;
+		}
+		struct xrow_header *dst = &batch->rows[batch->row_count++];
+		*dst = *row;
+		if (row->bodycnt > 0) {
+			memcpy(batch->data + used, row->body[0].iov_base, len);
+			dst->body[0].iov_base = batch->data + used;
+			used += len;
+		}
+		reader->row_is_pending = false;
+	}
+}
+
+/** Batch read request callback, executed by a reader thread. */
+static void
+snap_batch_perform(struct cmsg *m)
+{
+	struct cbus_call_msg *msg = (struct cbus_call_msg *)m;
+	msg->rc = msg->func(msg);
+	if (msg->rc != 0)
+		diag_move(&fiber()->diag, &msg->diag);
+}
+
+/** Batch read completion callback, executed in tx. */
+static void
+snap_batch_done(struct cmsg *m)
+{
+	struct cbus_call_msg *msg = (struct cbus_call_msg *)m;
+	msg->complete = true;
+	if (msg->caller != NULL)
+		fiber_wakeup(msg->caller);
+}
+
+/** Post a batch to the reader thread, doesn't wait. */
+static void
+snap_batch_post(struct snap_batch *batch)
+{
+	struct snap_reader *reader = batch->reader;
+	struct cbus_call_msg *msg = &batch->base;
+	msg->caller = NULL;
+	msg->complete = false;
+	msg->rc = 0;
+	msg->func = snap_batch_read;
+	msg->free_cb = NULL;
+	msg->route[0].f = snap_batch_perform;
+	msg->route[0].pipe = &reader->tx_pipe;
+	msg->route[1].f = snap_batch_done;
+	msg->route[1].pipe = NULL;
+	cmsg_init(cmsg(msg), msg->route);
+	stailq_add_tail_entry(&reader->batches, batch, in_reader);
+	cpipe_push(&reader->reader_pipe, cmsg(msg));
+}
+
+/** Wait for a batch posted to the reader thread. */
+static void
+snap_batch_wait(struct snap_batch *batch)
+{
+	struct cbus_call_msg *msg = &batch->base;
+	while (!msg->complete) {
+		msg->caller = fiber();
+		fiber_yield();
+		msg->caller = NULL;
+	}
+}
+
+/** Snapshot reader thread function. */
+static int
+snap_reader_f(va_list ap)
+{
+	struct snap_reader *reader = va_arg(ap, struct snap_reader *);
+	struct cbus_endpoint endpoint;
+
+	cpipe_create(&reader->tx_pipe, "tx_prio");
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&reader->tx_pipe);
+	if (xlog_cursor_is_open(&reader->cursor))
+		xlog_cursor_close(&reader->cursor, false);
+	return 0;
+}
+
+/**
+ * Start a thread reading chunk @a chunk of a snapshot and post
+ * all the batches of the reader to it.
+ */
+static int
+snap_reader_start(struct snap_reader *reader, const char *dirname,
+		  int64_t signature, uint32_t chunk, bool force_recovery)
+{
+	memset(reader, 0, sizeof(*reader));
+	snap_chunk_filename(reader->filename, sizeof(reader->filename),
+			    dirname, signature, chunk);
+	reader->force_recovery = force_recovery;
+	stailq_create(&reader->batches);
+	for (int i = 0; i < SNAP_READAHEAD; i++) {
+		struct snap_batch *batch = &reader->batch_pool[i];
+		batch->reader = reader;
+		diag_create(&batch->base.diag);
+	}
+	for (int i = 0; i < SNAP_READAHEAD; i++) {
+		struct snap_batch *batch = &reader->batch_pool[i];
+		batch->data_size = SNAP_BATCH_SIZE;
+		batch->data = malloc(batch->data_size);
+		if (batch->data == NULL) {
+			diag_set(OutOfMemory, batch->data_size,
+				 "malloc", "snapshot batch");
+			goto fail;
+		}
+	}
+	char name[FIBER_NAME_MAX];
+	snprintf(name, sizeof(name), "snap_reader_%p", reader);
+	if (cord_costart(&reader->cord, name, snap_reader_f, reader) != 0)
+		goto fail;
+	cpipe_create(&reader->reader_pipe, name);
+	for (int i = 0; i < SNAP_READAHEAD; i++)
+		snap_batch_post(&reader->batch_pool[i]);
+	return 0;
+fail:
+	for (int i = 0; i < SNAP_READAHEAD; i++) {
+		free(reader->batch_pool[i].data);
+		diag_destroy(&reader->batch_pool[i].base.diag);
+	}
+	return -1;
+}
+
+/** Wait for the batches being read and stop the reader thread. */
+static void
+snap_reader_stop(struct snap_reader *reader)
+{
+	struct snap_batch *batch;
+	stailq_foreach_entry(batch, &reader->batches, in_reader)
+		snap_batch_wait(batch);
+	cbus_stop_loop(&reader->reader_pipe);
+	cpipe_destroy(&reader->reader_pipe);
+	cord_cojoin(&reader->cord);
+	for (int i = 0; i < SNAP_READAHEAD; i++) {
+		batch = &reader->batch_pool[i];
+		free(batch->rows);
+		free(batch->data);
+		diag_destroy(&batch->base.diag);
+	}
+}
+
+/** A snapshot read by snap_cursor, possibly split into chunks. */
+struct snap_source {
+	/** Cursor over the current chunk file. */
+	struct xlog_cursor cursor;
+	/** The next row of the snapshot, unless @need_read is set. */
+	struct xrow_header row;
+	/** Id of the space of @row, UINT32_MAX at EOF. */
+	uint32_t space_id;
+	/** Set if @row was consumed and a new one must be read. */
+	bool need_read;
+	/** Set if @row was read, but not returned yet. */
+	bool row_is_pending;
+	/** The snapshot directory and signature, to open chunks. */
+	const char *dirname;
+	int64_t signature;
+	/** The chunk being read and the total number of chunks. */
+	uint32_t chunk;
+	uint32_t chunk_count;
+	/**
+	 * Readers of the chunks, one per chunk, if the snapshot
+	 * is read in threads, NULL otherwise. @cursor is only
+	 * used to read the snapshot meta and info then.
+	 */
+	struct snap_reader *readers;
+	/** The batch rows are taken from, if any. */
+	struct snap_batch *batch;
+};
+
+/**
+ * Cursor over the rows of a memtx checkpoint. If the checkpoint
+ * is a delta snapshot, rows of the spaces which didn't change
+ * since the base snapshot are read from the base and merged
+ * with rows of the delta so that system spaces still go in the
+ * order of their ids, as recovery of the data dictionary needs.
+ */
+struct snap_cursor {
+	/** The snapshot of the checkpoint. */
+	struct snap_source snap;
+	/** The base snapshot, used only if @is_delta is set. */
+	struct snap_source base;
+	/** Set if the checkpoint is a delta snapshot. */
+	bool is_delta;
+	/** Ids of the spaces to read from the base snapshot. */
+	struct mh_i32ptr_t *base_spaces;
+};
+
+static int
+snap_row_space_id(struct xrow_header *row, uint32_t *space_id)
+{
+	if (row->type != IPROTO_INSERT) {
+		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+			 (uint32_t) row->type);
+		return -1;
+	}
+	struct request request;
+	if (xrow_decode_dml(row, &request, dml_request_key_map(row->type)) != 0)
+		return -1;
+	*space_id = request.space_id;
+	return 0;
+}
+
+/**
+ * Decode the MEMTX_SNAP_INFO row written by checkpoint_f().
+ * Ids of the spaces to take from the base are stored in
+ * @base_spaces, if it is set.
+ */
+static int
+snap_source_decode_info(struct snap_source *source,
+			struct mh_i32ptr_t *base_spaces)
+{
+	const char *data = source->row.body[0].iov_base;
+	if (mp_typeof(*data) != MP_MAP)
+		goto error;
+	uint32_t map_size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*data) != MP_UINT)
+			goto error;
+		switch (mp_decode_uint(&data)) {
+		case MEMTX_SNAP_INFO_BASE_SPACES:
+			if (mp_typeof(*data) != MP_ARRAY)
+				goto error;
+			uint32_t count = mp_decode_array(&data);
+			for (uint32_t j = 0; j < count; j++) {
+				if (mp_typeof(*data) != MP_UINT)
+					goto error;
+				struct mh_i32ptr_t *h = base_spaces;
+				struct mh_i32ptr_node_t node;
+				node.key = mp_decode_uint(&data);
+				node.val = NULL;
+				if (h == NULL)
+					continue;
+				if (mh_i32ptr_put(h, &node, NULL,
+						  NULL) == mh_end(h)) {
+					diag_set(OutOfMemory, sizeof(node),
+						 "malloc", "base spaces");
+					return -1;
+				}
+			}
+			break;
+		case MEMTX_SNAP_INFO_CHUNK_COUNT:
+			if (mp_typeof(*data) != MP_UINT)
+				goto error;
+			source->chunk_count = mp_decode_uint(&data);
+			if (source->chunk_count == 0)
+				goto error;
+			break;
+		default:
+			mp_next(&data); /* unknown key */
+			break;
+		}
+	}
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "snapshot info");
+	return -1;
+}
+
+/** Start a reader thread for each chunk of a snapshot. */
+static int
+snap_source_start_readers(struct snap_source *source, bool force_recovery)
+{
+	uint32_t count = source->chunk_count;
+	source->readers = calloc(count, sizeof(*source->readers));
+	if (source->readers == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*source->readers),
+			 "malloc", "struct snap_reader");
+		return -1;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		if (snap_reader_start(&source->readers[i], source->dirname,
+				      source->signature, i,
+				      force_recovery) != 0) {
+			while (i-- > 0)
+				snap_reader_stop(&source->readers[i]);
+			free(source->readers);
+			source->readers = NULL;
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Open a snapshot. If @a use_readers is set, its chunks are
+ * read and decoded in reader threads, which only works in tx.
+ */
+static int
+snap_source_open(struct snap_source *source, const char *dirname,
+		 int64_t signature, struct mh_i32ptr_t *base_spaces,
+		 bool force_recovery, bool use_readers)
+{
+	source->dirname = dirname;
+	source->signature = signature;
+	source->chunk = 0;
+	source->chunk_count = 1;
+	source->need_read = true;
+	source->row_is_pending = false;
+	source->readers = NULL;
+	source->batch = NULL;
+
+	char filename[PATH_MAX];
+	snap_chunk_filename(filename, sizeof(filename), dirname, signature, 0);
+	if (xlog_cursor_open(&source->cursor, filename) < 0)
+		return -1;
+	/*
+	 * Chunked and delta snapshots start with an info row,
+	 * see checkpoint_f(). Peek the first row to check.
+	 */
+	bool is_delta = vclock_is_set(&source->cursor.meta.prev_vclock);
+	int rc = xlog_cursor_next(&source->cursor, &source->row,
+				  force_recovery);
+	if (rc < 0)
+		goto fail;
+	if (rc == 0 && source->row.type == MEMTX_SNAP_INFO) {
+		if (snap_source_decode_info(source, base_spaces) != 0)
+			goto fail;
+	} else if (is_delta) {
+		diag_set(XlogError, "%s: delta snapshot has no info",
+			 source->cursor.name);
+		goto fail;
+	} else {
+		source->row_is_pending = (rc == 0);
+	}
+	if (use_readers) {
+		/* Readers start over from the first row. */
+		source->row_is_pending = false;
+		if (snap_source_start_readers(source, force_recovery) != 0)
+			goto fail;
+	}
+	return 0;
+fail:
+	xlog_cursor_close(&source->cursor, false);
+	return -1;
+}
+
+static void
+snap_source_close(struct snap_source *source)
+{
+	if (source->readers != NULL) {
+		for (uint32_t i = 0; i < source->chunk_count; i++)
+			snap_reader_stop(&source->readers[i]);
+		free(source->readers);
+	}
+	xlog_cursor_close(&source->cursor, false);
+}
+
+/** Return true if the last chunk of a snapshot was read to EOF. */
+static bool
+snap_source_is_eof(struct snap_source *source)
+{
+	if (source->readers != NULL)
+		return source->readers[source->chunk_count - 1].is_eof;
+	return xlog_cursor_is_eof(&source->cursor);
+}
+
+/**
+ * Same as snap_source_next_row(), but for a snapshot read by
+ * reader threads: take rows from batches of the chunks in
+ * order, waiting for a batch if it's not decoded yet.
+ */
+static int
+snap_source_next_row_from_readers(struct snap_source *source)
+{
+	while (source->chunk < source->chunk_count) {
+		struct snap_reader *reader = &source->readers[source->chunk];
+		struct snap_batch *batch = source->batch;
+		if (batch != NULL && batch->next_row < batch->row_count) {
+			source->row = batch->rows[batch->next_row++];
+			/* Already decoded by snap_source_open(). */
+			if (source->row.type == MEMTX_SNAP_INFO)
+				continue;
+			return 0;
+		}
+		if (batch != NULL) {
+			source->batch = NULL;
+			if (!batch->is_last) {
+				snap_batch_post(batch);
+			} else if (!reader->is_eof &&
+				   source->chunk + 1 < source->chunk_count) {
+				diag_set(XlogError, "%s: has no EOF marker",
+					 reader->filename);
+				return -1;
+			} else {
+				source->chunk++;
+				continue;
+			}
+		}
+		batch = stailq_shift_entry(&reader->batches,
+					   struct snap_batch, in_reader);
+		snap_batch_wait(batch);
+		if (batch->base.rc != 0) {
+			diag_move(&batch->base.diag, diag_get());
+			return -1;
+		}
+		source->batch = batch;
+	}
+	return 1;
+}
+
+/** Read the next row of a snapshot, switching chunks on EOF. */
+static int
+snap_source_next_row(struct snap_source *source, bool force_recovery)
+{
+	if (source->readers != NULL)
+		return snap_source_next_row_from_readers(source);
+	if (source->row_is_pending) {
+		source->row_is_pending = false;
+		return 0;
+	}
+	while (true) {
+		int rc = xlog_cursor_next(&source->cursor, &source->row,
+					  force_recovery);
+		if (rc <= 0 || source->chunk + 1 >= source->chunk_count)
+			return rc;
+		if (!xlog_cursor_is_eof(&source->cursor)) {
+			diag_set(XlogError, "%s: has no EOF marker",
+				 source->cursor.name);
+			return -1;
+		}
+		char filename[PATH_MAX];
+		snap_chunk_filename(filename, sizeof(filename),
+				    source->dirname, source->signature,
+				    source->chunk + 1);
+		struct xlog_cursor cursor;
+		if (xlog_cursor_open(&cursor, filename) < 0)
+			return -1;
+		xlog_cursor_close(&source->cursor, false);
+		source->cursor = cursor;
+		source->chunk++;
+	}
+}
+
+/**
+ * Read the next row of a snapshot skipping rows of spaces
+ * missing in @filter, if it is set.
+ */
+static int
+snap_source_read(struct snap_source *source, struct mh_i32ptr_t *filter,
+		 bool force_recovery)
+{
+	int rc;
+	while ((rc = snap_source_next_row(source, force_recovery)) == 0) {
+		if (snap_row_space_id(&source->row, &source->space_id) != 0)
+			return -1;
+		if (filter == NULL || mh_i32ptr_find(filter, source->space_id,
+						     NULL) != mh_end(filter))
+			break;
+	}
+	if (rc < 0)
+		return -1;
+	if (rc > 0)
+		source->space_id = UINT32_MAX;
+	source->need_read = false;
+	return 0;
+}
+
+/**
+ * A snapshot has system spaces first, in the order of their
+ * ids, as recovery of the data dictionary needs, and then the
+ * rest of the spaces in any order, see space_foreach(). Note
+ * user spaces may have ids below the system range, so they
+ * can't be ordered by id.
+ */
+static inline uint32_t
+snap_source_order(struct snap_source *source)
+{
+	uint32_t id = source->space_id;
+	if (id == UINT32_MAX)
+		return UINT32_MAX;
+	/* Same as space_is_system(). */
+	if (id > BOX_SYSTEM_ID_MIN && id < BOX_SYSTEM_ID_MAX)
+		return id;
+	return BOX_SYSTEM_ID_MAX;
+}
+
+static int
+snap_cursor_open(struct snap_cursor *cursor, const char *dirname,
+		 int64_t signature, bool force_recovery, bool use_readers)
+{
+	cursor->is_delta = false;
+	cursor->base_spaces = mh_i32ptr_new();
+	if (cursor->base_spaces == NULL) {
+		diag_set(OutOfMemory, sizeof(*cursor->base_spaces),
+			 "malloc", "base spaces");
+		return -1;
+	}
+	if (snap_source_open(&cursor->snap, dirname, signature,
+			     cursor->base_spaces, force_recovery,
+			     use_readers) != 0)
+		goto fail;
+	struct vclock *base_vclock = &cursor->snap.cursor.meta.prev_vclock;
+	if (!vclock_is_set(base_vclock))
+		return 0;
+	if (snap_source_open(&cursor->base, dirname, vclock_sum(base_vclock),
+			     NULL, force_recovery, use_readers) != 0) {
+		snap_source_close(&cursor->snap);
+		goto fail;
+	}
+	cursor->is_delta = true;
+	return 0;
+fail:
+	mh_i32ptr_delete(cursor->base_spaces);
+	return -1;
+}
+
+/** Same as xlog_cursor_next(), but for a checkpoint. */
+static int
+snap_cursor_next(struct snap_cursor *cursor, struct xrow_header *row,
+		 bool force_recovery)
+{
+	if (!cursor->is_delta) {
+		int rc = snap_source_next_row(&cursor->snap, force_recovery);
+		if (rc == 0)
+			*row = cursor->snap.row;
+		return rc;
+	}
+	if (cursor->snap.need_read &&
+	    snap_source_read(&cursor->snap, NULL, force_recovery) != 0)
+		return -1;
+	if (cursor->base.need_read &&
+	    snap_source_read(&cursor->base, cursor->base_spaces,
+			     force_recovery) != 0)
+		return -1;
+	struct snap_source *source = &cursor->snap;
+	if (snap_source_order(&cursor->base) <= snap_source_order(source))
+		source = &cursor->base;
+	if (source->space_id == UINT32_MAX)
+		return 1;
+	*row = source->row;
+	source->need_read = true;
+	return 0;
+}
+
+static bool
+snap_cursor_is_eof(struct snap_cursor *cursor)
+{
+	return snap_source_is_eof(&cursor->snap) &&
+	       (!cursor->is_delta || snap_source_is_eof(&cursor->base));
+}
+
+static void
+snap_cursor_close(struct snap_cursor *cursor)
+{
+	snap_source_close(&cursor->snap);
+	if (cursor->is_delta)
+		snap_source_close(&cursor->base);
+	mh_i32ptr_delete(cursor->base_spaces);
+}
+
 static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row);
@@ -203,14 +955,17 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 						    signature, NONE);
 
 	say_info("recovering from `%s'", filename);
-	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
+	struct snap_cursor cursor;
+	if (snap_cursor_open(&cursor, memtx->snap_dir.dirname, signature,
+			     memtx->force_recovery, true) < 0)
 		return -1;
+	if (cursor.is_delta)
+		say_info("using base snapshot `%s'", cursor.base.cursor.name);
 
 	int rc;
 	struct xrow_header row;
 	uint64_t row_count = 0;
-	while ((rc = xlog_cursor_next(&cursor, &row,
+	while ((rc = snap_cursor_next(&cursor, &row,
 				      memtx->force_recovery)) == 0) {
 		row.lsn = signature;
 		rc = memtx_engine_recover_snapshot_row(memtx, &row);
@@ -227,7 +982,7 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			fiber_yield_timeout(0);
 		}
 	}
-	xlog_cursor_close(&cursor, false);
+	snap_cursor_close(&cursor);
 	if (rc < 0)
 		return -1;
 
@@ -236,12 +991,26 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	 * marker - such snapshots are very likely corrupted and
 	 * should not be trusted.
 	 */
-	if (!xlog_cursor_is_eof(&cursor))
-		panic("snapshot `%s' has no EOF marker", filename);
+	if (!snap_cursor_is_eof(&cursor))
+		panic("snapshot `%s' has no EOF marker",
+		      cursor.snap.cursor.name);
 
 	return 0;
 }
 
+int
+memtx_engine_scan_checkpoints(struct memtx_engine *memtx)
+{
+	if (xdir_scan(&memtx->snap_dir) != 0)
+		return -1;
+	for (struct vclock *vclock = vclockset_first(&memtx->snap_dir.index);
+	     vclock != NULL;
+	     vclock = vclockset_next(&memtx->snap_dir.index, vclock)) {
+		gc_add_checkpoint(vclock);
+	}
+	return 0;
+}
+
 static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row)
@@ -348,6 +1117,7 @@ memtx_engine_end_recovery(struct engine *engine)
 			return -1;
 	}
 	xdir_collect_inprogress(&memtx->snap_dir);
+	memtx_engine_collect_chunks(memtx, 0, true);
 	return 0;
 }
 
@@ -562,9 +1332,28 @@ checkpoint_write_tuple(struct xlog *l, struct space *space,
 struct checkpoint_entry {
 	struct space *space;
 	struct snapshot_iterator *iterator;
+	/** Size of the space data, used to balance writers. */
+	size_t bsize;
+	/** Chunk of the snapshot the space is written to. */
+	uint32_t chunk;
 	struct rlist link;
 };
 
+struct checkpoint;
+
+/** A thread writing a chunk of a snapshot. */
+struct checkpoint_writer {
+	struct cord cord;
+	struct checkpoint *ckpt;
+	/** Chunk written by this thread, 0 is the main file. */
+	uint32_t chunk;
+	/** Total size of the spaces assigned to the writer. */
+	size_t bsize;
+	/** The snapshot directory, named after the chunk. */
+	struct xdir dir;
+	char filename_ext[16];
+};
+
 struct checkpoint {
 	/**
 	 * List of MemTX spaces to snapshot, with consistent
@@ -572,16 +1361,27 @@ struct checkpoint {
 	 */
 	struct rlist entries;
 	uint64_t snap_io_rate_limit;
-	struct cord cord;
+	/** Threads writing snapshot chunks. */
+	struct checkpoint_writer *writers;
+	uint32_t writer_count;
 	bool waiting_for_snap_thread;
 	/** The vclock of the snapshot file. */
 	struct vclock vclock;
-	struct xdir dir;
+	const char *snap_dirname;
 	/**
 	 * Do nothing, just touch the snapshot file - the
 	 * checkpoint already exists.
 	 */
 	bool touch;
+	/**
+	 * Vclock of the base snapshot if this is a delta
+	 * snapshot, unset otherwise.
+	 */
+	struct vclock base_vclock;
+	/** memtx_engine::snap_base_version of the base. */
+	uint32_t base_version;
+	/** memtx_engine::snapshot_version of this checkpoint. */
+	uint32_t version;
 };
 
 static struct checkpoint *
@@ -594,11 +1394,16 @@ checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
 		return NULL;
 	}
 	rlist_create(&ckpt->entries);
+	ckpt->writers = NULL;
+	ckpt->writer_count = 0;
 	ckpt->waiting_for_snap_thread = false;
-	xdir_create(&ckpt->dir, snap_dirname, SNAP, &INSTANCE_UUID);
+	ckpt->snap_dirname = snap_dirname;
 	ckpt->snap_io_rate_limit = snap_io_rate_limit;
 	vclock_create(&ckpt->vclock);
 	ckpt->touch = false;
+	vclock_clear(&ckpt->base_vclock);
+	ckpt->base_version = 0;
+	ckpt->version = 0;
 	return ckpt;
 }
 
@@ -607,13 +1412,67 @@ checkpoint_delete(struct checkpoint *ckpt)
 {
 	struct checkpoint_entry *entry, *tmp;
 	rlist_foreach_entry_safe(entry, &ckpt->entries, link, tmp) {
-		entry->iterator->free(entry->iterator);
+		if (entry->iterator != NULL)
+			entry->iterator->free(entry->iterator);
 		free(entry);
 	}
-	xdir_destroy(&ckpt->dir);
+	for (uint32_t i = 0; i < ckpt->writer_count; i++)
+		xdir_destroy(&ckpt->writers[i].dir);
+	free(ckpt->writers);
 	free(ckpt);
 }
 
+/**
+ * Create @writer_count snapshot writers and distribute spaces
+ * among them. System spaces always go to the main file so that
+ * they are recovered in the order of their ids, each user space
+ * goes to the writer with the least amount of data to write.
+ */
+static int
+checkpoint_create_writers(struct checkpoint *ckpt, uint32_t writer_count)
+{
+	uint32_t user_space_count = 0;
+	struct checkpoint_entry *entry;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		if (entry->iterator != NULL && !space_is_system(entry->space))
+			user_space_count++;
+	}
+	writer_count = MIN(writer_count, user_space_count + 1);
+	ckpt->writers = calloc(writer_count, sizeof(*ckpt->writers));
+	if (ckpt->writers == NULL) {
+		diag_set(OutOfMemory, writer_count * sizeof(*ckpt->writers),
+			 "malloc", "struct checkpoint_writer");
+		return -1;
+	}
+	ckpt->writer_count = writer_count;
+	for (uint32_t i = 0; i < writer_count; i++) {
+		struct checkpoint_writer *writer = &ckpt->writers[i];
+		writer->ckpt = ckpt;
+		writer->chunk = i;
+		xdir_create(&writer->dir, ckpt->snap_dirname, SNAP,
+			    &INSTANCE_UUID);
+		if (i > 0) {
+			snprintf(writer->filename_ext,
+				 sizeof(writer->filename_ext), ".%u%s",
+				 (unsigned)i, writer->dir.filename_ext);
+			writer->dir.filename_ext = writer->filename_ext;
+		}
+	}
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		entry->chunk = 0;
+		if (entry->iterator == NULL)
+			continue;
+		if (!space_is_system(entry->space)) {
+			for (uint32_t i = 1; i < writer_count; i++) {
+				if (ckpt->writers[i].bsize <
+				    ckpt->writers[entry->chunk].bsize)
+					entry->chunk = i;
+			}
+		}
+		ckpt->writers[entry->chunk].bsize += entry->bsize;
+	}
+	return 0;
+}
 
 static int
 checkpoint_add_space(struct space *sp, void *data)
@@ -634,7 +1493,19 @@ checkpoint_add_space(struct space *sp, void *data)
 	}
 	rlist_add_tail_entry(&ckpt->entries, entry, link);
 
+	struct memtx_space *memtx_space = (struct memtx_space *)sp;
 	entry->space = sp;
+	entry->iterator = NULL;
+	entry->bsize = memtx_space->bsize;
+	entry->chunk = 0;
+	if (vclock_is_set(&ckpt->base_vclock) &&
+	    memtx_space->snapshot_version < ckpt->base_version) {
+		/*
+		 * The space hasn't changed since the base snapshot,
+		 * a delta snapshot will refer to it.
+		 */
+		return 0;
+	}
 	entry->iterator = index_create_snapshot_iterator(pk);
 	if (entry->iterator == NULL)
 		return -1;
@@ -642,13 +1513,65 @@ checkpoint_add_space(struct space *sp, void *data)
 	return 0;
 };
 
+/**
+ * Write the MEMTX_SNAP_INFO row, which must be the first row
+ * of a snapshot split into chunks or of a delta snapshot.
+ */
+static int
+checkpoint_write_info(struct xlog *l, struct checkpoint *ckpt)
+{
+	bool is_delta = vclock_is_set(&ckpt->base_vclock);
+	uint32_t count = 0;
+	struct checkpoint_entry *entry;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		if (entry->iterator == NULL)
+			count++;
+	}
+	size_t size = mp_sizeof_map(2) +
+		      mp_sizeof_uint(MEMTX_SNAP_INFO_CHUNK_COUNT) +
+		      mp_sizeof_uint(ckpt->writer_count) +
+		      mp_sizeof_uint(MEMTX_SNAP_INFO_BASE_SPACES) +
+		      mp_sizeof_array(count) +
+		      count * mp_sizeof_uint(UINT32_MAX);
+	char *buf = region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "snapshot info");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, is_delta ? 2 : 1);
+	data = mp_encode_uint(data, MEMTX_SNAP_INFO_CHUNK_COUNT);
+	data = mp_encode_uint(data, ckpt->writer_count);
+	if (is_delta) {
+		data = mp_encode_uint(data, MEMTX_SNAP_INFO_BASE_SPACES);
+		data = mp_encode_array(data, count);
+		rlist_foreach_entry(entry, &ckpt->entries, link) {
+			if (entry->iterator == NULL)
+				data = mp_encode_uint(data,
+						space_id(entry->space));
+		}
+	}
+	assert(data <= buf + size);
+
+	struct xrow_header row;
+	memset(&row, 0, sizeof(struct xrow_header));
+	row.type = MEMTX_SNAP_INFO;
+	row.bodycnt = 1;
+	row.body[0].iov_base = buf;
+	row.body[0].iov_len = data - buf;
+	return checkpoint_write_row(l, &row);
+}
+
 static int
 checkpoint_f(va_list ap)
 {
-	struct checkpoint *ckpt = va_arg(ap, struct checkpoint *);
+	struct checkpoint_writer *writer =
+		va_arg(ap, struct checkpoint_writer *);
+	struct checkpoint *ckpt = writer->ckpt;
 
 	if (ckpt->touch) {
-		if (xdir_touch_xlog(&ckpt->dir, &ckpt->vclock) == 0)
+		assert(ckpt->writer_count == 1);
+		if (xdir_touch_xlog(&writer->dir, &ckpt->vclock) == 0)
 			return 0;
 		/*
 		 * Failed to touch an existing snapshot, create
@@ -657,18 +1580,32 @@ checkpoint_f(va_list ap)
 		ckpt->touch = false;
 	}
 
+	/* A delta snapshot refers to its base with PrevVClock. */
+	const struct vclock *base_vclock = NULL;
+	if (writer->chunk == 0 && vclock_is_set(&ckpt->base_vclock))
+		base_vclock = &ckpt->base_vclock;
+
 	struct xlog snap;
-	if (xdir_create_xlog(&ckpt->dir, &snap, &ckpt->vclock) != 0)
+	if (xdir_create_xlog_with_prev(&writer->dir, &snap, &ckpt->vclock,
+				       base_vclock) != 0)
 		return -1;
 
-	snap.rate_limit = ckpt->snap_io_rate_limit;
+	snap.rate_limit = ckpt->snap_io_rate_limit / ckpt->writer_count;
 
 	say_info("saving snapshot `%s'", snap.filename);
+	if (writer->chunk == 0 &&
+	    (base_vclock != NULL || ckpt->writer_count > 1) &&
+	    checkpoint_write_info(&snap, ckpt) != 0) {
+		xlog_close(&snap, false);
+		return -1;
+	}
 	struct checkpoint_entry *entry;
 	rlist_foreach_entry(entry, &ckpt->entries, link) {
 		uint32_t size;
 		const char *data;
 		struct snapshot_iterator *it = entry->iterator;
+		if (it == NULL || entry->chunk != writer->chunk)
+			continue;
 		for (data = it->next(it, &size); data != NULL;
 		     data = it->next(it, &size)) {
 			if (checkpoint_write_tuple(&snap, entry->space,
@@ -698,6 +1635,17 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 	if (memtx->checkpoint == NULL)
 		return -1;
 
+	/*
+	 * Make a delta snapshot unless there's no base to refer
+	 * to or it's time to make a new base.
+	 */
+	if (vclock_is_set(&memtx->snap_base_vclock) &&
+	    memtx->checkpoint_delta_count < memtx->checkpoint_delta_max) {
+		vclock_copy(&memtx->checkpoint->base_vclock,
+			    &memtx->snap_base_vclock);
+		memtx->checkpoint->base_version = memtx->snap_base_version;
+	}
+
 	if (space_foreach(checkpoint_add_space, memtx->checkpoint) != 0) {
 		checkpoint_delete(memtx->checkpoint);
 		memtx->checkpoint = NULL;
@@ -706,6 +1654,7 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 
 	/* increment snapshot version; set tuple deletion to delayed mode */
 	memtx->snapshot_version++;
+	memtx->checkpoint->version = memtx->snapshot_version;
 	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, true);
 	return 0;
 }
@@ -715,30 +1664,46 @@ memtx_engine_wait_checkpoint(struct engine *engine,
 			     const struct vclock *vclock)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	struct checkpoint *ckpt = memtx->checkpoint;
 
-	assert(memtx->checkpoint != NULL);
+	assert(ckpt != NULL);
 	/*
 	 * If a snapshot already exists, do not create a new one.
 	 */
 	struct vclock last;
 	if (xdir_last_vclock(&memtx->snap_dir, &last) >= 0 &&
 	    vclock_compare(&last, vclock) == 0) {
-		memtx->checkpoint->touch = true;
+		ckpt->touch = true;
 	}
-	vclock_copy(&memtx->checkpoint->vclock, vclock);
+	vclock_copy(&ckpt->vclock, vclock);
 
-	if (cord_costart(&memtx->checkpoint->cord, "snapshot",
-			 checkpoint_f, memtx->checkpoint)) {
+	if (checkpoint_create_writers(ckpt, ckpt->touch ? 1 :
+				      memtx->checkpoint_threads) != 0)
 		return -1;
+
+	uint32_t started = 0;
+	int result = 0;
+	for (; started < ckpt->writer_count; started++) {
+		struct checkpoint_writer *writer = &ckpt->writers[started];
+		const char *name = started == 0 ? "snapshot" :
+				   tt_sprintf("snapshot.%u", (unsigned)started);
+		if (cord_costart(&writer->cord, name,
+				 checkpoint_f, writer) != 0) {
+			result = -1;
+			break;
+		}
 	}
-	memtx->checkpoint->waiting_for_snap_thread = true;
+	ckpt->waiting_for_snap_thread = true;
 
 	/* wait for memtx-part snapshot completion */
-	int result = cord_cojoin(&memtx->checkpoint->cord);
-	if (result != 0)
-		diag_log();
+	for (uint32_t i = 0; i < started; i++) {
+		if (cord_cojoin(&ckpt->writers[i].cord) != 0) {
+			diag_log();
+			result = -1;
+		}
+	}
 
-	memtx->checkpoint->waiting_for_snap_thread = false;
+	ckpt->waiting_for_snap_thread = false;
 	return result;
 }
 
@@ -748,22 +1713,17 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 {
 	(void) vclock;
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	struct checkpoint *ckpt = memtx->checkpoint;
 
 	/* beginCheckpoint() must have been done */
-	assert(memtx->checkpoint != NULL);
+	assert(ckpt != NULL);
 	/* waitCheckpoint() must have been done. */
-	assert(!memtx->checkpoint->waiting_for_snap_thread);
+	assert(!ckpt->waiting_for_snap_thread);
 
 	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
 
-	if (!memtx->checkpoint->touch) {
-		int64_t lsn = vclock_sum(&memtx->checkpoint->vclock);
-		struct xdir *dir = &memtx->checkpoint->dir;
-		/* rename snapshot on completion */
-		char to[PATH_MAX];
-		snprintf(to, sizeof(to), "%s",
-			 xdir_format_filename(dir, lsn, NONE));
-		char *from = xdir_format_filename(dir, lsn, INPROGRESS);
+	if (!ckpt->touch) {
+		int64_t lsn = vclock_sum(&ckpt->vclock);
 #ifndef NDEBUG
 		struct errinj *delay = errinj(ERRINJ_SNAP_COMMIT_DELAY,
 					       ERRINJ_BOOL);
@@ -772,19 +1732,41 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 				fiber_sleep(0.001);
 		}
 #endif
-		int rc = coio_rename(from, to);
-		if (rc != 0)
-			panic("can't rename .snap.inprogress");
+		/*
+		 * Rename snapshot on completion. Chunks go first
+		 * so that the main file never refers to missing
+		 * ones.
+		 */
+		for (uint32_t i = ckpt->writer_count; i-- > 0; ) {
+			struct xdir *dir = &ckpt->writers[i].dir;
+			char to[PATH_MAX];
+			snprintf(to, sizeof(to), "%s",
+				 xdir_format_filename(dir, lsn, NONE));
+			char *from = xdir_format_filename(dir, lsn,
+							  INPROGRESS);
+			int rc = coio_rename(from, to);
+			if (rc != 0)
+				panic("can't rename .snap.inprogress");
+		}
+
+		if (!vclock_is_set(&ckpt->base_vclock)) {
+			/* A full snapshot becomes the new base. */
+			vclock_copy(&memtx->snap_base_vclock, &ckpt->vclock);
+			memtx->snap_base_version = ckpt->version;
+			memtx->checkpoint_delta_count = 0;
+		} else {
+			memtx->checkpoint_delta_count++;
+		}
 	}
 
 	struct vclock last;
 	if (xdir_last_vclock(&memtx->snap_dir, &last) < 0 ||
 	    vclock_compare(&last, vclock) != 0) {
 		/* Add the new checkpoint to the set. */
-		xdir_add_vclock(&memtx->snap_dir, &memtx->checkpoint->vclock);
+		xdir_add_vclock(&memtx->snap_dir, &ckpt->vclock);
 	}
 
-	checkpoint_delete(memtx->checkpoint);
+	checkpoint_delete(ckpt);
 	memtx->checkpoint = NULL;
 }
 
@@ -792,36 +1774,87 @@ static void
 memtx_engine_abort_checkpoint(struct engine *engine)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	struct checkpoint *ckpt = memtx->checkpoint;
 
 	/**
 	 * An error in the other engine's first phase.
 	 */
-	if (memtx->checkpoint->waiting_for_snap_thread) {
+	if (ckpt->waiting_for_snap_thread) {
 		/* wait for memtx-part snapshot completion */
-		if (cord_cojoin(&memtx->checkpoint->cord) != 0)
-			diag_log();
-		memtx->checkpoint->waiting_for_snap_thread = false;
+		for (uint32_t i = 0; i < ckpt->writer_count; i++) {
+			if (cord_cojoin(&ckpt->writers[i].cord) != 0)
+				diag_log();
+		}
+		ckpt->waiting_for_snap_thread = false;
 	}
 
 	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
 
-	/** Remove garbage .inprogress file. */
-	char *filename =
-		xdir_format_filename(&memtx->checkpoint->dir,
-				     vclock_sum(&memtx->checkpoint->vclock),
-				     INPROGRESS);
-	(void) coio_unlink(filename);
+	/** Remove garbage .inprogress files. */
+	for (uint32_t i = 0; i < ckpt->writer_count; i++) {
+		char *filename =
+			xdir_format_filename(&ckpt->writers[i].dir,
+					     vclock_sum(&ckpt->vclock),
+					     INPROGRESS);
+		(void) coio_unlink(filename);
+	}
 
-	checkpoint_delete(memtx->checkpoint);
+	checkpoint_delete(ckpt);
 	memtx->checkpoint = NULL;
 }
 
+/**
+ * Read the vclock of the base snapshot of a checkpoint.
+ * The vclock is left unset if the checkpoint isn't a delta.
+ */
+static int
+memtx_engine_read_snap_base(struct memtx_engine *memtx, int64_t signature,
+			    struct vclock *base_vclock)
+{
+	struct xlog_cursor cursor;
+	if (xdir_open_cursor(&memtx->snap_dir, signature, &cursor) != 0)
+		return -1;
+	vclock_copy(base_vclock, &cursor.meta.prev_vclock);
+	xlog_cursor_close(&cursor, false);
+	return 0;
+}
+
 static void
 memtx_engine_collect_garbage(struct engine *engine, const struct vclock *vclock)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	xdir_collect_garbage(&memtx->snap_dir, vclock_sum(vclock),
-			     XDIR_GC_ASYNC);
+	/*
+	 * A delta snapshot is useless without its base so
+	 * keep the base of the oldest checkpoint in use.
+	 */
+	int64_t signature = vclock_sum(vclock);
+	struct vclock base_vclock;
+	if (memtx_engine_read_snap_base(memtx, signature, &base_vclock) != 0) {
+		diag_log();
+		return;
+	}
+	if (vclock_is_set(&base_vclock))
+		signature = MIN(signature, vclock_sum(&base_vclock));
+
+	/* Remove chunks before the main files referring to them. */
+	memtx_engine_collect_chunks(memtx, signature, false);
+	xdir_collect_garbage(&memtx->snap_dir, signature, XDIR_GC_ASYNC);
+}
+
+/** Pass all files of a snapshot to a backup callback. */
+static int
+memtx_engine_backup_snap(struct memtx_engine *memtx, int64_t signature,
+			 engine_backup_cb cb, void *cb_arg)
+{
+	for (uint32_t chunk = 0; ; chunk++) {
+		char filename[PATH_MAX];
+		snap_chunk_filename(filename, sizeof(filename),
+				    memtx->snap_dir.dirname, signature, chunk);
+		if (chunk > 0 && access(filename, F_OK) != 0)
+			return 0;
+		if (cb(filename, cb_arg) != 0)
+			return -1;
+	}
 }
 
 static int
@@ -829,9 +1862,15 @@ memtx_engine_backup(struct engine *engine, const struct vclock *vclock,
 		    engine_backup_cb cb, void *cb_arg)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	char *filename = xdir_format_filename(&memtx->snap_dir,
-					      vclock_sum(vclock), NONE);
-	return cb(filename, cb_arg);
+	int64_t signature = vclock_sum(vclock);
+	struct vclock base_vclock;
+	if (memtx_engine_read_snap_base(memtx, signature, &base_vclock) != 0)
+		return -1;
+	if (vclock_is_set(&base_vclock) &&
+	    memtx_engine_backup_snap(memtx, vclock_sum(&base_vclock),
+				     cb, cb_arg) != 0)
+		return -1;
+	return memtx_engine_backup_snap(memtx, signature, cb, cb_arg);
 }
 
 /** Used to pass arguments to memtx_initial_join_f */
@@ -852,25 +1891,31 @@ memtx_initial_join_f(va_list ap)
 	int64_t checkpoint_lsn = arg->checkpoint_lsn;
 	struct xstream *stream = arg->stream;
 
-	struct xdir dir;
 	/*
 	 * snap_dirname and INSTANCE_UUID don't change after start,
 	 * safe to use in another thread.
 	 */
-	xdir_create(&dir, snap_dirname, SNAP, &INSTANCE_UUID);
-	struct xlog_cursor cursor;
-	int rc = xdir_open_cursor(&dir, checkpoint_lsn, &cursor);
-	xdir_destroy(&dir);
-	if (rc < 0)
+	struct snap_cursor cursor;
+	/* Reader threads talk to tx, feed rows from this thread. */
+	if (snap_cursor_open(&cursor, snap_dirname, checkpoint_lsn,
+			     true, false) < 0)
 		return -1;
+	struct xlog_meta *meta = &cursor.snap.cursor.meta;
+	if (!tt_uuid_is_equal(&INSTANCE_UUID, &meta->instance_uuid)) {
+		diag_set(XlogError, "%s: invalid instance UUID",
+			 cursor.snap.cursor.name);
+		snap_cursor_close(&cursor);
+		return -1;
+	}
 
+	int rc;
 	struct xrow_header row;
-	while ((rc = xlog_cursor_next(&cursor, &row, true)) == 0) {
+	while ((rc = snap_cursor_next(&cursor, &row, true)) == 0) {
 		rc = xstream_write(stream, &row);
 		if (rc < 0)
 			break;
 	}
-	xlog_cursor_close(&cursor, false);
+	snap_cursor_close(&cursor);
 	if (rc < 0)
 		return -1;
 
@@ -880,8 +1925,9 @@ memtx_initial_join_f(va_list ap)
 	 * should not be trusted.
 	 */
 	/* TODO: replace panic with diag_set() */
-	if (!xlog_cursor_is_eof(&cursor))
-		panic("snapshot `%s' has no EOF marker", cursor.name);
+	if (!snap_cursor_is_eof(&cursor))
+		panic("snapshot `%s' has no EOF marker",
+		      cursor.snap.cursor.name);
 	return 0;
 }
 
@@ -998,6 +2044,325 @@ memtx_engine_gc_f(va_list va)
 	return 0;
 }
 
+enum {
+	/** Max number of tuples relocated by one defrag step. */
+	MEMTX_DEFRAG_BATCH = 256,
+};
+
+/** How often to check if the tuple allocator is fragmented. */
+static const double MEMTX_DEFRAG_CHECK_PERIOD = 1;
+/** Min time between two defragmentation passes. */
+static const double MEMTX_DEFRAG_PASS_PERIOD = 60;
+
+/**
+ * Return true if the fraction of memory allocated for tuples
+ * but not used exceeds the defragmentation threshold.
+ */
+static bool
+memtx_engine_is_fragmented(struct memtx_engine *memtx)
+{
+	struct small_stats stats;
+	small_stats(&memtx->alloc, &stats, small_stats_noop_cb, NULL);
+	return stats.total > 0 &&
+	       stats.total - stats.used > memtx->defrag_threshold * stats.total;
+}
+
+/**
+ * Find the memtx space with the lowest id greater than
+ * @space_id. Returns NULL if there's no such space.
+ */
+static struct space *
+memtx_engine_next_space(struct memtx_engine *memtx, uint32_t space_id)
+{
+	struct space *space = space_by_id(BOX_SPACE_ID);
+	struct index *pk = space != NULL ? space_index(space, 0) : NULL;
+	if (pk == NULL)
+		return NULL;
+	char key[6];
+	assert(mp_sizeof_uint(UINT32_MAX) <= sizeof(key));
+	mp_encode_uint(key, space_id);
+	struct iterator *it = index_create_iterator(pk, ITER_GT, key, 1);
+	if (it == NULL) {
+		diag_log();
+		return NULL;
+	}
+	space = NULL;
+	struct tuple *tuple;
+	while (iterator_next(it, &tuple) == 0 && tuple != NULL) {
+		uint32_t id;
+		if (tuple_field_u32(tuple, BOX_SPACE_FIELD_ID, &id) != 0)
+			continue;
+		space = space_by_id(id);
+		if (space != NULL && space->engine == &memtx->base)
+			break;
+		space = NULL;
+	}
+	iterator_delete(it);
+	return space;
+}
+
+/**
+ * Relocate the next batch of tuples. Spaces are processed in
+ * the order of their ids, tuples in the order of their primary
+ * keys. Set @pass_done if all spaces have been processed.
+ */
+static void
+memtx_engine_defrag_step(struct memtx_engine *memtx, bool *pass_done)
+{
+	*pass_done = false;
+	struct space *space = space_by_id(memtx->defrag_space_id);
+	if (space == NULL || space->engine != &memtx->base)
+		goto next_space;
+
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct index *pk = space_index(space, 0);
+	if (pk == NULL || memtx_space->replace != memtx_space_replace_all_keys)
+		goto next_space;
+
+	const char *key = memtx->defrag_key;
+	uint32_t part_count = key != NULL ? mp_decode_array(&key) : 0;
+	struct iterator *it = index_create_iterator(pk, key != NULL ?
+						    ITER_GT : ITER_ALL,
+						    key, part_count);
+	if (it == NULL) {
+		diag_log();
+		goto next_space;
+	}
+	struct tuple *batch[MEMTX_DEFRAG_BATCH];
+	int count = 0;
+	struct tuple *tuple;
+	while (count < MEMTX_DEFRAG_BATCH &&
+	       iterator_next(it, &tuple) == 0 && tuple != NULL)
+		batch[count++] = tuple;
+	iterator_delete(it);
+	if (count == 0)
+		goto next_space;
+
+	/*
+	 * Remember where to continue from. Do it before
+	 * relocating tuples, because the last tuple of the
+	 * batch may be freed by relocation.
+	 */
+	uint32_t key_size;
+	const char *last_key = tuple_extract_key(batch[count - 1],
+						 pk->def->key_def, &key_size);
+	char *new_key = last_key != NULL ? malloc(key_size) : NULL;
+	if (new_key == NULL) {
+		diag_log();
+		goto next_space;
+	}
+	memcpy(new_key, last_key, key_size);
+	free(memtx->defrag_key);
+	memtx->defrag_key = new_key;
+
+	/*
+	 * There are no yields below so the tuples can't
+	 * be freed while we are relocating them.
+	 */
+	for (int i = 0; i < count; i++) {
+		int rc = memtx_space_relocate_tuple(space, batch[i]);
+		if (rc < 0) {
+			diag_log();
+			break;
+		}
+		memtx->defrag_relocated += rc;
+	}
+	fiber_gc();
+	return;
+next_space:
+	free(memtx->defrag_key);
+	memtx->defrag_key = NULL;
+	space = memtx_engine_next_space(memtx, memtx->defrag_space_id);
+	if (space != NULL) {
+		memtx->defrag_space_id = space_id(space);
+	} else {
+		memtx->defrag_space_id = 0;
+		memtx->defrag_passes++;
+		*pass_done = true;
+	}
+}
+
+static int
+memtx_engine_defrag_f(va_list va)
+{
+	struct memtx_engine *memtx = va_arg(va, struct memtx_engine *);
+	while (!fiber_is_cancelled()) {
+		/*
+		 * Don't relocate tuples while a checkpoint is in
+		 * progress, because in the delayed free mode the
+		 * memory occupied by old tuples isn't freed until
+		 * the checkpoint completes.
+		 */
+		if (memtx->state != MEMTX_OK ||
+		    memtx->defrag_threshold == 0 ||
+		    memtx->alloc.free_mode == SMALL_DELAYED_FREE ||
+		    (memtx->defrag_key == NULL &&
+		     memtx->defrag_space_id == 0 &&
+		     !memtx_engine_is_fragmented(memtx))) {
+			fiber_sleep(MEMTX_DEFRAG_CHECK_PERIOD);
+			continue;
+		}
+		bool pass_done;
+		memtx_engine_defrag_step(memtx, &pass_done);
+		/*
+		 * Yield after each step so as not to block
+		 * tx thread for too long.
+		 */
+		fiber_sleep(pass_done ? MEMTX_DEFRAG_PASS_PERIOD : 0);
+	}
+	return 0;
+}
+
+enum {
+	/** Max number of expired tuples deleted by one transaction. */
+	MEMTX_EXPIRE_BATCH = 128,
+};
+
+/** Min time between two expiration passes. */
+static const double MEMTX_EXPIRE_PASS_PERIOD = 1;
+
+/**
+ * Return a TREE index of the space whose first part is the TTL
+ * field so that expired tuples come first, or NULL if there is
+ * no such index.
+ */
+static struct index *
+memtx_engine_expire_index(struct space *space)
+{
+	uint32_t fieldno = space->def->opts.ttl_field - 1;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		struct key_part *part = &index->def->key_def->parts[0];
+		if (index->def->type == TREE && part->fieldno == fieldno &&
+		    part->path == NULL)
+			return index;
+	}
+	return NULL;
+}
+
+/**
+ * Delete the next batch of expired tuples in one transaction so
+ * that it is written to WAL as a single entry. Spaces are
+ * processed in the order of their ids. Set @pass_done if all
+ * spaces have been processed.
+ */
+static void
+memtx_engine_expire_step(struct memtx_engine *memtx, bool *pass_done)
+{
+	*pass_done = false;
+	struct space *space = space_by_id(memtx->expire_space_id);
+	if (space == NULL || space->engine != &memtx->base ||
+	    space->def->opts.ttl_field == 0)
+		goto next_space;
+
+	struct index *pk = space_index(space, 0);
+	struct index *index = memtx_engine_expire_index(space);
+	if (pk == NULL || index == NULL)
+		goto next_space;
+
+	/*
+	 * Position the iterator at the first numeric TTL value:
+	 * nil and boolean values sort before numbers, strings and
+	 * binary values after them, so the scan can stop at the
+	 * first tuple that hasn't expired yet.
+	 */
+	struct key_part *part = &index->def->key_def->parts[0];
+	enum iterator_type type = ITER_ALL;
+	char key[1];
+	uint32_t part_count = 0;
+	if (part->type == FIELD_TYPE_SCALAR) {
+		mp_encode_bool(key, true);
+		type = ITER_GT;
+		part_count = 1;
+	} else if (key_part_is_nullable(part)) {
+		mp_encode_nil(key);
+		type = ITER_GT;
+		part_count = 1;
+	}
+	struct iterator *it = index_create_iterator(index, type, key,
+						    part_count);
+	if (it == NULL) {
+		diag_log();
+		goto next_space;
+	}
+	uint32_t fieldno = space->def->opts.ttl_field - 1;
+	double now = fiber_time();
+	const char *keys[MEMTX_EXPIRE_BATCH];
+	uint32_t key_sizes[MEMTX_EXPIRE_BATCH];
+	int count = 0;
+	struct tuple *tuple;
+	while (count < MEMTX_EXPIRE_BATCH &&
+	       iterator_next(it, &tuple) == 0 && tuple != NULL) {
+		const char *field = tuple_field(tuple, fieldno);
+		double value;
+		if (field == NULL || mp_read_double(&field, &value) != 0 ||
+		    value > now)
+			break;
+		keys[count] = tuple_extract_key(tuple, pk->def->key_def,
+						&key_sizes[count]);
+		if (keys[count] == NULL) {
+			diag_log();
+			break;
+		}
+		count++;
+	}
+	iterator_delete(it);
+	if (count == 0)
+		goto next_space;
+
+	if (box_txn_begin() != 0)
+		goto fail;
+	for (int i = 0; i < count; i++) {
+		if (box_delete(space_id(space), 0, keys[i],
+			       keys[i] + key_sizes[i], NULL) != 0) {
+			box_txn_rollback();
+			goto fail;
+		}
+	}
+	if (box_txn_commit() != 0)
+		goto fail;
+	fiber_gc();
+	/* Continue with the same space if the batch was full. */
+	if (count == MEMTX_EXPIRE_BATCH)
+		return;
+	goto next_space;
+fail:
+	diag_log();
+	fiber_gc();
+next_space:
+	space = memtx_engine_next_space(memtx, memtx->expire_space_id);
+	if (space != NULL) {
+		memtx->expire_space_id = space_id(space);
+	} else {
+		memtx->expire_space_id = 0;
+		*pass_done = true;
+	}
+}
+
+static int
+memtx_engine_expire_f(va_list va)
+{
+	struct memtx_engine *memtx = va_arg(va, struct memtx_engine *);
+	while (!fiber_is_cancelled()) {
+		/*
+		 * Expired tuples are deleted on the master only,
+		 * replicas receive the DELETE statements from it.
+		 */
+		if (memtx->state != MEMTX_OK || box_is_ro()) {
+			fiber_sleep(MEMTX_EXPIRE_PASS_PERIOD);
+			continue;
+		}
+		bool pass_done;
+		memtx_engine_expire_step(memtx, &pass_done);
+		/*
+		 * Yield after each step so as not to block
+		 * tx thread for too long.
+		 */
+		fiber_sleep(pass_done ? MEMTX_EXPIRE_PASS_PERIOD : 0);
+	}
+	return 0;
+}
+
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		 uint64_t tuple_arena_max_size, uint32_t objsize_min,
@@ -1047,6 +2412,12 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	memtx->gc_fiber = fiber_new("memtx.gc", memtx_engine_gc_f);
 	if (memtx->gc_fiber == NULL)
 		goto fail;
+	memtx->defrag_fiber = fiber_new("memtx.defrag", memtx_engine_defrag_f);
+	if (memtx->defrag_fiber == NULL)
+		goto fail;
+	memtx->expire_fiber = fiber_new("memtx.expire", memtx_engine_expire_f);
+	if (memtx->expire_fiber == NULL)
+		goto fail;
 
 	/* Apply lowest allowed objsize bound. */
 	if (objsize_min < OBJSIZE_MIN)
@@ -1071,12 +2442,16 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
+	vclock_clear(&memtx->snap_base_vclock);
+	memtx->checkpoint_threads = 1;
 	memtx->force_recovery = force_recovery;
 
 	memtx->base.vtab = &memtx_engine_vtab;
 	memtx->base.name = "memtx";
 
 	fiber_start(memtx->gc_fiber, memtx);
+	fiber_start(memtx->defrag_fiber, memtx);
+	fiber_start(memtx->expire_fiber, memtx);
 	return memtx;
 fail:
 	xdir_destroy(&memtx->snap_dir);
@@ -1116,6 +2491,38 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
+void
+memtx_engine_set_checkpoint_delta_max(struct memtx_engine *memtx,
+				      int delta_max)
+{
+	memtx->checkpoint_delta_max = delta_max;
+}
+
+void
+memtx_engine_set_checkpoint_threads(struct memtx_engine *memtx,
+				    int thread_count)
+{
+	memtx->checkpoint_threads = thread_count;
+}
+
+void
+memtx_engine_set_defrag_threshold(struct memtx_engine *memtx,
+				  double threshold)
+{
+	memtx->defrag_threshold = threshold;
+}
+
+void
+memtx_engine_stat(struct memtx_engine *memtx, struct info_handler *h)
+{
+	info_begin(h);
+	info_table_begin(h, "defrag");
+	info_append_int(h, "relocated", memtx->defrag_relocated);
+	info_append_int(h, "passes", memtx->defrag_passes);
+	info_table_end(h);
+	info_end(h);
+}
+
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 {
@@ -1189,6 +2596,14 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 		smfree_delayed(&memtx->alloc, memtx_tuple, total);
 }
 
+size_t
+memtx_tuple_size(const struct tuple *tuple)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	return sizeof(struct memtx_tuple) + format->field_map_size +
+		tuple->bsize;
+}
+
 struct tuple_format_vtab memtx_tuple_format_vtab = {
 	memtx_tuple_delete,
 	memtx_tuple_new,
@@ -1271,6 +2686,25 @@ memtx_index_extent_reserve(struct memtx_engine *memtx, int num)
 	return 0;
 }
 
+void
+memtx_index_stat(struct index *index, struct info_handler *h)
+{
+	info_begin(h);
+	info_append_int(h, "bsize", index_bsize(index));
+	struct space *space = space_by_id(index->def->space_id);
+	if (index->def->iid == 0 && space != NULL &&
+	    space->index_count > 0 && space->index[0] == index) {
+		struct memtx_space *memtx_space = (struct memtx_space *)space;
+		info_table_begin(h, "space");
+		info_append_int(h, "tuples", memtx_space->tuple_memory);
+		info_append_int(h, "memory", memtx_space_memory(space));
+		info_append_int(h, "memory_quota",
+				space->def->opts.memory_quota);
+		info_table_end(h);
+	}
+	info_end(h);
+}
+
 bool
 memtx_index_def_change_requires_rebuild(struct index *index,
 					const struct index_def *new_def)
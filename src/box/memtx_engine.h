@@ -49,6 +49,7 @@ struct index;
 struct fiber;
 struct tuple;
 struct tuple_format;
+struct info_handler;
 
 /**
  * The state of memtx recovery process.
@@ -137,6 +138,30 @@ struct memtx_engine {
 	size_t max_tuple_size;
 	/** Incremented with each next snapshot. */
 	uint32_t snapshot_version;
+	/**
+	 * Max number of delta snapshots made after a full one,
+	 * box.cfg.memtx_checkpoint_delta_max. A delta snapshot
+	 * stores only spaces modified since the last full (base)
+	 * snapshot and refers to the base for the rest. Zero
+	 * disables delta snapshots.
+	 */
+	int checkpoint_delta_max;
+	/** Number of delta snapshots made against the base. */
+	int checkpoint_delta_count;
+	/**
+	 * Vclock of the base snapshot, i.e. the last full
+	 * snapshot made by this instance since restart, or
+	 * unset if there is no such snapshot.
+	 */
+	struct vclock snap_base_vclock;
+	/** Value of snapshot_version assigned to the base. */
+	uint32_t snap_base_version;
+	/**
+	 * Number of threads writing a snapshot in parallel,
+	 * box.cfg.memtx_checkpoint_threads. Each thread writes
+	 * its own chunk file.
+	 */
+	int checkpoint_threads;
 	/** Memory pool for rtree index iterator. */
 	struct mempool rtree_iterator_pool;
 	/**
@@ -155,6 +180,36 @@ struct memtx_engine {
 	 * memtx_gc_task::link.
 	 */
 	struct stailq gc_queue;
+	/**
+	 * Fraction of memory allocated for tuples but not used
+	 * that triggers defragmentation of the tuple allocator,
+	 * box.cfg.memtx_defrag_threshold. Zero disables it.
+	 */
+	double defrag_threshold;
+	/**
+	 * Defragmentation fiber. Relocates tuples in small
+	 * batches so that sparsely populated slabs are freed.
+	 */
+	struct fiber *defrag_fiber;
+	/** Id of the space being defragmented. */
+	uint32_t defrag_space_id;
+	/**
+	 * Primary key of the last tuple relocated in the space
+	 * being defragmented, allocated with malloc(), or NULL
+	 * if the defragmentation of the space hasn't started.
+	 */
+	char *defrag_key;
+	/** Number of tuples relocated by the defragmentation. */
+	int64_t defrag_relocated;
+	/** Number of completed defragmentation passes. */
+	int64_t defrag_passes;
+	/**
+	 * Expiration fiber. Deletes tuples of spaces with
+	 * space_opts::ttl_field set once they expire.
+	 */
+	struct fiber *expire_fiber;
+	/** Id of the space being checked for expired tuples. */
+	uint32_t expire_space_id;
 };
 
 struct memtx_gc_task;
@@ -195,6 +250,15 @@ int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			      const struct vclock *vclock);
 
+/**
+ * Rescan the snapshot directory and apprise the garbage
+ * collector of the checkpoints found there. Called after
+ * checkpoint files have been received from the master
+ * on initial join.
+ */
+int
+memtx_engine_scan_checkpoints(struct memtx_engine *memtx);
+
 void
 memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit);
 
@@ -204,6 +268,25 @@ memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
+void
+memtx_engine_set_checkpoint_delta_max(struct memtx_engine *memtx,
+				      int delta_max);
+
+void
+memtx_engine_set_checkpoint_threads(struct memtx_engine *memtx,
+				    int thread_count);
+
+/** Set the tuple allocator defragmentation threshold. */
+void
+memtx_engine_set_defrag_threshold(struct memtx_engine *memtx,
+				  double threshold);
+
+/**
+ * Memtx engine statistics (box.stat.memtx()).
+ */
+void
+memtx_engine_stat(struct memtx_engine *memtx, struct info_handler *h);
+
 /** Allocate a memtx tuple. @sa tuple_new(). */
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
@@ -212,6 +295,13 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
 void
 memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple);
 
+/**
+ * Return the number of bytes allocated for a memtx tuple,
+ * including the tuple header and the field map.
+ */
+size_t
+memtx_tuple_size(const struct tuple *tuple);
+
 /** Tuple format vtab for memtx engine. */
 extern struct tuple_format_vtab memtx_tuple_format_vtab;
 
@@ -241,6 +331,15 @@ memtx_index_extent_free(void *ctx, void *extent);
 int
 memtx_index_extent_reserve(struct memtx_engine *memtx, int num);
 
+/**
+ * Generic implementation of index_vtab::stat, common for all
+ * kinds of memtx indexes. Reports the memory used by the index.
+ * For a primary index, also reports the memory used by tuples
+ * and the memory used by the whole space.
+ */
+void
+memtx_index_stat(struct index *index, struct info_handler *h);
+
 /**
  * Generic implementation of index_vtab::def_change_requires_rebuild,
  * common for all kinds of memtx indexes.
@@ -283,6 +382,13 @@ memtx_engine_recover_snapshot_xc(struct memtx_engine *memtx,
 		diag_raise();
 }
 
+static inline void
+memtx_engine_scan_checkpoints_xc(struct memtx_engine *memtx)
+{
+	if (memtx_engine_scan_checkpoints(memtx) != 0)
+		diag_raise();
+}
+
 #endif /* defined(__plusplus) */
 
 #endif /* TARANTOOL_BOX_MEMTX_ENGINE_H_INCLUDED */
@@ -55,35 +55,35 @@ memtx_hash_equal_key(struct tuple *tuple, const char *key,
 				      key_def) == 0;
 }
 
-#define LIGHT_NAME _index
-#define LIGHT_DATA_TYPE struct tuple *
-#define LIGHT_KEY_TYPE const char *
-#define LIGHT_CMP_ARG_TYPE struct key_def *
-#define LIGHT_EQUAL(a, b, c) memtx_hash_equal(a, b, c)
-#define LIGHT_EQUAL_KEY(a, b, c) memtx_hash_equal_key(a, b, c)
-
-#include "salad/light.h"
-
-#undef LIGHT_NAME
-#undef LIGHT_DATA_TYPE
-#undef LIGHT_KEY_TYPE
-#undef LIGHT_CMP_ARG_TYPE
-#undef LIGHT_EQUAL
-#undef LIGHT_EQUAL_KEY
+#define SWISS_NAME _index
+#define SWISS_DATA_TYPE struct tuple *
+#define SWISS_KEY_TYPE const char *
+#define SWISS_CMP_ARG_TYPE struct key_def *
+#define SWISS_EQUAL(a, b, c) memtx_hash_equal(a, b, c)
+#define SWISS_EQUAL_KEY(a, b, c) memtx_hash_equal_key(a, b, c)
+
+#include "salad/swiss.h"
+
+#undef SWISS_NAME
+#undef SWISS_DATA_TYPE
+#undef SWISS_KEY_TYPE
+#undef SWISS_CMP_ARG_TYPE
+#undef SWISS_EQUAL
+#undef SWISS_EQUAL_KEY
 
 struct memtx_hash_index {
 	struct index base;
-	struct light_index_core hash_table;
+	struct swiss_index_core hash_table;
 	struct memtx_gc_task gc_task;
-	struct light_index_iterator gc_iterator;
+	struct swiss_index_iterator gc_iterator;
 };
 
 /* {{{ MemtxHash Iterators ****************************************/
 
 struct hash_iterator {
 	struct iterator base; /* Must be the first member. */
-	struct light_index_core *hash_table;
-	struct light_index_iterator iterator;
+	struct swiss_index_core *hash_table;
+	struct swiss_index_iterator iterator;
 	/** Memory pool the iterator was allocated from. */
 	struct mempool *pool;
 };
@@ -105,7 +105,7 @@ hash_iterator_ge(struct iterator *ptr, struct tuple **ret)
 {
 	assert(ptr->free == hash_iterator_free);
 	struct hash_iterator *it = (struct hash_iterator *) ptr;
-	struct tuple **res = light_index_iterator_get_and_next(it->hash_table,
+	struct tuple **res = swiss_index_iterator_get_and_next(it->hash_table,
 							       &it->iterator);
 	*ret = res != NULL ? *res : NULL;
 	return 0;
@@ -117,10 +117,10 @@ hash_iterator_gt(struct iterator *ptr, struct tuple **ret)
 	assert(ptr->free == hash_iterator_free);
 	ptr->next = hash_iterator_ge;
 	struct hash_iterator *it = (struct hash_iterator *) ptr;
-	struct tuple **res = light_index_iterator_get_and_next(it->hash_table,
+	struct tuple **res = swiss_index_iterator_get_and_next(it->hash_table,
 							       &it->iterator);
 	if (res != NULL)
-		res = light_index_iterator_get_and_next(it->hash_table,
+		res = swiss_index_iterator_get_and_next(it->hash_table,
 							&it->iterator);
 	*ret = res != NULL ? *res : NULL;
 	return 0;
@@ -147,7 +147,7 @@ hash_iterator_eq(struct iterator *it, struct tuple **ret)
 static void
 memtx_hash_index_free(struct memtx_hash_index *index)
 {
-	light_index_destroy(&index->hash_table);
+	swiss_index_destroy(&index->hash_table);
 	free(index);
 }
 
@@ -166,12 +166,12 @@ memtx_hash_index_gc_run(struct memtx_gc_task *task, bool *done)
 
 	struct memtx_hash_index *index = container_of(task,
 			struct memtx_hash_index, gc_task);
-	struct light_index_core *hash = &index->hash_table;
-	struct light_index_iterator *itr = &index->gc_iterator;
+	struct swiss_index_core *hash = &index->hash_table;
+	struct swiss_index_iterator *itr = &index->gc_iterator;
 
 	struct tuple **res;
 	unsigned int loops = 0;
-	while ((res = light_index_iterator_get_and_next(hash, itr)) != NULL) {
+	while ((res = swiss_index_iterator_get_and_next(hash, itr)) != NULL) {
 		tuple_unref(*res);
 		if (++loops >= YIELD_LOOPS) {
 			*done = false;
@@ -206,7 +206,7 @@ memtx_hash_index_destroy(struct index *base)
 		 * background task in order not to block tx thread.
 		 */
 		index->gc_task.vtab = &memtx_hash_index_gc_vtab;
-		light_index_iterator_begin(&index->hash_table,
+		swiss_index_iterator_begin(&index->hash_table,
 					   &index->gc_iterator);
 		memtx_engine_schedule_gc(memtx, &index->gc_task);
 	} else {
@@ -236,7 +236,7 @@ static ssize_t
 memtx_hash_index_bsize(struct index *base)
 {
 	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
-	return matras_extent_count(&index->hash_table.mtable) *
+	return swiss_index_extent_count(&index->hash_table) *
 					MEMTX_EXTENT_SIZE;
 }
 
@@ -244,17 +244,17 @@ static int
 memtx_hash_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 {
 	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
-	struct light_index_core *hash_table = &index->hash_table;
+	struct swiss_index_core *hash_table = &index->hash_table;
 
 	*result = NULL;
 	if (hash_table->count == 0)
 		return 0;
 	rnd %= (hash_table->table_size);
-	while (!light_index_pos_valid(hash_table, rnd)) {
+	while (!swiss_index_pos_valid(hash_table, rnd)) {
 		rnd++;
 		rnd %= (hash_table->table_size);
 	}
-	*result = light_index_get(hash_table, rnd);
+	*result = swiss_index_get(hash_table, rnd);
 	return 0;
 }
 
@@ -279,9 +279,9 @@ memtx_hash_index_get(struct index *base, const char *key,
 
 	*result = NULL;
 	uint32_t h = key_hash(key, base->def->key_def);
-	uint32_t k = light_index_find_key(&index->hash_table, h, key);
-	if (k != light_index_end)
-		*result = light_index_get(&index->hash_table, k);
+	uint32_t k = swiss_index_find_key(&index->hash_table, h, key);
+	if (k != swiss_index_end)
+		*result = swiss_index_get(&index->hash_table, k);
 	return 0;
 }
 
@@ -291,23 +291,23 @@ memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple **result)
 {
 	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
-	struct light_index_core *hash_table = &index->hash_table;
+	struct swiss_index_core *hash_table = &index->hash_table;
 
 	if (new_tuple) {
 		uint32_t h = tuple_hash(new_tuple, base->def->key_def);
 		struct tuple *dup_tuple = NULL;
-		uint32_t pos = light_index_replace(hash_table, h, new_tuple,
+		uint32_t pos = swiss_index_replace(hash_table, h, new_tuple,
 						   &dup_tuple);
-		if (pos == light_index_end)
-			pos = light_index_insert(hash_table, h, new_tuple);
+		if (pos == swiss_index_end)
+			pos = swiss_index_insert(hash_table, h, new_tuple);
 
 		ERROR_INJECT(ERRINJ_INDEX_ALLOC,
 		{
-			light_index_delete(hash_table, pos);
-			pos = light_index_end;
+			swiss_index_delete(hash_table, pos);
+			pos = swiss_index_end;
 		});
 
-		if (pos == light_index_end) {
+		if (pos == swiss_index_end) {
 			diag_set(OutOfMemory, (ssize_t)hash_table->count,
 				 "hash_table", "key");
 			return -1;
@@ -315,10 +315,10 @@ memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 		uint32_t errcode = replace_check_dup(old_tuple,
 						     dup_tuple, mode);
 		if (errcode) {
-			light_index_delete(hash_table, pos);
+			swiss_index_delete(hash_table, pos);
 			if (dup_tuple) {
-				uint32_t pos = light_index_insert(hash_table, h, dup_tuple);
-				if (pos == light_index_end) {
+				uint32_t pos = swiss_index_insert(hash_table, h, dup_tuple);
+				if (pos == swiss_index_end) {
 					panic("Failed to allocate memory in "
 					      "recover of int hash_table");
 				}
@@ -338,7 +338,7 @@ memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 
 	if (old_tuple) {
 		uint32_t h = tuple_hash(old_tuple, base->def->key_def);
-		int res = light_index_delete_value(hash_table, h, old_tuple);
+		int res = swiss_index_delete_value(hash_table, h, old_tuple);
 		assert(res == 0); (void) res;
 	}
 	*result = old_tuple;
@@ -364,26 +364,26 @@ memtx_hash_index_create_iterator(struct index *base, enum iterator_type type,
 	it->pool = &memtx->iterator_pool;
 	it->base.free = hash_iterator_free;
 	it->hash_table = &index->hash_table;
-	light_index_iterator_begin(it->hash_table, &it->iterator);
+	swiss_index_iterator_begin(it->hash_table, &it->iterator);
 
 	switch (type) {
 	case ITER_GT:
 		if (part_count != 0) {
-			light_index_iterator_key(it->hash_table, &it->iterator,
+			swiss_index_iterator_key(it->hash_table, &it->iterator,
 					key_hash(key, base->def->key_def), key);
 			it->base.next = hash_iterator_gt;
 		} else {
-			light_index_iterator_begin(it->hash_table, &it->iterator);
+			swiss_index_iterator_begin(it->hash_table, &it->iterator);
 			it->base.next = hash_iterator_ge;
 		}
 		break;
 	case ITER_ALL:
-		light_index_iterator_begin(it->hash_table, &it->iterator);
+		swiss_index_iterator_begin(it->hash_table, &it->iterator);
 		it->base.next = hash_iterator_ge;
 		break;
 	case ITER_EQ:
 		assert(part_count > 0);
-		light_index_iterator_key(it->hash_table, &it->iterator,
+		swiss_index_iterator_key(it->hash_table, &it->iterator,
 				key_hash(key, base->def->key_def), key);
 		it->base.next = hash_iterator_eq;
 		break;
@@ -398,8 +398,8 @@ memtx_hash_index_create_iterator(struct index *base, enum iterator_type type,
 
 struct hash_snapshot_iterator {
 	struct snapshot_iterator base;
-	struct light_index_core *hash_table;
-	struct light_index_iterator iterator;
+	struct swiss_index_core *hash_table;
+	struct swiss_index_iterator iterator;
 };
 
 /**
@@ -413,7 +413,7 @@ hash_snapshot_iterator_free(struct snapshot_iterator *iterator)
 	assert(iterator->free == hash_snapshot_iterator_free);
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
-	light_index_iterator_destroy(it->hash_table, &it->iterator);
+	swiss_index_iterator_destroy(it->hash_table, &it->iterator);
 	free(iterator);
 }
 
@@ -428,7 +428,7 @@ hash_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
 	assert(iterator->free == hash_snapshot_iterator_free);
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
-	struct tuple **res = light_index_iterator_get_and_next(it->hash_table,
+	struct tuple **res = swiss_index_iterator_get_and_next(it->hash_table,
 							       &it->iterator);
 	if (res == NULL)
 		return NULL;
@@ -455,8 +455,8 @@ memtx_hash_index_create_snapshot_iterator(struct index *base)
 	it->base.next = hash_snapshot_iterator_next;
 	it->base.free = hash_snapshot_iterator_free;
 	it->hash_table = &index->hash_table;
-	light_index_iterator_begin(it->hash_table, &it->iterator);
-	light_index_iterator_freeze(it->hash_table, &it->iterator);
+	swiss_index_iterator_begin(it->hash_table, &it->iterator);
+	swiss_index_iterator_freeze(it->hash_table, &it->iterator);
 	return (struct snapshot_iterator *) it;
 }
 
@@ -481,7 +481,7 @@ static const struct index_vtab memtx_hash_index_vtab = {
 	/* .create_iterator = */ memtx_hash_index_create_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_hash_index_create_snapshot_iterator,
-	/* .stat = */ generic_index_stat,
+	/* .stat = */ memtx_index_stat,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
 	/* .begin_build = */ generic_index_begin_build,
@@ -506,7 +506,7 @@ memtx_hash_index_new(struct memtx_engine *memtx, struct index_def *def)
 		return NULL;
 	}
 
-	light_index_create(&index->hash_table, MEMTX_EXTENT_SIZE,
+	swiss_index_create(&index->hash_table, MEMTX_EXTENT_SIZE,
 			   memtx_index_extent_alloc, memtx_index_extent_free,
 			   memtx, index->base.def->key_def);
 	return &index->base;
@@ -328,7 +328,7 @@ static const struct index_vtab memtx_rtree_index_vtab = {
 	/* .create_iterator = */ memtx_rtree_index_create_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
-	/* .stat = */ generic_index_stat,
+	/* .stat = */ memtx_index_stat,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
 	/* .begin_build = */ generic_index_begin_build,
@@ -56,6 +56,53 @@ memtx_space_bsize(struct space *space)
 	return memtx_space->bsize;
 }
 
+size_t
+memtx_space_memory(struct space *space)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	size_t memory = memtx_space->tuple_memory;
+	for (uint32_t i = 0; i < space->index_count; i++)
+		memory += index_bsize(space->index[i]);
+	return memory;
+}
+
+int
+memtx_space_relocate_tuple(struct space *space, struct tuple *tuple)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	assert(memtx_space->replace == memtx_space_replace_all_keys);
+	/*
+	 * A tuple referenced from elsewhere may be in use by
+	 * Lua or by a transaction, which expects to find it in
+	 * indexes on rollback, so leave it be.
+	 */
+	if (tuple->refs != 1)
+		return 0;
+
+	uint32_t bsize;
+	const char *data = tuple_data_range(tuple, &bsize);
+	struct tuple *new_tuple = memtx_tuple_new(tuple_format(tuple),
+						  data, data + bsize);
+	if (new_tuple == NULL)
+		return -1;
+	tuple_ref(new_tuple);
+	/*
+	 * The space content doesn't change so don't mark
+	 * the space as modified since the last snapshot.
+	 */
+	uint32_t snapshot_version = memtx_space->snapshot_version;
+	struct tuple *old_tuple;
+	int rc = memtx_space_replace_all_keys(space, tuple, new_tuple,
+					      DUP_REPLACE, &old_tuple);
+	memtx_space->snapshot_version = snapshot_version;
+	if (rc == 0) {
+		assert(old_tuple == tuple);
+		tuple_unref(old_tuple);
+	}
+	tuple_unref(new_tuple);
+	return rc == 0 ? 1 : -1;
+}
+
 /* {{{ DML */
 
 void
@@ -68,6 +115,41 @@ memtx_space_update_bsize(struct space *space,
 	ssize_t new_bsize = new_tuple ? box_tuple_bsize(new_tuple) : 0;
 	assert((ssize_t)memtx_space->bsize + new_bsize - old_bsize >= 0);
 	memtx_space->bsize += new_bsize - old_bsize;
+	if (old_tuple != NULL) {
+		size_t size = memtx_tuple_size(old_tuple);
+		assert(memtx_space->tuple_memory >= size);
+		memtx_space->tuple_memory -= size;
+	}
+	if (new_tuple != NULL)
+		memtx_space->tuple_memory += memtx_tuple_size(new_tuple);
+	struct memtx_engine *memtx = (struct memtx_engine *)space->engine;
+	memtx_space->snapshot_version = memtx->snapshot_version;
+}
+
+/**
+ * Check if replacing @old_tuple with @new_tuple in a space
+ * fits in the space memory quota. Changes that don't make
+ * tuples bigger are always allowed so that the user can free
+ * memory in a space that is over quota.
+ */
+static int
+memtx_space_check_memory_quota(struct space *space,
+			       struct tuple *old_tuple,
+			       struct tuple *new_tuple)
+{
+	int64_t quota = space->def->opts.memory_quota;
+	if (quota == 0 || new_tuple == NULL)
+		return 0;
+	size_t old_size = old_tuple != NULL ? memtx_tuple_size(old_tuple) : 0;
+	size_t new_size = memtx_tuple_size(new_tuple);
+	if (new_size <= old_size)
+		return 0;
+	size_t used = memtx_space_memory(space) + new_size - old_size;
+	if (used <= (size_t)quota)
+		return 0;
+	diag_set(ClientError, ER_SPACE_MEMORY_QUOTA, space_name(space),
+		 (unsigned long long)used, (long long)quota);
+	return -1;
 }
 
 /**
@@ -275,6 +357,16 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 			goto rollback;
 	}
 
+	/*
+	 * Check the quota after updating indexes, because we
+	 * don't know the old tuple in case of REPLACE before
+	 * looking it up in the primary index. Index extents
+	 * allocated by this statement are accounted too.
+	 */
+	if (memtx_space_check_memory_quota(space, old_tuple,
+					   new_tuple) != 0)
+		goto rollback;
+
 	memtx_space_update_bsize(space, old_tuple, new_tuple);
 	if (new_tuple != NULL)
 		tuple_ref(new_tuple);
@@ -617,6 +709,11 @@ memtx_space_ephemeral_rowid_next(struct space *space, uint64_t *rowid)
 static int
 memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 {
+	if (index_def->opts.is_covering) {
+		diag_set(ClientError, ER_UNSUPPORTED, "memtx",
+			 "covering indexes");
+		return -1;
+	}
 	if (index_def->key_def->is_nullable) {
 		if (index_def->iid == 0) {
 			diag_set(ClientError, ER_NULLABLE_PRIMARY,
@@ -837,6 +934,7 @@ memtx_space_drop_primary_key(struct space *space)
 	 */
 	memtx_space->replace = memtx_space_replace_no_keys;
 	memtx_space->bsize = 0;
+	memtx_space->tuple_memory = 0;
 }
 
 static void
@@ -935,6 +1033,7 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 
 	new_memtx_space->replace = old_memtx_space->replace;
 	new_memtx_space->bsize = old_memtx_space->bsize;
+	new_memtx_space->tuple_memory = old_memtx_space->tuple_memory;
 	return 0;
 }
 
@@ -1011,7 +1110,9 @@ memtx_space_new(struct memtx_engine *memtx,
 	tuple_format_unref(format);
 
 	memtx_space->bsize = 0;
+	memtx_space->tuple_memory = 0;
 	memtx_space->rowid = 0;
+	memtx_space->snapshot_version = memtx->snapshot_version;
 	memtx_space->replace = memtx_space_replace_no_keys;
 	return (struct space *)memtx_space;
 }
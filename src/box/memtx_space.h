@@ -42,6 +42,11 @@ struct memtx_space {
 	struct space base;
 	/* Number of bytes used in memory by tuples in the space. */
 	size_t bsize;
+	/**
+	 * Number of bytes allocated for tuples in the space.
+	 * Unlike @bsize, includes tuple headers and field maps.
+	 */
+	size_t tuple_memory;
 	/**
 	 * This counter is used to generate unique ids for
 	 * ephemeral spaces. Mostly used by SQL: values of this
@@ -49,6 +54,12 @@ struct memtx_space {
 	 * tuples within one unique primary key.
 	 */
 	uint64_t rowid;
+	/**
+	 * Value of memtx_engine::snapshot_version when the space
+	 * was last modified or created. Used to tell spaces that
+	 * changed since a snapshot from those that didn't.
+	 */
+	uint32_t snapshot_version;
 	/**
 	 * A pointer to replace function, set to different values
 	 * at different stages of recovery.
@@ -57,10 +68,20 @@ struct memtx_space {
 		       enum dup_replace_mode, struct tuple **);
 };
 
+/**
+ * Return the total amount of memory used by a memtx space,
+ * i.e. memory allocated for its tuples plus memory used by
+ * its indexes.
+ */
+size_t
+memtx_space_memory(struct space *space);
+
 /**
  * Change binary size of a space subtracting old tuple's size and
  * adding new tuple's size. Used also for rollback by swaping old
- * and new tuple.
+ * and new tuple. Marks the space as modified since the last
+ * snapshot, @sa memtx_space::snapshot_version. Updates
+ * memtx_space::tuple_memory accordingly.
  *
  * @param space Instance of memtx space.
  * @param old_tuple Old tuple (replaced or deleted).
@@ -71,6 +92,20 @@ memtx_space_update_bsize(struct space *space,
 			 const struct tuple *old_tuple,
 			 const struct tuple *new_tuple);
 
+/**
+ * Move a tuple of a memtx space to a newly allocated memory
+ * block and update all indexes of the space to point to it.
+ * Used to defragment the tuple allocator. A tuple is only
+ * relocated if it is referenced by the primary index only.
+ * The space must be fully built.
+ *
+ * @retval 1 if the tuple was relocated
+ * @retval 0 if the tuple was skipped
+ * @retval -1 on error, diag is set
+ */
+int
+memtx_space_relocate_tuple(struct space *space, struct tuple *tuple);
+
 int
 memtx_space_replace_no_keys(struct space *, struct tuple *, struct tuple *,
 			    enum dup_replace_mode, struct tuple **);
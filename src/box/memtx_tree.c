@@ -76,6 +76,7 @@ memtx_tree_compare_key(const struct tuple *tuple,
 #define bps_tree_elem_t struct tuple *
 #define bps_tree_key_t struct memtx_tree_key_data *
 #define bps_tree_arg_t struct key_def *
+#define BPS_INNER_CARD
 
 #include "salad/bps_tree.h"
 
@@ -87,6 +88,7 @@ memtx_tree_compare_key(const struct tuple *tuple,
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
+#undef BPS_INNER_CARD
 
 struct memtx_tree_index {
 	struct index base;
@@ -106,6 +108,45 @@ memtx_tree_qcompare(const void* a, const void *b, void *c)
 		*(struct tuple **)b, (struct key_def *)c);
 }
 
+/**
+ * Find the range [begin, end) of offsets of tuples in the tree
+ * that are visited by an iterator of the given type and key.
+ * Takes logarithmic time, because the tree maintains the count
+ * of elements in every subtree (see BPS_INNER_CARD).
+ */
+static void
+memtx_tree_range(const struct memtx_tree *tree, enum iterator_type type,
+		 struct memtx_tree_key_data *key_data,
+		 size_t *begin, size_t *end)
+{
+	*begin = 0;
+	*end = memtx_tree_size(tree);
+	if (key_data->key == NULL)
+		return;
+	switch (type) {
+	case ITER_ALL:
+	case ITER_GE:
+		memtx_tree_lower_bound_get_offset(tree, key_data, NULL, begin);
+		break;
+	case ITER_GT:
+		memtx_tree_upper_bound_get_offset(tree, key_data, NULL, begin);
+		break;
+	case ITER_EQ:
+	case ITER_REQ:
+		memtx_tree_lower_bound_get_offset(tree, key_data, NULL, begin);
+		memtx_tree_upper_bound_get_offset(tree, key_data, NULL, end);
+		break;
+	case ITER_LT:
+		memtx_tree_lower_bound_get_offset(tree, key_data, NULL, end);
+		break;
+	case ITER_LE:
+		memtx_tree_upper_bound_get_offset(tree, key_data, NULL, end);
+		break;
+	default:
+		unreachable();
+	}
+}
+
 /* {{{ MemtxTree Iterators ****************************************/
 struct tree_iterator {
 	struct iterator base;
@@ -341,6 +382,40 @@ tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
+/**
+ * Position a not yet started iterator right after the first
+ * @a count tuples it would return, without visiting them.
+ */
+static int
+tree_iterator_skip(struct iterator *iterator, uint32_t *count)
+{
+	struct tree_iterator *it = tree_iterator(iterator);
+	if (iterator->next != tree_iterator_start)
+		return 0;
+	assert(it->current_tuple == NULL);
+	size_t begin, end;
+	memtx_tree_range(it->tree, it->type, &it->key_data, &begin, &end);
+	size_t skip = MIN((size_t)*count, end - begin);
+	*count -= (uint32_t)skip;
+	if (skip == end - begin) {
+		iterator->next = tree_iterator_dummie;
+		return 0;
+	}
+	if (skip == 0)
+		return 0;
+	/* Position the iterator at the last skipped tuple. */
+	size_t offset = iterator_type_is_reverse(it->type) ?
+			end - skip : begin + skip - 1;
+	it->tree_iterator = memtx_tree_iterator_at(it->tree, offset);
+	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
+						&it->tree_iterator);
+	assert(res != NULL);
+	it->current_tuple = *res;
+	tuple_ref(it->current_tuple);
+	tree_iterator_set_next_method(it);
+	return 0;
+}
+
 /* }}} */
 
 /* {{{ MemtxTree  **********************************************************/
@@ -481,7 +556,15 @@ memtx_tree_index_count(struct index *base, enum iterator_type type,
 {
 	if (type == ITER_ALL)
 		return memtx_tree_index_size(base); /* optimization */
-	return generic_index_count(base, type, key, part_count);
+	if (type > ITER_GT)
+		return generic_index_count(base, type, key, part_count);
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct memtx_tree_key_data key_data;
+	key_data.key = part_count > 0 ? key : NULL;
+	key_data.part_count = part_count;
+	size_t begin, end;
+	memtx_tree_range(&index->tree, type, &key_data, &begin, &end);
+	return end - begin;
 }
 
 static int
@@ -573,6 +656,7 @@ memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 	iterator_create(&it->base, base);
 	it->pool = &memtx->iterator_pool;
 	it->base.next = tree_iterator_start;
+	it->base.skip = tree_iterator_skip;
 	it->base.free = tree_iterator_free;
 	it->type = type;
 	it->key_data.key = key;
@@ -736,7 +820,7 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator,
-	/* .stat = */ generic_index_stat,
+	/* .stat = */ memtx_index_stat,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
 	/* .begin_build = */ memtx_tree_index_begin_build,
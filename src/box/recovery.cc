@@ -30,6 +30,12 @@
  */
 #include "recovery.h"
 
+#include "trivia/config.h"
+#if defined(TARGET_OS_LINUX)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif /* defined(TARGET_OS_LINUX) */
+
 #include "small/rlist.h"
 #include "scoped_guard.h"
 #include "trigger.h"
@@ -242,6 +248,10 @@ recover_xlog(struct recovery *r, struct xstream *stream,
 {
 	struct xrow_header row;
 	uint64_t row_count = 0;
+	off_t start_pos = xlog_cursor_pos(&r->cursor);
+	auto size_guard = make_scoped_guard([&] {
+		r->wal_size_read += xlog_cursor_pos(&r->cursor) - start_pos;
+	});
 	while (xlog_cursor_next_xc(&r->cursor, &row,
 				   r->wal_dir.force_recovery) == 0) {
 		/*
@@ -372,6 +382,13 @@ recovery_finalize(struct recovery *r)
  * Any change to the WAL dir itself or a change in the XLOG
  * file triggers a wakeup. The WAL dir path is set in the
  * constructor. XLOG file path is set with set_log_path().
+ *
+ * On Linux, inotify is used directly: a file created in or
+ * removed from the WAL dir or a write to the XLOG file wakes
+ * up the subscriber right away. ev_stat can't be relied upon
+ * for this, because it only reports a change if stat() data
+ * differ, and the WAL dir mtime has one second granularity.
+ * If inotify isn't available, ev_stat is used instead.
  */
 class WalSubscription {
 public:
@@ -381,6 +398,15 @@ public:
 	struct ev_stat file_stat;
 	char dir_path[PATH_MAX];
 	char file_path[PATH_MAX];
+#if defined(TARGET_OS_LINUX)
+	/** Inotify instance fd or -1 if ev_stat is used. */
+	int inotify_fd;
+	/** Watch descriptor of the WAL dir. */
+	int dir_wd;
+	/** Watch descriptor of the XLOG file, -1 if none. */
+	int file_wd;
+	struct ev_io inotify_io;
+#endif
 
 	static void dir_stat_cb(struct ev_loop *, struct ev_stat *stat, int)
 	{
@@ -414,18 +440,32 @@ public:
 		dir_stat.data = this;
 		file_stat.data = this;
 
+#if defined(TARGET_OS_LINUX)
+		if (inotify_start() == 0)
+			return;
+#endif
 		ev_stat_set(&dir_stat, dir_path, 0.0);
 		ev_stat_start(loop(), &dir_stat);
 	}
 
 	~WalSubscription()
 	{
+#if defined(TARGET_OS_LINUX)
+		if (inotify_fd >= 0) {
+			ev_io_stop(loop(), &inotify_io);
+			close(inotify_fd);
+		}
+#endif
 		ev_stat_stop(loop(), &file_stat);
 		ev_stat_stop(loop(), &dir_stat);
 	}
 
 	void set_log_path(const char *path)
 	{
+#if defined(TARGET_OS_LINUX)
+		if (inotify_fd >= 0 && inotify_set_log_path(path) == 0)
+			return;
+#endif
 		/*
 		 * Avoid toggling ev_stat if the path didn't change.
 		 * Note: .file_path valid iff file_stat is active.
@@ -449,6 +489,157 @@ public:
 		ev_stat_set(&file_stat, file_path, 0.0);
 		ev_stat_start(loop(), &file_stat);
 	}
+
+#if defined(TARGET_OS_LINUX)
+	static void inotify_cb(struct ev_loop *, struct ev_io *io, int)
+	{
+		((WalSubscription *)io->data)->inotify_read();
+	}
+
+	/**
+	 * Start watching the WAL dir with inotify.
+	 * Returns -1 if inotify can't be used.
+	 */
+	int inotify_start()
+	{
+		file_wd = -1;
+		inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (inotify_fd < 0) {
+			say_syserror("inotify_init1");
+			return -1;
+		}
+		if (inotify_watch_dir() != 0) {
+			close(inotify_fd);
+			inotify_fd = -1;
+			return -1;
+		}
+		ev_io_init(&inotify_io, inotify_cb, inotify_fd, EV_READ);
+		inotify_io.data = this;
+		ev_io_start(loop(), &inotify_io);
+		return 0;
+	}
+
+	int inotify_watch_dir()
+	{
+		dir_wd = inotify_add_watch(inotify_fd, dir_path,
+					   IN_CREATE | IN_DELETE |
+					   IN_MOVED_FROM | IN_MOVED_TO |
+					   IN_DELETE_SELF | IN_MOVE_SELF);
+		if (dir_wd < 0) {
+			say_syserror("inotify_add_watch, called on '%s'",
+				     dir_path);
+			return -1;
+		}
+		return 0;
+	}
+
+	/**
+	 * Handle removal of a watch, either by inotify_rm_watch()
+	 * on a switch to the next XLOG file or by the kernel when
+	 * the watched file or directory is gone. Returns the
+	 * events to report to the subscriber.
+	 */
+	unsigned inotify_watch_removed(int wd)
+	{
+		if (wd == file_wd) {
+			/*
+			 * The XLOG file is gone. Forget the watch,
+			 * so that it's set again by set_log_path().
+			 */
+			file_wd = -1;
+			return WAL_EVENT_ROTATE | WAL_EVENT_WRITE;
+		}
+		if (wd == dir_wd) {
+			/*
+			 * The WAL dir is gone or replaced. Watch it
+			 * again or fall back on ev_stat, otherwise
+			 * new XLOG files would be noticed only by
+			 * the periodic rescan.
+			 */
+			if (inotify_watch_dir() != 0) {
+				ev_stat_set(&dir_stat, dir_path, 0.0);
+				ev_stat_start(loop(), &dir_stat);
+			}
+			return WAL_EVENT_ROTATE | WAL_EVENT_WRITE;
+		}
+		/* A watch removed by inotify_rm_watch(). */
+		return 0;
+	}
+
+	/**
+	 * Watch the XLOG file with inotify. Returns -1 if the file
+	 * can't be watched, in which case ev_stat should be used.
+	 */
+	int inotify_set_log_path(const char *path)
+	{
+		if (path != NULL && file_wd >= 0 &&
+		    strcmp(file_path, path) == 0)
+			return 0;
+		if (file_wd >= 0) {
+			inotify_rm_watch(inotify_fd, file_wd);
+			file_wd = -1;
+		}
+		if (path == NULL)
+			return 0;
+		if ((size_t)snprintf(file_path, sizeof(file_path), "%s", path) >=
+				sizeof(file_path)) {
+
+			panic("path too long: %s", path);
+		}
+		file_wd = inotify_add_watch(inotify_fd, file_path,
+					    IN_MODIFY | IN_DELETE_SELF |
+					    IN_MOVE_SELF);
+		if (file_wd < 0) {
+			say_syserror("inotify_add_watch, called on '%s'",
+				     file_path);
+			return -1;
+		}
+		/*
+		 * Rows could have been appended after the file had
+		 * been read, but before the watch was set. Make the
+		 * subscriber check the file once more.
+		 */
+		events |= WAL_EVENT_WRITE;
+		return 0;
+	}
+
+	void inotify_read()
+	{
+		char buf[4096]
+			__attribute__((aligned(__alignof__(struct inotify_event))));
+		unsigned new_events = 0;
+		while (true) {
+			ssize_t n = read(inotify_fd, buf, sizeof(buf));
+			if (n <= 0) {
+				if (n < 0 && errno != EAGAIN && errno != EINTR)
+					say_syserror("inotify read");
+				break;
+			}
+			for (char *pos = buf; pos < buf + n; ) {
+				struct inotify_event *ev =
+					(struct inotify_event *)pos;
+				pos += sizeof(*ev) + ev->len;
+				if ((ev->mask & IN_IGNORED) != 0) {
+					new_events |=
+						inotify_watch_removed(ev->wd);
+				} else if (ev->wd == file_wd &&
+				    (ev->mask & IN_MODIFY) != 0) {
+					new_events |= WAL_EVENT_WRITE;
+				} else {
+					/*
+					 * A change in the WAL dir,
+					 * a removed XLOG file or
+					 * a queue overflow.
+					 */
+					new_events |= WAL_EVENT_ROTATE |
+						      WAL_EVENT_WRITE;
+				}
+			}
+		}
+		if (new_events != 0)
+			wakeup(new_events);
+	}
+#endif /* defined(TARGET_OS_LINUX) */
 };
 
 static int
@@ -59,6 +59,8 @@ struct recovery {
 	struct fiber *watcher;
 	/** List of triggers invoked when the current WAL is closed. */
 	struct rlist on_close_log;
+	/** Size of WAL data read so far, in bytes. */
+	int64_t wal_size_read;
 };
 
 struct recovery *
@@ -30,6 +30,12 @@
  */
 #include "relay.h"
 
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zstd.h>
+
 #include "trivia/config.h"
 #include "trivia/util.h"
 #include "scoped_guard.h"
@@ -53,6 +59,17 @@
 #include "xrow_io.h"
 #include "xstream.h"
 #include "wal.h"
+#include "box.h"
+
+enum {
+	/**
+	 * Size of the buffer accumulating rows before they
+	 * are written to the socket, see relay_write_row().
+	 * The buffer is compressed as a whole, so it must not
+	 * exceed what a replica accepts in a compressed frame.
+	 */
+	RELAY_SEND_BUF_SIZE = XROW_COMPRESSED_ROWS_MAX,
+};
 
 /**
  * Cbus message to send status updates from relay to tx thread.
@@ -132,6 +149,31 @@ struct relay {
 	double last_row_tm;
 	/** Relay sync state. */
 	enum relay_state state;
+	/**
+	 * Rows not sent yet. Allocated with malloc(), because
+	 * the rows may be fed by an engine or relay thread.
+	 * If NULL, rows are written to the socket one by one.
+	 */
+	struct {
+		char *data;
+		size_t used;
+	} send_buf;
+	/**
+	 * Level of compression the replica asked for on
+	 * SUBSCRIBE, 0 if the stream isn't compressed.
+	 */
+	int compression;
+	/**
+	 * Compression stream, NULL unless compression is on.
+	 * The stream lives as long as the subscription, so that
+	 * each frame is compressed with the history of the rows
+	 * sent before it.
+	 */
+	ZSTD_CStream *zstream;
+	/** Buffer for a compressed frame of send_buf rows. */
+	char *zbuf;
+	/** Size of zbuf. */
+	size_t zbuf_size;
 
 	struct {
 		/* Align to prevent false-sharing with tx thread */
@@ -162,6 +204,8 @@ relay_vclock(const struct relay *relay)
 static void
 relay_send(struct relay *relay, struct xrow_header *packet);
 static void
+relay_flush(struct relay *relay);
+static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
 relay_send_row(struct xstream *stream, struct xrow_header *row);
@@ -242,6 +286,15 @@ relay_stop(struct relay *relay)
 	if (relay->r != NULL)
 		recovery_delete(relay->r);
 	relay->r = NULL;
+	free(relay->send_buf.data);
+	relay->send_buf.data = NULL;
+	relay->send_buf.used = 0;
+	if (relay->zstream != NULL)
+		ZSTD_freeCStream(relay->zstream);
+	relay->zstream = NULL;
+	free(relay->zbuf);
+	relay->zbuf = NULL;
+	relay->compression = 0;
 	relay->state = RELAY_STOPPED;
 	/*
 	 * Needed to track whether relay thread is running or not
@@ -262,6 +315,61 @@ relay_delete(struct relay *relay)
 	free(relay);
 }
 
+/**
+ * Allocate the buffer accumulating rows before sending them
+ * and, if @a compression is set, the compression stream.
+ * Must be called before relay_start(), so that the relay is
+ * left intact on failure.
+ */
+static int
+relay_create_send_buf(struct relay *relay, uint32_t compression)
+{
+	assert(relay->send_buf.data == NULL && relay->zstream == NULL);
+	size_t rc;
+	relay->send_buf.data = (char *) malloc(RELAY_SEND_BUF_SIZE);
+	if (relay->send_buf.data == NULL) {
+		diag_set(OutOfMemory, RELAY_SEND_BUF_SIZE,
+			 "malloc", "relay send buffer");
+		goto fail;
+	}
+	relay->send_buf.used = 0;
+	if (compression == 0)
+		return 0;
+	relay->compression = MIN(compression, (uint32_t) ZSTD_maxCLevel());
+	relay->zstream = ZSTD_createCStream();
+	if (relay->zstream == NULL) {
+		diag_set(ClientError, ER_COMPRESSION,
+			 "failed to create stream");
+		goto fail;
+	}
+	rc = ZSTD_initCStream(relay->zstream, relay->compression);
+	if (ZSTD_isError(rc)) {
+		diag_set(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+		goto fail;
+	}
+	/*
+	 * A flushed frame of send_buf rows can't take more than
+	 * the bound, since the stream has nothing buffered from
+	 * the previous frame.
+	 */
+	relay->zbuf_size = ZSTD_compressBound(RELAY_SEND_BUF_SIZE);
+	relay->zbuf = (char *) malloc(relay->zbuf_size);
+	if (relay->zbuf == NULL) {
+		diag_set(OutOfMemory, relay->zbuf_size,
+			 "malloc", "relay compression buffer");
+		goto fail;
+	}
+	return 0;
+fail:
+	free(relay->send_buf.data);
+	relay->send_buf.data = NULL;
+	if (relay->zstream != NULL)
+		ZSTD_freeCStream(relay->zstream);
+	relay->zstream = NULL;
+	relay->compression = 0;
+	return -1;
+}
+
 static void
 relay_set_cord_name(int fd)
 {
@@ -284,6 +392,10 @@ relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
 	if (relay == NULL)
 		diag_raise();
 
+	if (relay_create_send_buf(relay, 0) != 0) {
+		relay_delete(relay);
+		diag_raise();
+	}
 	relay_start(relay, fd, sync, relay_send_initial_join_row);
 	auto relay_guard = make_scoped_guard([=] {
 		relay_stop(relay);
@@ -291,6 +403,151 @@ relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
 	});
 
 	engine_join_xc(vclock, &relay->stream);
+	relay_flush(relay);
+}
+
+/** A checkpoint file sent to a replica on initial join. */
+struct relay_join_file {
+	/** Link in relay_join_files::files. */
+	struct rlist in_files;
+	/** Size of the file. */
+	uint64_t size;
+	/** Name of the file sent to the replica. */
+	char *name;
+	/** Path to the file. */
+	char path[0];
+};
+
+/** List of checkpoint files sent to a replica on initial join. */
+struct relay_join_files {
+	/** Relay sending the files. */
+	struct relay *relay;
+	/** Engine whose files are being collected. */
+	struct engine *engine;
+	/** Directory of the engine. */
+	char dir[PATH_MAX];
+	/** List of relay_join_file objects. */
+	struct rlist files;
+};
+
+/**
+ * Engine backup callback that adds a checkpoint file to
+ * the list of files to send. The file is sent under the
+ * name <engine>/<path relative to the engine directory>
+ * so that the replica can put it to its own directory.
+ */
+static int
+relay_add_join_file(const char *path, void *arg)
+{
+	struct relay_join_files *ctx = (struct relay_join_files *)arg;
+	size_t dir_len = strlen(ctx->dir);
+	if (strncmp(path, ctx->dir, dir_len) != 0 || path[dir_len] != '/') {
+		diag_set(ClientError, ER_UNSUPPORTED, ctx->engine->name,
+			 "checkpoint files outside of the engine directory");
+		return -1;
+	}
+	struct stat st;
+	if (stat(path, &st) != 0) {
+		diag_set(SystemError, "failed to stat file '%s'", path);
+		return -1;
+	}
+	const char *rel_path = path + dir_len + 1;
+	size_t path_len = strlen(path) + 1;
+	size_t name_len = strlen(ctx->engine->name) + 1 + strlen(rel_path) + 1;
+	size_t size = sizeof(struct relay_join_file) + path_len + name_len;
+	struct relay_join_file *file = (struct relay_join_file *)malloc(size);
+	if (file == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "struct relay_join_file");
+		return -1;
+	}
+	file->size = st.st_size;
+	memcpy(file->path, path, path_len);
+	file->name = file->path + path_len;
+	snprintf(file->name, name_len, "%s/%s", ctx->engine->name, rel_path);
+	rlist_add_tail_entry(&ctx->files, file, in_files);
+	return 0;
+}
+
+static int
+relay_initial_join_files_f(va_list ap)
+{
+	struct relay_join_files *ctx = va_arg(ap, struct relay_join_files *);
+	struct relay *relay = ctx->relay;
+
+	coio_enable();
+	relay_set_cord_name(relay->io.fd);
+
+	struct relay_join_file *file;
+	rlist_foreach_entry(file, &ctx->files, in_files) {
+		int fd = open(file->path, O_RDONLY);
+		if (fd < 0) {
+			tnt_raise(SystemError, "failed to open file '%s'",
+				  file->path);
+		}
+		auto fd_guard = make_scoped_guard([=] { close(fd); });
+		struct xrow_header row;
+		xrow_encode_join_file_xc(&row, file->name, file->size);
+		relay_send(relay, &row);
+		relay_flush(relay);
+		coio_sendfile(&relay->io, fd, 0, file->size);
+		say_verbose("sent file `%s'", file->path);
+	}
+	return 0;
+}
+
+void
+relay_initial_join_files(int fd, uint64_t sync, struct vclock *vclock)
+{
+	struct relay_join_files ctx;
+	rlist_create(&ctx.files);
+	auto files_guard = make_scoped_guard([&] {
+		struct relay_join_file *file, *tmp;
+		rlist_foreach_entry_safe(file, &ctx.files, in_files, tmp)
+			free(file);
+	});
+	/*
+	 * Collect files in tx, because engines maintain the lists
+	 * of checkpoint files there. The files can't be deleted
+	 * while the join is in progress, because the caller holds
+	 * a reference to the checkpoint.
+	 */
+	struct engine *engine;
+	engine_foreach(engine) {
+		const char *dir = box_engine_dir(engine->name);
+		if (dir == NULL)
+			continue;
+		ctx.engine = engine;
+		snprintf(ctx.dir, sizeof(ctx.dir), "%s", dir);
+		if (engine->vtab->backup(engine, vclock, relay_add_join_file,
+					 &ctx) != 0)
+			diag_raise();
+	}
+
+	struct relay *relay = relay_new(NULL);
+	if (relay == NULL)
+		diag_raise();
+
+	if (relay_create_send_buf(relay, 0) != 0) {
+		relay_delete(relay);
+		diag_raise();
+	}
+	relay_start(relay, fd, sync, relay_send_initial_join_row);
+	auto relay_guard = make_scoped_guard([=] {
+		relay_stop(relay);
+		relay_delete(relay);
+	});
+	ctx.relay = relay;
+
+	/*
+	 * Send the files from a separate thread so that reading
+	 * them from disk doesn't stall tx.
+	 */
+	int rc = cord_costart(&relay->cord, "initial_join",
+			      relay_initial_join_files_f, &ctx);
+	if (rc == 0)
+		rc = cord_cojoin(&relay->cord);
+	if (rc != 0)
+		diag_raise();
 }
 
 int
@@ -306,6 +563,7 @@ relay_final_join_f(va_list ap)
 	assert(relay->stream.write != NULL);
 	recover_remaining_wals(relay->r, &relay->stream,
 			       &relay->stop_vclock, true);
+	relay_flush(relay);
 	assert(vclock_compare(&relay->r->vclock, &relay->stop_vclock) == 0);
 	return 0;
 }
@@ -318,6 +576,10 @@ relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
 	if (relay == NULL)
 		diag_raise();
 
+	if (relay_create_send_buf(relay, 0) != 0) {
+		relay_delete(relay);
+		diag_raise();
+	}
 	relay_start(relay, fd, sync, relay_send_row);
 	auto relay_guard = make_scoped_guard([=] {
 		relay_stop(relay);
@@ -453,6 +715,7 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 	try {
 		recover_remaining_wals(relay->r, &relay->stream, NULL,
 				       (events & WAL_EVENT_ROTATE) != 0);
+		relay_flush(relay);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -501,6 +764,7 @@ relay_send_heartbeat(struct relay *relay)
 	xrow_encode_timestamp(&row, instance_id, ev_now(loop()));
 	try {
 		relay_send(relay, &row);
+		relay_flush(relay);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -629,7 +893,8 @@ relay_subscribe_f(va_list ap)
 /** Replication acceptor fiber handler. */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_clock, uint32_t replica_version_id)
+		struct vclock *replica_clock, uint32_t replica_version_id,
+		uint32_t compression)
 {
 	assert(replica->id != REPLICA_ID_NIL);
 	struct relay *relay = replica->relay;
@@ -646,6 +911,8 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 			diag_raise();
 	}
 
+	if (relay_create_send_buf(relay, compression) != 0)
+		diag_raise();
 	relay_start(relay, fd, sync, relay_send_row);
 	vclock_copy(&relay->local_vclock_at_subscribe, &replicaset.vclock);
 	relay->r = recovery_new(cfg_gets("wal_dir"), false,
@@ -665,21 +932,118 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 		diag_raise();
 }
 
+/**
+ * Feed the rows accumulated in the send buffer to the
+ * compression stream and flush it, so that the frame can be
+ * unpacked by the replica without waiting for more data.
+ * Returns the size of the frame in relay->zbuf.
+ */
+static size_t
+relay_compress(struct relay *relay, size_t used)
+{
+	ZSTD_inBuffer input = {relay->send_buf.data, used, 0};
+	ZSTD_outBuffer output = {relay->zbuf, relay->zbuf_size, 0};
+	size_t rc;
+	while (input.pos < input.size) {
+		rc = ZSTD_compressStream(relay->zstream, &output, &input);
+		if (ZSTD_isError(rc))
+			goto error;
+		if (output.pos == output.size)
+			goto overflow;
+	}
+	do {
+		rc = ZSTD_flushStream(relay->zstream, &output);
+		if (ZSTD_isError(rc))
+			goto error;
+		if (rc != 0 && output.pos == output.size)
+			goto overflow;
+	} while (rc != 0);
+	return output.pos;
+error:
+	tnt_raise(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+overflow:
+	tnt_raise(ClientError, ER_COMPRESSION, "frame is too large");
+}
+
+/**
+ * Write the rows accumulated in the send buffer to the socket.
+ * If the replica asked for compression, pack them in a single
+ * compressed frame. Rows that have been fed to the stream can't
+ * be sent as is, even if they don't compress well: the replica
+ * needs them to unpack the following frames.
+ */
+static void
+relay_flush(struct relay *relay)
+{
+	size_t used = relay->send_buf.used;
+	if (used == 0)
+		return;
+	relay->send_buf.used = 0;
+	if (relay->zstream == NULL) {
+		coio_write(&relay->io, relay->send_buf.data, used);
+		return;
+	}
+	size_t zsize = relay_compress(relay, used);
+	struct xrow_header row;
+	xrow_encode_compressed_rows_xc(&row, relay->zbuf, zsize);
+	row.sync = relay->sync;
+	coio_write_xrow(&relay->io, &row);
+	fiber_gc();
+}
+
+/**
+ * Write a row to the socket. If the relay has a send buffer,
+ * the row is appended to it, and the buffer is only written
+ * out when full or on relay_flush(), so that a burst of rows
+ * is sent with a few system calls rather than one per row.
+ */
+static void
+relay_write_row(struct relay *relay, struct xrow_header *row)
+{
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec_xc(row, iov);
+	if (relay->send_buf.data == NULL) {
+		coio_writev(&relay->io, iov, iovcnt, 0);
+		return;
+	}
+	size_t len = 0;
+	for (int i = 0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+	if (relay->send_buf.used + len > RELAY_SEND_BUF_SIZE)
+		relay_flush(relay);
+	if (len > RELAY_SEND_BUF_SIZE) {
+		coio_writev(&relay->io, iov, iovcnt, len);
+		return;
+	}
+	char *pos = relay->send_buf.data + relay->send_buf.used;
+	for (int i = 0; i < iovcnt; i++) {
+		memcpy(pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+	relay->send_buf.used += len;
+}
+
 static void
 relay_send(struct relay *relay, struct xrow_header *packet)
 {
 	struct errinj *inj = errinj(ERRINJ_RELAY_SEND_DELAY, ERRINJ_BOOL);
-	while (inj != NULL && inj->bparam)
-		fiber_sleep(0.01);
+	if (inj != NULL && inj->bparam) {
+		/* Deliver what has been sent before the delay. */
+		relay_flush(relay);
+		while (inj->bparam)
+			fiber_sleep(0.01);
+	}
 
 	packet->sync = relay->sync;
 	relay->last_row_tm = ev_monotonic_now(loop());
-	coio_write_xrow(&relay->io, packet);
+	relay_write_row(relay, packet);
 	fiber_gc();
 
 	inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
-	if (inj != NULL && inj->dparam > 0)
+	if (inj != NULL && inj->dparam > 0) {
+		relay_flush(relay);
 		fiber_sleep(inj->dparam);
+	}
 }
 
 static void
@@ -690,8 +1054,10 @@ relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 	 * Ignore replica local requests as we don't need to promote
 	 * vclock while sending a snapshot.
 	 */
-	if (row->group_id != GROUP_LOCAL)
-		relay_send(relay, row);
+	if (row->group_id == GROUP_LOCAL)
+		return;
+
+	relay_send(relay, row);
 }
 
 /** Send a single row to the client. */
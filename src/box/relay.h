@@ -99,6 +99,17 @@ relay_vclock(const struct relay *relay);
 void
 relay_initial_join(int fd, uint64_t sync, struct vclock *vclock);
 
+/**
+ * Send checkpoint files to the replica instead of initial
+ * JOIN rows.
+ *
+ * @param fd        client connection
+ * @param sync      sync from incoming JOIN request
+ * @param vclock    vclock of the last checkpoint
+ */
+void
+relay_initial_join_files(int fd, uint64_t sync, struct vclock *vclock);
+
 /**
  * Send final JOIN rows to the replica.
  *
@@ -116,6 +127,7 @@ relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
  */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_vclock, uint32_t replica_version_id);
+		struct vclock *replica_vclock, uint32_t replica_version_id,
+		uint32_t compression);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
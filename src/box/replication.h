@@ -137,6 +137,12 @@ extern double replication_sync_timeout;
  */
 extern bool replication_skip_conflict;
 
+/**
+ * Level of compression the master is asked to apply to
+ * the replication stream on SUBSCRIBE, 0 to disable.
+ */
+extern int replication_compression;
+
 /**
  * Wait for the given period of time before trying to reconnect
  * to a master.
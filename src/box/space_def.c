@@ -57,6 +57,8 @@ const struct space_opts space_opts_default = {
 	/* .view = */ false,
 	/* .sql        = */ NULL,
 	/* .checks     = */ NULL,
+	/* .memory_quota = */ 0,
+	/* .ttl_field  = */ 0,
 };
 
 const struct opt_def space_opts_reg[] = {
@@ -66,6 +68,8 @@ const struct opt_def space_opts_reg[] = {
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
 	OPT_DEF_ARRAY("checks", struct space_opts, checks,
 		      checks_array_decode),
+	OPT_DEF("memory_quota", OPT_INT64, struct space_opts, memory_quota),
+	OPT_DEF("ttl_field", OPT_UINT32, struct space_opts, ttl_field),
 	OPT_END,
 };
 
@@ -73,6 +73,19 @@ struct space_opts {
 	char *sql;
 	/** SQL Checks expressions list. */
 	struct ExprList *checks;
+	/**
+	 * Max amount of memory the space may use, in bytes,
+	 * or 0 if unlimited. Only supported by memtx.
+	 */
+	int64_t memory_quota;
+	/**
+	 * Number of the field, starting from 1, that stores
+	 * the time, in seconds since the Epoch, when a tuple
+	 * expires, or 0 if tuples never expire. Expired tuples
+	 * are removed by memtx in background and dropped by
+	 * vinyl compaction.
+	 */
+	uint32_t ttl_field;
 };
 
 extern const struct space_opts space_opts_default;
@@ -312,6 +312,7 @@ vy_info_append_memory(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "tuple_cache", env->cache_env.mem_used);
 	info_append_int(h, "page_index", env->lsm_env.page_index_size);
 	info_append_int(h, "bloom_filter", env->lsm_env.bloom_size);
+	info_append_int(h, "meta_cache", env->run_env.meta_cache.mem_used);
 	info_table_end(h); /* memory */
 }
 
@@ -423,6 +424,11 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_append_int(h, "hit", stat->disk.iterator.bloom_hit);
 	info_append_int(h, "miss", stat->disk.iterator.bloom_miss);
 	info_table_end(h); /* bloom */
+	info_table_begin(h, "readahead");
+	info_append_int(h, "pages", stat->disk.iterator.readahead.pages);
+	info_append_int(h, "hit", stat->disk.iterator.readahead.hit);
+	info_append_int(h, "waste", stat->disk.iterator.readahead.waste);
+	info_table_end(h); /* readahead */
 	info_table_end(h); /* iterator */
 	info_table_begin(h, "dump");
 	info_append_int(h, "count", stat->disk.dump.count);
@@ -448,6 +454,7 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	vy_info_append_stmt_counter(h, "put", &cache_stat->put);
 	vy_info_append_stmt_counter(h, "invalidate", &cache_stat->invalidate);
 	vy_info_append_stmt_counter(h, "evict", &cache_stat->evict);
+	vy_info_append_stmt_counter(h, "promote", &cache_stat->promote);
 	info_append_int(h, "index_size",
 			vy_cache_tree_mem_used(&lsm->cache.cache_tree));
 	info_table_end(h); /* cache */
@@ -469,6 +476,24 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_append_int(h, "dumps_per_compaction",
 			vy_lsm_dumps_per_compaction(lsm));
 
+	/*
+	 * Amplification factors as observed with the configured
+	 * compaction strategy: bytes written to disk per byte
+	 * dumped, runs checked per lookup, and disk bytes per
+	 * byte of the last LSM tree level.
+	 */
+	double dump_bytes = stat->disk.dump.output.bytes;
+	double last_level_bytes = stat->disk.last_level_count.bytes;
+	info_table_begin(h, "amplification");
+	info_append_double(h, "write", dump_bytes == 0 ? 0 :
+			   (dump_bytes + stat->disk.compaction.output.bytes) /
+			   dump_bytes);
+	info_append_double(h, "read",
+			   (double)lsm->run_count / lsm->range_count);
+	info_append_double(h, "space", last_level_bytes == 0 ? 0 :
+			   stat->disk.count.bytes / last_level_bytes);
+	info_table_end(h); /* amplification */
+
 	info_end(h);
 }
 
@@ -509,6 +534,7 @@ vinyl_index_reset_stat(struct index *index)
 	vy_stmt_counter_reset(&cache_stat->put);
 	vy_stmt_counter_reset(&cache_stat->invalidate);
 	vy_stmt_counter_reset(&cache_stat->evict);
+	vy_stmt_counter_reset(&cache_stat->promote);
 }
 
 static void
@@ -521,6 +547,7 @@ vinyl_engine_memory_stat(struct engine *engine, struct engine_memory_stat *stat)
 	stat->index += env->mem_env.tree_extent_size;
 	stat->index += env->lsm_env.bloom_size;
 	stat->index += env->lsm_env.page_index_size;
+	stat->index += env->run_env.meta_cache.mem_used;
 	stat->cache += env->cache_env.mem_used;
 	stat->tx += tx_manager_mem_used(env->xm);
 }
@@ -602,6 +629,26 @@ static struct space *
 vinyl_engine_create_space(struct engine *engine, struct space_def *def,
 			  struct rlist *key_list)
 {
+	if (def->opts.memory_quota != 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "space memory quota");
+		return NULL;
+	}
+	/*
+	 * Expired tuples are deleted from secondary indexes with
+	 * deferred DELETEs, see vy_task_set_expiration(), while
+	 * covering indexes are read without looking up the primary
+	 * index so they would return expired tuples until compacted.
+	 */
+	struct index_def *index_def;
+	rlist_foreach_entry(index_def, key_list, link) {
+		if (def->opts.ttl_field != 0 && index_def->iid > 0 &&
+		    index_def->opts.is_covering) {
+			diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+				 "covering indexes in spaces with ttl_field");
+			return NULL;
+		}
+	}
 	struct space *space = malloc(sizeof(*space));
 	if (space == NULL) {
 		diag_set(OutOfMemory, sizeof(*space),
@@ -611,7 +658,6 @@ vinyl_engine_create_space(struct engine *engine, struct space_def *def,
 
 	/* Create a format from key and field definitions. */
 	int key_count = 0;
-	struct index_def *index_def;
 	rlist_foreach_entry(index_def, key_list, link)
 		key_count++;
 	struct key_def **keys = region_alloc(&fiber()->gc,
@@ -983,6 +1029,8 @@ vinyl_index_def_change_requires_rebuild(struct index *index,
 
 	if (!old_def->opts.is_unique && new_def->opts.is_unique)
 		return true;
+	if (old_def->opts.is_covering != new_def->opts.is_covering)
+		return true;
 
 	assert(index_depends_on_pk(index));
 	const struct key_def *old_cmp_def = old_def->cmp_def;
@@ -1283,6 +1331,23 @@ vy_is_committed(struct vy_env *env, struct space *space)
 	return true;
 }
 
+/**
+ * Check if a space has a covering secondary index. Such an
+ * index is read without looking up the primary index so
+ * the overwritten tuple must be deleted from it immediately
+ * rather than with a deferred DELETE.
+ */
+static bool
+vy_has_covering_index(struct space *space)
+{
+	for (uint32_t iid = 1; iid < space->index_count; iid++) {
+		struct vy_lsm *lsm = vy_lsm(space->index[iid]);
+		if (lsm->opts.is_covering)
+			return true;
+	}
+	return false;
+}
+
 /**
  * Get a full tuple by a tuple read from a secondary index.
  * @param lsm         LSM tree from which the tuple was read.
@@ -1300,7 +1365,7 @@ vy_get_by_secondary_tuple(struct vy_lsm *lsm, struct vy_tx *tx,
 			  const struct vy_read_view **rv,
 			  struct tuple *tuple, struct tuple **result)
 {
-	assert(lsm->index_id > 0);
+	assert(!vy_lsm_is_covering(lsm));
 
 	if (vy_point_lookup(lsm->pk, tx, rv, tuple, result) != 0)
 		return -1;
@@ -1382,7 +1447,7 @@ vy_get(struct vy_lsm *lsm, struct vy_tx *tx,
 			return -1;
 		if (vy_point_lookup(lsm, tx, rv, key, &tuple) != 0)
 			return -1;
-		if (lsm->index_id > 0 && tuple != NULL) {
+		if (!vy_lsm_is_covering(lsm) && tuple != NULL) {
 			rc = vy_get_by_secondary_tuple(lsm, tx, rv,
 						       tuple, result);
 			tuple_unref(tuple);
@@ -1399,7 +1464,7 @@ vy_get(struct vy_lsm *lsm, struct vy_tx *tx,
 	struct vy_read_iterator itr;
 	vy_read_iterator_open(&itr, lsm, tx, ITER_EQ, key, rv);
 	while ((rc = vy_read_iterator_next(&itr, &tuple)) == 0) {
-		if (lsm->index_id == 0 || tuple == NULL) {
+		if (vy_lsm_is_covering(lsm) || tuple == NULL) {
 			*result = tuple;
 			if (tuple != NULL)
 				tuple_ref(tuple);
@@ -1666,13 +1731,16 @@ vy_delete(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	if (vy_unique_key_validate(lsm, key, part_count))
 		return -1;
 	/*
-	 * There are two cases when need to get the full tuple
+	 * There are three cases when need to get the full tuple
 	 * before deletion.
 	 * - if the space has on_replace triggers and need to pass
 	 *   to them the old tuple.
 	 * - if deletion is done by a secondary index.
+	 * - if the space has a covering index, which can't wait
+	 *   for a deferred DELETE.
 	 */
-	if (lsm->index_id > 0 || !rlist_empty(&space->on_replace)) {
+	if (lsm->index_id > 0 || !rlist_empty(&space->on_replace) ||
+	    vy_has_covering_index(space)) {
 		if (vy_get_by_raw_key(lsm, tx, vy_tx_read_view(tx),
 				      key, part_count, &stmt->old_tuple) != 0)
 			return -1;
@@ -2194,9 +2262,12 @@ vy_replace(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	/*
 	 * Get the overwritten tuple from the primary index if
 	 * the space has on_replace triggers, in which case we
-	 * need to pass the old tuple to trigger callbacks.
+	 * need to pass the old tuple to trigger callbacks, or
+	 * a covering index, which must not contain overwritten
+	 * tuples.
 	 */
-	if (!rlist_empty(&space->on_replace)) {
+	if (!rlist_empty(&space->on_replace) ||
+	    vy_has_covering_index(space)) {
 		if (vy_get(pk, tx, vy_tx_read_view(tx),
 			   stmt->new_tuple, &stmt->old_tuple) != 0)
 			return -1;
@@ -2620,6 +2691,12 @@ vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota)
 	vy_cache_env_set_quota(&vinyl->env->cache_env, quota);
 }
 
+void
+vinyl_engine_set_meta_cache(struct vinyl_engine *vinyl, size_t quota)
+{
+	vy_run_env_set_meta_cache_quota(&vinyl->env->run_env, quota);
+}
+
 int
 vinyl_engine_set_memory(struct vinyl_engine *vinyl, size_t size)
 {
@@ -2645,6 +2722,19 @@ vinyl_engine_set_timeout(struct vinyl_engine *vinyl, double timeout)
 	vinyl->env->timeout = timeout;
 }
 
+void
+vinyl_engine_set_max_subcompactions(struct vinyl_engine *vinyl,
+				    int max_subcompactions)
+{
+	vinyl->env->scheduler.max_subcompactions = max_subcompactions;
+}
+
+void
+vinyl_engine_set_max_subdumps(struct vinyl_engine *vinyl, int max_subdumps)
+{
+	vinyl->env->scheduler.max_subdumps = max_subdumps;
+}
+
 void
 vinyl_engine_set_too_long_threshold(struct vinyl_engine *vinyl,
 				    double too_long_threshold)
@@ -2950,9 +3040,19 @@ vy_send_range_f(struct cbus_call_msg *cmsg)
 		goto err;
 	while ((rc = ctx->wi->iface->next(ctx->wi, &stmt)) == 0 &&
 	       stmt != NULL) {
+		struct tuple *full = stmt;
+		if (vy_stmt_is_blob_ref(stmt)) {
+			full = vy_stmt_load_blob(stmt, false);
+			if (full == NULL) {
+				rc = -1;
+				break;
+			}
+		}
 		struct xrow_header xrow;
-		rc = vy_stmt_encode_primary(stmt, ctx->key_def,
+		rc = vy_stmt_encode_primary(full, ctx->key_def,
 					    ctx->space_id, &xrow);
+		if (full != stmt)
+			tuple_unref(full);
 		if (rc != 0)
 			break;
 		/*
@@ -3228,15 +3328,26 @@ vinyl_space_apply_initial_join_row(struct space *space, struct request *request)
  * delete the corresponding files. On success, write a "forget" record
  * to the log so that all information about the run is deleted on the
  * next log rotation.
+ *
+ * Blob file links of a run are known from the log unless the run
+ * was left incomplete by a crash. If @scan_blobs is set, the index
+ * directory is scanned to find such links.
  */
 static void
 vy_gc_run(struct vy_env *env,
 	  struct vy_lsm_recovery_info *lsm_info,
-	  struct vy_run_recovery_info *run_info)
+	  struct vy_run_recovery_info *run_info, bool scan_blobs)
 {
 	/* Try to delete files. */
 	if (vy_run_remove_files(env->path, lsm_info->space_id,
-				lsm_info->index_id, run_info->id) != 0)
+				lsm_info->index_id, run_info->id,
+				run_info->blob_ids,
+				run_info->blob_count) != 0)
+		return;
+	if (scan_blobs &&
+	    vy_run_remove_unlogged_blob_files(env->path, lsm_info->space_id,
+					      lsm_info->index_id,
+					      run_info->id) != 0)
 		return;
 
 	/* Forget the run on success. */
@@ -3317,7 +3428,16 @@ vy_gc(struct vy_env *env, struct vy_recovery *recovery,
 			     (gc_mask & VY_GC_DROPPED) != 0) ||
 			    (run_info->is_incomplete &&
 			     (gc_mask & VY_GC_INCOMPLETE) != 0)) {
-				vy_gc_run(env, lsm_info, run_info);
+				/*
+				 * Blob files linked by a run left
+				 * incomplete by a crash aren't logged
+				 * so we have to look them up in the
+				 * directory. Do it only on recovery,
+				 * when such runs may be found.
+				 */
+				vy_gc_run(env, lsm_info, run_info,
+					  run_info->is_incomplete &&
+					  (gc_mask & VY_GC_INCOMPLETE) != 0);
 			}
 			if (loops % VY_YIELD_LOOPS == 0)
 				fiber_sleep(0);
@@ -3394,6 +3514,17 @@ vinyl_engine_backup(struct engine *engine, const struct vclock *vclock,
 				if (rc != 0)
 					goto out;
 			}
+			for (uint32_t i = 0; i < run_info->blob_count; i++) {
+				vy_blob_snprint_path(path, sizeof(path),
+						     env->path,
+						     lsm_info->space_id,
+						     lsm_info->index_id,
+						     run_info->id,
+						     run_info->blob_ids[i]);
+				rc = cb(path, cb_arg);
+				if (rc != 0)
+					goto out;
+			}
 			if (loops % VY_YIELD_LOOPS == 0)
 				fiber_sleep(0);
 		}
@@ -3696,7 +3827,7 @@ vinyl_iterator_primary_next(struct iterator *base, struct tuple **ret)
 {
 	assert(base->next = vinyl_iterator_primary_next);
 	struct vinyl_iterator *it = (struct vinyl_iterator *)base;
-	assert(it->lsm->index_id == 0);
+	assert(vy_lsm_is_covering(it->lsm));
 
 	if (vinyl_iterator_check_tx(it) != 0)
 		goto fail;
@@ -3720,7 +3851,7 @@ vinyl_iterator_secondary_next(struct iterator *base, struct tuple **ret)
 {
 	assert(base->next = vinyl_iterator_secondary_next);
 	struct vinyl_iterator *it = (struct vinyl_iterator *)base;
-	assert(it->lsm->index_id > 0);
+	assert(!vy_lsm_is_covering(it->lsm));
 	struct tuple *tuple;
 
 next:
@@ -3797,7 +3928,7 @@ vinyl_index_create_iterator(struct index *base, enum iterator_type type,
 	}
 
 	iterator_create(&it->base, base);
-	if (lsm->index_id == 0)
+	if (vy_lsm_is_covering(lsm))
 		it->base.next = vinyl_iterator_primary_next;
 	else
 		it->base.next = vinyl_iterator_secondary_next;
@@ -57,6 +57,12 @@ vinyl_engine_stat(struct vinyl_engine *vinyl, struct info_handler *handler);
 void
 vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota);
 
+/**
+ * Update vinyl run metadata cache size.
+ */
+void
+vinyl_engine_set_meta_cache(struct vinyl_engine *vinyl, size_t quota);
+
 /**
  * Update vinyl memory size.
  */
@@ -75,6 +81,19 @@ vinyl_engine_set_max_tuple_size(struct vinyl_engine *vinyl, size_t max_size);
 void
 vinyl_engine_set_timeout(struct vinyl_engine *vinyl, double timeout);
 
+/**
+ * Update max number of parallel parts of a range compaction.
+ */
+void
+vinyl_engine_set_max_subcompactions(struct vinyl_engine *vinyl,
+				    int max_subcompactions);
+
+/**
+ * Update max number of parallel parts of an LSM tree dump.
+ */
+void
+vinyl_engine_set_max_subdumps(struct vinyl_engine *vinyl, int max_subdumps);
+
 /**
  * Update too_long_threshold.
  */
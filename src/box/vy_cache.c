@@ -50,12 +50,16 @@ enum {
 	/* Max number of deletes that are made by cleanup action per one
 	 * cache operation */
 	VY_CACHE_CLEANUP_MAX_STEPS = 10,
+	/* Max size of the protected segment, in percent of the quota */
+	VY_CACHE_PROTECTED_PERCENT = 80,
 };
 
 void
 vy_cache_env_create(struct vy_cache_env *e, struct slab_cache *slab_cache)
 {
 	rlist_create(&e->cache_lru);
+	rlist_create(&e->cache_lru_protected);
+	e->mem_protected = 0;
 	e->mem_used = 0;
 	e->mem_quota = 0;
 	mempool_create(&e->cache_entry_mempool, slab_cache,
@@ -96,6 +100,7 @@ vy_cache_entry_new(struct vy_cache_env *env, struct vy_cache *cache,
 	entry->flags = 0;
 	entry->left_boundary_level = cache->cmp_def->part_count;
 	entry->right_boundary_level = cache->cmp_def->part_count;
+	entry->is_protected = false;
 	rlist_add(&env->cache_lru, &entry->in_lru);
 	env->mem_used += vy_cache_entry_size(entry);
 	vy_stmt_counter_acct_tuple(&cache->stat.count, stmt);
@@ -108,12 +113,52 @@ vy_cache_entry_delete(struct vy_cache_env *env, struct vy_cache_entry *entry)
 	vy_stmt_counter_unacct_tuple(&entry->cache->stat.count, entry->stmt);
 	assert(env->mem_used >= vy_cache_entry_size(entry));
 	env->mem_used -= vy_cache_entry_size(entry);
+	if (entry->is_protected) {
+		assert(env->mem_protected >= vy_cache_entry_size(entry));
+		env->mem_protected -= vy_cache_entry_size(entry);
+	}
 	tuple_unref(entry->stmt);
 	rlist_del(&entry->in_lru);
 	TRASH(entry);
 	mempool_free(&env->cache_entry_mempool, entry);
 }
 
+/**
+ * Move a cache entry to the head of the protected LRU list.
+ * If the protected segment exceeds its limit, move the least
+ * recently used protected entries to the probationary segment.
+ */
+static void
+vy_cache_entry_protect(struct vy_cache_env *env, struct vy_cache_entry *entry)
+{
+	rlist_move(&env->cache_lru_protected, &entry->in_lru);
+	if (entry->is_protected)
+		return;
+	entry->is_protected = true;
+	env->mem_protected += vy_cache_entry_size(entry);
+	size_t limit = env->mem_quota / 100 * VY_CACHE_PROTECTED_PERCENT;
+	while (env->mem_protected > limit) {
+		struct vy_cache_entry *last = rlist_last_entry(
+			&env->cache_lru_protected, struct vy_cache_entry,
+			in_lru);
+		last->is_protected = false;
+		env->mem_protected -= vy_cache_entry_size(last);
+		rlist_move(&env->cache_lru, &last->in_lru);
+	}
+}
+
+/**
+ * Account a repeated access to a cache entry.
+ */
+static void
+vy_cache_entry_touch(struct vy_cache_entry *entry)
+{
+	struct vy_cache *cache = entry->cache;
+	if (!entry->is_protected)
+		vy_stmt_counter_acct_tuple(&cache->stat.promote, entry->stmt);
+	vy_cache_entry_protect(cache->env, entry);
+}
+
 static void *
 vy_cache_tree_page_alloc(void *ctx)
 {
@@ -166,7 +211,11 @@ vy_cache_destroy(struct vy_cache *cache)
 static void
 vy_cache_gc_step(struct vy_cache_env *env)
 {
+	/* Evict from the probationary segment first. */
 	struct rlist *lru = &env->cache_lru;
+	if (rlist_empty(lru))
+		lru = &env->cache_lru_protected;
+	assert(!rlist_empty(lru));
 	struct vy_cache_entry *entry =
 	rlist_last_entry(lru, struct vy_cache_entry, in_lru);
 	struct vy_cache *cache = entry->cache;
@@ -320,6 +369,8 @@ vy_cache_add(struct vy_cache *cache, struct tuple *stmt,
 		entry->flags = replaced->flags;
 		entry->left_boundary_level = replaced->left_boundary_level;
 		entry->right_boundary_level = replaced->right_boundary_level;
+		if (replaced->is_protected)
+			vy_cache_entry_protect(cache->env, entry);
 		vy_cache_entry_delete(cache->env, replaced);
 	}
 	if (direction > 0 && boundary_level < entry->left_boundary_level)
@@ -407,6 +458,8 @@ vy_cache_add(struct vy_cache *cache, struct tuple *stmt,
 		prev_entry->flags = replaced->flags;
 		prev_entry->left_boundary_level = replaced->left_boundary_level;
 		prev_entry->right_boundary_level = replaced->right_boundary_level;
+		if (replaced->is_protected)
+			vy_cache_entry_protect(cache->env, prev_entry);
 		vy_cache_entry_delete(cache->env, replaced);
 	}
 
@@ -424,6 +477,7 @@ vy_cache_get(struct vy_cache *cache, const struct tuple *key)
 		vy_cache_tree_find(&cache->cache_tree, key);
 	if (entry == NULL)
 		return NULL;
+	vy_cache_entry_touch(*entry);
 	return (*entry)->stmt;
 }
 
@@ -504,6 +558,23 @@ vy_cache_on_write(struct vy_cache *cache, const struct tuple *stmt,
 	}
 }
 
+/**
+ * Account a read of the statement the iterator is positioned at.
+ */
+static void
+vy_cache_iterator_acct_get(struct vy_cache_iterator *itr)
+{
+	struct vy_cache *cache = itr->cache;
+	vy_stmt_counter_acct_tuple(&cache->stat.get, itr->curr_stmt);
+	if (itr->is_scan)
+		return;
+	struct vy_cache_entry **entry =
+		vy_cache_tree_iterator_get_elem(&cache->cache_tree,
+						&itr->curr_pos);
+	if (entry != NULL && (*entry)->stmt == itr->curr_stmt)
+		vy_cache_entry_touch(*entry);
+}
+
 /**
  * Get a stmt by current position
  */
@@ -697,8 +768,7 @@ vy_cache_iterator_next(struct vy_cache_iterator *itr,
 	vy_cache_iterator_skip_to_read_view(itr, stop);
 	if (itr->curr_stmt != NULL) {
 		tuple_ref(itr->curr_stmt);
-		vy_stmt_counter_acct_tuple(&itr->cache->stat.get,
-					   itr->curr_stmt);
+		vy_cache_iterator_acct_get(itr);
 		return vy_history_append_stmt(history, itr->curr_stmt);
 	}
 	return 0;
@@ -755,8 +825,7 @@ vy_cache_iterator_skip(struct vy_cache_iterator *itr,
 	vy_cache_iterator_skip_to_read_view(itr, stop);
 	if (itr->curr_stmt != NULL) {
 		tuple_ref(itr->curr_stmt);
-		vy_stmt_counter_acct_tuple(&itr->cache->stat.get,
-					   itr->curr_stmt);
+		vy_cache_iterator_acct_get(itr);
 		return vy_history_append_stmt(history, itr->curr_stmt);
 	}
 	return 0;
@@ -845,8 +914,7 @@ vy_cache_iterator_restore(struct vy_cache_iterator *itr,
 	vy_history_cleanup(history);
 	if (itr->curr_stmt != NULL) {
 		tuple_ref(itr->curr_stmt);
-		vy_stmt_counter_acct_tuple(&itr->cache->stat.get,
-					   itr->curr_stmt);
+		vy_cache_iterator_acct_get(itr);
 		if (vy_history_append_stmt(history, itr->curr_stmt) != 0)
 			return -1;
 		return prev_stmt != itr->curr_stmt;
@@ -879,4 +947,11 @@ vy_cache_iterator_open(struct vy_cache_iterator *itr, struct vy_cache *cache,
 
 	itr->version = 0;
 	itr->search_started = false;
+	/*
+	 * select{} is an EQ iterator with an empty key,
+	 * see vy_cache_iterator_is_stop().
+	 */
+	itr->is_scan = (iterator_type != ITER_EQ &&
+			iterator_type != ITER_REQ) ||
+		       tuple_field_count(key) == 0;
 }
@@ -56,7 +56,7 @@ struct vy_cache_entry {
 	struct vy_cache *cache;
 	/* Statement in cache */
 	struct tuple *stmt;
-	/* Link in LRU list */
+	/* Link in LRU list, probationary or protected */
 	struct rlist in_lru;
 	/* VY_CACHE_LEFT_LINKED and/or VY_CACHE_RIGHT_LINKED, see
 	 * description of them for more information */
@@ -65,6 +65,8 @@ struct vy_cache_entry {
 	uint8_t left_boundary_level;
 	/* Number of parts in key when the value was the last in EQ search */
 	uint8_t right_boundary_level;
+	/* Set if the entry is in the protected LRU list */
+	bool is_protected;
 };
 
 /**
@@ -115,8 +117,28 @@ vy_cache_tree_key_cmp(struct vy_cache_entry *a,
  * Environment of the cache
  */
 struct vy_cache_env {
-	/** Common LRU list of read cache. The first element is the newest */
+	/**
+	 * The cache is split into two segments so that a scan
+	 * can't flush the hot working set out of the cache.
+	 * New entries go to the probationary segment. An entry
+	 * moves to the protected segment when it's accessed by
+	 * a point lookup or an equality search. Entries are
+	 * evicted from the probationary segment first. When the
+	 * protected segment grows too big, its least recently
+	 * used entries go back to the probationary segment.
+	 */
+	/**
+	 * Common LRU list of the probationary segment.
+	 * The first element is the newest.
+	 */
 	struct rlist cache_lru;
+	/**
+	 * Common LRU list of the protected segment.
+	 * The first element is the most recently used.
+	 */
+	struct rlist cache_lru_protected;
+	/** Size of memory occupied by protected entries */
+	size_t mem_protected;
 	/** Common mempool for vy_cache_entry struct */
 	struct mempool cache_entry_mempool;
 	/** Size of memory occupied by cached tuples */
@@ -160,7 +182,10 @@ struct vy_cache {
 	 * key parts
 	 */
 	struct key_def *cmp_def;
-	/** Set if this cache is for a primary index. */
+	/**
+	 * Set if this cache is for a primary or a covering
+	 * index, i.e. it doesn't share tuples with other caches.
+	 */
 	bool is_primary;
 	/* Tree of cache entries */
 	struct vy_cache_tree cache_tree;
@@ -252,6 +277,11 @@ struct vy_cache_iterator {
 	uint32_t version;
 	/* Is false until first .._get or .._next_.. method is called */
 	bool search_started;
+	/*
+	 * Set if the iterator is a range scan. A scan doesn't
+	 * move the entries it reads to the protected segment.
+	 */
+	bool is_scan;
 };
 
 /**
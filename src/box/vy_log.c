@@ -85,6 +85,7 @@ enum vy_log_key {
 	VY_LOG_KEY_DROP_LSN		= 14,
 	VY_LOG_KEY_GROUP_ID		= 15,
 	VY_LOG_KEY_DUMP_COUNT		= 16,
+	VY_LOG_KEY_BLOB_IDS		= 17,
 };
 
 /** vy_log_key -> human readable name. */
@@ -106,6 +107,7 @@ static const char *vy_log_key_name[] = {
 	[VY_LOG_KEY_DROP_LSN]		= "drop_lsn",
 	[VY_LOG_KEY_GROUP_ID]		= "group_id",
 	[VY_LOG_KEY_DUMP_COUNT]		= "dump_count",
+	[VY_LOG_KEY_BLOB_IDS]		= "blob_ids",
 };
 
 /** vy_log_type -> human readable name. */
@@ -291,6 +293,14 @@ vy_log_record_snprint(char *buf, int size, const struct vy_log_record *record)
 		SNPRINT(total, snprintf, buf, size, "%s=%"PRIu32", ",
 			vy_log_key_name[VY_LOG_KEY_DUMP_COUNT],
 			record->dump_count);
+	if (record->blob_count > 0) {
+		SNPRINT(total, snprintf, buf, size, "%s=[",
+			vy_log_key_name[VY_LOG_KEY_BLOB_IDS]);
+		for (uint32_t i = 0; i < record->blob_count; i++)
+			SNPRINT(total, snprintf, buf, size, "%s%"PRIi64,
+				i > 0 ? ", " : "", record->blob_ids[i]);
+		SNPRINT(total, snprintf, buf, size, "], ");
+	}
 	SNPRINT(total, snprintf, buf, size, "}");
 	return total;
 }
@@ -422,6 +432,13 @@ vy_log_record_encode(const struct vy_log_record *record,
 		size += mp_sizeof_uint(record->dump_count);
 		n_keys++;
 	}
+	if (record->blob_count > 0) {
+		size += mp_sizeof_uint(VY_LOG_KEY_BLOB_IDS);
+		size += mp_sizeof_array(record->blob_count);
+		for (uint32_t i = 0; i < record->blob_count; i++)
+			size += mp_sizeof_uint(record->blob_ids[i]);
+		n_keys++;
+	}
 	size += mp_sizeof_map(n_keys);
 
 	/*
@@ -508,6 +525,12 @@ vy_log_record_encode(const struct vy_log_record *record,
 		pos = mp_encode_uint(pos, VY_LOG_KEY_DUMP_COUNT);
 		pos = mp_encode_uint(pos, record->dump_count);
 	}
+	if (record->blob_count > 0) {
+		pos = mp_encode_uint(pos, VY_LOG_KEY_BLOB_IDS);
+		pos = mp_encode_array(pos, record->blob_count);
+		for (uint32_t i = 0; i < record->blob_count; i++)
+			pos = mp_encode_uint(pos, record->blob_ids[i]);
+	}
 	assert(pos == tuple + size);
 
 	/*
@@ -639,6 +662,23 @@ vy_log_record_decode(struct vy_log_record *record,
 		case VY_LOG_KEY_DUMP_COUNT:
 			record->dump_count = mp_decode_uint(&pos);
 			break;
+		case VY_LOG_KEY_BLOB_IDS: {
+			struct region *region = &fiber()->gc;
+			uint32_t blob_count = mp_decode_array(&pos);
+			int64_t *blob_ids = region_alloc(region,
+					sizeof(*blob_ids) * blob_count);
+			if (blob_ids == NULL) {
+				diag_set(OutOfMemory,
+					 sizeof(*blob_ids) * blob_count,
+					 "region", "blob_ids");
+				return -1;
+			}
+			for (uint32_t j = 0; j < blob_count; j++)
+				blob_ids[j] = mp_decode_uint(&pos);
+			record->blob_ids = blob_ids;
+			record->blob_count = blob_count;
+			break;
+		}
 		default:
 			mp_next(&pos); /* unknown key, ignore */
 			break;
@@ -724,6 +764,17 @@ vy_log_record_dup(struct region *pool, const struct vy_log_record *src)
 		dst->key_part_count = src->key_def->part_count;
 		dst->key_def = NULL;
 	}
+	if (src->blob_count > 0) {
+		size_t size = src->blob_count * sizeof(*src->blob_ids);
+		int64_t *blob_ids = region_alloc(pool, size);
+		if (blob_ids == NULL) {
+			diag_set(OutOfMemory, size, "region",
+				 "vy_log_record::blob_ids");
+			goto err;
+		}
+		memcpy(blob_ids, src->blob_ids, size);
+		dst->blob_ids = blob_ids;
+	}
 	return dst;
 
 err:
@@ -1612,6 +1663,8 @@ vy_recovery_do_create_run(struct vy_recovery *recovery, int64_t run_id)
 	run->dump_lsn = -1;
 	run->gc_lsn = -1;
 	run->dump_count = 0;
+	run->blob_ids = NULL;
+	run->blob_count = 0;
 	run->is_incomplete = false;
 	run->is_dropped = false;
 	run->data = NULL;
@@ -1621,6 +1674,28 @@ vy_recovery_do_create_run(struct vy_recovery *recovery, int64_t run_id)
 	return run;
 }
 
+/**
+ * Remember the IDs of blob files a vinyl run has links to.
+ * Return 0 on success, -1 on OOM.
+ */
+static int
+vy_recovery_set_run_blob_ids(struct vy_run_recovery_info *run,
+			     const int64_t *blob_ids, uint32_t blob_count)
+{
+	if (blob_count == 0)
+		return 0;
+	size_t size = blob_count * sizeof(*blob_ids);
+	int64_t *copy = realloc(run->blob_ids, size);
+	if (copy == NULL) {
+		diag_set(OutOfMemory, size, "realloc", "blob_ids");
+		return -1;
+	}
+	memcpy(copy, blob_ids, size);
+	run->blob_ids = copy;
+	run->blob_count = blob_count;
+	return 0;
+}
+
 /**
  * Handle a VY_LOG_PREPARE_RUN log record.
  * This function creates a new incomplete vinyl run with ID @run_id
@@ -1666,7 +1741,8 @@ vy_recovery_prepare_run(struct vy_recovery *recovery, int64_t lsm_id,
  */
 static int
 vy_recovery_create_run(struct vy_recovery *recovery, int64_t lsm_id,
-		       int64_t run_id, int64_t dump_lsn, uint32_t dump_count)
+		       int64_t run_id, int64_t dump_lsn, uint32_t dump_count,
+		       const int64_t *blob_ids, uint32_t blob_count)
 {
 	struct vy_lsm_recovery_info *lsm;
 	lsm = vy_recovery_lookup_lsm(recovery, lsm_id);
@@ -1690,6 +1766,8 @@ vy_recovery_create_run(struct vy_recovery *recovery, int64_t lsm_id,
 		if (run == NULL)
 			return -1;
 	}
+	if (vy_recovery_set_run_blob_ids(run, blob_ids, blob_count) != 0)
+		return -1;
 	run->dump_lsn = dump_lsn;
 	run->dump_count = dump_count;
 	run->is_incomplete = false;
@@ -1706,7 +1784,8 @@ vy_recovery_create_run(struct vy_recovery *recovery, int64_t lsm_id,
  */
 static int
 vy_recovery_drop_run(struct vy_recovery *recovery, int64_t run_id,
-		     int64_t gc_lsn)
+		     int64_t gc_lsn, const int64_t *blob_ids,
+		     uint32_t blob_count)
 {
 	struct vy_run_recovery_info *run;
 	run = vy_recovery_lookup_run(recovery, run_id);
@@ -1722,6 +1801,8 @@ vy_recovery_drop_run(struct vy_recovery *recovery, int64_t run_id,
 				    (long long)run_id));
 		return -1;
 	}
+	if (vy_recovery_set_run_blob_ids(run, blob_ids, blob_count) != 0)
+		return -1;
 	run->is_dropped = true;
 	run->gc_lsn = gc_lsn;
 	return 0;
@@ -1746,6 +1827,7 @@ vy_recovery_forget_run(struct vy_recovery *recovery, int64_t run_id)
 	struct vy_run_recovery_info *run = mh_i64ptr_node(h, k)->val;
 	mh_i64ptr_del(h, k, NULL);
 	rlist_del_entry(run, in_lsm);
+	free(run->blob_ids);
 	free(run);
 	return 0;
 }
@@ -2054,11 +2136,13 @@ vy_recovery_process_record(struct vy_recovery *recovery,
 	case VY_LOG_CREATE_RUN:
 		rc = vy_recovery_create_run(recovery, record->lsm_id,
 					    record->run_id, record->dump_lsn,
-					    record->dump_count);
+					    record->dump_count, record->blob_ids,
+					    record->blob_count);
 		break;
 	case VY_LOG_DROP_RUN:
 		rc = vy_recovery_drop_run(recovery, record->run_id,
-					  record->gc_lsn);
+					  record->gc_lsn, record->blob_ids,
+					  record->blob_count);
 		break;
 	case VY_LOG_FORGET_RUN:
 		rc = vy_recovery_forget_run(recovery, record->run_id);
@@ -2340,8 +2424,10 @@ vy_recovery_delete(struct vy_recovery *recovery)
 				free(slice);
 			free(range);
 		}
-		rlist_foreach_entry_safe(run, &lsm->runs, in_lsm, next_run)
+		rlist_foreach_entry_safe(run, &lsm->runs, in_lsm, next_run) {
+			free(run->blob_ids);
 			free(run);
+		}
 		free(lsm->key_parts);
 		free(lsm);
 	}
@@ -2405,6 +2491,8 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 			record.type = VY_LOG_CREATE_RUN;
 			record.dump_lsn = run->dump_lsn;
 			record.dump_count = run->dump_count;
+			record.blob_ids = run->blob_ids;
+			record.blob_count = run->blob_count;
 		}
 		record.lsm_id = lsm->id;
 		record.run_id = run->id;
@@ -2418,6 +2506,10 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 		record.type = VY_LOG_DROP_RUN;
 		record.run_id = run->id;
 		record.gc_lsn = run->gc_lsn;
+		if (run->is_incomplete) {
+			record.blob_ids = run->blob_ids;
+			record.blob_count = run->blob_count;
+		}
 		if (vy_log_append_record(xlog, &record) != 0)
 			return -1;
 	}
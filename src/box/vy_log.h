@@ -97,6 +97,7 @@ enum vy_log_record_type {
 	/**
 	 * Commit a vinyl run file creation.
 	 * Requires vy_log_record::lsm_id, run_id, dump_lsn, dump_count.
+	 * Optionally stores blob_ids.
 	 *
 	 * Written after a run file was successfully created.
 	 */
@@ -104,6 +105,7 @@ enum vy_log_record_type {
 	/**
 	 * Drop a vinyl run.
 	 * Requires vy_log_record::run_id, gc_lsn.
+	 * Optionally stores blob_ids if the run was never committed.
 	 *
 	 * A record of this type indicates that the run is not in use
 	 * any more and its files can be safely removed. When the log
@@ -273,6 +275,13 @@ struct vy_log_record {
 	int64_t gc_lsn;
 	/** For runs: number of dumps it took to create the run. */
 	uint32_t dump_count;
+	/**
+	 * For runs: IDs of blob files the run has links to,
+	 * see vy_run_info::blob_ids.
+	 */
+	const int64_t *blob_ids;
+	/** Number of elements in blob_ids. */
+	uint32_t blob_count;
 	/** Link in vy_log::tx. */
 	struct stailq_entry in_tx;
 };
@@ -393,6 +402,14 @@ struct vy_run_recovery_info {
 	int64_t gc_lsn;
 	/** Number of dumps it took to create the run. */
 	uint32_t dump_count;
+	/**
+	 * IDs of blob files the run has links to, allocated
+	 * with malloc(). Used to remove and back up the links
+	 * without scanning the LSM tree directory.
+	 */
+	int64_t *blob_ids;
+	/** Number of elements in blob_ids. */
+	uint32_t blob_count;
 	/**
 	 * True if the run was not committed (there's
 	 * VY_LOG_PREPARE_RUN, but no VY_LOG_CREATE_RUN).
@@ -715,7 +732,8 @@ vy_log_prepare_run(int64_t lsm_id, int64_t run_id)
 /** Helper to log a vinyl run creation. */
 static inline void
 vy_log_create_run(int64_t lsm_id, int64_t run_id,
-		  int64_t dump_lsn, uint32_t dump_count)
+		  int64_t dump_lsn, uint32_t dump_count,
+		  const int64_t *blob_ids, uint32_t blob_count)
 {
 	struct vy_log_record record;
 	vy_log_record_init(&record);
@@ -724,6 +742,8 @@ vy_log_create_run(int64_t lsm_id, int64_t run_id,
 	record.run_id = run_id;
 	record.dump_lsn = dump_lsn;
 	record.dump_count = dump_count;
+	record.blob_ids = blob_ids;
+	record.blob_count = blob_count;
 	vy_log_write(&record);
 }
 
@@ -739,6 +759,25 @@ vy_log_drop_run(int64_t run_id, int64_t gc_lsn)
 	vy_log_write(&record);
 }
 
+/**
+ * Helper to log deletion of a run that was never committed.
+ * Unlike vy_log_drop_run(), stores the IDs of blob files the
+ * run has links to, because they aren't known from the log.
+ */
+static inline void
+vy_log_discard_run(int64_t run_id, const int64_t *blob_ids,
+		   uint32_t blob_count)
+{
+	struct vy_log_record record;
+	vy_log_record_init(&record);
+	record.type = VY_LOG_DROP_RUN;
+	record.run_id = run_id;
+	record.gc_lsn = 0;
+	record.blob_ids = blob_ids;
+	record.blob_count = blob_count;
+	vy_log_write(&record);
+}
+
 /** Helper to log a run cleanup. */
 static inline void
 vy_log_forget_run(int64_t run_id)
@@ -352,6 +352,18 @@ vy_lsm_is_empty(struct vy_lsm *lsm)
 		lsm->stat.memory.count.rows == 0);
 }
 
+/**
+ * Return true if the LSM tree stores full tuples and hence
+ * can be read without looking up the primary index. This is
+ * true for the primary index and for secondary indexes created
+ * with the 'covering' option.
+ */
+static inline bool
+vy_lsm_is_covering(struct vy_lsm *lsm)
+{
+	return lsm->index_id == 0 || lsm->opts.is_covering;
+}
+
 /**
  * Return the averange number of dumps it takes to trigger major
  * compaction of a range in this LSM tree.
@@ -32,6 +32,7 @@
 
 #include <stdlib.h>
 
+#include <pmatomic.h>
 #include <trivia/util.h>
 #include <small/lsregion.h>
 #include <small/slab_arena.h>
@@ -118,12 +119,103 @@ vy_mem_new(struct vy_mem_env *env, struct key_def *cmp_def,
 			   vy_mem_tree_extent_free, index);
 	rlist_create(&index->in_sealed);
 	fiber_cond_create(&index->pin_cond);
+	rlist_create(&index->views);
 	return index;
 }
 
+struct vy_mem_view *
+vy_mem_view_new(struct vy_mem *mem, const struct tuple *begin,
+		const struct tuple *end)
+{
+	struct vy_mem_view *view = malloc(sizeof(*view));
+	if (view == NULL) {
+		diag_set(OutOfMemory, sizeof(*view),
+			 "malloc", "struct vy_mem_view");
+		return NULL;
+	}
+	struct tree_mem_key tree_key;
+	/* (lsn == INT64_MAX - 1) means that lsn is ignored in comparison */
+	tree_key.lsn = INT64_MAX - 1;
+	if (begin != NULL) {
+		tree_key.stmt = begin;
+		view->itr = vy_mem_tree_lower_bound(&mem->tree,
+						    &tree_key, NULL);
+	} else {
+		view->itr = vy_mem_tree_iterator_first(&mem->tree);
+	}
+	if (end != NULL) {
+		tree_key.stmt = end;
+		view->end = vy_mem_tree_lower_bound(&mem->tree,
+						    &tree_key, NULL);
+	} else {
+		view->end = vy_mem_tree_invalid_iterator();
+	}
+	/*
+	 * Both positions were looked up in the current version of
+	 * the tree, which is the version we freeze, so they stay
+	 * valid in the read view whatever happens to the tree.
+	 */
+	vy_mem_tree_iterator_freeze(&mem->tree, &view->itr);
+	view->is_released = false;
+	rlist_add_tail_entry(&mem->views, view, in_mem);
+	return view;
+}
+
+const struct tuple *
+vy_mem_view_next(struct vy_mem *mem, struct vy_mem_view *view)
+{
+	/*
+	 * Tree lookups and iterator increments always yield
+	 * a position within a leaf or an invalid iterator so
+	 * positions may be compared directly. Note, we can't use
+	 * vy_mem_tree_iterator_are_equal() here, because it may
+	 * look up the end position in the current tree.
+	 */
+	if (view->itr.block_id == view->end.block_id &&
+	    view->itr.pos == view->end.pos)
+		return NULL;
+	const struct tuple **res =
+		vy_mem_tree_iterator_get_elem(&mem->tree, &view->itr);
+	if (res == NULL)
+		return NULL;
+	vy_mem_tree_iterator_next(&mem->tree, &view->itr);
+	return *res;
+}
+
+void
+vy_mem_view_release(struct vy_mem_view *view)
+{
+	pm_atomic_store(&view->is_released, true);
+}
+
+/** Destroy a read view of an in-memory tree. */
+static void
+vy_mem_view_delete(struct vy_mem *mem, struct vy_mem_view *view)
+{
+	rlist_del_entry(view, in_mem);
+	vy_mem_tree_iterator_destroy(&mem->tree, &view->itr);
+	free(view);
+}
+
+/** Destroy read views that have been released by readers. */
+static void
+vy_mem_gc_views(struct vy_mem *mem)
+{
+	struct vy_mem_view *view, *next;
+	rlist_foreach_entry_safe(view, &mem->views, in_mem, next) {
+		if (pm_atomic_load(&view->is_released))
+			vy_mem_view_delete(mem, view);
+	}
+}
+
 void
 vy_mem_delete(struct vy_mem *index)
 {
+	struct vy_mem_view *view, *next;
+	rlist_foreach_entry_safe(view, &index->views, in_mem, next) {
+		assert(pm_atomic_load(&view->is_released));
+		vy_mem_view_delete(index, view);
+	}
 	index->env->tree_extent_size -= index->tree_extent_size;
 	tuple_format_unref(index->format);
 	fiber_cond_destroy(&index->pin_cond);
@@ -159,6 +251,8 @@ vy_mem_insert_upsert(struct vy_mem *mem, const struct tuple *stmt)
 	assert(stmt->format_id == tuple_format_id(mem->format));
 	/* The statement must be from a lsregion. */
 	assert(!vy_stmt_is_refable(stmt));
+	if (!rlist_empty(&mem->views))
+		vy_mem_gc_views(mem);
 	size_t size = tuple_size(stmt);
 	const struct tuple *replaced_stmt = NULL;
 	struct vy_mem_tree_iterator inserted;
@@ -218,6 +312,8 @@ vy_mem_insert(struct vy_mem *mem, const struct tuple *stmt)
 	assert(stmt->format_id == tuple_format_id(mem->format));
 	/* The statement must be from a lsregion. */
 	assert(!vy_stmt_is_refable(stmt));
+	if (!rlist_empty(&mem->views))
+		vy_mem_gc_views(mem);
 	size_t size = tuple_size(stmt);
 	const struct tuple *replaced_stmt = NULL;
 	if (vy_mem_tree_insert(&mem->tree, stmt, &replaced_stmt))
@@ -622,33 +718,54 @@ vy_mem_stream_next(struct vy_stmt_stream *virt_stream, struct tuple **ret)
 {
 	assert(virt_stream->iface->next == vy_mem_stream_next);
 	struct vy_mem_stream *stream = (struct vy_mem_stream *)virt_stream;
+	*ret = (struct tuple *)vy_mem_view_next(stream->mem, stream->view);
+	return 0;
+}
 
-	struct tuple **res = (struct tuple **)
-		vy_mem_tree_iterator_get_elem(&stream->mem->tree,
-					      &stream->curr_pos);
-	if (res == NULL) {
-		*ret = NULL;
-	} else {
-		*ret = *res;
-		vy_mem_tree_iterator_next(&stream->mem->tree,
-					  &stream->curr_pos);
-	}
+static NODISCARD int
+vy_mem_stream_next_empty(struct vy_stmt_stream *virt_stream,
+			 struct tuple **ret)
+{
+	(void)virt_stream;
+	*ret = NULL;
 	return 0;
 }
 
+static void
+vy_mem_stream_close(struct vy_stmt_stream *virt_stream)
+{
+	assert(virt_stream->iface->next == vy_mem_stream_next);
+	struct vy_mem_stream *stream = (struct vy_mem_stream *)virt_stream;
+	vy_mem_view_release(stream->view);
+	stream->view = NULL;
+}
+
 static const struct vy_stmt_stream_iface vy_mem_stream_iface = {
 	.start = NULL,
 	.next = vy_mem_stream_next,
 	.stop = NULL,
+	.close = vy_mem_stream_close
+};
+
+/** Interface of a stream that failed to open. */
+static const struct vy_stmt_stream_iface vy_mem_stream_empty_iface = {
+	.start = NULL,
+	.next = vy_mem_stream_next_empty,
+	.stop = NULL,
 	.close = NULL
 };
 
-void
-vy_mem_stream_open(struct vy_mem_stream *stream, struct vy_mem *mem)
+int
+vy_mem_stream_open(struct vy_mem_stream *stream, struct vy_mem *mem,
+		   const struct tuple *begin, const struct tuple *end)
 {
-	stream->base.iface = &vy_mem_stream_iface;
+	stream->base.iface = &vy_mem_stream_empty_iface;
 	stream->mem = mem;
-	stream->curr_pos = vy_mem_tree_iterator_first(&mem->tree);
+	stream->view = vy_mem_view_new(mem, begin, end);
+	if (stream->view == NULL)
+		return -1;
+	stream->base.iface = &vy_mem_stream_iface;
+	return 0;
 }
 
 /* }}} vy_mem_iterator API implementation */
@@ -213,8 +213,83 @@ struct vy_mem {
 	 * if pin_count reaches 0.
 	 */
 	struct fiber_cond pin_cond;
+	/** List of read views of the tree, linked by vy_mem_view::in_mem. */
+	struct rlist views;
 };
 
+/**
+ * Read view of an in-memory tree.
+ *
+ * The tree may only be accessed from the tx thread, but a read
+ * view of it may be traversed by any thread while the tx thread
+ * keeps modifying the tree: tree blocks referenced by read views
+ * are copied on write, see matras. Since tree extents and
+ * statements are allocated from lsregion, nothing a read view
+ * points to is freed until the mem is deleted.
+ *
+ * A read view covers a range of the tree. Both the current and
+ * the end positions are looked up when the view is created so
+ * they refer to the same frozen version of the tree and may be
+ * compared without looking at the tree as it is now.
+ *
+ * Note, LSN of a prepared statement is updated in place on
+ * commit so a reader must skip statements that are newer than
+ * its read view rather than rely on their LSN being stable.
+ *
+ * A read view is created by the tx thread with vy_mem_view_new().
+ * When the reader is done with it, it releases it with
+ * vy_mem_view_release(), which may be called from any thread.
+ * Released views are destroyed by the tx thread on the next
+ * write to the tree or when the mem is deleted.
+ */
+struct vy_mem_view {
+	/** Frozen tree iterator pointing to the current position. */
+	struct vy_mem_tree_iterator itr;
+	/**
+	 * Position to stop at, in the version of the tree frozen
+	 * by @itr. Invalid if the view is unbounded.
+	 */
+	struct vy_mem_tree_iterator end;
+	/** Link in vy_mem::views. */
+	struct rlist in_mem;
+	/** Set by vy_mem_view_release(). */
+	bool is_released;
+};
+
+/**
+ * Create a read view of an in-memory tree.
+ * Must be called from the tx thread.
+ *
+ * @param mem    vy_mem.
+ * @param begin  If not NULL, the view starts at the first statement
+ *               greater than or equal to it, otherwise at the first
+ *               statement of the tree.
+ * @param end    If not NULL, the view ends before the first statement
+ *               greater than or equal to it, otherwise at the end of
+ *               the tree.
+ *
+ * @retval new read view on success.
+ * @retval NULL on memory error.
+ */
+struct vy_mem_view *
+vy_mem_view_new(struct vy_mem *mem, const struct tuple *begin,
+		const struct tuple *end);
+
+/**
+ * Return the statement at the current position of a read view
+ * and advance the position. Return NULL if the end of the view
+ * has been reached. May be called from any thread.
+ */
+const struct tuple *
+vy_mem_view_next(struct vy_mem *mem, struct vy_mem_view *view);
+
+/**
+ * Release a read view of an in-memory tree.
+ * May be called from any thread.
+ */
+void
+vy_mem_view_release(struct vy_mem_view *view);
+
 /**
  * Pin an in-memory index.
  *
@@ -418,15 +493,28 @@ struct vy_mem_stream {
 	struct vy_stmt_stream base;
 	/** Mem to stream */
 	struct vy_mem *mem;
-	/** Current position */
-	struct vy_mem_tree_iterator curr_pos;
+	/** Read view of the mem the stream iterates over. */
+	struct vy_mem_view *view;
 };
 
 /**
  * Open a mem stream. Use vy_stmt_stream api for further work.
+ * If @begin is not NULL, the stream starts at the first statement
+ * greater than or equal to @begin. If @end is not NULL, the stream
+ * stops before the first statement greater than or equal to @end.
+ * The boundaries are looked up on open so that streaming doesn't
+ * need to compare statements.
+ *
+ * The stream iterates over a read view of the mem created on open
+ * so it may be used by a worker thread while the tx thread keeps
+ * modifying the mem. The stream must be opened in the tx thread.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error. The stream is still valid and empty.
  */
-void
-vy_mem_stream_open(struct vy_mem_stream *stream, struct vy_mem *mem);
+int
+vy_mem_stream_open(struct vy_mem_stream *stream, struct vy_mem *mem,
+		   const struct tuple *begin, const struct tuple *end);
 
 #if defined(__cplusplus)
 } /* extern "C" */
@@ -284,31 +284,16 @@ vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice)
  * compaction is relatively cheap, because of the level size
  * ratio.
  *
- * Given a range, this function computes the maximal level that needs
- * to be compacted and sets @compaction_priority to the number of runs
- * in this level and all preceding levels.
+ * Given the @slice_count newest slices of a range, this function
+ * computes the maximal level that needs to be compacted and sets
+ * @compaction_priority to the number of runs in this level and
+ * all preceding levels.
  */
-void
-vy_range_update_compaction_priority(struct vy_range *range,
-				    const struct index_opts *opts)
+static void
+vy_range_pick_levels(struct vy_range *range, int slice_count,
+		     uint32_t run_count_per_level, double run_size_ratio)
 {
-	assert(opts->run_count_per_level > 0);
-	assert(opts->run_size_ratio > 1);
-
-	range->compaction_priority = 0;
-	vy_disk_stmt_counter_reset(&range->compaction_queue);
-
-	if (range->slice_count <= 1) {
-		/* Nothing to compact. */
-		range->needs_compaction = false;
-		return;
-	}
-
-	if (range->needs_compaction) {
-		range->compaction_priority = range->slice_count;
-		range->compaction_queue = range->count;
-		return;
-	}
+	assert(slice_count > 1 && slice_count <= range->slice_count);
 
 	/* Total number of statements in checked runs. */
 	struct vy_disk_stmt_counter total_stmt_count;
@@ -346,13 +331,16 @@ vy_range_update_compaction_priority(struct vy_range *range,
 
 	uint64_t size;
 	struct vy_slice *slice;
-	slice = rlist_last_entry(&range->slices, struct vy_slice, in_range);
-	size = slice->count.bytes;
-	slice = rlist_first_entry(&range->slices, struct vy_slice, in_range);
+	struct vy_slice *first = rlist_first_entry(&range->slices,
+						   struct vy_slice, in_range);
+	struct vy_slice *last = first;
+	for (int i = 1; i < slice_count; i++)
+		last = rlist_next_entry(last, in_range);
+	size = last->count.bytes;
 	do {
 		target_run_size = size;
-		size = DIV_ROUND_UP(target_run_size, opts->run_size_ratio);
-	} while (size > (uint64_t)MAX(slice->count.bytes, 1));
+		size = DIV_ROUND_UP(target_run_size, run_size_ratio);
+	} while (size > (uint64_t)MAX(first->count.bytes, 1));
 
 	rlist_foreach_entry(slice, &range->slices, in_range) {
 		size = slice->count.bytes;
@@ -382,7 +370,7 @@ vy_range_update_compaction_priority(struct vy_range *range,
 			 * Calculate the target run size for this
 			 * level.
 			 */
-			target_run_size *= opts->run_size_ratio;
+			target_run_size *= run_size_ratio;
 			/*
 			 * Keep pushing the run down until
 			 * we find an appropriate level for it.
@@ -403,7 +391,7 @@ vy_range_update_compaction_priority(struct vy_range *range,
 		 * scans all LSM tree levels. Instead we use the
 		 * value of rand() from the slice creation time.
 		 */
-		uint32_t max_run_count = opts->run_count_per_level;
+		uint32_t max_run_count = run_count_per_level;
 		if (slice->seed < RAND_MAX / 10)
 			max_run_count++;
 		if (level_run_count > max_run_count) {
@@ -417,6 +405,8 @@ vy_range_update_compaction_priority(struct vy_range *range,
 			range->compaction_queue = total_stmt_count;
 			est_new_run_size = total_stmt_count.bytes;
 		}
+		if (slice == last)
+			break;
 	}
 
 	if (level_run_count > 1) {
@@ -429,6 +419,160 @@ vy_range_update_compaction_priority(struct vy_range *range,
 	}
 }
 
+/**
+ * Leveled compaction keeps exactly one run per level, except L0,
+ * which consists of runs created by dumps. Each level is expected
+ * to be run_size_ratio times smaller than the next one; the target
+ * sizes are derived from the oldest run, which forms the last level.
+ *
+ * When the number of runs at L0 reaches run_count_per_level, they
+ * are merged into L1, or into a new level if L1 is more than
+ * run_size_ratio times bigger than L0. Otherwise, if a level grows
+ * beyond its target size, it is merged into the next level, but,
+ * unlike the tiered strategy, upper levels are not taken in, see
+ * vy_range::compaction_skip. This results in lower read and space
+ * amplification at the cost of rewriting the next level on each
+ * compaction.
+ */
+static void
+vy_range_pick_leveled(struct vy_range *range, uint32_t run_count_per_level,
+		      double run_size_ratio)
+{
+	assert(range->slice_count > 1);
+	struct vy_slice *slice, *next_slice;
+	/*
+	 * Count runs at L0. A run created by compaction accounts
+	 * more than one dump, see vy_run::dump_count. The oldest
+	 * run is always at the last level.
+	 */
+	int l0_count = 0;
+	uint64_t l0_size = 0;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		if (l0_count == range->slice_count - 1 ||
+		    slice->run->dump_count > 1)
+			break;
+		l0_count++;
+		l0_size += slice->count.bytes;
+	}
+	int skip = 0;
+	int count = 0;
+	if (l0_count > 0 && l0_count >= (int)run_count_per_level) {
+		/* slice points to the first run after L0. */
+		count = l0_count + 1;
+		if (l0_count > 1 &&
+		    l0_size * run_size_ratio <= slice->count.bytes)
+			count = l0_count;
+	} else {
+		/*
+		 * Merge the level that exceeds its target size
+		 * most into the next one.
+		 */
+		double max_score = 1;
+		int i = 0;
+		rlist_foreach_entry(slice, &range->slices, in_range) {
+			if (++i == range->slice_count)
+				break;
+			if (i <= l0_count)
+				continue;
+			next_slice = rlist_next_entry(slice, in_range);
+			double score = slice->count.bytes * run_size_ratio /
+				       MAX(next_slice->count.bytes, 1);
+			if (score > max_score) {
+				max_score = score;
+				skip = i - 1;
+				count = 2;
+			}
+		}
+	}
+	if (count == 0)
+		return;
+	range->compaction_priority = count;
+	range->compaction_skip = skip;
+	int i = 0;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		if (i >= skip + count)
+			break;
+		if (i++ >= skip)
+			vy_disk_stmt_counter_add(&range->compaction_queue,
+						 &slice->count);
+	}
+}
+
+/**
+ * Return the number of the newest slices of a range whose runs
+ * were dumped within the same time window as the newest one.
+ */
+static int
+vy_range_current_window_slice_count(struct vy_range *range,
+				    double compaction_window)
+{
+	assert(compaction_window > 0);
+	struct vy_slice *slice;
+	int64_t window = -1;
+	int count = 0;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		int64_t w = slice->run->info.dump_time / compaction_window;
+		if (window >= 0 && w != window)
+			break;
+		window = w;
+		count++;
+	}
+	return count;
+}
+
+void
+vy_range_update_compaction_priority(struct vy_range *range,
+				    const struct index_opts *opts)
+{
+	assert(opts->run_count_per_level > 0);
+	assert(opts->run_size_ratio > 1);
+
+	range->compaction_priority = 0;
+	range->compaction_skip = 0;
+	vy_disk_stmt_counter_reset(&range->compaction_queue);
+
+	if (range->slice_count <= 1) {
+		/* Nothing to compact. */
+		range->needs_compaction = false;
+		return;
+	}
+
+	if (range->needs_compaction) {
+		range->compaction_priority = range->slice_count;
+		range->compaction_queue = range->count;
+		return;
+	}
+
+	int slice_count;
+	switch (opts->compaction_strategy) {
+	case COMPACTION_STRATEGY_LEVELED:
+		vy_range_pick_leveled(range, opts->run_count_per_level,
+				      opts->run_size_ratio);
+		break;
+	case COMPACTION_STRATEGY_TIME_WINDOW:
+		/*
+		 * Only runs dumped within the current time window
+		 * are merged, with the tiered policy. Runs of past
+		 * windows are left as they are, because keys are
+		 * supposed to be appended in time order and so
+		 * past windows don't overlap with new data.
+		 */
+		slice_count = vy_range_current_window_slice_count(range,
+						opts->compaction_window);
+		if (slice_count > 1) {
+			vy_range_pick_levels(range, slice_count,
+					     opts->run_count_per_level,
+					     opts->run_size_ratio);
+		}
+		break;
+	default:
+		vy_range_pick_levels(range, range->slice_count,
+				     opts->run_count_per_level,
+				     opts->run_size_ratio);
+		break;
+	}
+}
+
 void
 vy_range_update_dumps_per_compaction(struct vy_range *range)
 {
@@ -473,17 +617,14 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
 		return false;
 
 	/* Find the median key in the oldest run (approximately). */
-	struct vy_page_info *mid_page;
-	mid_page = vy_run_page_info(slice->run, slice->first_page_no +
-				    (slice->last_page_no -
-				     slice->first_page_no) / 2);
-
-	struct vy_page_info *first_page = vy_run_page_info(slice->run,
-						slice->first_page_no);
+	const char *mid_key = vy_run_page_min_key(slice->run,
+			slice->first_page_no +
+			(slice->last_page_no - slice->first_page_no) / 2);
+	const char *first_key = vy_run_page_min_key(slice->run,
+						    slice->first_page_no);
 
 	/* No point in splitting if a new range is going to be empty. */
-	if (key_compare(first_page->min_key, mid_page->min_key,
-			range->cmp_def) == 0)
+	if (key_compare(first_key, mid_key, range->cmp_def) == 0)
 		return false;
 	/*
 	 * In extreme cases the median key can be < the beginning
@@ -497,21 +638,23 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
 	 * begin = [30], end = [70]
 	 * first_page_no = N, last_page_no = N + 1
 	 *
-	 * which makes mid_page_no = N and mid_page->min_key = [10].
+	 * which makes mid_page_no = N and mid_key = [10].
 	 *
 	 * In such cases there's no point in splitting the range.
 	 */
-	if (slice->begin != NULL && key_compare(mid_page->min_key,
+	if (slice->begin != NULL && key_compare(mid_key,
 			tuple_data(slice->begin), range->cmp_def) <= 0)
 		return false;
 	/*
-	 * The median key can't be >= the end of the slice as we
-	 * take the min key of a page for the median key.
+	 * Similarly, the median key can be >= the end of the slice
+	 * if the last page of the slice was rounded up to the end
+	 * of a page index partition, see vy_slice_find_page().
 	 */
-	assert(slice->end == NULL || key_compare(mid_page->min_key,
-			tuple_data(slice->end), range->cmp_def) < 0);
+	if (slice->end != NULL && key_compare(mid_key,
+			tuple_data(slice->end), range->cmp_def) >= 0)
+		return false;
 
-	*p_split_key = mid_page->min_key;
+	*p_split_key = mid_key;
 	return true;
 }
 
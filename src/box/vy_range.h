@@ -107,6 +107,13 @@ struct vy_range {
 	 * how we  decide how many runs to compact next time.
 	 */
 	int compaction_priority;
+	/**
+	 * Number of the newest runs the next compaction of this
+	 * range will skip. Always 0 unless the leveled compaction
+	 * strategy is used, which merges a level into the next one
+	 * without taking in upper levels.
+	 */
+	int compaction_skip;
 	/** Number of statements that need to be compacted. */
 	struct vy_disk_stmt_counter compaction_queue;
 	/**
@@ -258,7 +265,8 @@ vy_range_update_dumps_per_compaction(struct vy_range *range);
  *
  * @param range             The range.
  * @param range_size        Target range size.
- * @param[out] p_split_key  Key to split the range by.
+ * @param[out] p_split_key  Key to split the range by, valid
+ *                          until the fiber yields.
  *
  * @retval true             If the range needs to be split.
  */
@@ -623,7 +623,7 @@ vy_read_iterator_add_disk(struct vy_read_iterator *itr)
 				     iterator_type, itr->key,
 				     itr->read_view, lsm->cmp_def,
 				     lsm->key_def, lsm->disk_format,
-				     lsm->index_id == 0);
+				     vy_lsm_is_covering(lsm));
 	}
 }
 
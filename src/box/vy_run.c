@@ -31,6 +31,9 @@
 #include "vy_run.h"
 
 #include <zstd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 #include "fiber.h"
 #include "fiber_cond.h"
@@ -38,6 +41,7 @@
 #include "cbus.h"
 #include "memory.h"
 #include "coio_file.h"
+#include "assoc.h"
 
 #include "replication.h"
 #include "tuple_bloom.h"
@@ -71,6 +75,16 @@ const char *vy_file_suffix[] = {
 	"run" inprogress_suffix, 	/* VY_FILE_RUN_INPROGRESS */
 };
 
+const char *vy_blob_suffix = "blob";
+
+/**
+ * If less than this fraction of a blob file is used by a run,
+ * compaction of the run moves the tuples it refers to to a new
+ * blob file so that the space occupied by dead tuples can be
+ * reclaimed once all runs linking the old blob file are deleted.
+ */
+static const double VY_BLOB_GC_RATIO = 0.5;
+
 /**
  * We read runs in background threads so as not to stall tx.
  * This structure represents such a thread.
@@ -96,6 +110,35 @@ struct vy_page_read_task {
 	struct vy_page *page;
 };
 
+/**
+ * Page read issued by a run iterator in advance, before the
+ * iterator actually needs the page, see vy_run_iterator_readahead().
+ * Unlike a page read task, it is posted to a reader thread without
+ * waiting for completion, hence it has its own cbus callbacks.
+ */
+struct vy_page_readahead {
+	/** Page read task. */
+	struct vy_page_read_task task;
+	/** Number of the page to read. */
+	uint32_t page_no;
+	/**
+	 * Set if the iterator is not interested in the page
+	 * anymore. The request is freed upon completion then.
+	 */
+	bool is_cancelled;
+	/** Link in vy_run_iterator::readahead. */
+	struct rlist in_itr;
+};
+
+/**
+ * Number of pages a run iterator must load sequentially in a row
+ * before it starts reading pages ahead.
+ */
+static const uint32_t VY_READAHEAD_SEQ_THRESHOLD = 2;
+
+/** Max number of pages a run iterator may read ahead. */
+static const uint32_t VY_READAHEAD_WINDOW_MAX = 16;
+
 /** Destructor for env->zdctx_key thread-local variable */
 static void
 vy_free_zdctx(void *arg)
@@ -168,6 +211,13 @@ vy_run_env_create(struct vy_run_env *env, int read_threads)
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
+	mempool_create(&env->readahead_pool, cord_slab_cache(),
+		       sizeof(struct vy_page_readahead));
+	rlist_create(&env->meta_cache.lru);
+	env->meta_cache.mem_quota = SIZE_MAX;
+	env->blob_files = mh_i64ptr_new();
+	if (env->blob_files == NULL)
+		panic("failed to allocate vinyl blob file hash");
 }
 
 /**
@@ -179,7 +229,9 @@ vy_run_env_destroy(struct vy_run_env *env)
 	if (env->reader_pool != NULL)
 		vy_run_env_stop_readers(env);
 	mempool_destroy(&env->read_task_pool);
+	mempool_destroy(&env->readahead_pool);
 	tt_pthread_key_delete(env->zdctx_key);
+	mh_i64ptr_delete(env->blob_files);
 }
 
 /**
@@ -220,6 +272,57 @@ vy_page_info_destroy(struct vy_page_info *page_info)
 		free(page_info->min_key);
 }
 
+/** Destroy and free an array of page infos. */
+static void
+vy_page_info_array_delete(struct vy_page_info *page_info, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+		vy_page_info_destroy(&page_info[i]);
+	free(page_info);
+}
+
+/** Free page infos and the bloom filter of a loaded partition. */
+static void
+vy_meta_cache_evict(struct vy_meta_cache *cache,
+		    struct vy_page_index_part *part)
+{
+	assert(part->page_info != NULL);
+	assert(cache->mem_used >= part->mem_used);
+	cache->mem_used -= part->mem_used;
+	rlist_del_entry(part, in_lru);
+	vy_page_info_array_delete(part->page_info, part->count.pages);
+	part->page_info = NULL;
+	if (part->bloom != NULL) {
+		tuple_bloom_delete(part->bloom);
+		part->bloom = NULL;
+	}
+	part->mem_used = 0;
+}
+
+/**
+ * Evict least recently used partitions until the cache fits
+ * in the quota. The partition given in @keep is never evicted.
+ */
+static void
+vy_meta_cache_gc(struct vy_meta_cache *cache,
+		 struct vy_page_index_part *keep)
+{
+	struct vy_page_index_part *part, *tmp;
+	rlist_foreach_entry_safe(part, &cache->lru, in_lru, tmp) {
+		if (cache->mem_used <= cache->mem_quota)
+			break;
+		if (part != keep)
+			vy_meta_cache_evict(cache, part);
+	}
+}
+
+void
+vy_run_env_set_meta_cache_quota(struct vy_run_env *env, size_t quota)
+{
+	env->meta_cache.mem_quota = quota;
+	vy_meta_cache_gc(&env->meta_cache, NULL);
+}
+
 struct vy_run *
 vy_run_new(struct vy_run_env *env, int64_t id)
 {
@@ -239,6 +342,54 @@ vy_run_new(struct vy_run_env *env, int64_t id)
 	return run;
 }
 
+/**
+ * Register an open blob file in the environment.
+ * On success, the file takes ownership of @fd.
+ * Returns NULL on memory allocation error.
+ */
+static struct vy_blob_file *
+vy_blob_file_new(struct vy_run_env *env, int64_t id, int fd, uint64_t size)
+{
+	struct vy_blob_file *file = malloc(sizeof(*file));
+	if (file == NULL) {
+		diag_set(OutOfMemory, sizeof(*file),
+			 "malloc", "struct vy_blob_file");
+		return NULL;
+	}
+	struct mh_i64ptr_t *h = env->blob_files;
+	struct mh_i64ptr_node_t node = { id, file };
+	if (mh_i64ptr_put(h, &node, NULL, NULL) == mh_end(h)) {
+		diag_set(OutOfMemory, 0, "mh_i64ptr_put", "mh_i64ptr_node_t");
+		free(file);
+		return NULL;
+	}
+	file->id = id;
+	file->fd = fd;
+	file->size = size;
+	file->refs = 1;
+	return file;
+}
+
+/**
+ * Drop a reference to a shared blob file. The file is closed
+ * when the last run linking it is freed.
+ */
+static void
+vy_blob_file_unref(struct vy_run_env *env, struct vy_blob_file *file)
+{
+	assert(file->refs > 0);
+	if (--file->refs > 0)
+		return;
+	struct mh_i64ptr_t *h = env->blob_files;
+	mh_int_t k = mh_i64ptr_find(h, file->id, NULL);
+	assert(k != mh_end(h));
+	assert(mh_i64ptr_node(h, k)->val == file);
+	mh_i64ptr_del(h, k, NULL);
+	if (close(file->fd) < 0)
+		say_syserror("close failed");
+	free(file);
+}
+
 static void
 vy_run_clear(struct vy_run *run)
 {
@@ -249,6 +400,15 @@ vy_run_clear(struct vy_run *run)
 		free(run->page_info);
 	}
 	run->page_info = NULL;
+	for (uint32_t i = 0; i < run->info.part_count; i++) {
+		struct vy_page_index_part *part = &run->info.parts[i];
+		if (part->page_info != NULL)
+			vy_meta_cache_evict(&run->env->meta_cache, part);
+		free(part->min_key);
+	}
+	free(run->info.parts);
+	run->info.parts = NULL;
+	run->info.part_count = 0;
 	run->page_index_size = 0;
 	run->info.page_count = 0;
 	if (run->info.bloom != NULL) {
@@ -259,6 +419,158 @@ vy_run_clear(struct vy_run *run)
 	run->info.min_key = NULL;
 	free(run->info.max_key);
 	run->info.max_key = NULL;
+	for (uint32_t i = 0; i < run->info.blob_count; i++) {
+		struct vy_run_blob *blob = &run->info.blobs[i];
+		if (blob->file != NULL)
+			vy_blob_file_unref(run->env, blob->file);
+		else if (blob->fd >= 0 && close(blob->fd) < 0)
+			say_syserror("close failed");
+	}
+	free(run->info.blobs);
+	run->info.blobs = NULL;
+	free(run->info.blob_ids);
+	run->info.blob_ids = NULL;
+	run->info.blob_count = 0;
+}
+
+/** Find a blob file referenced by a run. */
+static struct vy_run_blob *
+vy_run_find_blob(struct vy_run *run, int64_t blob_id)
+{
+	for (uint32_t i = 0; i < run->info.blob_count; i++) {
+		if (run->info.blobs[i].id == blob_id)
+			return &run->info.blobs[i];
+	}
+	return NULL;
+}
+
+/**
+ * Add a blob file to the list of blob files referenced by
+ * a run. Returns NULL on memory allocation error.
+ */
+static struct vy_run_blob *
+vy_run_add_blob(struct vy_run *run, int64_t blob_id)
+{
+	assert(vy_run_find_blob(run, blob_id) == NULL);
+	size_t size = (run->info.blob_count + 1) * sizeof(struct vy_run_blob);
+	struct vy_run_blob *blobs = realloc(run->info.blobs, size);
+	if (blobs == NULL) {
+		diag_set(OutOfMemory, size, "realloc", "struct vy_run_blob");
+		return NULL;
+	}
+	run->info.blobs = blobs;
+	size = (run->info.blob_count + 1) * sizeof(int64_t);
+	int64_t *blob_ids = realloc(run->info.blob_ids, size);
+	if (blob_ids == NULL) {
+		diag_set(OutOfMemory, size, "realloc", "blob_ids");
+		return NULL;
+	}
+	run->info.blob_ids = blob_ids;
+	blob_ids[run->info.blob_count] = blob_id;
+	struct vy_run_blob *blob = &blobs[run->info.blob_count++];
+	blob->id = blob_id;
+	blob->size = 0;
+	blob->bytes = 0;
+	blob->fd = -1;
+	blob->file = NULL;
+	return blob;
+}
+
+int
+vy_run_open_blobs(struct vy_run *run, const char *dir,
+		  uint32_t space_id, uint32_t iid)
+{
+	struct vy_run_env *env = run->env;
+	struct mh_i64ptr_t *h = env->blob_files;
+	char path[PATH_MAX];
+	for (uint32_t i = 0; i < run->info.blob_count; i++) {
+		struct vy_run_blob *blob = &run->info.blobs[i];
+		struct vy_blob_file *file;
+		if (blob->file != NULL)
+			continue;
+		if (blob->fd >= 0) {
+			/* Blob file created by the run writer. */
+			assert(mh_i64ptr_find(h, blob->id,
+					      NULL) == mh_end(h));
+			file = vy_blob_file_new(env, blob->id, blob->fd,
+						blob->size);
+			if (file == NULL)
+				return -1;
+			blob->file = file;
+			continue;
+		}
+		mh_int_t k = mh_i64ptr_find(h, blob->id, NULL);
+		if (k != mh_end(h)) {
+			file = mh_i64ptr_node(h, k)->val;
+			file->refs++;
+		} else {
+			vy_blob_snprint_path(path, sizeof(path), dir,
+					     space_id, iid, run->id, blob->id);
+			int fd = open(path, O_RDONLY);
+			if (fd < 0) {
+				diag_set(SystemError,
+					 "failed to open file '%s'", path);
+				return -1;
+			}
+			struct stat st;
+			if (fstat(fd, &st) < 0) {
+				diag_set(SystemError,
+					 "failed to stat file '%s'", path);
+				close(fd);
+				return -1;
+			}
+			file = vy_blob_file_new(env, blob->id, fd,
+						st.st_size);
+			if (file == NULL) {
+				close(fd);
+				return -1;
+			}
+		}
+		blob->file = file;
+		blob->fd = file->fd;
+		blob->size = file->size;
+	}
+	return 0;
+}
+
+/**
+ * Account a statement read from a run that refers to a blob file
+ * to the run blob file list. Used for rebuilding run index.
+ */
+static int
+vy_run_acct_blob_ref(struct vy_run *run, const struct tuple *stmt)
+{
+	const struct vy_blob_ref *ref = vy_stmt_blob_ref(stmt);
+	struct vy_run_blob *blob = vy_run_find_blob(run, ref->blob_id);
+	if (blob == NULL) {
+		blob = vy_run_add_blob(run, ref->blob_id);
+		if (blob == NULL)
+			return -1;
+	}
+	blob->bytes += ref->size;
+	return 0;
+}
+
+/**
+ * Fill in the members of the blob reference of a statement
+ * read from a run that are not stored on disk.
+ */
+static int
+vy_run_bind_blob_ref(struct vy_run *run, struct tuple *stmt)
+{
+	struct vy_blob_ref *ref = vy_stmt_blob_ref(stmt);
+	struct vy_run_blob *blob = vy_run_find_blob(run, ref->blob_id);
+	if (blob == NULL || blob->fd < 0) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Unknown blob file %lld",
+				    (long long)ref->blob_id));
+		return -1;
+	}
+	ref->run_id = run->id;
+	ref->fd = blob->fd;
+	ref->blob_size = blob->size;
+	ref->run_bytes = blob->bytes;
+	return 0;
 }
 
 void
@@ -278,6 +590,107 @@ vy_run_bloom_size(struct vy_run *run)
 	return run->info.bloom == NULL ? 0 : tuple_bloom_size(run->info.bloom);
 }
 
+static NODISCARD int
+vy_run_load_part(struct vy_run *run, uint32_t part_no, bool use_coio);
+
+/**
+ * Return the number of pages in @page_info (@count entries) with
+ * min key less than @key if @is_lower_bound is set, less than or
+ * equal to @key otherwise.
+ */
+static uint32_t
+vy_page_info_bound(const struct vy_page_info *page_info, uint32_t count,
+		   const struct tuple *key, struct key_def *cmp_def,
+		   bool is_lower_bound)
+{
+	uint32_t beg = 0;
+	uint32_t end = count;
+	while (beg != end) {
+		uint32_t mid = beg + (end - beg) / 2;
+		int cmp = vy_stmt_compare_with_raw_key(key,
+				page_info[mid].min_key, cmp_def);
+		if (cmp > 0 || (cmp == 0 && !is_lower_bound))
+			beg = mid + 1;
+		else
+			end = mid;
+	}
+	return end;
+}
+
+/**
+ * Same as vy_page_info_bound(), but for the page index partition
+ * directory of a run.
+ */
+static uint32_t
+vy_page_index_part_bound(struct vy_run *run, const struct tuple *key,
+			 struct key_def *cmp_def, bool is_lower_bound)
+{
+	uint32_t beg = 0;
+	uint32_t end = run->info.part_count;
+	while (beg != end) {
+		uint32_t mid = beg + (end - beg) / 2;
+		int cmp = vy_stmt_compare_with_raw_key(key,
+				run->info.parts[mid].min_key, cmp_def);
+		if (cmp > 0 || (cmp == 0 && !is_lower_bound))
+			beg = mid + 1;
+		else
+			end = mid;
+	}
+	return end;
+}
+
+/** Return the index of the page index partition storing a page. */
+static uint32_t
+vy_run_find_part(struct vy_run *run, uint32_t page_no)
+{
+	assert(run->info.parts != NULL);
+	assert(page_no < run->info.page_count);
+	uint32_t beg = 0;
+	uint32_t end = run->info.part_count;
+	while (end - beg > 1) {
+		uint32_t mid = beg + (end - beg) / 2;
+		if (run->info.parts[mid].first_page_no <= page_no)
+			beg = mid;
+		else
+			end = mid;
+	}
+	return beg;
+}
+
+/**
+ * Return the min key of a run page if it is available without
+ * reading the page index from disk, NULL otherwise.
+ */
+static const char *
+vy_run_cached_page_min_key(struct vy_run *run, uint32_t page_no)
+{
+	if (run->info.parts == NULL)
+		return vy_run_page_info(run, page_no)->min_key;
+	struct vy_page_index_part *part;
+	part = &run->info.parts[vy_run_find_part(run, page_no)];
+	if (page_no == part->first_page_no)
+		return part->min_key;
+	if (part->page_info != NULL)
+		return part->page_info[page_no - part->first_page_no].min_key;
+	return NULL;
+}
+
+/**
+ * Return the info of a run page if it is available without
+ * reading the page index from disk, NULL otherwise.
+ */
+static struct vy_page_info *
+vy_run_cached_page_info(struct vy_run *run, uint32_t page_no)
+{
+	if (run->info.parts == NULL)
+		return vy_run_page_info(run, page_no);
+	struct vy_page_index_part *part;
+	part = &run->info.parts[vy_run_find_part(run, page_no)];
+	if (part->page_info == NULL)
+		return NULL;
+	return &part->page_info[page_no - part->first_page_no];
+}
+
 /**
  * Find a page from which the iteration of a given key must be started.
  * LE and LT: the found page definitely contains the position
@@ -287,19 +700,26 @@ vy_run_bloom_size(struct vy_run *run)
  *  for iteration start. In this case it is certain that the iteration
  *  must be started from the beginning of the next page.
  *
+ * If the page index of the run is partitioned, the search is
+ * done in two steps: first, the partition directory is searched,
+ * then the only partition that may contain the boundary is loaded
+ * (in a reader thread if coio is enabled) and searched.
+ *
  * @param run - run
  * @param key - key to find
  * @param key_def - key_def for comparison
  * @param itype - iterator type (see above)
+ * @param[out] page_no - offset of the page in page index OR
+ *  run->info.page_count if there no pages fulfilling the conditions.
  * @param equal_key: *equal_key is set to true if there is a page
  *  with min_key equal to the given key.
- * @return offset of the page in page index OR run->info.page_count if
- *  there no pages fulfilling the conditions.
+ * @retval 0 success
+ * @retval -1 read or memory error
  */
-static uint32_t
+static NODISCARD int
 vy_page_index_find_page(struct vy_run *run, const struct tuple *key,
 			struct key_def *cmp_def, enum iterator_type itype,
-			bool *equal_key)
+			uint32_t *page_no, bool *equal_key)
 {
 	if (itype == ITER_EQ)
 		itype = ITER_GE; /* One day it'll become obsolete */
@@ -318,46 +738,109 @@ vy_page_index_find_page(struct vy_run *run, const struct tuple *key,
 	 * Example: we are searching for a value 2 in the run of 10 pages:
 	 * min_key:         [1   1   2   2   2   2   2   3   3   3]
 	 * we want to find: [    LT  GE              LE  GT       ]
-	 * For LT and GE it's a classical lower_bound search.
-	 * Let's set up a range with left page's min_key < key and
-	 *  right page's min >= key; binary cut the range until it
-	 *  becomes of length 1 and then LT pos = left bound of the range
-	 *  and GE pos = right bound of the range.
-	 * For LE and GT it's a classical upper_bound search.
-	 * Let's set up a range with left page's min_key <= key and
-	 *  right page's min > key; binary cut the range until it
-	 *  becomes of length 1 and then LE pos = left bound of the range
-	 *  and GT pos = right bound of the range.
+	 * For LT and GE it's a classical lower_bound search: count
+	 *  pages with min_key < key, then LT pos = count - 1 and
+	 *  GE pos = count.
+	 * For LE and GT it's a classical upper_bound search: count
+	 *  pages with min_key <= key, then LE pos = count - 1 and
+	 *  GT pos = count.
 	 */
 	bool is_lower_bound = itype == ITER_LT || itype == ITER_GE;
 
-	assert(run->info.page_count > 0);
-	/* Initially the range is set with virtual positions */
-	int32_t range[2] = { -1, run->info.page_count };
-	assert(run->info.page_count > 0);
-	do {
-		int32_t mid = range[0] + (range[1] - range[0]) / 2;
-		struct vy_page_info *info = vy_run_page_info(run, mid);
-		int cmp = vy_stmt_compare_with_raw_key(key, info->min_key,
-						       cmp_def);
-		if (is_lower_bound)
-			range[cmp <= 0] = mid;
-		else
-			range[cmp < 0] = mid;
-		*equal_key = *equal_key || cmp == 0;
-	} while (range[1] - range[0] > 1);
-	if (range[0] < 0)
-		range[0] = run->info.page_count;
-	uint32_t page = range[dir > 0];
+	uint32_t page_count = run->info.page_count;
+	assert(page_count > 0);
+	uint32_t bound;
+	if (run->info.parts == NULL) {
+		bound = vy_page_info_bound(run->page_info, page_count,
+					   key, cmp_def, is_lower_bound);
+	} else {
+		/*
+		 * The first partition starts with a page that
+		 * doesn't fall within the bound, if any, so the
+		 * bound lies within the previous partition.
+		 */
+		uint32_t part_no = vy_page_index_part_bound(run, key, cmp_def,
+							    is_lower_bound);
+		bound = 0;
+		if (part_no > 0) {
+			struct vy_page_index_part *part;
+			part = &run->info.parts[--part_no];
+			if (vy_run_load_part(run, part_no, true) != 0)
+				return -1;
+			bound = part->first_page_no +
+				vy_page_info_bound(part->page_info,
+						   part->count.pages, key,
+						   cmp_def, is_lower_bound);
+		}
+	}
+	/*
+	 * The only page that may have min_key equal to the key
+	 * is the first page past the bound in case of lower_bound
+	 * search and the last page within the bound otherwise.
+	 */
+	uint32_t eq_page_no = is_lower_bound ? bound : bound - 1;
+	if (eq_page_no < page_count) {
+		const char *min_key = vy_run_cached_page_min_key(run,
+								 eq_page_no);
+		assert(min_key != NULL);
+		*equal_key = vy_stmt_compare_with_raw_key(key, min_key,
+							  cmp_def) == 0;
+	}
 
 	/**
 	 * Since page search uses only min_key of pages,
 	 *  for GE, GT and EQ the previous page can contain
 	 *  the point where iteration must be started.
 	 */
-	if (page > 0 && dir > 0)
-		return page - 1;
-	return page;
+	if (bound > 0)
+		*page_no = bound - 1;
+	else
+		*page_no = dir > 0 ? 0 : page_count;
+	return 0;
+}
+
+/**
+ * Find the first (ITER_GE) or the last (ITER_LT) page spanned by
+ * a slice with the given boundary, see vy_page_index_find_page().
+ * Unlike the latter, never reads the page index from disk so that
+ * slices can be created in the tx thread without blocking it. If
+ * the partition that contains the boundary isn't cached, the
+ * first or the last page of the partition, respectively, is
+ * returned. A slice stream narrows the slice down when it reads
+ * the partition, see vy_slice_stream_search().
+ */
+static uint32_t
+vy_slice_find_page(struct vy_run *run, const struct tuple *key,
+		   struct key_def *cmp_def, enum iterator_type itype)
+{
+	assert(itype == ITER_GE || itype == ITER_LT);
+	uint32_t bound;
+	if (run->info.parts == NULL) {
+		bound = vy_page_info_bound(run->page_info,
+					   run->info.page_count,
+					   key, cmp_def, true);
+	} else {
+		uint32_t part_no = vy_page_index_part_bound(run, key,
+							    cmp_def, true);
+		bound = 0;
+		if (part_no > 0) {
+			struct vy_page_index_part *part;
+			part = &run->info.parts[part_no - 1];
+			if (part->page_info != NULL) {
+				bound = part->first_page_no +
+					vy_page_info_bound(part->page_info,
+							   part->count.pages,
+							   key, cmp_def, true);
+			} else if (itype == ITER_GE) {
+				bound = part->first_page_no + 1;
+			} else {
+				bound = part->first_page_no + part->count.pages;
+			}
+		}
+	}
+	if (bound > 0)
+		return bound - 1;
+	return itype == ITER_GE ? 0 : run->info.page_count;
 }
 
 struct vy_slice *
@@ -389,21 +872,19 @@ vy_slice_new(int64_t id, struct vy_run *run, struct tuple *begin,
 		return slice;
 	}
 	/** Lookup the first and the last pages spanned by the slice. */
-	bool unused;
 	if (slice->begin == NULL) {
 		slice->first_page_no = 0;
 	} else {
 		slice->first_page_no =
-			vy_page_index_find_page(run, slice->begin, cmp_def,
-						ITER_GE, &unused);
+			vy_slice_find_page(run, slice->begin, cmp_def,
+					   ITER_GE);
 		assert(slice->first_page_no < run->info.page_count);
 	}
 	if (slice->end == NULL) {
 		slice->last_page_no = run->info.page_count - 1;
 	} else {
 		slice->last_page_no =
-			vy_page_index_find_page(run, slice->end, cmp_def,
-						ITER_LT, &unused);
+			vy_slice_find_page(run, slice->end, cmp_def, ITER_LT);
 		if (slice->last_page_no == run->info.page_count) {
 			/* It's an empty slice */
 			slice->first_page_no = 0;
@@ -564,6 +1045,90 @@ vy_stmt_stat_decode(struct vy_stmt_stat *stat, const char **data)
 	}
 }
 
+/**
+ * Decode the array of blob files referenced by a run from @data
+ * and advance @data. Each entry is encoded as [id, bytes].
+ */
+static int
+vy_run_blobs_decode(struct vy_run_info *run_info, const char **data)
+{
+	uint32_t count = mp_decode_array(data);
+	if (count == 0)
+		return 0;
+	struct vy_run_blob *blobs = calloc(count, sizeof(*blobs));
+	if (blobs == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*blobs),
+			 "calloc", "struct vy_run_blob");
+		return -1;
+	}
+	int64_t *blob_ids = calloc(count, sizeof(*blob_ids));
+	if (blob_ids == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*blob_ids),
+			 "calloc", "blob_ids");
+		free(blobs);
+		return -1;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		struct vy_run_blob *blob = &blobs[i];
+		uint32_t size = mp_decode_array(data);
+		blob->id = mp_decode_uint(data);
+		blob->bytes = mp_decode_uint(data);
+		blob->fd = -1;
+		blob_ids[i] = blob->id;
+		for (uint32_t j = 2; j < size; j++)
+			mp_next(data);
+	}
+	run_info->blobs = blobs;
+	run_info->blob_ids = blob_ids;
+	run_info->blob_count = count;
+	return 0;
+}
+
+/**
+ * Decode the page index partition directory from @data and
+ * advance @data. Each entry is encoded as [offset, size,
+ * unpacked size, page count, min key, rows, bytes, bytes
+ * compressed].
+ */
+static int
+vy_page_index_parts_decode(struct vy_run_info *run_info, const char **data)
+{
+	uint32_t count = mp_decode_array(data);
+	if (count == 0)
+		return 0;
+	struct vy_page_index_part *parts = calloc(count, sizeof(*parts));
+	if (parts == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*parts),
+			 "calloc", "struct vy_page_index_part");
+		return -1;
+	}
+	run_info->parts = parts;
+	uint32_t first_page_no = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		struct vy_page_index_part *part = &parts[i];
+		rlist_create(&part->in_lru);
+		uint32_t size = mp_decode_array(data);
+		part->offset = mp_decode_uint(data);
+		part->size = mp_decode_uint(data);
+		part->unpacked_size = mp_decode_uint(data);
+		part->count.pages = mp_decode_uint(data);
+		const char *min_key = *data;
+		mp_next(data);
+		part->min_key = vy_key_dup(min_key);
+		if (part->min_key == NULL)
+			return -1;
+		run_info->part_count++;
+		part->count.rows = mp_decode_uint(data);
+		part->count.bytes = mp_decode_uint(data);
+		part->count.bytes_compressed = mp_decode_uint(data);
+		part->first_page_no = first_page_no;
+		first_page_no += part->count.pages;
+		for (uint32_t j = 8; j < size; j++)
+			mp_next(data);
+	}
+	return 0;
+}
+
 /**
  * Decode the run metadata from xrow.
  *
@@ -628,6 +1193,17 @@ vy_run_info_decode(struct vy_run_info *run_info,
 		case VY_RUN_INFO_STMT_STAT:
 			vy_stmt_stat_decode(&run_info->stmt_stat, &pos);
 			break;
+		case VY_RUN_INFO_BLOBS:
+			if (vy_run_blobs_decode(run_info, &pos) != 0)
+				return -1;
+			break;
+		case VY_RUN_INFO_DUMP_TIME:
+			run_info->dump_time = mp_decode_uint(&pos);
+			break;
+		case VY_RUN_INFO_PAGE_INDEX:
+			if (vy_page_index_parts_decode(run_info, &pos) != 0)
+				return -1;
+			break;
 		default:
 			mp_next(&pos); /* unknown key, ignore */
 			break;
@@ -707,22 +1283,125 @@ vy_page_xrow(struct vy_page *page, uint32_t stmt_no,
  * Read raw stmt data from the page
  * @param page          Page.
  * @param stmt_no       Statement position in the page.
+ * @param run           Run the page belongs to.
  * @param cmp_def       Key definition, including primary key parts.
  * @param format        Format for REPLACE/DELETE tuples.
- * @param is_primary    True if the index is primary.
+ * @param is_primary    True if the run stores full tuples.
  *
  * @retval not NULL Statement read from page.
  * @retval     NULL Memory error.
  */
 static struct tuple *
-vy_page_stmt(struct vy_page *page, uint32_t stmt_no,
+vy_page_stmt(struct vy_page *page, uint32_t stmt_no, struct vy_run *run,
 	     const struct key_def *cmp_def, struct tuple_format *format,
 	     bool is_primary)
 {
 	struct xrow_header xrow;
 	if (vy_page_xrow(page, stmt_no, &xrow) != 0)
 		return NULL;
-	return vy_stmt_decode(&xrow, cmp_def, format, is_primary);
+	struct tuple *stmt = vy_stmt_decode(&xrow, cmp_def, format,
+					    is_primary);
+	if (stmt != NULL && vy_stmt_is_blob_ref(stmt) &&
+	    vy_run_bind_blob_ref(run, stmt) != 0) {
+		tuple_unref(stmt);
+		return NULL;
+	}
+	return stmt;
+}
+
+struct tuple *
+vy_stmt_load_blob(const struct tuple *stmt, bool use_coio)
+{
+	const struct vy_blob_ref *ref = vy_stmt_blob_ref(stmt);
+	assert(ref->fd >= 0);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct tuple *result = NULL;
+	char *data = region_alloc(region, ref->size);
+	if (data == NULL) {
+		diag_set(OutOfMemory, ref->size, "region", "blob");
+		return NULL;
+	}
+	ssize_t readen;
+	if (use_coio)
+		readen = coio_preadn(ref->fd, data, ref->size, ref->offset);
+	else
+		readen = fio_pread(ref->fd, data, ref->size, ref->offset);
+	if (readen < 0) {
+		diag_set(SystemError, "failed to read from blob file");
+		goto out;
+	}
+	if (readen != (ssize_t)ref->size) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Unexpected end of blob file");
+		goto out;
+	}
+	const char *data_end = data;
+	if (mp_typeof(*data) != MP_ARRAY ||
+	    mp_check(&data_end, data + ref->size) != 0 ||
+	    data_end != data + ref->size) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Invalid tuple in blob file %lld",
+				    (long long)ref->blob_id));
+		goto out;
+	}
+	struct tuple_format *format = tuple_format(stmt);
+	if (vy_stmt_type(stmt) == IPROTO_INSERT)
+		result = vy_stmt_new_insert(format, data, data_end);
+	else
+		result = vy_stmt_new_replace(format, data, data_end);
+	if (result == NULL)
+		goto out;
+	vy_stmt_set_lsn(result, vy_stmt_lsn(stmt));
+	vy_stmt_set_flags(result, vy_stmt_flags(stmt) & ~VY_STMT_BLOB_REF);
+out:
+	region_truncate(region, region_svp);
+	return result;
+}
+
+/** Free a page read ahead request. */
+static void
+vy_page_readahead_delete(struct vy_page_readahead *ra)
+{
+	struct vy_run_env *env = ra->task.run->env;
+	if (ra->task.page != NULL)
+		vy_page_delete(ra->task.page);
+	vy_run_unref(ra->task.run);
+	diag_destroy(&ra->task.base.diag);
+	mempool_free(&env->readahead_pool, ra);
+}
+
+/**
+ * Cancel a page read ahead request. If the request is still
+ * being processed by a reader thread, it will be freed upon
+ * completion.
+ */
+static void
+vy_page_readahead_cancel(struct vy_page_readahead *ra)
+{
+	if (ra->task.base.complete)
+		vy_page_readahead_delete(ra);
+	else
+		ra->is_cancelled = true;
+}
+
+/**
+ * Cancel all pages read ahead by a run iterator. They are
+ * accounted as wasted and shrink the read ahead window.
+ */
+static void
+vy_run_iterator_cancel_readahead(struct vy_run_iterator *itr)
+{
+	if (rlist_empty(&itr->readahead))
+		return;
+	struct vy_page_readahead *ra, *tmp;
+	rlist_foreach_entry_safe(ra, &itr->readahead, in_itr, tmp) {
+		rlist_del_entry(ra, in_itr);
+		vy_page_readahead_cancel(ra);
+		itr->stat->readahead.waste++;
+	}
+	itr->readahead_count = 0;
+	itr->readahead_window = MAX(itr->readahead_window / 2, 1U);
 }
 
 /**
@@ -731,6 +1410,7 @@ vy_page_stmt(struct vy_page *page, uint32_t stmt_no,
 static void
 vy_run_iterator_stop(struct vy_run_iterator *itr)
 {
+	vy_run_iterator_cancel_readahead(itr);
 	if (itr->curr_stmt != NULL) {
 		tuple_unref(itr->curr_stmt);
 		itr->curr_stmt = NULL;
@@ -904,15 +1584,483 @@ vy_page_read_cb_free(struct cbus_call_msg *base)
 }
 
 /**
- * Read a page from disk given its number.
- * The function caches two most recently read pages.
- *
- * @retval 0 success
- * @retval -1 critical error
+ * Decode the bloom filter of a page index partition.
+ * Returns NULL on memory error.
  */
-static NODISCARD int
-vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
-			  struct vy_page **result)
+static struct tuple_bloom *
+vy_page_index_bloom_decode(const struct xrow_header *xrow)
+{
+	assert(xrow->type == VY_RUN_BLOOM);
+	struct tuple_bloom *bloom = NULL;
+	const char *pos = xrow->body->iov_base;
+	uint32_t map_size = mp_decode_map(&pos);
+	for (uint32_t i = 0; i < map_size; i++) {
+		uint32_t key = mp_decode_uint(&pos);
+		if (key != VY_RUN_INFO_BLOOM || bloom != NULL) {
+			mp_next(&pos); /* unknown key, ignore */
+			continue;
+		}
+		bloom = tuple_bloom_decode(&pos);
+		if (bloom == NULL)
+			return NULL;
+	}
+	if (bloom == NULL) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Can't decode page index bloom filter");
+	}
+	return bloom;
+}
+
+/**
+ * Read a page index partition from the run data file and decode
+ * the page infos and, unless @p_bloom is NULL, the bloom filter
+ * stored in it. Doesn't use the metadata cache and so may be
+ * called from any thread.
+ *
+ * @retval 0 on success
+ * @retval -1 on error, check diag
+ */
+static int
+vy_page_index_part_read(struct vy_run *run,
+			const struct vy_page_index_part *part,
+			ZSTD_DStream *zdctx, struct vy_page_info **p_page_info,
+			struct tuple_bloom **p_bloom)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t page_count = part->count.pages;
+	uint32_t page_no = 0;
+	struct tuple_bloom *bloom = NULL;
+	struct vy_page_info *page_info = calloc(page_count,
+						sizeof(*page_info));
+	if (page_info == NULL) {
+		diag_set(OutOfMemory, page_count * sizeof(*page_info),
+			 "calloc", "struct vy_page_info");
+		return -1;
+	}
+	char *data = region_alloc(region, part->size);
+	char *rows = region_alloc(region, part->unpacked_size);
+	if (data == NULL || rows == NULL) {
+		diag_set(OutOfMemory, part->size + part->unpacked_size,
+			 "region", "page index");
+		goto error;
+	}
+	ssize_t readen = fio_pread(run->fd, data, part->size, part->offset);
+	if (readen < 0) {
+		diag_set(SystemError, "failed to read from file");
+		goto error;
+	}
+	if (readen != (ssize_t)part->size) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Unexpected end of file");
+		goto error;
+	}
+	if (xlog_tx_decode(data, data + part->size, rows,
+			   rows + part->unpacked_size, zdctx) != 0)
+		goto error;
+
+	const char *pos = rows;
+	const char *end = rows + part->unpacked_size;
+	while (pos < end) {
+		struct xrow_header xrow;
+		if (xrow_header_decode(&xrow, &pos, end) != 0)
+			goto error;
+		if (xrow.type == VY_INDEX_PAGE_INFO && page_no < page_count) {
+			if (vy_page_info_decode(&page_info[page_no], &xrow,
+						vy_run_filename(run)) != 0) {
+				vy_page_info_destroy(&page_info[page_no]);
+				goto error;
+			}
+			page_no++;
+		} else if (xrow.type == VY_RUN_BLOOM && bloom == NULL) {
+			if (p_bloom == NULL)
+				continue;
+			bloom = vy_page_index_bloom_decode(&xrow);
+			if (bloom == NULL)
+				goto error;
+		} else {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 tt_sprintf("Wrong page index xrow type %u",
+					    (unsigned)xrow.type));
+			goto error;
+		}
+	}
+	if (page_no != page_count) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Unexpected end of page index");
+		goto error;
+	}
+	region_truncate(region, region_svp);
+	*p_page_info = page_info;
+	if (p_bloom != NULL)
+		*p_bloom = bloom;
+	return 0;
+error:
+	region_truncate(region, region_svp);
+	vy_page_info_array_delete(page_info, page_no);
+	if (bloom != NULL)
+		tuple_bloom_delete(bloom);
+	diag_log();
+	say_error("error reading page index %s@%llu:%u",
+		  vy_run_filename(run), (unsigned long long)part->offset,
+		  (unsigned)part->size);
+	return -1;
+}
+
+/** Cbus task for reading a page index partition. */
+struct vy_page_index_read_task {
+	/** parent */
+	struct cbus_call_msg base;
+	/** vy_run with fd - ref. counted */
+	struct vy_run *run;
+	/** Partition to read. */
+	const struct vy_page_index_part *part;
+	/** [out] page infos of the partition */
+	struct vy_page_info *page_info;
+	/** [out] bloom filter of the partition */
+	struct tuple_bloom *bloom;
+};
+
+/**
+ * vinyl page index read task callback
+ */
+static int
+vy_page_index_read_cb(struct cbus_call_msg *base)
+{
+	struct vy_page_index_read_task *task =
+		(struct vy_page_index_read_task *)base;
+	ZSTD_DStream *zdctx = vy_env_get_zdctx(task->run->env);
+	if (zdctx == NULL)
+		return -1;
+	return vy_page_index_part_read(task->run, task->part, zdctx,
+				       &task->page_info, &task->bloom);
+}
+
+/**
+ * vinyl page index read task cleanup callback
+ */
+static int
+vy_page_index_read_cb_free(struct cbus_call_msg *base)
+{
+	struct vy_page_index_read_task *task =
+		(struct vy_page_index_read_task *)base;
+	if (task->page_info != NULL) {
+		vy_page_info_array_delete(task->page_info,
+					  task->part->count.pages);
+	}
+	if (task->bloom != NULL)
+		tuple_bloom_delete(task->bloom);
+	vy_run_unref(task->run);
+	free(task);
+	return 0;
+}
+
+/**
+ * Read a page index partition in a reader thread.
+ * @retval 0 on success
+ * @retval -1 on error, check diag
+ */
+static int
+vy_page_index_part_read_coio(struct vy_run *run,
+			     const struct vy_page_index_part *part,
+			     struct vy_page_info **p_page_info,
+			     struct tuple_bloom **p_bloom)
+{
+	struct vy_run_env *env = run->env;
+	struct vy_page_index_read_task *task = calloc(1, sizeof(*task));
+	if (task == NULL) {
+		diag_set(OutOfMemory, sizeof(*task), "calloc",
+			 "vy_page_index_read_task");
+		return -1;
+	}
+
+	/* Pick a reader thread. */
+	struct vy_run_reader *reader;
+	reader = &env->reader_pool[env->next_reader++];
+	env->next_reader %= env->reader_pool_size;
+
+	task->run = run;
+	task->part = part;
+	vy_run_ref(run);
+
+	/* Post task to the reader thread. */
+	int rc = cbus_call(&reader->reader_pipe, &reader->tx_pipe,
+			   &task->base, vy_page_index_read_cb,
+			   vy_page_index_read_cb_free, TIMEOUT_INFINITY);
+	if (!task->base.complete)
+		return -1; /* timed out or cancelled */
+
+	vy_run_unref(run);
+	if (rc == 0) {
+		*p_page_info = task->page_info;
+		*p_bloom = task->bloom;
+	}
+	free(task);
+	return rc;
+}
+
+/** Return the size of memory used by page infos of a partition. */
+static size_t
+vy_page_index_part_mem_used(const struct vy_page_index_part *part)
+{
+	size_t size = part->count.pages * sizeof(struct vy_page_info);
+	for (uint32_t i = 0; i < part->count.pages; i++) {
+		const char *min_key = part->page_info[i].min_key;
+		const char *min_key_end = min_key;
+		mp_next(&min_key_end);
+		size += min_key_end - min_key;
+	}
+	if (part->bloom != NULL)
+		size += tuple_bloom_size(part->bloom);
+	return size;
+}
+
+/**
+ * Make sure a page index partition of a run is loaded. If it
+ * isn't cached, it's read from disk, in a reader thread if
+ * @use_coio is set and coio is enabled, otherwise blocking the
+ * calling thread, and added to the metadata cache, which may
+ * evict other partitions. The loaded page infos and bloom filter
+ * stay valid until another partition is loaded or the fiber
+ * yields.
+ *
+ * @retval 0 on success
+ * @retval -1 on error, check diag
+ */
+static NODISCARD int
+vy_run_load_part(struct vy_run *run, uint32_t part_no, bool use_coio)
+{
+	struct vy_meta_cache *cache = &run->env->meta_cache;
+	assert(part_no < run->info.part_count);
+	struct vy_page_index_part *part = &run->info.parts[part_no];
+	if (part->page_info != NULL) {
+		rlist_move_tail_entry(&cache->lru, part, in_lru);
+		return 0;
+	}
+	struct vy_page_info *page_info;
+	struct tuple_bloom *bloom;
+	if (use_coio && run->env->reader_pool != NULL) {
+		if (vy_page_index_part_read_coio(run, part, &page_info,
+						 &bloom) != 0)
+			return -1;
+	} else {
+		ZSTD_DStream *zdctx = vy_env_get_zdctx(run->env);
+		if (zdctx == NULL)
+			return -1;
+		if (vy_page_index_part_read(run, part, zdctx, &page_info,
+					    &bloom) != 0)
+			return -1;
+	}
+	if (part->page_info != NULL) {
+		/* Loaded by another fiber while we were waiting. */
+		vy_page_info_array_delete(page_info, part->count.pages);
+		if (bloom != NULL)
+			tuple_bloom_delete(bloom);
+		rlist_move_tail_entry(&cache->lru, part, in_lru);
+		return 0;
+	}
+	part->page_info = page_info;
+	part->bloom = bloom;
+	part->mem_used = vy_page_index_part_mem_used(part);
+	cache->mem_used += part->mem_used;
+	rlist_add_tail_entry(&cache->lru, part, in_lru);
+	vy_meta_cache_gc(cache, part);
+	return 0;
+}
+
+/**
+ * Get the info of a run page. See vy_run_load_part() for
+ * the description of @use_coio and the pointer lifetime.
+ *
+ * @retval 0 on success
+ * @retval -1 on error, check diag
+ */
+static NODISCARD int
+vy_run_get_page_info(struct vy_run *run, uint32_t page_no, bool use_coio,
+		     struct vy_page_info **page_info)
+{
+	if (run->info.parts == NULL) {
+		*page_info = vy_run_page_info(run, page_no);
+		return 0;
+	}
+	uint32_t part_no = vy_run_find_part(run, page_no);
+	if (vy_run_load_part(run, part_no, use_coio) != 0)
+		return -1;
+	struct vy_page_index_part *part = &run->info.parts[part_no];
+	*page_info = &part->page_info[page_no - part->first_page_no];
+	return 0;
+}
+
+const char *
+vy_run_page_min_key(struct vy_run *run, uint32_t page_no)
+{
+	const char *min_key = vy_run_cached_page_min_key(run, page_no);
+	if (min_key != NULL)
+		return min_key;
+	struct vy_page_index_part *part;
+	part = &run->info.parts[vy_run_find_part(run, page_no)];
+	return part->min_key;
+}
+
+/** Read ahead request callback, executed by a reader thread. */
+static void
+vy_page_readahead_perform(struct cmsg *m)
+{
+	struct cbus_call_msg *msg = (struct cbus_call_msg *)m;
+	msg->rc = msg->func(msg);
+	if (msg->rc != 0)
+		diag_move(&fiber()->diag, &msg->diag);
+}
+
+/**
+ * Read ahead request completion callback, executed in tx.
+ * Wakes up the iterator waiting for the page, if any.
+ */
+static void
+vy_page_readahead_done(struct cmsg *m)
+{
+	struct vy_page_readahead *ra = (struct vy_page_readahead *)m;
+	struct cbus_call_msg *msg = &ra->task.base;
+	msg->complete = true;
+	if (ra->is_cancelled) {
+		vy_page_readahead_delete(ra);
+		return;
+	}
+	if (msg->caller != NULL)
+		fiber_wakeup(msg->caller);
+}
+
+/**
+ * Post a request to read a run page to a reader thread.
+ * Doesn't wait for the request to complete.
+ * Returns NULL on memory error.
+ */
+static struct vy_page_readahead *
+vy_page_readahead_new(struct vy_run *run, uint32_t page_no,
+		      const struct vy_page_info *page_info)
+{
+	struct vy_run_env *env = run->env;
+	assert(env->reader_pool != NULL);
+
+	struct vy_page_readahead *ra = mempool_alloc(&env->readahead_pool);
+	if (ra == NULL) {
+		diag_set(OutOfMemory, sizeof(*ra), "mempool",
+			 "vy_page_readahead");
+		return NULL;
+	}
+	struct vy_page *page = vy_page_new(page_info);
+	if (page == NULL) {
+		mempool_free(&env->readahead_pool, ra);
+		return NULL;
+	}
+
+	/* Pick a reader thread. */
+	struct vy_run_reader *reader;
+	reader = &env->reader_pool[env->next_reader++];
+	env->next_reader %= env->reader_pool_size;
+
+	ra->page_no = page_no;
+	ra->is_cancelled = false;
+	rlist_create(&ra->in_itr);
+	ra->task.run = run;
+	ra->task.page_info = *page_info;
+	ra->task.page = page;
+	vy_run_ref(run);
+
+	struct cbus_call_msg *msg = &ra->task.base;
+	diag_create(&msg->diag);
+	msg->caller = NULL;
+	msg->complete = false;
+	msg->rc = 0;
+	msg->func = vy_page_read_cb;
+	msg->free_cb = NULL;
+	msg->route[0].f = vy_page_readahead_perform;
+	msg->route[0].pipe = &reader->tx_pipe;
+	msg->route[1].f = vy_page_readahead_done;
+	msg->route[1].pipe = NULL;
+	cmsg_init(cmsg(msg), msg->route);
+
+	cpipe_push(&reader->reader_pipe, cmsg(msg));
+	return ra;
+}
+
+/**
+ * Wait for a page read ahead request to complete.
+ *
+ * @retval 0 success
+ * @retval -1 read error or the fiber was cancelled
+ */
+static int
+vy_page_readahead_wait(struct vy_page_readahead *ra)
+{
+	struct cbus_call_msg *msg = &ra->task.base;
+	while (!msg->complete) {
+		msg->caller = fiber();
+		fiber_yield_timeout(TIMEOUT_INFINITY);
+		msg->caller = NULL;
+		if (!msg->complete && fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			return -1;
+		}
+	}
+	if (msg->rc != 0) {
+		diag_move(&msg->diag, &fiber()->diag);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Start reading pages following the given one in the iteration
+ * direction so that they are ready by the time the iterator
+ * needs them. Up to readahead_window pages are read ahead. Pages
+ * are read only within the slice boundaries and only if their
+ * page index partition is loaded, because loading a partition
+ * would stall the iterator.
+ */
+static void
+vy_run_iterator_readahead(struct vy_run_iterator *itr, uint32_t page_no)
+{
+	struct vy_slice *slice = itr->slice;
+	int dir = iterator_direction(itr->iterator_type);
+	if (!rlist_empty(&itr->readahead)) {
+		page_no = rlist_last_entry(&itr->readahead,
+					   struct vy_page_readahead,
+					   in_itr)->page_no;
+	}
+	while (itr->readahead_count < itr->readahead_window) {
+		if (dir > 0 ? page_no >= slice->last_page_no :
+			      page_no <= slice->first_page_no)
+			break;
+		page_no = dir > 0 ? page_no + 1 : page_no - 1;
+		struct vy_page_info *page_info;
+		page_info = vy_run_cached_page_info(slice->run, page_no);
+		if (page_info == NULL)
+			break;
+		struct vy_page_readahead *ra;
+		ra = vy_page_readahead_new(slice->run, page_no, page_info);
+		if (ra == NULL) {
+			/* Reading ahead is optional, ignore errors. */
+			diag_clear(diag_get());
+			break;
+		}
+		rlist_add_tail_entry(&itr->readahead, ra, in_itr);
+		itr->readahead_count++;
+		itr->stat->readahead.pages++;
+	}
+}
+
+/**
+ * Read a page from disk given its number.
+ * The function caches two most recently read pages.
+ * On sequential access, it also reads following pages ahead.
+ *
+ * @retval 0 success
+ * @retval -1 critical error
+ */
+static NODISCARD int
+vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
+			  struct vy_page **result)
 {
 	struct vy_slice *slice = itr->slice;
 	struct vy_run_env *env = slice->run->env;
@@ -931,9 +2079,68 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		}
 	}
 
+	/*
+	 * Detect sequential access: if the iterator keeps loading
+	 * pages one by one in the iteration direction, it is likely
+	 * to need the following pages soon so we read them ahead.
+	 * The pages read ahead are useless otherwise.
+	 */
+	int dir = iterator_direction(itr->iterator_type);
+	if (itr->last_page_no != UINT32_MAX &&
+	    page_no == (dir > 0 ? itr->last_page_no + 1 :
+				  itr->last_page_no - 1)) {
+		itr->seq_page_count++;
+	} else {
+		itr->seq_page_count = 0;
+		vy_run_iterator_cancel_readahead(itr);
+	}
+	itr->last_page_no = page_no;
+
+	struct vy_page *page;
+	struct vy_page_info page_info_buf;
+	struct vy_page_info *page_info = &page_info_buf;
+	if (!rlist_empty(&itr->readahead)) {
+		/* The page must have been read ahead. */
+		struct vy_page_readahead *ra;
+		ra = rlist_first_entry(&itr->readahead,
+				       struct vy_page_readahead, in_itr);
+		assert(ra->page_no == page_no);
+		rlist_del_entry(ra, in_itr);
+		itr->readahead_count--;
+		itr->stat->readahead.hit++;
+		if (!ra->task.base.complete) {
+			/*
+			 * The page isn't ready yet, which means that
+			 * we don't read ahead far enough to hide the
+			 * disk latency. Widen the window.
+			 */
+			itr->readahead_window = MIN(itr->readahead_window * 2,
+						    VY_READAHEAD_WINDOW_MAX);
+		}
+		if (vy_page_readahead_wait(ra) != 0) {
+			vy_page_readahead_cancel(ra);
+			return -1;
+		}
+		page_info_buf = ra->task.page_info;
+		page = ra->task.page;
+		ra->task.page = NULL;
+		vy_page_readahead_delete(ra);
+		goto done;
+	}
+
+	/*
+	 * Copy the page info, because the page index partition
+	 * it belongs to may be evicted while we are reading the
+	 * page.
+	 */
+	struct vy_page_info *page_info_ptr;
+	if (vy_run_get_page_info(slice->run, page_no, true,
+				 &page_info_ptr) != 0)
+		return -1;
+	page_info_buf = *page_info_ptr;
+
 	/* Allocate buffers */
-	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
-	struct vy_page *page = vy_page_new(page_info);
+	page = vy_page_new(page_info);
 	if (page == NULL)
 		return -1;
 
@@ -991,6 +2198,11 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		}
 	}
 
+done:
+	if (itr->seq_page_count >= VY_READAHEAD_SEQ_THRESHOLD &&
+	    env->reader_pool != NULL)
+		vy_run_iterator_readahead(itr, page_no);
+
 	/* Update cache */
 	if (itr->prev_page != NULL)
 		vy_page_delete(itr->prev_page);
@@ -1025,8 +2237,8 @@ vy_run_iterator_read(struct vy_run_iterator *itr,
 	int rc = vy_run_iterator_load_page(itr, pos.page_no, &page);
 	if (rc != 0)
 		return rc;
-	*stmt = vy_page_stmt(page, pos.pos_in_page, itr->cmp_def,
-			     itr->format, itr->is_primary);
+	*stmt = vy_page_stmt(page, pos.pos_in_page, itr->slice->run,
+			     itr->cmp_def, itr->format, itr->is_primary);
 	if (*stmt == NULL)
 		return -1;
 	return 0;
@@ -1052,7 +2264,9 @@ vy_run_iterator_search_in_page(struct vy_run_iterator *itr,
 			iterator_type == ITER_LE ? -1 : 0);
 	while (beg != end) {
 		uint32_t mid = beg + (end - beg) / 2;
-		struct tuple *fnd_key = vy_page_stmt(page, mid, itr->cmp_def,
+		struct tuple *fnd_key = vy_page_stmt(page, mid,
+						     itr->slice->run,
+						     itr->cmp_def,
 						     itr->format,
 						     itr->is_primary);
 		if (fnd_key == NULL)
@@ -1085,9 +2299,10 @@ vy_run_iterator_search(struct vy_run_iterator *itr,
 		       const struct tuple *key,
 		       struct vy_run_iterator_pos *pos, bool *equal_key)
 {
-	pos->page_no = vy_page_index_find_page(itr->slice->run, key,
-					       itr->cmp_def, iterator_type,
-					       equal_key);
+	if (vy_page_index_find_page(itr->slice->run, key, itr->cmp_def,
+				    iterator_type, &pos->page_no,
+				    equal_key) != 0)
+		return -1;
 	if (pos->page_no == itr->slice->run->info.page_count) {
 		itr->search_ended = true;
 		return 0;
@@ -1109,11 +2324,40 @@ vy_run_iterator_search(struct vy_run_iterator *itr,
 	return 0;
 }
 
+/**
+ * Get the number of statements in a run page. Pages read by
+ * the iterator are checked first so as not to look up the page
+ * index, which may be partitioned and hence not in memory.
+ * @retval 0 success
+ * @retval -1 read or memory error
+ */
+static NODISCARD int
+vy_run_iterator_page_row_count(struct vy_run_iterator *itr,
+			       uint32_t page_no, uint32_t *row_count)
+{
+	struct vy_page *page = NULL;
+	if (itr->curr_page != NULL && itr->curr_page->page_no == page_no)
+		page = itr->curr_page;
+	else if (itr->prev_page != NULL && itr->prev_page->page_no == page_no)
+		page = itr->prev_page;
+	if (page != NULL) {
+		*row_count = page->row_count;
+		return 0;
+	}
+	struct vy_page_info *page_info;
+	if (vy_run_get_page_info(itr->slice->run, page_no, true,
+				 &page_info) != 0)
+		return -1;
+	*row_count = page_info->row_count;
+	return 0;
+}
+
 /**
  * Increment (or decrement, depending on the order) the current
  * wide position.
  * @retval 0 success, set *pos to new value
  * @retval 1 EOF
+ * @retval -1 read or memory error
  * Affects: curr_loaded_page
  */
 static NODISCARD int
@@ -1122,6 +2366,7 @@ vy_run_iterator_next_pos(struct vy_run_iterator *itr,
 			 struct vy_run_iterator_pos *pos)
 {
 	struct vy_run *run = itr->slice->run;
+	uint32_t row_count;
 	*pos = itr->curr_pos;
 	if (iterator_type == ITER_LE || iterator_type == ITER_LT) {
 		assert(pos->page_no <= run->info.page_count);
@@ -1131,20 +2376,22 @@ vy_run_iterator_next_pos(struct vy_run_iterator *itr,
 			if (pos->page_no == 0)
 				return 1;
 			pos->page_no--;
-			struct vy_page_info *page_info =
-				vy_run_page_info(run, pos->page_no);
-			assert(page_info->row_count > 0);
-			pos->pos_in_page = page_info->row_count - 1;
+			if (vy_run_iterator_page_row_count(itr, pos->page_no,
+							   &row_count) != 0)
+				return -1;
+			assert(row_count > 0);
+			pos->pos_in_page = row_count - 1;
 		}
 	} else {
 		assert(iterator_type == ITER_GE || iterator_type == ITER_GT ||
 		       iterator_type == ITER_EQ);
 		assert(pos->page_no < run->info.page_count);
-		struct vy_page_info *page_info =
-			vy_run_page_info(run, pos->page_no);
-		assert(page_info->row_count > 0);
+		if (vy_run_iterator_page_row_count(itr, pos->page_no,
+						   &row_count) != 0)
+			return -1;
+		assert(row_count > 0);
 		pos->pos_in_page++;
-		if (pos->pos_in_page >= page_info->row_count) {
+		if (pos->pos_in_page >= row_count) {
 			pos->page_no++;
 			pos->pos_in_page = 0;
 			if (pos->page_no == run->info.page_count)
@@ -1178,10 +2425,14 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 	assert(itr->curr_stmt != NULL);
 	assert(itr->curr_pos.page_no < slice->run->info.page_count);
 
+	int rc;
 	while (vy_stmt_lsn(itr->curr_stmt) > (**itr->read_view).vlsn ||
 	       vy_stmt_flags(itr->curr_stmt) & VY_STMT_SKIP_READ) {
-		if (vy_run_iterator_next_pos(itr, iterator_type,
-					     &itr->curr_pos) != 0) {
+		rc = vy_run_iterator_next_pos(itr, iterator_type,
+					      &itr->curr_pos);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
 			vy_run_iterator_stop(itr);
 			return 0;
 		}
@@ -1198,8 +2449,8 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 	}
 	if (iterator_type == ITER_LE || iterator_type == ITER_LT) {
 		struct vy_run_iterator_pos test_pos;
-		while (vy_run_iterator_next_pos(itr, iterator_type,
-						&test_pos) == 0) {
+		while ((rc = vy_run_iterator_next_pos(itr, iterator_type,
+						      &test_pos)) == 0) {
 			struct tuple *test_stmt;
 			if (vy_run_iterator_read(itr, test_pos,
 						 &test_stmt) != 0)
@@ -1215,6 +2466,8 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 			itr->curr_stmt = test_stmt;
 			itr->curr_pos = test_pos;
 		}
+		if (rc < 0)
+			return -1;
 	}
 	/* Check if the result is within the slice boundaries. */
 	if (iterator_type == ITER_LE || iterator_type == ITER_LT) {
@@ -1239,6 +2492,84 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 	return 0;
 }
 
+/** Check if a bloom filter may have statements matching a key. */
+static bool
+vy_run_bloom_maybe_has(struct tuple_bloom *bloom, const struct tuple *key,
+		       struct key_def *key_def)
+{
+	if (vy_stmt_type(key) == IPROTO_SELECT) {
+		const char *data = tuple_data(key);
+		uint32_t part_count = mp_decode_array(&data);
+		return tuple_bloom_maybe_has_key(bloom, data, part_count,
+						 key_def);
+	}
+	return tuple_bloom_maybe_has(bloom, key, key_def);
+}
+
+/**
+ * Max number of page index partitions whose bloom filters are
+ * checked on EQ lookup. A partial key may be stored in a lot of
+ * partitions, in which case it's cheaper to do the lookup.
+ */
+enum { VY_BLOOM_PART_COUNT_MAX = 2 };
+
+/**
+ * Check bloom filters of a run for a key before doing EQ lookup.
+ * If the page index of the run is partitioned, bloom filters of
+ * the partitions that may store the key are checked, which may
+ * require reading them from disk.
+ *
+ * @param[out] checked - set if there were bloom filters to check.
+ * @param[out] need_lookup - cleared if the run doesn't have the key.
+ * @retval 0 success
+ * @retval -1 read or memory error
+ */
+static NODISCARD int
+vy_run_iterator_check_bloom(struct vy_run_iterator *itr,
+			    const struct tuple *key,
+			    bool *checked, bool *need_lookup)
+{
+	struct vy_run *run = itr->slice->run;
+	*checked = false;
+	*need_lookup = true;
+	if (run->info.parts == NULL) {
+		if (run->info.bloom == NULL)
+			return 0;
+		*checked = true;
+		*need_lookup = vy_run_bloom_maybe_has(run->info.bloom, key,
+						      itr->key_def);
+		return 0;
+	}
+	/*
+	 * Statements matching the key may be stored in the
+	 * partition preceding the first one starting with
+	 * a key >= the given key up to the last partition
+	 * starting with a key <= the given key.
+	 */
+	uint32_t begin = vy_page_index_part_bound(run, key, itr->cmp_def,
+						  true);
+	uint32_t end = vy_page_index_part_bound(run, key, itr->cmp_def,
+						false);
+	if (begin > 0)
+		begin--;
+	if (end == 0 || end - begin > VY_BLOOM_PART_COUNT_MAX)
+		return 0;
+	for (uint32_t part_no = begin; part_no < end; part_no++) {
+		if (vy_run_load_part(run, part_no, true) != 0)
+			return -1;
+		struct tuple_bloom *bloom = run->info.parts[part_no].bloom;
+		if (bloom == NULL)
+			return 0;
+		if (vy_run_bloom_maybe_has(bloom, key, itr->key_def)) {
+			*checked = true;
+			return 0;
+		}
+	}
+	*checked = true;
+	*need_lookup = false;
+	return 0;
+}
+
 static NODISCARD int
 vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 			enum iterator_type iterator_type,
@@ -1248,19 +2579,12 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 
 	*ret = NULL;
 
-	struct tuple_bloom *bloom = run->info.bloom;
-	struct key_def *key_def = itr->key_def;
-	if (iterator_type == ITER_EQ && bloom != NULL) {
+	bool bloom_checked = false;
+	if (iterator_type == ITER_EQ) {
 		bool need_lookup;
-		if (vy_stmt_type(key) == IPROTO_SELECT) {
-			const char *data = tuple_data(key);
-			uint32_t part_count = mp_decode_array(&data);
-			need_lookup = tuple_bloom_maybe_has_key(bloom, data,
-							part_count, key_def);
-		} else {
-			need_lookup = tuple_bloom_maybe_has(bloom, key,
-							    key_def);
-		}
+		if (vy_run_iterator_check_bloom(itr, key, &bloom_checked,
+						&need_lookup) != 0)
+			return -1;
 		if (!need_lookup) {
 			itr->search_ended = true;
 			itr->stat->bloom_hit++;
@@ -1287,7 +2611,7 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 	}
 	if (iterator_type == ITER_EQ && !equal_found) {
 		vy_run_iterator_stop(itr);
-		if (bloom != NULL)
+		if (bloom_checked)
 			itr->stat->bloom_miss++;
 		return 0;
 	}
@@ -1304,8 +2628,11 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 		 * given (special branch of code in vy_run_iterator_search),
 		 * so we need to make a step on previous key
 		 */
-		if (vy_run_iterator_next_pos(itr, iterator_type,
-					     &itr->curr_pos) > 0) {
+		rc = vy_run_iterator_next_pos(itr, iterator_type,
+					      &itr->curr_pos);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
 			vy_run_iterator_stop(itr);
 			return 0;
 		}
@@ -1434,6 +2761,12 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 	itr->curr_page = NULL;
 	itr->prev_page = NULL;
 
+	rlist_create(&itr->readahead);
+	itr->readahead_count = 0;
+	itr->readahead_window = 1;
+	itr->last_page_no = UINT32_MAX;
+	itr->seq_page_count = 0;
+
 	itr->search_started = false;
 	itr->search_ended = false;
 
@@ -1472,8 +2805,11 @@ vy_run_iterator_next_key(struct vy_run_iterator *itr, struct tuple **ret)
 	do {
 		if (next_key != NULL)
 			tuple_unref(next_key);
-		if (vy_run_iterator_next_pos(itr, itr->iterator_type,
-					     &itr->curr_pos) != 0) {
+		int rc = vy_run_iterator_next_pos(itr, itr->iterator_type,
+						  &itr->curr_pos);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
 			vy_run_iterator_stop(itr);
 			return 0;
 		}
@@ -1511,8 +2847,12 @@ vy_run_iterator_next_lsn(struct vy_run_iterator *itr, struct tuple **ret)
 	assert(itr->curr_pos.page_no < itr->slice->run->info.page_count);
 
 	struct vy_run_iterator_pos next_pos;
+	int rc;
 next:
-	if (vy_run_iterator_next_pos(itr, ITER_GE, &next_pos) != 0) {
+	rc = vy_run_iterator_next_pos(itr, ITER_GE, &next_pos);
+	if (rc < 0)
+		return -1;
+	if (rc > 0) {
 		vy_run_iterator_stop(itr);
 		return 0;
 	}
@@ -1537,6 +2877,28 @@ next:
 	return 0;
 }
 
+/**
+ * Append a statement to a key history. If the statement refers
+ * to a blob file, load the full tuple first so that statements
+ * returned by the iterator always carry all fields.
+ * Returns 0 on success, -1 on memory allocation or IO error.
+ */
+static NODISCARD int
+vy_run_iterator_append_stmt(struct vy_run_iterator *itr,
+			    struct vy_history *history, struct tuple *stmt)
+{
+	if (!vy_stmt_is_blob_ref(stmt))
+		return vy_history_append_stmt(history, stmt);
+
+	bool use_coio = itr->slice->run->env->reader_pool != NULL;
+	struct tuple *full = vy_stmt_load_blob(stmt, use_coio);
+	if (full == NULL)
+		return -1;
+	int rc = vy_history_append_stmt(history, full);
+	tuple_unref(full);
+	return rc;
+}
+
 NODISCARD int
 vy_run_iterator_next(struct vy_run_iterator *itr,
 		     struct vy_history *history)
@@ -1546,7 +2908,7 @@ vy_run_iterator_next(struct vy_run_iterator *itr,
 	if (vy_run_iterator_next_key(itr, &stmt) != 0)
 		return -1;
 	while (stmt != NULL) {
-		if (vy_history_append_stmt(history, stmt) != 0)
+		if (vy_run_iterator_append_stmt(itr, history, stmt) != 0)
 			return -1;
 		if (vy_history_is_terminal(history))
 			break;
@@ -1598,7 +2960,7 @@ vy_run_iterator_skip(struct vy_run_iterator *itr,
 	}
 
 	while (stmt != NULL) {
-		if (vy_history_append_stmt(history, stmt) != 0)
+		if (vy_run_iterator_append_stmt(itr, history, stmt) != 0)
 			return -1;
 		if (vy_history_is_terminal(history))
 			break;
@@ -1632,6 +2994,29 @@ vy_run_acct_page(struct vy_run *run, struct vy_page_info *page)
 	run->count.pages++;
 }
 
+/**
+ * Account the page index partition directory to run statistics.
+ * Returns -1 if the directory doesn't match the page count.
+ */
+static int
+vy_run_acct_parts(struct vy_run *run)
+{
+	uint32_t page_count = 0;
+	run->page_index_size += run->info.part_count *
+				sizeof(struct vy_page_index_part);
+	for (uint32_t i = 0; i < run->info.part_count; i++) {
+		struct vy_page_index_part *part = &run->info.parts[i];
+		const char *min_key_end = part->min_key;
+		mp_next(&min_key_end);
+		run->page_index_size += min_key_end - part->min_key;
+		vy_disk_stmt_counter_add(&run->count, &part->count);
+		if (part->count.pages == 0)
+			return -1;
+		page_count += part->count.pages;
+	}
+	return page_count == run->info.page_count ? 0 : -1;
+}
+
 int
 vy_run_recover(struct vy_run *run, const char *dir,
 	       uint32_t space_id, uint32_t iid)
@@ -1686,6 +3071,20 @@ vy_run_recover(struct vy_run *run, const char *dir,
 	if (vy_run_info_decode(&run->info, &xrow, path) != 0)
 		goto fail_close;
 
+	if (run->info.parts != NULL) {
+		/*
+		 * The page index is partitioned and stored in
+		 * the run data file. Partitions will be loaded
+		 * on demand, see vy_run_load_part().
+		 */
+		if (vy_run_acct_parts(run) != 0) {
+			diag_set(ClientError, ER_INVALID_INDEX_FILE, path,
+				 "Page index doesn't match page count");
+			goto fail_close;
+		}
+		goto open_data;
+	}
+
 	/* Allocate buffer for page info. */
 	run->page_info = calloc(run->info.page_count,
 				      sizeof(struct vy_page_info));
@@ -1730,10 +3129,13 @@ vy_run_recover(struct vy_run *run, const char *dir,
 		}
 		vy_run_acct_page(run, page);
 	}
-
+open_data:
 	/* We don't need to keep metadata file open any longer. */
 	xlog_cursor_close(&cursor, false);
 
+	if (vy_run_open_blobs(run, dir, space_id, iid) != 0)
+		goto fail;
+
 	/* Prepare data file for reading. */
 	vy_run_snprint_path(path, sizeof(path), dir,
 			    space_id, iid, run->id, VY_FILE_RUN);
@@ -1762,12 +3164,16 @@ fail:
 static int
 vy_run_dump_stmt(const struct tuple *value, struct xlog *data_xlog,
 		 struct vy_page_info *info, struct key_def *key_def,
-		 bool is_primary)
+		 bool is_primary, const struct vy_blob_ref *blob_ref)
 {
 	struct xrow_header xrow;
-	int rc = (is_primary ?
-		  vy_stmt_encode_primary(value, key_def, 0, &xrow) :
-		  vy_stmt_encode_secondary(value, key_def, &xrow));
+	int rc;
+	if (blob_ref != NULL)
+		rc = vy_stmt_encode_blob_ref(value, key_def, blob_ref, &xrow);
+	else if (is_primary)
+		rc = vy_stmt_encode_primary(value, key_def, 0, &xrow);
+	else
+		rc = vy_stmt_encode_secondary(value, key_def, &xrow);
 	if (rc != 0)
 		return -1;
 
@@ -1942,6 +3348,80 @@ vy_stmt_stat_encode(const struct vy_stmt_stat *stat, char *buf)
 	return buf;
 }
 
+/** Return the size of the encoded array of blob files. */
+static size_t
+vy_run_blobs_sizeof(const struct vy_run_info *run_info)
+{
+	size_t size = mp_sizeof_array(run_info->blob_count);
+	for (uint32_t i = 0; i < run_info->blob_count; i++) {
+		const struct vy_run_blob *blob = &run_info->blobs[i];
+		size += mp_sizeof_array(2) + mp_sizeof_uint(blob->id) +
+			mp_sizeof_uint(blob->bytes);
+	}
+	return size;
+}
+
+/** Encode the array of blob files to @buf and return advanced @buf. */
+static char *
+vy_run_blobs_encode(const struct vy_run_info *run_info, char *buf)
+{
+	buf = mp_encode_array(buf, run_info->blob_count);
+	for (uint32_t i = 0; i < run_info->blob_count; i++) {
+		const struct vy_run_blob *blob = &run_info->blobs[i];
+		buf = mp_encode_array(buf, 2);
+		buf = mp_encode_uint(buf, blob->id);
+		buf = mp_encode_uint(buf, blob->bytes);
+	}
+	return buf;
+}
+
+/** Return the size of the encoded page index partition directory. */
+static size_t
+vy_page_index_parts_sizeof(const struct vy_run_info *run_info)
+{
+	size_t size = mp_sizeof_array(run_info->part_count);
+	for (uint32_t i = 0; i < run_info->part_count; i++) {
+		const struct vy_page_index_part *part = &run_info->parts[i];
+		const char *min_key_end = part->min_key;
+		mp_next(&min_key_end);
+		size += mp_sizeof_array(8) + mp_sizeof_uint(part->offset) +
+			mp_sizeof_uint(part->size) +
+			mp_sizeof_uint(part->unpacked_size) +
+			mp_sizeof_uint(part->count.pages) +
+			(min_key_end - part->min_key) +
+			mp_sizeof_uint(part->count.rows) +
+			mp_sizeof_uint(part->count.bytes) +
+			mp_sizeof_uint(part->count.bytes_compressed);
+	}
+	return size;
+}
+
+/**
+ * Encode the page index partition directory to @buf and
+ * return advanced @buf.
+ */
+static char *
+vy_page_index_parts_encode(const struct vy_run_info *run_info, char *buf)
+{
+	buf = mp_encode_array(buf, run_info->part_count);
+	for (uint32_t i = 0; i < run_info->part_count; i++) {
+		const struct vy_page_index_part *part = &run_info->parts[i];
+		const char *min_key_end = part->min_key;
+		mp_next(&min_key_end);
+		buf = mp_encode_array(buf, 8);
+		buf = mp_encode_uint(buf, part->offset);
+		buf = mp_encode_uint(buf, part->size);
+		buf = mp_encode_uint(buf, part->unpacked_size);
+		buf = mp_encode_uint(buf, part->count.pages);
+		memcpy(buf, part->min_key, min_key_end - part->min_key);
+		buf += min_key_end - part->min_key;
+		buf = mp_encode_uint(buf, part->count.rows);
+		buf = mp_encode_uint(buf, part->count.bytes);
+		buf = mp_encode_uint(buf, part->count.bytes_compressed);
+	}
+	return buf;
+}
+
 /**
  * Encode vy_run_info as xrow
  * Allocates using region alloc
@@ -1967,6 +3447,12 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	uint32_t key_count = 6;
 	if (run_info->bloom != NULL)
 		key_count++;
+	if (run_info->blob_count > 0)
+		key_count++;
+	if (run_info->dump_time > 0)
+		key_count++;
+	if (run_info->parts != NULL)
+		key_count++;
 
 	size_t size = mp_sizeof_map(key_count);
 	size += mp_sizeof_uint(VY_RUN_INFO_MIN_KEY) + min_key_size;
@@ -1982,6 +3468,15 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 			tuple_bloom_size(run_info->bloom);
 	size += mp_sizeof_uint(VY_RUN_INFO_STMT_STAT) +
 		vy_stmt_stat_sizeof(&run_info->stmt_stat);
+	if (run_info->blob_count > 0)
+		size += mp_sizeof_uint(VY_RUN_INFO_BLOBS) +
+			vy_run_blobs_sizeof(run_info);
+	if (run_info->dump_time > 0)
+		size += mp_sizeof_uint(VY_RUN_INFO_DUMP_TIME) +
+			mp_sizeof_uint(run_info->dump_time);
+	if (run_info->parts != NULL)
+		size += mp_sizeof_uint(VY_RUN_INFO_PAGE_INDEX) +
+			vy_page_index_parts_sizeof(run_info);
 
 	char *pos = region_alloc(&fiber()->gc, size);
 	if (pos == NULL) {
@@ -2010,6 +3505,18 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	}
 	pos = mp_encode_uint(pos, VY_RUN_INFO_STMT_STAT);
 	pos = vy_stmt_stat_encode(&run_info->stmt_stat, pos);
+	if (run_info->blob_count > 0) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOBS);
+		pos = vy_run_blobs_encode(run_info, pos);
+	}
+	if (run_info->dump_time > 0) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_DUMP_TIME);
+		pos = mp_encode_uint(pos, run_info->dump_time);
+	}
+	if (run_info->parts != NULL) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_PAGE_INDEX);
+		pos = vy_page_index_parts_encode(run_info, pos);
+	}
 	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
 	xrow->bodycnt = 1;
 	xrow->type = VY_INDEX_RUN_INFO;
@@ -2049,7 +3556,13 @@ vy_run_write_index(struct vy_run *run, const char *dirpath,
 	    xlog_write_row(&index_xlog, &xrow) < 0)
 		goto fail_rollback;
 
-	for (uint32_t page_no = 0; page_no < run->info.page_count; ++page_no) {
+	/*
+	 * A partitioned page index is stored in the run data
+	 * file, see vy_run_writer_write_page_index().
+	 */
+	uint32_t page_count = run->info.parts == NULL ?
+			      run->info.page_count : 0;
+	for (uint32_t page_no = 0; page_no < page_count; ++page_no) {
 		struct vy_page_info *page_info = vy_run_page_info(run, page_no);
 		if (vy_page_info_encode(page_info, &xrow) < 0) {
 			goto fail_rollback;
@@ -2088,7 +3601,8 @@ int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr)
+		     bool is_primary, uint64_t page_size, double bloom_fpr,
+		     int64_t blob_threshold)
 {
 	memset(writer, 0, sizeof(*writer));
 	writer->run = run;
@@ -2097,6 +3611,9 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 	writer->iid = iid;
 	writer->cmp_def = cmp_def;
 	writer->key_def = key_def;
+	writer->is_primary = is_primary;
+	writer->blob_threshold = is_primary ? blob_threshold : 0;
+	writer->blob_fd = -1;
 	writer->page_size = page_size;
 	writer->bloom_fpr = bloom_fpr;
 	if (bloom_fpr < 1) {
@@ -2137,6 +3654,39 @@ vy_run_writer_create_xlog(struct vy_run_writer *writer)
 	return 0;
 }
 
+/**
+ * Finish the bloom filter of the current page index partition
+ * and start a new one.
+ * @param writer Run writer.
+ *
+ * @retval -1 Memory error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_end_part_bloom(struct vy_run_writer *writer)
+{
+	assert(writer->bloom != NULL);
+	struct tuple_bloom *bloom = tuple_bloom_new(writer->bloom,
+						    writer->bloom_fpr);
+	if (bloom == NULL)
+		return -1;
+	size_t size = (writer->part_bloom_count + 1) *
+		      sizeof(*writer->part_blooms);
+	struct tuple_bloom **blooms = realloc(writer->part_blooms, size);
+	if (blooms == NULL) {
+		diag_set(OutOfMemory, size, "realloc", "struct tuple_bloom");
+		tuple_bloom_delete(bloom);
+		return -1;
+	}
+	blooms[writer->part_bloom_count++] = bloom;
+	writer->part_blooms = blooms;
+	tuple_bloom_builder_delete(writer->bloom);
+	writer->bloom = tuple_bloom_builder_new(writer->key_def->part_count);
+	if (writer->bloom == NULL)
+		return -1;
+	return 0;
+}
+
 /**
  * Start a new page with a min_key stored in @a first_stmt.
  * @param writer Run writer.
@@ -2153,6 +3703,10 @@ vy_run_writer_start_page(struct vy_run_writer *writer,
 	if (run->info.page_count >= writer->page_info_capacity &&
 	    vy_run_alloc_page_info(run, &writer->page_info_capacity) != 0)
 		return -1;
+	if (writer->bloom != NULL && run->info.page_count > 0 &&
+	    run->info.page_count % VY_PAGE_INDEX_PART_SIZE == 0 &&
+	    vy_run_writer_end_part_bloom(writer) != 0)
+		return -1;
 	const char *key = tuple_extract_key(first_stmt, writer->cmp_def, NULL);
 	if (key == NULL)
 		return -1;
@@ -2169,6 +3723,152 @@ vy_run_writer_start_page(struct vy_run_writer *writer,
 	return 0;
 }
 
+/**
+ * Append a tuple to the blob file created by the writer and
+ * fill in a reference to it.
+ * @param writer Run writer.
+ * @param data MessagePack tuple.
+ * @param size Size of the tuple.
+ * @param[out] ref Reference to the tuple in the blob file.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_write_blob(struct vy_run_writer *writer, const char *data,
+			 uint32_t size, struct vy_blob_ref *ref)
+{
+	struct vy_run *run = writer->run;
+	struct vy_run_blob *blob;
+	if (writer->blob_fd < 0) {
+		char path[PATH_MAX];
+		vy_blob_snprint_path(path, sizeof(path), writer->dirpath,
+				     writer->space_id, writer->iid,
+				     run->id, run->id);
+		say_info("writing `%s'", path);
+		int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			diag_set(SystemError, "failed to create file '%s'",
+				 path);
+			return -1;
+		}
+		blob = vy_run_add_blob(run, run->id);
+		if (blob == NULL) {
+			close(fd);
+			return -1;
+		}
+		blob->fd = fd;
+		writer->blob_fd = fd;
+	} else {
+		blob = vy_run_find_blob(run, run->id);
+		assert(blob != NULL && blob->fd == writer->blob_fd);
+	}
+	if (fio_writen(writer->blob_fd, data, size) != 0) {
+		diag_set(SystemError, "failed to write to blob file");
+		return -1;
+	}
+	memset(ref, 0, sizeof(*ref));
+	ref->blob_id = run->id;
+	ref->offset = writer->blob_offset;
+	ref->size = size;
+	writer->blob_offset += size;
+	blob->size += size;
+	blob->bytes += size;
+	return 0;
+}
+
+/**
+ * Make the run being written reference a blob file linked by
+ * the run a statement was read from. The blob file is hard
+ * linked under the name of the new run when it is referenced
+ * for the first time. It isn't opened here: the new run will
+ * share the descriptor of the source run when it is committed,
+ * see vy_run_open_blobs().
+ * @param writer Run writer.
+ * @param ref Blob reference of the statement.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_link_blob(struct vy_run_writer *writer,
+			const struct vy_blob_ref *ref)
+{
+	struct vy_run *run = writer->run;
+	struct vy_run_blob *blob = vy_run_find_blob(run, ref->blob_id);
+	if (blob == NULL) {
+		char old_path[PATH_MAX];
+		char new_path[PATH_MAX];
+		vy_blob_snprint_path(old_path, sizeof(old_path),
+				     writer->dirpath, writer->space_id,
+				     writer->iid, ref->run_id, ref->blob_id);
+		vy_blob_snprint_path(new_path, sizeof(new_path),
+				     writer->dirpath, writer->space_id,
+				     writer->iid, run->id, ref->blob_id);
+		if (link(old_path, new_path) != 0) {
+			diag_set(SystemError, "failed to link file '%s'",
+				 new_path);
+			return -1;
+		}
+		blob = vy_run_add_blob(run, ref->blob_id);
+		if (blob == NULL)
+			return -1;
+		blob->size = ref->blob_size;
+	}
+	blob->bytes += ref->size;
+	return 0;
+}
+
+/**
+ * Decide where the tuple of a REPLACE or INSERT statement
+ * written to a run storing full tuples should go.
+ *
+ * If the tuple is large enough, it is written to a blob file
+ * and @blob_ref is set to point to it. A statement that already
+ * refers to a blob file keeps the reference unless the blob file
+ * is mostly garbage, in which case the tuple is moved to the
+ * blob file created by the writer, or unless the tuple became
+ * too small for separation (the threshold was altered), in which
+ * case the tuple is stored in the run again. If the tuple has to
+ * be loaded, the full statement is returned in @value and must be
+ * unreferenced by the caller.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_prepare_value(struct vy_run_writer *writer,
+			    struct tuple **value, struct vy_blob_ref *ref,
+			    const struct vy_blob_ref **blob_ref)
+{
+	struct tuple *stmt = *value;
+	*blob_ref = NULL;
+	if (vy_stmt_is_blob_ref(stmt)) {
+		const struct vy_blob_ref *src = vy_stmt_blob_ref(stmt);
+		if (writer->blob_threshold > 0 &&
+		    src->size >= writer->blob_threshold &&
+		    src->run_bytes >= src->blob_size * VY_BLOB_GC_RATIO) {
+			if (vy_run_writer_link_blob(writer, src) != 0)
+				return -1;
+			*ref = *src;
+			*blob_ref = ref;
+			return 0;
+		}
+		stmt = vy_stmt_load_blob(stmt, false);
+		if (stmt == NULL)
+			return -1;
+		*value = stmt;
+	}
+	uint32_t size;
+	const char *data = tuple_data_range(stmt, &size);
+	if (writer->blob_threshold == 0 || size < writer->blob_threshold)
+		return 0;
+	if (vy_run_writer_write_blob(writer, data, size, ref) != 0)
+		return -1;
+	*blob_ref = ref;
+	return 0;
+}
+
 /**
  * Write @a stmt into a current page.
  * @param writer Run writer.
@@ -2180,8 +3880,18 @@ vy_run_writer_start_page(struct vy_run_writer *writer,
 static int
 vy_run_writer_write_to_page(struct vy_run_writer *writer, struct tuple *stmt)
 {
+	struct vy_run *run = writer->run;
+	struct vy_page_info *page = run->page_info + run->info.page_count;
 	if (writer->bloom != NULL) {
-		uint32_t hashed_parts = writer->last_stmt == NULL ? 0 :
+		/*
+		 * The first statement of a page index partition
+		 * starts a new bloom filter so all its key parts
+		 * must be hashed.
+		 */
+		bool is_part_start = page->row_count == 0 &&
+			run->info.page_count % VY_PAGE_INDEX_PART_SIZE == 0;
+		uint32_t hashed_parts = writer->last_stmt == NULL ||
+					is_part_start ? 0 :
 			tuple_common_key_parts(stmt, writer->last_stmt,
 					       writer->key_def);
 		tuple_bloom_builder_add(writer->bloom, stmt,
@@ -2191,8 +3901,6 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct tuple *stmt)
 		vy_stmt_unref_if_possible(writer->last_stmt);
 	writer->last_stmt = stmt;
 	vy_stmt_ref_if_possible(stmt);
-	struct vy_run *run = writer->run;
-	struct vy_page_info *page = run->page_info + run->info.page_count;
 	uint32_t *offset = (uint32_t *)ibuf_alloc(&writer->row_index_buf,
 						  sizeof(uint32_t));
 	if (offset == NULL) {
@@ -2200,8 +3908,22 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct tuple *stmt)
 		return -1;
 	}
 	*offset = page->unpacked_size;
-	if (vy_run_dump_stmt(stmt, &writer->data_xlog, page,
-			     writer->cmp_def, writer->iid == 0) != 0)
+	struct tuple *value = stmt;
+	struct vy_blob_ref ref;
+	const struct vy_blob_ref *blob_ref = NULL;
+	enum iproto_type type = vy_stmt_type(stmt);
+	int rc = 0;
+	if (writer->is_primary &&
+	    (type == IPROTO_REPLACE || type == IPROTO_INSERT))
+		rc = vy_run_writer_prepare_value(writer, &value, &ref,
+						 &blob_ref);
+	if (rc == 0)
+		rc = vy_run_dump_stmt(value, &writer->data_xlog, page,
+				      writer->cmp_def, writer->is_primary,
+				      blob_ref);
+	if (value != stmt)
+		tuple_unref(value);
+	if (rc != 0)
 		return -1;
 	int64_t lsn = vy_stmt_lsn(stmt);
 	run->info.min_lsn = MIN(run->info.min_lsn, lsn);
@@ -2285,9 +4007,162 @@ vy_run_writer_destroy(struct vy_run_writer *writer, bool reuse_fd)
 		xlog_close(&writer->data_xlog, reuse_fd);
 	if (writer->bloom != NULL)
 		tuple_bloom_builder_delete(writer->bloom);
+	for (uint32_t i = 0; i < writer->part_bloom_count; i++)
+		tuple_bloom_delete(writer->part_blooms[i]);
+	free(writer->part_blooms);
 	ibuf_destroy(&writer->row_index_buf);
 }
 
+/**
+ * Encode the bloom filter of a page index partition as xrow.
+ * Allocates using region alloc.
+ *
+ * @retval  0 success
+ * @retval -1 on error, check diag
+ */
+static int
+vy_page_index_bloom_encode(const struct tuple_bloom *bloom,
+			   struct xrow_header *xrow)
+{
+	size_t size = mp_sizeof_map(1) + mp_sizeof_uint(VY_RUN_INFO_BLOOM) +
+		      tuple_bloom_size(bloom);
+	char *pos = region_alloc(&fiber()->gc, size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, size, "region", "bloom encode");
+		return -1;
+	}
+	memset(xrow, 0, sizeof(*xrow));
+	xrow->type = VY_RUN_BLOOM;
+	xrow->body->iov_base = pos;
+	pos = mp_encode_map(pos, 1);
+	pos = mp_encode_uint(pos, VY_RUN_INFO_BLOOM);
+	pos = tuple_bloom_encode(bloom, pos);
+	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
+	assert(xrow->body->iov_len == size);
+	xrow->bodycnt = 1;
+	return 0;
+}
+
+/**
+ * Write a page index partition to the run data file.
+ * @param writer Run writer.
+ * @param part Partition to write. The page range must be set.
+ * @param bloom Bloom filter of the partition or NULL.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_write_part(struct vy_run_writer *writer,
+			 struct vy_page_index_part *part,
+			 const struct tuple_bloom *bloom)
+{
+	struct vy_run *run = writer->run;
+	struct xlog *xlog = &writer->data_xlog;
+	struct xrow_header xrow;
+	part->offset = xlog->offset;
+	xlog_tx_begin(xlog);
+	for (uint32_t i = 0; i < part->count.pages; i++) {
+		struct vy_page_info *page;
+		page = vy_run_page_info(run, part->first_page_no + i);
+		ssize_t written;
+		if (vy_page_info_encode(page, &xrow) != 0 ||
+		    (written = xlog_write_row(xlog, &xrow)) < 0)
+			goto fail;
+		part->unpacked_size += written;
+		part->count.rows += page->row_count;
+		part->count.bytes += page->unpacked_size;
+		part->count.bytes_compressed += page->size;
+	}
+	if (bloom != NULL) {
+		ssize_t written;
+		if (vy_page_index_bloom_encode(bloom, &xrow) != 0 ||
+		    (written = xlog_write_row(xlog, &xrow)) < 0)
+			goto fail;
+		part->unpacked_size += written;
+	}
+	ssize_t written = xlog_tx_commit(xlog);
+	if (written == 0)
+		written = xlog_flush(xlog);
+	if (written < 0)
+		return -1;
+	part->size = written;
+	part->min_key = vy_key_dup(vy_run_page_info(run,
+					part->first_page_no)->min_key);
+	if (part->min_key == NULL)
+		return -1;
+	return 0;
+fail:
+	xlog_tx_rollback(xlog);
+	return -1;
+}
+
+/**
+ * Split the page index of a big run in partitions, write them
+ * along with their bloom filters to the end of the run data
+ * file and replace the page index of the run with the partition
+ * directory, see struct vy_page_index_part.
+ * @param writer Run writer.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_write_page_index(struct vy_run_writer *writer)
+{
+	struct vy_run *run = writer->run;
+	uint32_t page_count = run->info.page_count;
+	uint32_t part_count = DIV_ROUND_UP(page_count,
+					   VY_PAGE_INDEX_PART_SIZE);
+	assert(part_count > 1);
+	if (writer->bloom != NULL &&
+	    vy_run_writer_end_part_bloom(writer) != 0)
+		return -1;
+	assert(writer->part_bloom_count == 0 ||
+	       writer->part_bloom_count == part_count);
+
+	struct vy_page_index_part *parts = calloc(part_count, sizeof(*parts));
+	if (parts == NULL) {
+		diag_set(OutOfMemory, part_count * sizeof(*parts),
+			 "calloc", "struct vy_page_index_part");
+		return -1;
+	}
+	uint32_t part_no;
+	for (part_no = 0; part_no < part_count; part_no++) {
+		struct vy_page_index_part *part = &parts[part_no];
+		rlist_create(&part->in_lru);
+		part->first_page_no = part_no * VY_PAGE_INDEX_PART_SIZE;
+		part->count.pages = MIN(page_count - part->first_page_no,
+					(uint32_t)VY_PAGE_INDEX_PART_SIZE);
+		const struct tuple_bloom *bloom = NULL;
+		if (writer->part_bloom_count > 0)
+			bloom = writer->part_blooms[part_no];
+		if (vy_run_writer_write_part(writer, part, bloom) != 0)
+			goto fail;
+	}
+
+	/* Replace the page index with the partition directory. */
+	vy_page_info_array_delete(run->page_info, page_count);
+	run->page_info = NULL;
+	writer->page_info_capacity = 0;
+	run->info.parts = parts;
+	run->info.part_count = part_count;
+	run->page_index_size = 0;
+	struct vy_disk_stmt_counter count = run->count;
+	memset(&run->count, 0, sizeof(run->count));
+	if (vy_run_acct_parts(run) != 0)
+		unreachable();
+	assert(run->count.rows == count.rows);
+	assert(run->count.pages == count.pages);
+	(void)count;
+	return 0;
+fail:
+	for (uint32_t i = 0; i <= part_no; i++)
+		free(parts[i].min_key);
+	free(parts);
+	return -1;
+}
+
 int
 vy_run_writer_commit(struct vy_run_writer *writer)
 {
@@ -2316,6 +4191,10 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 	if (run->info.max_key == NULL)
 		goto out;
 
+	if (run->info.page_count > VY_PAGE_INDEX_PART_SIZE &&
+	    vy_run_writer_write_page_index(writer) != 0)
+		goto out;
+
 	ERROR_INJECT(ERRINJ_VY_RUN_FILE_RENAME, {
 		diag_set(ClientError, ER_INJECTION, "vinyl run file rename");
 		goto out;
@@ -2326,7 +4205,16 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 	    xlog_rename(&writer->data_xlog) < 0)
 		goto out;
 
-	if (writer->bloom != NULL) {
+	/*
+	 * The blob file must be persistent before the index
+	 * file, which makes the run visible on recovery, is.
+	 */
+	if (writer->blob_fd >= 0 && fsync(writer->blob_fd) < 0) {
+		diag_set(SystemError, "failed to sync blob file");
+		goto out;
+	}
+
+	if (writer->bloom != NULL && run->info.parts == NULL) {
 		run->info.bloom = tuple_bloom_new(writer->bloom,
 						  writer->bloom_fpr);
 		if (run->info.bloom == NULL)
@@ -2377,6 +4265,7 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	int64_t max_lsn = 0;
 	int64_t min_lsn = INT64_MAX;
 	struct tuple *prev_tuple = NULL;
+	bool is_primary = (iid == 0 || opts->is_covering);
 
 	struct tuple_bloom_builder *bloom_builder = NULL;
 	if (opts->bloom_fpr < 1) {
@@ -2385,8 +4274,15 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 			goto close_err;
 	}
 
+	/*
+	 * Page index partitions of a big run are stored after
+	 * the data pages, see vy_run_writer_write_page_index().
+	 * They are ignored: the rebuilt index is not partitioned.
+	 */
+	bool is_page_index = false;
 	off_t page_offset, next_page_offset = xlog_cursor_pos(&cursor);
-	while ((rc = xlog_cursor_next_tx(&cursor)) == 0) {
+	while (!is_page_index &&
+	       (rc = xlog_cursor_next_tx(&cursor)) == 0) {
 		region_truncate(region, mem_used);
 		page_offset = next_page_offset;
 		next_page_offset = xlog_cursor_pos(&cursor);
@@ -2401,6 +4297,11 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 
 		struct xrow_header xrow;
 		while ((rc = xlog_cursor_next_row(&cursor, &xrow)) == 0) {
+			if (xrow.type == VY_INDEX_PAGE_INFO ||
+			    xrow.type == VY_RUN_BLOOM) {
+				is_page_index = true;
+				break;
+			}
 			if (xrow.type == VY_RUN_ROW_INDEX) {
 				page_row_index_offset = row_offset;
 				row_offset = xlog_cursor_tx_pos(&cursor);
@@ -2408,7 +4309,7 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 			}
 			++page_row_count;
 			struct tuple *tuple = vy_stmt_decode(&xrow, cmp_def,
-							     format, iid == 0);
+							     format, is_primary);
 			if (tuple == NULL)
 				goto close_err;
 			if (bloom_builder != NULL) {
@@ -2424,6 +4325,9 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 			prev_tuple = tuple;
 			if (key == NULL)
 				goto close_err;
+			if (vy_stmt_is_blob_ref(tuple) &&
+			    vy_run_acct_blob_ref(run, tuple) != 0)
+				goto close_err;
 			if (run->info.min_key == NULL) {
 				run->info.min_key = vy_key_dup(key);
 				if (run->info.min_key == NULL)
@@ -2437,6 +4341,8 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 				min_lsn = xrow.lsn;
 			row_offset = xlog_cursor_tx_pos(&cursor);
 		}
+		if (is_page_index)
+			break;
 		struct vy_page_info *info;
 		info = run->page_info + run->info.page_count;
 		if (vy_page_info_create(info, page_offset, page_min_key) != 0)
@@ -2466,6 +4372,9 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	run->fd = cursor.fd;
 	xlog_cursor_close(&cursor, true);
 
+	if (vy_run_open_blobs(run, dir, space_id, iid) != 0)
+		goto close_err;
+
 	if (bloom_builder != NULL) {
 		run->info.bloom = tuple_bloom_new(bloom_builder,
 						  opts->bloom_fpr);
@@ -2498,9 +4407,90 @@ close_err:
 	return -1;
 }
 
+/**
+ * Invoke @cb for each blob file linked by a run with the given
+ * id, found by scanning the index directory. Iteration stops if
+ * the callback returns a non-zero value, which is then returned
+ * to the caller. Returns -1 and sets diag if the directory
+ * couldn't be read.
+ */
+static int
+vy_run_foreach_blob_file(const char *dir, uint32_t space_id,
+			 uint32_t iid, int64_t run_id,
+			 int (*cb)(const char *path, void *arg), void *arg)
+{
+	char path[PATH_MAX];
+	vy_lsm_snprint_path(path, sizeof(path), dir, space_id, iid);
+	DIR *dh = opendir(path);
+	if (dh == NULL) {
+		if (errno == ENOENT)
+			return 0;
+		diag_set(SystemError, "failed to open directory '%s'", path);
+		return -1;
+	}
+	char prefix[32];
+	int prefix_len = snprintf(prefix, sizeof(prefix), "%020lld.",
+				  (long long)run_id);
+	int rc = 0;
+	struct dirent *de;
+	while ((de = readdir(dh)) != NULL) {
+		if (strncmp(de->d_name, prefix, prefix_len) != 0)
+			continue;
+		const char *suffix = strrchr(de->d_name, '.');
+		if (suffix == NULL || strcmp(suffix + 1, vy_blob_suffix) != 0)
+			continue;
+		char file_path[PATH_MAX];
+		snprintf(file_path, sizeof(file_path), "%s/%s",
+			 path, de->d_name);
+		rc = cb(file_path, arg);
+		if (rc != 0)
+			break;
+	}
+	closedir(dh);
+	return rc;
+}
+
+/** Remove a run file, ignoring ENOENT. */
+static int
+vy_run_remove_file(const char *path)
+{
+	if (coio_unlink(path) < 0) {
+		if (errno != ENOENT) {
+			say_syserror("error while removing %s", path);
+			return -1;
+		}
+	} else
+		say_info("removed %s", path);
+	return 0;
+}
+
+/** Callback passed to vy_run_foreach_blob_file() to remove files. */
+static int
+vy_run_remove_blob_file_cb(const char *path, void *arg)
+{
+	int *ret = arg;
+	if (vy_run_remove_file(path) != 0)
+		*ret = -1;
+	return 0;
+}
+
+int
+vy_run_remove_unlogged_blob_files(const char *dir, uint32_t space_id,
+				  uint32_t iid, int64_t run_id)
+{
+	int ret = 0;
+	if (vy_run_foreach_blob_file(dir, space_id, iid, run_id,
+				     vy_run_remove_blob_file_cb, &ret) != 0) {
+		diag_log();
+		ret = -1;
+	}
+	return ret;
+}
+
 int
 vy_run_remove_files(const char *dir, uint32_t space_id,
-		    uint32_t iid, int64_t run_id)
+		    uint32_t iid, int64_t run_id,
+		    const int64_t *blob_ids, uint32_t blob_count)
 {
 	ERROR_INJECT(ERRINJ_VY_GC,
 		     {say_error("error injection: vinyl run %lld not deleted",
@@ -2510,17 +4500,59 @@ vy_run_remove_files(const char *dir, uint32_t space_id,
 	for (int type = 0; type < vy_file_MAX; type++) {
 		vy_run_snprint_path(path, sizeof(path), dir,
 				    space_id, iid, run_id, type);
-		if (coio_unlink(path) < 0) {
-			if (errno != ENOENT) {
-				say_syserror("error while removing %s", path);
-				ret = -1;
-			}
-		} else
-			say_info("removed %s", path);
+		if (vy_run_remove_file(path) != 0)
+			ret = -1;
+	}
+	for (uint32_t i = 0; i < blob_count; i++) {
+		vy_blob_snprint_path(path, sizeof(path), dir, space_id, iid,
+				     run_id, blob_ids[i]);
+		if (vy_run_remove_file(path) != 0)
+			ret = -1;
 	}
 	return ret;
 }
 
+/**
+ * Get the page info of the page with stream->page_no. Slice
+ * streams are used by worker threads, which must not touch the
+ * metadata cache, so page index partitions of a big run are read
+ * privately and the last one is kept in the stream.
+ * @param stream - the stream.
+ * @param zdctx - decompression context.
+ * @param[out] page_info - the page info.
+ * @return 0 on success, -1 of memory or read error (diag is set).
+ */
+static NODISCARD int
+vy_slice_stream_get_page_info(struct vy_slice_stream *stream,
+			      ZSTD_DStream *zdctx,
+			      struct vy_page_info **page_info)
+{
+	struct vy_run *run = stream->slice->run;
+	if (run->info.parts == NULL) {
+		*page_info = vy_run_page_info(run, stream->page_no);
+		return 0;
+	}
+	uint32_t part_no = vy_run_find_part(run, stream->page_no);
+	struct vy_page_index_part *part = &run->info.parts[part_no];
+	if (stream->part_page_info == NULL || stream->part_no != part_no) {
+		struct vy_page_info *part_page_info;
+		if (vy_page_index_part_read(run, part, zdctx,
+					    &part_page_info, NULL) != 0)
+			return -1;
+		if (stream->part_page_info != NULL) {
+			struct vy_page_index_part *prev;
+			prev = &run->info.parts[stream->part_no];
+			vy_page_info_array_delete(stream->part_page_info,
+						  prev->count.pages);
+		}
+		stream->part_page_info = part_page_info;
+		stream->part_no = part_no;
+	}
+	*page_info = &stream->part_page_info[stream->page_no -
+					     part->first_page_no];
+	return 0;
+}
+
 /**
  * Read a page with stream->page_no from the run and save it in stream->page.
  * Support function of slice stream.
@@ -2537,7 +4569,9 @@ vy_slice_stream_read_page(struct vy_slice_stream *stream)
 	if (zdctx == NULL)
 		return -1;
 
-	struct vy_page_info *page_info = vy_run_page_info(run, stream->page_no);
+	struct vy_page_info *page_info;
+	if (vy_slice_stream_get_page_info(stream, zdctx, &page_info) != 0)
+		return -1;
 	stream->page = vy_page_new(page_info);
 	if (stream->page == NULL)
 		return -1;
@@ -2569,6 +4603,32 @@ vy_slice_stream_search(struct vy_stmt_stream *virt_stream)
 		return 0;
 	}
 
+	struct vy_run *run = stream->slice->run;
+	if (run->info.parts != NULL) {
+		/*
+		 * The first page of the slice may be the first
+		 * page of the partition storing the slice begin,
+		 * so look up the page in the partition.
+		 */
+		ZSTD_DStream *zdctx = vy_env_get_zdctx(run->env);
+		if (zdctx == NULL)
+			return -1;
+		struct vy_page_info *unused;
+		if (vy_slice_stream_get_page_info(stream, zdctx, &unused) != 0)
+			return -1;
+		struct vy_page_index_part *part;
+		part = &run->info.parts[stream->part_no];
+		uint32_t bound = vy_page_info_bound(stream->part_page_info,
+						    part->count.pages,
+						    stream->slice->begin,
+						    stream->cmp_def, true);
+		if (bound > 0)
+			stream->page_no = MAX(stream->page_no,
+					      part->first_page_no + bound - 1);
+		if (stream->page_no > stream->slice->last_page_no)
+			return 0;
+	}
+
 	if (vy_slice_stream_read_page(stream) != 0)
 		return -1;
 
@@ -2581,8 +4641,8 @@ vy_slice_stream_search(struct vy_stmt_stream *virt_stream)
 	while (beg != end) {
 		uint32_t mid = beg + (end - beg) / 2;
 		struct tuple *fnd_key = vy_page_stmt(stream->page, mid,
-					stream->cmp_def, stream->format,
-					stream->is_primary);
+					stream->slice->run, stream->cmp_def,
+					stream->format, stream->is_primary);
 		if (fnd_key == NULL)
 			return -1;
 		int cmp = vy_tuple_compare_with_key(fnd_key,
@@ -2629,14 +4689,14 @@ vy_slice_stream_next(struct vy_stmt_stream *virt_stream, struct tuple **ret)
 
 	/* Read current tuple from the page */
 	struct tuple *tuple = vy_page_stmt(stream->page, stream->pos_in_page,
-					   stream->cmp_def, stream->format,
-					   stream->is_primary);
+					   stream->slice->run, stream->cmp_def,
+					   stream->format, stream->is_primary);
 	if (tuple == NULL) /* Read or memory error */
 		return -1;
 
 	/* Check that the tuple is not out of slice bounds = */
 	if (stream->slice->end != NULL &&
-	    stream->page_no >= stream->slice->last_page_no &&
+	    stream->page_no >= stream->end_page_no &&
 	    vy_tuple_compare_with_key(tuple, stream->slice->end,
 				      stream->cmp_def) >= 0) {
 		tuple_unref(tuple);
@@ -2653,9 +4713,7 @@ vy_slice_stream_next(struct vy_stmt_stream *virt_stream, struct tuple **ret)
 	stream->pos_in_page++;
 
 	/* Check whether the position is out of page */
-	struct vy_page_info *page_info = vy_run_page_info(stream->slice->run,
-							  stream->page_no);
-	if (stream->pos_in_page >= page_info->row_count) {
+	if (stream->pos_in_page >= stream->page->row_count) {
 		/**
 		 * Out of page. Free page, move the position to the next page
 		 * and * nullify page pointer to read it on the next iteration.
@@ -2685,6 +4743,12 @@ vy_slice_stream_close(struct vy_stmt_stream *virt_stream)
 		tuple_unref(stream->tuple);
 		stream->tuple = NULL;
 	}
+	if (stream->part_page_info != NULL) {
+		struct vy_run *run = stream->slice->run;
+		vy_page_info_array_delete(stream->part_page_info,
+				run->info.parts[stream->part_no].count.pages);
+		stream->part_page_info = NULL;
+	}
 }
 
 static const struct vy_stmt_stream_iface vy_slice_stream_iface = {
@@ -2705,6 +4769,14 @@ vy_slice_stream_open(struct vy_slice_stream *stream, struct vy_slice *slice,
 	stream->pos_in_page = 0; /* We'll find it later */
 	stream->page = NULL;
 	stream->tuple = NULL;
+	stream->part_page_info = NULL;
+	stream->part_no = 0;
+	stream->end_page_no = slice->last_page_no;
+	if (slice->end != NULL && slice->run->info.parts != NULL) {
+		struct vy_run *run = slice->run;
+		uint32_t part_no = vy_run_find_part(run, slice->last_page_no);
+		stream->end_page_no = run->info.parts[part_no].first_page_no;
+	}
 
 	stream->slice = slice;
 	stream->cmp_def = cmp_def;
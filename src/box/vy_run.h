@@ -51,6 +51,21 @@ extern "C" {
 
 struct vy_history;
 struct vy_run_reader;
+struct mh_i64ptr_t;
+
+/**
+ * Cache of run page index partitions read from disk,
+ * see struct vy_page_index_part. Accessed only from
+ * the tx thread.
+ */
+struct vy_meta_cache {
+	/** Loaded partitions, least recently used first. */
+	struct rlist lru;
+	/** Memory used by loaded partitions. */
+	size_t mem_used;
+	/** Max memory loaded partitions may use. */
+	size_t mem_quota;
+};
 
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
@@ -58,6 +73,8 @@ struct vy_run_env {
 	uint64_t snap_io_rate_limit;
 	/** Mempool for struct vy_page_read_task */
 	struct mempool read_task_pool;
+	/** Mempool for struct vy_page_readahead */
+	struct mempool readahead_pool;
 	/** Key for thread-local ZSTD context */
 	pthread_key_t zdctx_key;
 	/** Pool of threads used for reading run files. */
@@ -69,6 +86,93 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/** Cache of page index partitions. */
+	struct vy_meta_cache meta_cache;
+	/**
+	 * Open blob files: blob id -> struct vy_blob_file.
+	 * A blob file may be linked by many runs, but it is
+	 * opened only once. Accessed only from the tx thread.
+	 */
+	struct mh_i64ptr_t *blob_files;
+};
+
+/**
+ * Open blob file shared by all runs that link it.
+ * @sa vy_run_env::blob_files.
+ */
+struct vy_blob_file {
+	/** ID of the blob file. */
+	int64_t id;
+	/** File descriptor. */
+	int fd;
+	/** Size of the file. */
+	uint64_t size;
+	/** Number of runs linking the file. */
+	int refs;
+};
+
+/**
+ * Blob file referenced by a run.
+ * @sa struct vy_blob_ref.
+ */
+struct vy_run_blob {
+	/** ID of the blob file. */
+	int64_t id;
+	/** Size of the blob file. */
+	uint64_t size;
+	/** Number of bytes of the blob file used by the run. */
+	uint64_t bytes;
+	/**
+	 * Blob file descriptor or -1 if not open. Borrowed from
+	 * @file unless the run has just been written and hasn't
+	 * been committed yet, in which case it is the descriptor
+	 * of the blob file created by the run writer.
+	 */
+	int fd;
+	/** Shared open blob file or NULL, see vy_run_open_blobs(). */
+	struct vy_blob_file *file;
+};
+
+/**
+ * Number of pages in a page index partition. The page index
+ * of a run that has more pages is partitioned.
+ */
+enum { VY_PAGE_INDEX_PART_SIZE = 64 };
+
+/**
+ * Page index partition.
+ *
+ * A big run doesn't keep its page index and bloom filter in
+ * memory. Instead, the page index is split in partitions of
+ * VY_PAGE_INDEX_PART_SIZE pages, each of which has a bloom
+ * filter of its own. Partitions are written to the run data
+ * file after the last page while the index file stores only
+ * the partition directory, i.e. an array of this struct, which
+ * is loaded on recovery. A partition is read from disk when
+ * a page it describes is accessed and kept in the metadata
+ * cache until evicted, see struct vy_meta_cache.
+ */
+struct vy_page_index_part {
+	/** Offset of the partition in the run data file. */
+	uint64_t offset;
+	/** Size of the partition in the run data file. */
+	uint32_t size;
+	/** Size of the partition in memory, i.e. unpacked. */
+	uint32_t unpacked_size;
+	/** Number of the first page of the partition. */
+	uint32_t first_page_no;
+	/** Statistics of the pages of the partition. */
+	struct vy_disk_stmt_counter count;
+	/** Min key of the first page of the partition. */
+	char *min_key;
+	/** Page infos of the partition or NULL if not loaded. */
+	struct vy_page_info *page_info;
+	/** Bloom filter of the partition or NULL. */
+	struct tuple_bloom *bloom;
+	/** Memory used by the loaded page infos and bloom filter. */
+	size_t mem_used;
+	/** Link in vy_meta_cache::lru. */
+	struct rlist in_lru;
 };
 
 /**
@@ -89,6 +193,29 @@ struct vy_run_info {
 	struct tuple_bloom *bloom;
 	/** Statement statistics. */
 	struct vy_stmt_stat stmt_stat;
+	/** Blob files referenced by the run. */
+	struct vy_run_blob *blobs;
+	/**
+	 * IDs of the blob files, in the same order as in the
+	 * blobs array. Kept separately so that they can be
+	 * written to the metadata log as is.
+	 */
+	int64_t *blob_ids;
+	/** Number of entries in the blobs and blob_ids arrays. */
+	uint32_t blob_count;
+	/**
+	 * Wall clock time, in seconds, of the newest dump whose
+	 * data was merged into the run, 0 if unknown. Used by
+	 * the time window compaction strategy.
+	 */
+	uint64_t dump_time;
+	/**
+	 * Page index partition directory or NULL if the page
+	 * index of the run isn't partitioned.
+	 */
+	struct vy_page_index_part *parts;
+	/** Number of entries in the parts array. */
+	uint32_t part_count;
 };
 
 /**
@@ -117,7 +244,11 @@ struct vy_run {
 	struct vy_run_env *env;
 	/** Info about the run stored in the index file. */
 	struct vy_run_info info;
-	/** Info about the run pages stored in the index file. */
+	/**
+	 * Info about the run pages stored in the index file.
+	 * NULL if the page index is partitioned, in which case
+	 * page infos are loaded on demand, see vy_page_index_part.
+	 */
 	struct vy_page_info *page_info;
 	/** Run data file. */
 	int fd;
@@ -125,7 +256,11 @@ struct vy_run {
 	int64_t id;
 	/** Number of statements in this run. */
 	struct vy_disk_stmt_counter count;
-	/** Size of memory used for storing page index. */
+	/**
+	 * Size of memory used for storing page index. For a run
+	 * with a partitioned page index, this is the size of the
+	 * partition directory.
+	 */
 	size_t page_index_size;
 	/** Max LSN stored on disk. */
 	int64_t dump_lsn;
@@ -209,7 +344,9 @@ struct vy_slice {
 	};
 	/**
 	 * Indexes of the first and the last page in the run
-	 * that belong to this slice.
+	 * that belong to this slice. If the page index of the
+	 * run is partitioned, they may be rounded to partition
+	 * boundaries, see vy_slice_find_page().
 	 */
 	uint32_t first_page_no;
 	uint32_t last_page_no;
@@ -248,7 +385,10 @@ struct vy_run_iterator {
 	 * pages.
 	 */
 	struct tuple_format *format;
-	/** Set if this iterator is for a primary index. */
+	/**
+	 * Set if the run stores full tuples, i.e. it belongs
+	 * to a primary or a covering index.
+	 */
 	bool is_primary;
 	/** The run slice to iterate. */
 	struct vy_slice *slice;
@@ -279,6 +419,23 @@ struct vy_run_iterator {
 	 */
 	struct vy_page *curr_page;
 	struct vy_page *prev_page;
+	/**
+	 * Pages being read ahead, in the iteration order.
+	 * Linked by vy_page_readahead::in_itr.
+	 */
+	struct rlist readahead;
+	/** Number of pages in the readahead list. */
+	uint32_t readahead_count;
+	/**
+	 * Max number of pages to read ahead. Grows when the
+	 * iterator has to wait for a page read ahead, shrinks
+	 * when pages read ahead are wasted.
+	 */
+	uint32_t readahead_window;
+	/** Number of the last page loaded or UINT32_MAX. */
+	uint32_t last_page_no;
+	/** Number of pages loaded sequentially in a row. */
+	uint32_t seq_page_count;
 	/** Is false until first .._get or .._next_.. method is called */
 	bool search_started;
 	/** Search is finished, you will not get more values from iterator */
@@ -332,6 +489,13 @@ vy_run_env_destroy(struct vy_run_env *env);
 void
 vy_run_env_enable_coio(struct vy_run_env *env);
 
+/**
+ * Set the max amount of memory that may be used by page index
+ * partitions loaded from disk, evicting partitions if needed.
+ */
+void
+vy_run_env_set_meta_cache_quota(struct vy_run_env *env, size_t quota);
+
 /**
  * Return the size of a run bloom filter.
  */
@@ -341,10 +505,23 @@ vy_run_bloom_size(struct vy_run *run);
 static inline struct vy_page_info *
 vy_run_page_info(struct vy_run *run, uint32_t pos)
 {
+	assert(run->info.parts == NULL);
 	assert(pos < run->info.page_count);
 	return &run->page_info[pos];
 }
 
+/**
+ * Return the min key of a run page. If the page index of the
+ * run is partitioned and the partition the page belongs to
+ * isn't cached, the min key of the partition is returned
+ * instead, which is fine since the function is only used for
+ * choosing split keys in the tx thread, which must not read
+ * the page index from disk. The key stays valid until another
+ * partition is loaded or the fiber yields.
+ */
+const char *
+vy_run_page_min_key(struct vy_run *run, uint32_t page_no);
+
 static inline bool
 vy_run_is_empty(struct vy_run *run)
 {
@@ -413,6 +590,9 @@ enum vy_file_type {
 
 extern const char *vy_file_suffix[];
 
+/** Suffix of blob files, see struct vy_blob_ref. */
+extern const char *vy_blob_suffix;
+
 static inline int
 vy_lsm_snprint_path(char *buf, int size, const char *dir,
 		    uint32_t space_id, uint32_t iid)
@@ -443,13 +623,67 @@ vy_run_snprint_path(char *buf, int size, const char *dir,
 }
 
 /**
- * Remove all files (data, index) corresponding to a run
- * with the given id. Return 0 on success, -1 if unlink()
- * failed.
+ * Blob files are named <run_id>.<blob_id>.blob, where run_id
+ * is the ID of the run that links the blob file and blob_id is
+ * the ID of the run that created it.
+ */
+static inline int
+vy_blob_snprint_path(char *buf, int size, const char *dir,
+		     uint32_t space_id, uint32_t iid,
+		     int64_t run_id, int64_t blob_id)
+{
+	int total = 0;
+	SNPRINT(total, vy_lsm_snprint_path, buf, size,
+		dir, (unsigned)space_id, (unsigned)iid);
+	SNPRINT(total, snprintf, buf, size, "/%020lld.%020lld.%s",
+		(long long)run_id, (long long)blob_id, vy_blob_suffix);
+	return total;
+}
+
+/**
+ * Load the tuple a statement flagged with VY_STMT_BLOB_REF
+ * refers to and return a new REPLACE or INSERT statement with
+ * the same LSN and flags. If @use_coio is set, the blob file
+ * is read in a coio thread, otherwise the read blocks the
+ * calling thread.
+ *
+ * @retval not NULL Full statement.
+ * @retval     NULL Memory or IO error.
+ */
+struct tuple *
+vy_stmt_load_blob(const struct tuple *stmt, bool use_coio);
+
+/**
+ * Make a run share descriptors of the blob files it links with
+ * other runs, opening the files that aren't open yet. Called
+ * when a run is recovered or committed. Must be called from the
+ * tx thread. Returns 0 on success, -1 on error.
+ */
+int
+vy_run_open_blobs(struct vy_run *run, const char *dir,
+		  uint32_t space_id, uint32_t iid);
+
+/**
+ * Remove all files (data, index, blob links) corresponding to
+ * a run with the given id. @blob_ids lists the blob files the
+ * run links, as stored in the metadata log. Return 0 on success,
+ * -1 if unlink() failed.
  */
 int
 vy_run_remove_files(const char *dir, uint32_t space_id,
-		    uint32_t iid, int64_t run_id);
+		    uint32_t iid, int64_t run_id,
+		    const int64_t *blob_ids, uint32_t blob_count);
+
+/**
+ * Remove blob file links of a run that was left incomplete by
+ * a crash and so doesn't have its blob files logged. Unlike
+ * vy_run_remove_files(), this scans the index directory and
+ * is supposed to be used only on recovery. Return 0 on success,
+ * -1 on error.
+ */
+int
+vy_run_remove_unlogged_blob_files(const char *dir, uint32_t space_id,
+				  uint32_t iid, int64_t run_id);
 
 /**
  * Allocate a new run slice.
@@ -564,6 +798,21 @@ struct vy_slice_stream {
 	struct vy_page *page;
 	/** The last tuple returned to user */
 	struct tuple *tuple;
+	/**
+	 * Page infos of the page index partition that describes
+	 * the current page if the page index of the run is
+	 * partitioned, NULL otherwise. The stream is used by
+	 * worker threads so it reads partitions on its own
+	 * rather than looking them up in the metadata cache.
+	 */
+	struct vy_page_info *part_page_info;
+	/** Index of the partition stored in part_page_info. */
+	uint32_t part_no;
+	/**
+	 * Statements are compared with the slice end starting
+	 * from this page, see vy_slice_find_page().
+	 */
+	uint32_t end_page_no;
 
 	/** Members needed for memory allocation and disk access */
 	/** Slice to stream */
@@ -575,7 +824,10 @@ struct vy_slice_stream {
 	struct key_def *cmp_def;
 	/** Format for allocating REPLACE and DELETE tuples read from pages. */
 	struct tuple_format *format;
-	/** Set if this iterator is for a primary index. */
+	/**
+	 * Set if the run stores full tuples, i.e. it belongs
+	 * to a primary or a covering index.
+	 */
 	bool is_primary;
 };
 
@@ -608,6 +860,21 @@ struct vy_run_writer {
 	struct key_def *cmp_def;
 	/** Key definition to calculate bloom. */
 	struct key_def *key_def;
+	/**
+	 * Set if full statements are written to the run, i.e.
+	 * it belongs to a primary or a covering index.
+	 */
+	bool is_primary;
+	/**
+	 * Tuples of this size or larger are written to a blob
+	 * file rather than to the run file. 0 if disabled.
+	 * @sa index_opts::blob_threshold.
+	 */
+	int64_t blob_threshold;
+	/** Blob file created by this writer or -1. */
+	int blob_fd;
+	/** Size of the data written to the blob file. */
+	uint64_t blob_offset;
 	/**
 	 * Minimal page size. When a page becames bigger, it is
 	 * dumped.
@@ -621,8 +888,17 @@ struct vy_run_writer {
 	struct xlog data_xlog;
 	/** Bloom filter false positive rate. */
 	double bloom_fpr;
-	/** Bloom filter. */
+	/** Bloom filter of the current page index partition. */
 	struct tuple_bloom_builder *bloom;
+	/**
+	 * Bloom filters of the page index partitions written so
+	 * far. Used only if the run turns out big enough for its
+	 * page index to be partitioned, otherwise the bloom filter
+	 * of the only partition becomes the run bloom filter.
+	 */
+	struct tuple_bloom **part_blooms;
+	/** Number of entries in the part_blooms array. */
+	uint32_t part_bloom_count;
 	/** Buffer of a current page row offsets. */
 	struct ibuf row_index_buf;
 	/**
@@ -637,7 +913,8 @@ int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr);
+		     bool is_primary, uint64_t page_size, double bloom_fpr,
+		     int64_t blob_threshold);
 
 /**
  * Write a specified statement into a run.
@@ -103,6 +103,9 @@ struct vy_worker {
 /** Max number of statements in a batch of deferred DELETEs. */
 enum { VY_DEFERRED_DELETE_BATCH_MAX = 100 };
 
+/** Max number of parts a range compaction or a dump can be split in. */
+enum { VY_COMPACTION_PARTS_MAX = 8 };
+
 /** Deferred DELETE statement. */
 struct vy_deferred_delete_stmt {
 	/** Overwritten tuple. */
@@ -204,6 +207,7 @@ struct vy_task {
 	 */
 	double bloom_fpr;
 	int64_t page_size;
+	int64_t blob_threshold;
 	/**
 	 * Deferred DELETE handler passed to the write iterator.
 	 * It sends deferred DELETE statements generated during
@@ -217,6 +221,36 @@ struct vy_task {
 	 * and not yet processed.
 	 */
 	int deferred_delete_in_progress;
+	/**
+	 * Compaction of a big range may be split by key in parts
+	 * merged in parallel by different worker threads. Each
+	 * part is a task of its own that writes a run of its own.
+	 * The first part is merged by the task scheduled for the
+	 * range while the rest are merged by the subtasks stored
+	 * in this array. On completion the range is split at
+	 * part boundaries, see vy_task_compaction_complete_parts().
+	 */
+	struct vy_task *subtasks[VY_COMPACTION_PARTS_MAX - 1];
+	/** Number of elements stored in @subtasks array. */
+	int subtask_count;
+	/** Task this task is a part of or NULL. */
+	struct vy_task *parent;
+	/**
+	 * Number of parts of this task that haven't been
+	 * processed by worker threads yet. The task may be
+	 * completed only after it drops to 0.
+	 */
+	int parts_in_progress;
+	/**
+	 * Boundaries of the key range merged by a part of
+	 * a compaction task. NULL if the task isn't split.
+	 */
+	struct tuple *begin, *end;
+	/**
+	 * Slices of the compacted runs cut to the part
+	 * boundaries. Linked by vy_slice::in_range.
+	 */
+	struct rlist cut_slices;
 	/** Link in vy_scheduler::processed_tasks. */
 	struct stailq_entry in_processed;
 };
@@ -261,6 +295,8 @@ vy_task_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	vy_lsm_ref(lsm);
 	diag_create(&task->diag);
 	task->deferred_delete_handler.iface = &vy_task_deferred_delete_iface;
+	task->parts_in_progress = 1;
+	rlist_create(&task->cut_slices);
 	return task;
 }
 
@@ -270,6 +306,13 @@ vy_task_delete(struct vy_task *task)
 {
 	assert(task->deferred_delete_batch == NULL);
 	assert(task->deferred_delete_in_progress == 0);
+	assert(rlist_empty(&task->cut_slices));
+	for (int i = 0; i < task->subtask_count; i++)
+		vy_task_delete(task->subtasks[i]);
+	if (task->begin != NULL)
+		tuple_unref(task->begin);
+	if (task->end != NULL)
+		tuple_unref(task->end);
 	key_def_delete(task->cmp_def);
 	key_def_delete(task->key_def);
 	vy_lsm_unref(task->lsm);
@@ -459,6 +502,8 @@ vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 			      "dump", dump_threads);
 	vy_worker_pool_create(&scheduler->compaction_pool,
 			      "compaction", compaction_threads);
+	scheduler->max_subcompactions = 1;
+	scheduler->max_subdumps = 1;
 
 	stailq_create(&scheduler->processed_tasks);
 
@@ -774,24 +819,28 @@ vy_run_discard(struct vy_run *run)
 {
 	int64_t run_id = run->id;
 
-	vy_run_unref(run);
-
-	ERROR_INJECT(ERRINJ_VY_RUN_DISCARD,
-		     {say_error("error injection: run %lld not discarded",
-				(long long)run_id); return;});
+	ERROR_INJECT(ERRINJ_VY_RUN_DISCARD, {
+		say_error("error injection: run %lld not discarded",
+			  (long long)run_id);
+		vy_run_unref(run);
+		return;
+	});
 
 	vy_log_tx_begin();
 	/*
 	 * The run hasn't been used and can be deleted right away
-	 * so set gc_lsn to minimal possible (0).
+	 * so set gc_lsn to minimal possible (0). The blob files
+	 * the run links are logged so that garbage collection
+	 * can remove the links without scanning the directory.
 	 */
-	vy_log_drop_run(run_id, 0);
+	vy_log_discard_run(run_id, run->info.blob_ids, run->info.blob_count);
 	/*
 	 * Leave the record in the vylog buffer on disk error.
 	 * If we fail to flush it before restart, we will delete
 	 * the run file upon recovery completion.
 	 */
 	vy_log_tx_try_commit();
+	vy_run_unref(run);
 }
 
 /**
@@ -1047,7 +1096,9 @@ vy_task_write_run(struct vy_task *task)
 	if (vy_run_writer_create(&writer, task->new_run, lsm->env->path,
 				 lsm->space_id, lsm->index_id,
 				 task->cmp_def, task->key_def,
-				 task->page_size, task->bloom_fpr) != 0)
+				 vy_lsm_is_covering(lsm),
+				 task->page_size, task->bloom_fpr,
+				 task->blob_threshold) != 0)
 		goto fail;
 
 	if (wi->iface->start(wi) != 0)
@@ -1098,103 +1149,156 @@ vy_task_dump_complete(struct vy_task *task)
 {
 	struct vy_scheduler *scheduler = task->scheduler;
 	struct vy_lsm *lsm = task->lsm;
-	struct vy_run *new_run = task->new_run;
-	int64_t dump_lsn = new_run->dump_lsn;
+	int64_t dump_lsn = task->new_run->dump_lsn;
 	double dump_time = ev_monotonic_now(loop()) - task->start_time;
-	struct vy_disk_stmt_counter dump_output = new_run->count;
+	struct vy_disk_stmt_counter dump_output;
 	struct vy_stmt_counter dump_input;
 	struct tuple_format *key_format = lsm->env->key_format;
 	struct vy_mem *mem, *next_mem;
-	struct vy_slice **new_slices, *slice;
-	struct vy_range *range, *begin_range, *end_range;
+	struct vy_slice **new_slices = NULL, *slice;
+	struct vy_range *range;
+	struct vy_run *run;
 	struct tuple *min_key, *max_key;
-	int i;
-
-	assert(lsm->is_dumping);
+	int i, j, slice_count = 0;
 
-	if (vy_run_is_empty(new_run)) {
-		/*
-		 * In case the run is empty, we can discard the run
-		 * and delete dumped in-memory trees right away w/o
-		 * inserting slices into ranges. However, we need
-		 * to log LSM tree dump anyway.
-		 */
-		vy_log_tx_begin();
-		vy_log_dump_lsm(lsm->id, dump_lsn);
-		if (vy_log_tx_commit() < 0)
-			goto fail;
-		vy_run_discard(new_run);
-		goto delete_mems;
-	}
+	/*
+	 * If the dump was split in parts, each part has written
+	 * a run of its own, see vy_task_dump_split().
+	 */
+	int n_parts = task->subtask_count + 1;
+	struct vy_task *parts[VY_COMPACTION_PARTS_MAX];
+	struct vy_range *begin_ranges[VY_COMPACTION_PARTS_MAX];
+	struct vy_range *end_ranges[VY_COMPACTION_PARTS_MAX];
+	parts[0] = task;
+	for (i = 1; i < n_parts; i++)
+		parts[i] = task->subtasks[i - 1];
 
-	assert(new_run->info.max_lsn <= dump_lsn);
+	assert(lsm->is_dumping);
 
 	/*
-	 * Figure out which ranges intersect the new run.
+	 * Figure out which ranges intersect each new run.
 	 * @begin_range is the first range intersecting the run.
 	 * @end_range is the range following the last range
 	 * intersecting the run or NULL if the run itersects all
 	 * ranges.
+	 *
+	 * In case a run is empty, we discard it w/o inserting
+	 * slices into ranges, so it intersects no ranges. However,
+	 * we need to log LSM tree dump anyway.
 	 */
-	min_key = vy_key_from_msgpack(key_format, new_run->info.min_key);
-	if (min_key == NULL)
-		goto fail;
-	max_key = vy_key_from_msgpack(key_format, new_run->info.max_key);
-	if (max_key == NULL) {
+	vy_disk_stmt_counter_reset(&dump_output);
+	for (i = 0; i < n_parts; i++) {
+		run = parts[i]->new_run;
+		vy_disk_stmt_counter_add(&dump_output, &run->count);
+		begin_ranges[i] = end_ranges[i] = NULL;
+		if (vy_run_is_empty(run))
+			continue;
+
+		assert(run->info.max_lsn <= dump_lsn);
+
+		min_key = vy_key_from_msgpack(key_format, run->info.min_key);
+		if (min_key == NULL)
+			goto fail;
+		max_key = vy_key_from_msgpack(key_format, run->info.max_key);
+		if (max_key == NULL) {
+			tuple_unref(min_key);
+			goto fail;
+		}
+		begin_ranges[i] = vy_range_tree_psearch(&lsm->range_tree,
+							min_key);
+		end_ranges[i] = vy_range_tree_psearch(&lsm->range_tree,
+						      max_key);
+		/*
+		 * If min_key == max_key, the slice has to span over
+		 * at least one range.
+		 */
+		end_ranges[i] = vy_range_tree_next(&lsm->range_tree,
+						   end_ranges[i]);
 		tuple_unref(min_key);
-		goto fail;
+		tuple_unref(max_key);
+
+		for (range = begin_ranges[i]; range != end_ranges[i];
+		     range = vy_range_tree_next(&lsm->range_tree, range))
+			slice_count++;
 	}
-	begin_range = vy_range_tree_psearch(&lsm->range_tree, min_key);
-	end_range = vy_range_tree_psearch(&lsm->range_tree, max_key);
-	/*
-	 * If min_key == max_key, the slice has to span over at
-	 * least one range.
-	 */
-	end_range = vy_range_tree_next(&lsm->range_tree, end_range);
-	tuple_unref(min_key);
-	tuple_unref(max_key);
 
 	/*
 	 * For each intersected range allocate a slice of the new run.
+	 * Parts are split at range boundaries, but ranges may have
+	 * been split or coalesced while the dump was in progress so
+	 * a range may get slices of more than one run.
 	 */
-	new_slices = calloc(lsm->range_count, sizeof(*new_slices));
-	if (new_slices == NULL) {
-		diag_set(OutOfMemory, lsm->range_count * sizeof(*new_slices),
-			 "malloc", "struct vy_slice *");
-		goto fail;
+	if (slice_count > 0) {
+		new_slices = calloc(slice_count, sizeof(*new_slices));
+		if (new_slices == NULL) {
+			diag_set(OutOfMemory, slice_count * sizeof(*new_slices),
+				 "malloc", "struct vy_slice *");
+			goto fail;
+		}
+	}
+	for (i = 0, j = 0; i < n_parts; i++) {
+		run = parts[i]->new_run;
+		for (range = begin_ranges[i]; range != end_ranges[i];
+		     range = vy_range_tree_next(&lsm->range_tree, range), j++) {
+			slice = vy_slice_new(vy_log_next_id(), run,
+					     range->begin, range->end,
+					     lsm->cmp_def);
+			if (slice == NULL)
+				goto fail_free_slices;
+
+			assert(j < slice_count);
+			new_slices[j] = slice;
+		}
 	}
-	for (range = begin_range, i = 0; range != end_range;
-	     range = vy_range_tree_next(&lsm->range_tree, range), i++) {
-		slice = vy_slice_new(vy_log_next_id(), new_run,
-				     range->begin, range->end, lsm->cmp_def);
-		if (slice == NULL)
-			goto fail_free_slices;
 
-		assert(i < lsm->range_count);
-		new_slices[i] = slice;
+	/*
+	 * Share descriptors of the blob files linked by the new
+	 * runs with the runs that are already in use.
+	 */
+	for (i = 0; i < n_parts; i++) {
+		run = parts[i]->new_run;
+		if (!vy_run_is_empty(run) &&
+		    vy_run_open_blobs(run, lsm->env->path, lsm->space_id,
+				      lsm->index_id) != 0)
+			goto fail_free_slices;
 	}
 
 	/*
 	 * Log change in metadata.
 	 */
 	vy_log_tx_begin();
-	vy_log_create_run(lsm->id, new_run->id, dump_lsn, new_run->dump_count);
-	for (range = begin_range, i = 0; range != end_range;
-	     range = vy_range_tree_next(&lsm->range_tree, range), i++) {
-		assert(i < lsm->range_count);
-		slice = new_slices[i];
-		vy_log_insert_slice(range->id, new_run->id, slice->id,
-				    tuple_data_or_null(slice->begin),
-				    tuple_data_or_null(slice->end));
+	for (i = 0, j = 0; i < n_parts; i++) {
+		run = parts[i]->new_run;
+		if (vy_run_is_empty(run))
+			continue;
+		vy_log_create_run(lsm->id, run->id, dump_lsn, run->dump_count,
+				  run->info.blob_ids, run->info.blob_count);
+		for (range = begin_ranges[i]; range != end_ranges[i];
+		     range = vy_range_tree_next(&lsm->range_tree, range), j++) {
+			assert(j < slice_count);
+			slice = new_slices[j];
+			vy_log_insert_slice(range->id, run->id, slice->id,
+					    tuple_data_or_null(slice->begin),
+					    tuple_data_or_null(slice->end));
+		}
 	}
 	vy_log_dump_lsm(lsm->id, dump_lsn);
 	if (vy_log_tx_commit() < 0)
 		goto fail_free_slices;
 
-	/* Account the new run. */
-	vy_lsm_add_run(lsm, new_run);
-	/* Drop the reference held by the task. */
-	vy_run_unref(new_run);
+	/*
+	 * Account the new runs that are not empty,
+	 * discard the rest.
+	 */
+	for (i = 0; i < n_parts; i++) {
+		run = parts[i]->new_run;
+		if (!vy_run_is_empty(run)) {
+			vy_lsm_add_run(lsm, run);
+			/* Drop the reference held by the task. */
+			vy_run_unref(run);
+		} else
+			vy_run_discard(run);
+	}
 
 	/*
 	 * Add new slices to ranges.
@@ -1204,20 +1308,21 @@ vy_task_dump_complete(struct vy_task *task)
 	 * LSM tree state, when the same statement is present twice,
 	 * in memory and on disk.
 	 */
-	for (range = begin_range, i = 0; range != end_range;
-	     range = vy_range_tree_next(&lsm->range_tree, range), i++) {
-		assert(i < lsm->range_count);
-		slice = new_slices[i];
-		vy_lsm_unacct_range(lsm, range);
-		vy_range_add_slice(range, slice);
-		vy_range_update_compaction_priority(range, &lsm->opts);
-		vy_range_update_dumps_per_compaction(range);
-		vy_lsm_acct_range(lsm, range);
+	for (i = 0, j = 0; i < n_parts; i++) {
+		for (range = begin_ranges[i]; range != end_ranges[i];
+		     range = vy_range_tree_next(&lsm->range_tree, range), j++) {
+			assert(j < slice_count);
+			slice = new_slices[j];
+			vy_lsm_unacct_range(lsm, range);
+			vy_range_add_slice(range, slice);
+			vy_range_update_compaction_priority(range, &lsm->opts);
+			vy_range_update_dumps_per_compaction(range);
+			vy_lsm_acct_range(lsm, range);
+		}
 	}
 	vy_range_heap_update_all(&lsm->range_heap);
 	free(new_slices);
 
-delete_mems:
 	/*
 	 * Delete dumped in-memory trees and account dump in
 	 * LSM tree statistics.
@@ -1240,8 +1345,9 @@ delete_mems:
 	scheduler->stat.dump_output += dump_output.bytes;
 	scheduler->stat.dump_time += dump_time;
 
-	/* The iterator has been cleaned up in a worker thread. */
-	task->wi->iface->close(task->wi);
+	/* The iterators have been cleaned up in worker threads. */
+	for (i = 0; i < n_parts; i++)
+		parts[i]->wi->iface->close(parts[i]->wi);
 
 	lsm->is_dumping = false;
 	vy_scheduler_update_lsm(scheduler, lsm);
@@ -1258,8 +1364,8 @@ delete_mems:
 	return 0;
 
 fail_free_slices:
-	for (i = 0; i < lsm->range_count; i++) {
-		slice = new_slices[i];
+	for (j = 0; j < slice_count; j++) {
+		slice = new_slices[j];
 		if (slice != NULL)
 			vy_slice_delete(slice);
 	}
@@ -1268,6 +1374,23 @@ fail:
 	return -1;
 }
 
+/**
+ * Free the write iterator and the run allocated for a part
+ * of a dump task.
+ */
+static void
+vy_task_dump_discard(struct vy_task *task)
+{
+	if (task->wi != NULL) {
+		task->wi->iface->close(task->wi);
+		task->wi = NULL;
+	}
+	if (task->new_run != NULL) {
+		vy_run_discard(task->new_run);
+		task->new_run = NULL;
+	}
+}
+
 static void
 vy_task_dump_abort(struct vy_task *task)
 {
@@ -1276,9 +1399,6 @@ vy_task_dump_abort(struct vy_task *task)
 
 	assert(lsm->is_dumping);
 
-	/* The iterator has been cleaned up in a worker thread. */
-	task->wi->iface->close(task->wi);
-
 	/*
 	 * It's no use alerting the user if the server is
 	 * shutting down or the LSM tree was dropped.
@@ -1289,7 +1409,10 @@ vy_task_dump_abort(struct vy_task *task)
 		say_error("%s: dump failed", vy_lsm_name(lsm));
 	}
 
-	vy_run_discard(task->new_run);
+	/* The iterators have been cleaned up in worker threads. */
+	vy_task_dump_discard(task);
+	for (int i = 0; i < task->subtask_count; i++)
+		vy_task_dump_discard(task->subtasks[i]);
 
 	lsm->is_dumping = false;
 	vy_scheduler_update_lsm(scheduler, lsm);
@@ -1313,6 +1436,142 @@ vy_task_dump_abort(struct vy_task *task)
 		vy_scheduler_complete_dump(scheduler);
 }
 
+/**
+ * Make a write iterator drop expired tuples if the space has
+ * a TTL field, see space_opts::ttl_field. This is only safe
+ * when writing the last LSM tree level, because otherwise an
+ * older version of a dropped tuple could show through. Tuples
+ * are only expired by primary index compaction: secondary
+ * indexes are purged with deferred DELETEs, which can't be
+ * generated on dump, see vy_task_dump_prepare(). Until then,
+ * secondary index entries pointing to dropped tuples are
+ * skipped on read, like overwritten ones.
+ */
+static void
+vy_task_set_expiration(struct vy_task *task, struct vy_stmt_stream *wi,
+		       bool is_last_level)
+{
+	struct vy_lsm *lsm = task->lsm;
+	if (!is_last_level || lsm->index_id > 0)
+		return;
+	struct space *space = space_by_id(lsm->space_id);
+	if (space == NULL || space->def->opts.ttl_field == 0)
+		return;
+	vy_write_iterator_set_expiration(wi, space->def->opts.ttl_field - 1,
+					 ev_now(loop()),
+					 space->index_count > 1);
+}
+
+/**
+ * Split a dump task in parts if the dumped in-memory trees are
+ * big enough and there are idle dump threads to write the parts
+ * in parallel. A subtask is allocated for each part but the first
+ * one, which is written by the task itself.
+ *
+ * Parts are split at range boundaries so that each range gets
+ * a slice of exactly one new run, just like on ordinary dump,
+ * and there are about the same number of ranges in each part.
+ * A part is never smaller than a page.
+ */
+static int
+vy_task_dump_split(struct vy_task *task, size_t dump_size)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+
+	int max_parts = MIN(scheduler->max_subdumps, VY_COMPACTION_PARTS_MAX);
+	max_parts = MIN(max_parts, lsm->range_count);
+	if ((size_t)max_parts > dump_size / lsm->opts.page_size)
+		max_parts = dump_size / lsm->opts.page_size;
+
+	struct vy_worker *workers[VY_COMPACTION_PARTS_MAX - 1];
+	int worker_count = 0;
+	while (worker_count < max_parts - 1) {
+		struct vy_worker *worker;
+		worker = vy_worker_pool_get(&scheduler->dump_pool);
+		if (worker == NULL)
+			break;
+		workers[worker_count++] = worker;
+	}
+
+	int rc = -1;
+	int n_parts = worker_count + 1;
+	struct vy_range *range = vy_range_tree_first(&lsm->range_tree);
+	int range_no = 0;
+	struct vy_task *part = task;
+	for (int i = 1; i < n_parts; i++) {
+		int boundary = (int64_t)lsm->range_count * i / n_parts;
+		while (range_no < boundary) {
+			range = vy_range_tree_next(&lsm->range_tree, range);
+			range_no++;
+		}
+		assert(range != NULL && range->begin != NULL);
+		part->end = range->begin;
+		tuple_ref(part->end);
+		part = vy_task_new(scheduler, workers[i - 1], lsm, task->ops);
+		if (part == NULL)
+			goto out;
+		part->parent = task;
+		part->begin = range->begin;
+		tuple_ref(part->begin);
+		task->subtasks[task->subtask_count++] = part;
+	}
+	task->parts_in_progress = n_parts;
+	rc = 0;
+out:
+	/* Return workers that haven't been used. */
+	for (int i = task->subtask_count; i < worker_count; i++)
+		vy_worker_pool_put(workers[i]);
+	return rc;
+}
+
+/**
+ * Allocate a run and a write iterator for a part of a dump task.
+ * If the task is split in parts, the iterator is fed only with
+ * statements that fall within the part boundaries.
+ */
+static int
+vy_task_dump_prepare(struct vy_task *task, int64_t dump_lsn,
+		     bool is_last_level)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+
+	task->new_run = vy_run_prepare(scheduler->run_env, lsm);
+	if (task->new_run == NULL)
+		return -1;
+	task->new_run->dump_count = 1;
+	task->new_run->dump_lsn = dump_lsn;
+	task->new_run->info.dump_time = ev_now(loop());
+
+	/*
+	 * Note, since deferred DELETE are generated on tx commit
+	 * in case the overwritten tuple is found in-memory, no
+	 * deferred DELETE statement should be generated during
+	 * dump so we don't pass a deferred DELETE handler.
+	 */
+	task->wi = vy_write_iterator_new(task->cmp_def, lsm->disk_format,
+					 vy_lsm_is_covering(lsm),
+					 is_last_level, scheduler->read_views,
+					 NULL);
+	if (task->wi == NULL)
+		return -1;
+
+	struct vy_mem *mem;
+	rlist_foreach_entry(mem, &lsm->sealed, in_sealed) {
+		if (mem->generation > scheduler->dump_generation)
+			continue;
+		if (vy_write_iterator_new_mem(task->wi, mem, task->begin,
+					      task->end) != 0)
+			return -1;
+	}
+
+	task->bloom_fpr = lsm->opts.bloom_fpr;
+	task->page_size = lsm->opts.page_size;
+	task->blob_threshold = lsm->opts.blob_threshold;
+	return 0;
+}
+
 /**
  * Create a task to dump an LSM tree.
  *
@@ -1351,6 +1610,7 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	 * eligible for dump are over.
 	 */
 	int64_t dump_lsn = -1;
+	size_t dump_size = 0;
 	struct vy_mem *mem, *next_mem;
 	rlist_foreach_entry_safe(mem, &lsm->sealed, in_sealed, next_mem) {
 		if (mem->generation > scheduler->dump_generation)
@@ -1365,6 +1625,7 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 			continue;
 		}
 		dump_lsn = MAX(dump_lsn, mem->dump_lsn);
+		dump_size += mem->count.bytes;
 	}
 
 	if (dump_lsn < 0) {
@@ -1378,38 +1639,17 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	if (task == NULL)
 		goto err;
 
-	struct vy_run *new_run = vy_run_prepare(scheduler->run_env, lsm);
-	if (new_run == NULL)
-		goto err_run;
-
-	new_run->dump_count = 1;
-	new_run->dump_lsn = dump_lsn;
-
-	/*
-	 * Note, since deferred DELETE are generated on tx commit
-	 * in case the overwritten tuple is found in-memory, no
-	 * deferred DELETE statement should be generated during
-	 * dump so we don't pass a deferred DELETE handler.
-	 */
-	struct vy_stmt_stream *wi;
+	if (vy_task_dump_split(task, dump_size) != 0)
+		goto err_parts;
 	bool is_last_level = (lsm->run_count == 0);
-	wi = vy_write_iterator_new(task->cmp_def, lsm->disk_format,
-				   lsm->index_id == 0, is_last_level,
-				   scheduler->read_views, NULL);
-	if (wi == NULL)
-		goto err_wi;
-	rlist_foreach_entry(mem, &lsm->sealed, in_sealed) {
-		if (mem->generation > scheduler->dump_generation)
-			continue;
-		if (vy_write_iterator_new_mem(wi, mem) != 0)
-			goto err_wi_sub;
+	if (vy_task_dump_prepare(task, dump_lsn, is_last_level) != 0)
+		goto err_parts;
+	for (int i = 0; i < task->subtask_count; i++) {
+		if (vy_task_dump_prepare(task->subtasks[i], dump_lsn,
+					 is_last_level) != 0)
+			goto err_parts;
 	}
 
-	task->new_run = new_run;
-	task->wi = wi;
-	task->bloom_fpr = lsm->opts.bloom_fpr;
-	task->page_size = lsm->opts.page_size;
-
 	lsm->is_dumping = true;
 	vy_scheduler_update_lsm(scheduler, lsm);
 
@@ -1427,15 +1667,17 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 
 	scheduler->dump_task_count++;
 
-	say_info("%s: dump started", vy_lsm_name(lsm));
+	say_info("%s: dump started, parts %d", vy_lsm_name(lsm),
+		 task->parts_in_progress);
 	*p_task = task;
 	return 0;
 
-err_wi_sub:
-	task->wi->iface->close(wi);
-err_wi:
-	vy_run_discard(new_run);
-err_run:
+err_parts:
+	vy_task_dump_discard(task);
+	for (int i = 0; i < task->subtask_count; i++) {
+		vy_task_dump_discard(task->subtasks[i]);
+		vy_worker_pool_put(task->subtasks[i]->worker);
+	}
 	vy_task_delete(task);
 err:
 	diag_log();
@@ -1454,9 +1696,278 @@ vy_task_compaction_execute(struct vy_task *task)
 	return vy_task_write_run(task);
 }
 
+/**
+ * Build the list of runs that became unused as a result of
+ * compaction of slices [@first_slice, @last_slice].
+ */
+static void
+vy_task_compaction_unused_runs(struct vy_slice *first_slice,
+			       struct vy_slice *last_slice,
+			       struct rlist *unused_runs)
+{
+	struct vy_slice *slice;
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		slice->run->compacted_slice_count++;
+		if (slice == last_slice)
+			break;
+	}
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		struct vy_run *run = slice->run;
+		if (run->compacted_slice_count == run->slice_count)
+			rlist_add_entry(unused_runs, run, in_unused);
+		slice->run->compacted_slice_count = 0;
+		if (slice == last_slice)
+			break;
+	}
+}
+
+/**
+ * Close the write iterator of a part of a compaction task
+ * and delete the slices it was fed with.
+ */
+static void
+vy_task_compaction_close_input(struct vy_task *task)
+{
+	if (task->wi != NULL) {
+		task->wi->iface->close(task->wi);
+		task->wi = NULL;
+	}
+	struct vy_slice *slice, *next_slice;
+	rlist_foreach_entry_safe(slice, &task->cut_slices,
+				 in_range, next_slice)
+		vy_slice_delete(slice);
+	rlist_create(&task->cut_slices);
+}
+
+/**
+ * Remove compacted run files that were created after
+ * the last checkpoint (and hence are not referenced
+ * by any checkpoint) immediately to save disk space.
+ */
+static void
+vy_task_compaction_remove_runs(struct vy_lsm *lsm, struct rlist *unused_runs,
+			       int64_t gc_lsn)
+{
+	struct vy_run *run;
+	vy_log_tx_begin();
+	rlist_foreach_entry(run, unused_runs, in_unused) {
+		if (run->dump_lsn > gc_lsn &&
+		    vy_run_remove_files(lsm->env->path, lsm->space_id,
+					lsm->index_id, run->id,
+					run->info.blob_ids,
+					run->info.blob_count) == 0) {
+			vy_log_forget_run(run->id);
+		}
+	}
+	vy_log_tx_try_commit();
+}
+
+/**
+ * Complete a compaction task that was split in parts.
+ *
+ * Since each part writes a run of its own, we can't replace
+ * the compacted slices with a slice of the new run as we do
+ * in case of ordinary compaction. Instead we replace the range
+ * with new ranges, one per part. Each new range gets
+ * a slice of the run written by the part instead of the
+ * compacted slices and slices of the runs that weren't
+ * compacted cut to the part boundaries, just like
+ * vy_lsm_split_range() does.
+ */
+static int
+vy_task_compaction_complete_parts(struct vy_task *task)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_range *range = task->range;
+	double compaction_time = ev_monotonic_now(loop()) - task->start_time;
+	struct vy_disk_stmt_counter compaction_output;
+	struct vy_disk_stmt_counter compaction_input;
+	struct vy_slice *first_slice = task->first_slice;
+	struct vy_slice *last_slice = task->last_slice;
+	struct vy_slice *slice, *new_slice;
+	struct vy_run *run;
+
+	int n_parts = task->subtask_count + 1;
+	struct vy_task *parts[VY_COMPACTION_PARTS_MAX];
+	struct vy_range *new_ranges[VY_COMPACTION_PARTS_MAX] = {NULL, };
+	parts[0] = task;
+	for (int i = 1; i < n_parts; i++)
+		parts[i] = task->subtasks[i - 1];
+
+	/*
+	 * The iterators have been cleaned up in workers.
+	 * Close them and delete the slices they were fed
+	 * with right away, because those slices reference
+	 * the compacted runs and so would prevent us from
+	 * figuring out which runs became unused.
+	 */
+	for (int i = 0; i < n_parts; i++)
+		vy_task_compaction_close_input(parts[i]);
+
+	/*
+	 * Allocate new ranges and fill them with slices.
+	 */
+	vy_disk_stmt_counter_reset(&compaction_output);
+	for (int i = 0; i < n_parts; i++) {
+		struct vy_task *part = parts[i];
+		struct vy_range *new_range;
+		vy_disk_stmt_counter_add(&compaction_output,
+					 &part->new_run->count);
+		new_range = vy_range_new(vy_log_next_id(), part->begin,
+					 part->end, lsm->cmp_def);
+		if (new_range == NULL)
+			goto fail;
+		new_ranges[i] = new_range;
+		/*
+		 * vy_range_add_slice() adds a slice to the list head,
+		 * so to preserve the order of the slices list, we have
+		 * to iterate backward.
+		 */
+		bool is_compacted = false;
+		rlist_foreach_entry_reverse(slice, &range->slices, in_range) {
+			if (slice == last_slice) {
+				is_compacted = true;
+				if (!vy_run_is_empty(part->new_run)) {
+					new_slice = vy_slice_new(
+						vy_log_next_id(), part->new_run,
+						NULL, NULL, lsm->cmp_def);
+					if (new_slice == NULL)
+						goto fail;
+					vy_range_add_slice(new_range, new_slice);
+				}
+			}
+			if (!is_compacted) {
+				if (vy_slice_cut(slice, vy_log_next_id(),
+						 new_range->begin,
+						 new_range->end, lsm->cmp_def,
+						 &new_slice) != 0)
+					goto fail;
+				if (new_slice != NULL)
+					vy_range_add_slice(new_range, new_slice);
+			}
+			if (slice == first_slice)
+				is_compacted = false;
+		}
+		new_range->n_compactions = range->n_compactions + 1;
+		vy_range_update_compaction_priority(new_range, &lsm->opts);
+		vy_range_update_dumps_per_compaction(new_range);
+	}
+
+	/*
+	 * Share descriptors of the blob files linked by the new
+	 * runs with the compacted runs.
+	 */
+	for (int i = 0; i < n_parts; i++) {
+		run = parts[i]->new_run;
+		if (!vy_run_is_empty(run) &&
+		    vy_run_open_blobs(run, lsm->env->path, lsm->space_id,
+				      lsm->index_id) != 0)
+			goto fail;
+	}
+
+	RLIST_HEAD(unused_runs);
+	vy_task_compaction_unused_runs(first_slice, last_slice, &unused_runs);
+
+	/*
+	 * Log change in metadata.
+	 */
+	vy_log_tx_begin();
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_log_delete_slice(slice->id);
+	vy_log_delete_range(range->id);
+	int64_t gc_lsn = vy_log_signature();
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_log_drop_run(run->id, gc_lsn);
+	for (int i = 0; i < n_parts; i++) {
+		run = parts[i]->new_run;
+		if (!vy_run_is_empty(run))
+			vy_log_create_run(lsm->id, run->id, run->dump_lsn,
+					  run->dump_count, run->info.blob_ids,
+					  run->info.blob_count);
+	}
+	for (int i = 0; i < n_parts; i++) {
+		struct vy_range *new_range = new_ranges[i];
+		vy_log_insert_range(lsm->id, new_range->id,
+				    tuple_data_or_null(new_range->begin),
+				    tuple_data_or_null(new_range->end));
+		rlist_foreach_entry(slice, &new_range->slices, in_range)
+			vy_log_insert_slice(new_range->id, slice->run->id,
+					    slice->id,
+					    tuple_data_or_null(slice->begin),
+					    tuple_data_or_null(slice->end));
+	}
+	if (vy_log_tx_commit() < 0)
+		goto fail;
+
+	vy_task_compaction_remove_runs(lsm, &unused_runs, gc_lsn);
+
+	/*
+	 * Account the new runs that are not empty,
+	 * discard the rest.
+	 */
+	for (int i = 0; i < n_parts; i++) {
+		run = parts[i]->new_run;
+		if (!vy_run_is_empty(run)) {
+			vy_lsm_add_run(lsm, run);
+			/* Drop the reference held by the task. */
+			vy_run_unref(run);
+		} else
+			vy_run_discard(run);
+	}
+
+	/*
+	 * Replace the old range in the LSM tree. Note, the range
+	 * was removed from the heap when the task was scheduled.
+	 */
+	vy_disk_stmt_counter_reset(&compaction_input);
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		vy_disk_stmt_counter_add(&compaction_input, &slice->count);
+		if (slice == last_slice)
+			break;
+	}
+	vy_lsm_unacct_range(lsm, range);
+	vy_range_heap_insert(&lsm->range_heap, range);
+	vy_lsm_remove_range(lsm, range);
+	for (int i = 0; i < n_parts; i++) {
+		vy_lsm_add_range(lsm, new_ranges[i]);
+		vy_lsm_acct_range(lsm, new_ranges[i]);
+	}
+	lsm->range_tree_version++;
+	vy_lsm_acct_compaction(lsm, compaction_time,
+			       &compaction_input, &compaction_output);
+	scheduler->stat.compaction_input += compaction_input.bytes;
+	scheduler->stat.compaction_output += compaction_output.bytes;
+	scheduler->stat.compaction_time += compaction_time;
+
+	/*
+	 * Unaccount unused runs and delete the old range.
+	 */
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_lsm_remove_run(lsm, run);
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_slice_wait_pinned(slice);
+
+	vy_scheduler_update_lsm(scheduler, lsm);
+
+	say_info("%s: completed compacting range %s in %d parts",
+		 vy_lsm_name(lsm), vy_range_str(range), n_parts);
+	vy_range_delete(range);
+	return 0;
+fail:
+	for (int i = 0; i < n_parts; i++) {
+		if (new_ranges[i] != NULL)
+			vy_range_delete(new_ranges[i]);
+	}
+	return -1;
+}
+
 static int
 vy_task_compaction_complete(struct vy_task *task)
 {
+	if (task->subtask_count > 0)
+		return vy_task_compaction_complete_parts(task);
+
 	struct vy_scheduler *scheduler = task->scheduler;
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_range *range = task->range;
@@ -1481,6 +1992,15 @@ vy_task_compaction_complete(struct vy_task *task)
 					 NULL, NULL, lsm->cmp_def);
 		if (new_slice == NULL)
 			return -1;
+		/*
+		 * Share descriptors of the blob files linked by
+		 * the new run with the compacted runs.
+		 */
+		if (vy_run_open_blobs(new_run, lsm->env->path,
+				      lsm->space_id, lsm->index_id) != 0) {
+			vy_slice_delete(new_slice);
+			return -1;
+		}
 	}
 
 	/*
@@ -1488,19 +2008,7 @@ vy_task_compaction_complete(struct vy_task *task)
 	 * as a result of compaction.
 	 */
 	RLIST_HEAD(unused_runs);
-	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
-		slice->run->compacted_slice_count++;
-		if (slice == last_slice)
-			break;
-	}
-	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
-		run = slice->run;
-		if (run->compacted_slice_count == run->slice_count)
-			rlist_add_entry(&unused_runs, run, in_unused);
-		slice->run->compacted_slice_count = 0;
-		if (slice == last_slice)
-			break;
-	}
+	vy_task_compaction_unused_runs(first_slice, last_slice, &unused_runs);
 
 	/*
 	 * Log change in metadata.
@@ -1516,7 +2024,8 @@ vy_task_compaction_complete(struct vy_task *task)
 		vy_log_drop_run(run->id, gc_lsn);
 	if (new_slice != NULL) {
 		vy_log_create_run(lsm->id, new_run->id, new_run->dump_lsn,
-				  new_run->dump_count);
+				  new_run->dump_count, new_run->info.blob_ids,
+				  new_run->info.blob_count);
 		vy_log_insert_slice(range->id, new_run->id, new_slice->id,
 				    tuple_data_or_null(new_slice->begin),
 				    tuple_data_or_null(new_slice->end));
@@ -1527,20 +2036,7 @@ vy_task_compaction_complete(struct vy_task *task)
 		return -1;
 	}
 
-	/*
-	 * Remove compacted run files that were created after
-	 * the last checkpoint (and hence are not referenced
-	 * by any checkpoint) immediately to save disk space.
-	 */
-	vy_log_tx_begin();
-	rlist_foreach_entry(run, &unused_runs, in_unused) {
-		if (run->dump_lsn > gc_lsn &&
-		    vy_run_remove_files(lsm->env->path, lsm->space_id,
-					lsm->index_id, run->id) == 0) {
-			vy_log_forget_run(run->id);
-		}
-	}
-	vy_log_tx_try_commit();
+	vy_task_compaction_remove_runs(lsm, &unused_runs, gc_lsn);
 
 	/*
 	 * Account the new run if it is not empty,
@@ -1608,6 +2104,20 @@ vy_task_compaction_complete(struct vy_task *task)
 	return 0;
 }
 
+/**
+ * Free the write iterator and the run allocated for a part
+ * of a compaction task.
+ */
+static void
+vy_task_compaction_discard(struct vy_task *task)
+{
+	vy_task_compaction_close_input(task);
+	if (task->new_run != NULL) {
+		vy_run_discard(task->new_run);
+		task->new_run = NULL;
+	}
+}
+
 static void
 vy_task_compaction_abort(struct vy_task *task)
 {
@@ -1615,9 +2125,6 @@ vy_task_compaction_abort(struct vy_task *task)
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_range *range = task->range;
 
-	/* The iterator has been cleaned up in worker. */
-	task->wi->iface->close(task->wi);
-
 	/*
 	 * It's no use alerting the user if the server is
 	 * shutting down or the LSM tree was dropped.
@@ -1629,13 +2136,224 @@ vy_task_compaction_abort(struct vy_task *task)
 			  vy_lsm_name(lsm), vy_range_str(range));
 	}
 
-	vy_run_discard(task->new_run);
+	/* The iterators have been cleaned up in workers. */
+	vy_task_compaction_discard(task);
+	for (int i = 0; i < task->subtask_count; i++)
+		vy_task_compaction_discard(task->subtasks[i]);
 
 	assert(heap_node_is_stray(&range->heap_node));
 	vy_range_heap_insert(&lsm->range_heap, range);
 	vy_scheduler_update_lsm(scheduler, lsm);
 }
 
+/**
+ * Choose boundaries for splitting compaction of a range in at
+ * most @max_parts parts. The boundaries are taken from the page
+ * index of the biggest compacted run so that the parts are of
+ * about the same size. Since the range is split at the part
+ * boundaries on completion, we never make a part less than half
+ * the target range size, otherwise the new ranges would be
+ * coalesced back, see vy_range_needs_coalesce().
+ *
+ * Returns the number of parts and stores the keys separating
+ * them in @keys or -1 on memory error. The caller is supposed
+ * to unreference the keys.
+ */
+static int
+vy_task_compaction_split_keys(struct vy_task *task, int max_parts,
+			      struct tuple **keys)
+{
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_range *range = task->range;
+	struct vy_slice *slice, *biggest = NULL;
+	uint64_t input_size = 0;
+	for (slice = task->first_slice; ;
+	     slice = rlist_next_entry(slice, in_range)) {
+		input_size += slice->count.bytes;
+		if (biggest == NULL ||
+		    slice->count.bytes > biggest->count.bytes)
+			biggest = slice;
+		if (slice == task->last_slice)
+			break;
+	}
+
+	uint64_t part_size = MAX(vy_lsm_range_size(lsm) / 2, 1);
+	uint32_t page_count = biggest->last_page_no -
+			      biggest->first_page_no + 1;
+	int n_parts = MIN(input_size / part_size, (uint64_t)max_parts);
+	n_parts = MIN((uint32_t)n_parts, page_count);
+	if (n_parts <= 1)
+		return 1;
+
+	/*
+	 * A boundary must be greater than the previous one and
+	 * the beginning of the range and the slice, see also
+	 * vy_range_needs_split(). A key returned by
+	 * vy_run_page_min_key() may be freed once the fiber
+	 * yields so we make tuples of the boundaries right away.
+	 */
+	const char *prev_key = vy_run_page_min_key(biggest->run,
+						   biggest->first_page_no);
+	int count = 1;
+	for (int i = 1; i < n_parts; i++) {
+		uint32_t page_no = biggest->first_page_no +
+				   (uint64_t)page_count * i / n_parts;
+		const char *key = vy_run_page_min_key(biggest->run, page_no);
+		if (key_compare(key, prev_key, lsm->cmp_def) <= 0)
+			continue;
+		if (biggest->begin != NULL && key_compare(key,
+				tuple_data(biggest->begin), lsm->cmp_def) <= 0)
+			continue;
+		if (range->begin != NULL && key_compare(key,
+				tuple_data(range->begin), lsm->cmp_def) <= 0)
+			continue;
+		if (range->end != NULL && key_compare(key,
+				tuple_data(range->end), lsm->cmp_def) >= 0)
+			break;
+		keys[count - 1] = vy_key_from_msgpack(lsm->env->key_format,
+						      key);
+		if (keys[count - 1] == NULL) {
+			for (int j = 0; j < count - 1; j++)
+				tuple_unref(keys[j]);
+			count = -1;
+			break;
+		}
+		prev_key = tuple_data(keys[count - 1]);
+		count++;
+	}
+	return count;
+}
+
+/**
+ * Split a compaction task in parts if the range is big enough
+ * and there are idle worker threads to merge the parts in
+ * parallel. A subtask is allocated for each part but the first
+ * one, which is merged by the task itself.
+ */
+static int
+vy_task_compaction_split(struct vy_task *task)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_range *range = task->range;
+
+	struct vy_worker *workers[VY_COMPACTION_PARTS_MAX - 1];
+	int worker_count = 0;
+	int max_parts = MIN(scheduler->max_subcompactions,
+			    VY_COMPACTION_PARTS_MAX);
+	while (worker_count < max_parts - 1) {
+		struct vy_worker *worker;
+		worker = vy_worker_pool_get(&scheduler->compaction_pool);
+		if (worker == NULL)
+			break;
+		workers[worker_count++] = worker;
+	}
+
+	int rc = -1;
+	struct tuple *keys[VY_COMPACTION_PARTS_MAX - 1];
+	int n_parts = 1;
+	int i = 0;
+	if (worker_count > 0)
+		n_parts = vy_task_compaction_split_keys(task, worker_count + 1,
+							keys);
+	if (n_parts < 0) {
+		n_parts = 0;
+		goto out;
+	}
+	if (n_parts > 1) {
+		task->begin = range->begin;
+		if (task->begin != NULL)
+			tuple_ref(task->begin);
+	}
+	struct vy_task *part = task;
+	for (; i < n_parts - 1; i++) {
+		struct tuple *key = keys[i];
+		part->end = key;
+		part = vy_task_new(scheduler, workers[i], lsm, task->ops);
+		if (part == NULL) {
+			i++;
+			goto out;
+		}
+		part->parent = task;
+		part->range = range;
+		part->first_slice = task->first_slice;
+		part->last_slice = task->last_slice;
+		part->begin = key;
+		tuple_ref(key);
+		task->subtasks[task->subtask_count++] = part;
+	}
+	if (n_parts > 1) {
+		part->end = range->end;
+		if (part->end != NULL)
+			tuple_ref(part->end);
+	}
+	task->parts_in_progress = n_parts;
+	rc = 0;
+out:
+	/* Drop split keys that haven't been used. */
+	for (; rc != 0 && i < n_parts - 1; i++)
+		tuple_unref(keys[i]);
+	/* Return workers that haven't been used. */
+	for (int i = task->subtask_count; i < worker_count; i++)
+		vy_worker_pool_put(workers[i]);
+	return rc;
+}
+
+/**
+ * Allocate a run and a write iterator for a part of a compaction
+ * task. If the task is split in parts, the iterator is fed with
+ * slices of the compacted runs cut to the part boundaries.
+ */
+static int
+vy_task_compaction_prepare(struct vy_task *task, bool is_last_level,
+			   int64_t dump_lsn, uint32_t dump_count,
+			   uint64_t dump_time)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+
+	task->new_run = vy_run_prepare(scheduler->run_env, lsm);
+	if (task->new_run == NULL)
+		return -1;
+	task->new_run->dump_lsn = dump_lsn;
+	task->new_run->dump_count = dump_count;
+	task->new_run->info.dump_time = dump_time;
+
+	task->wi = vy_write_iterator_new(task->cmp_def, lsm->disk_format,
+					 vy_lsm_is_covering(lsm),
+					 is_last_level, scheduler->read_views,
+					 lsm->index_id > 0 ? NULL :
+					 &task->deferred_delete_handler);
+	if (task->wi == NULL)
+		return -1;
+	vy_task_set_expiration(task, task->wi, is_last_level);
+
+	bool is_split = task->begin != NULL || task->end != NULL;
+	struct vy_slice *slice;
+	for (slice = task->first_slice; ;
+	     slice = rlist_next_entry(slice, in_range)) {
+		struct vy_slice *src = slice;
+		if (is_split) {
+			if (vy_slice_cut(slice, vy_log_next_id(), task->begin,
+					 task->end, lsm->cmp_def, &src) != 0)
+				return -1;
+			if (src != NULL)
+				rlist_add_tail_entry(&task->cut_slices,
+						     src, in_range);
+		}
+		if (src != NULL && vy_write_iterator_new_slice(task->wi,
+								src) != 0)
+			return -1;
+		if (slice == task->last_slice)
+			break;
+	}
+
+	task->bloom_fpr = lsm->opts.bloom_fpr;
+	task->page_size = lsm->opts.page_size;
+	task->blob_threshold = lsm->opts.blob_threshold;
+	return 0;
+}
+
 static int
 vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 		       struct vy_lsm *lsm, struct vy_task **p_task)
@@ -1662,29 +2380,23 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	if (task == NULL)
 		goto err_task;
 
-	struct vy_run *new_run = vy_run_prepare(scheduler->run_env, lsm);
-	if (new_run == NULL)
-		goto err_run;
-
-	struct vy_stmt_stream *wi;
-	bool is_last_level = (range->compaction_priority == range->slice_count);
-	wi = vy_write_iterator_new(task->cmp_def, lsm->disk_format,
-				   lsm->index_id == 0, is_last_level,
-				   scheduler->read_views,
-				   lsm->index_id > 0 ? NULL :
-				   &task->deferred_delete_handler);
-	if (wi == NULL)
-		goto err_wi;
+	task->range = range;
 
 	struct vy_slice *slice;
+	int64_t dump_lsn = -1;
 	int32_t dump_count = 0;
+	uint64_t dump_time = 0;
+	int skip = range->compaction_skip;
 	int n = range->compaction_priority;
 	rlist_foreach_entry(slice, &range->slices, in_range) {
-		if (vy_write_iterator_new_slice(wi, slice) != 0)
-			goto err_wi_sub;
-		new_run->dump_lsn = MAX(new_run->dump_lsn,
-					slice->run->dump_lsn);
+		/* Leave upper levels alone, if requested. */
+		if (skip > 0) {
+			skip--;
+			continue;
+		}
+		dump_lsn = MAX(dump_lsn, slice->run->dump_lsn);
 		dump_count += slice->run->dump_count;
+		dump_time = MAX(dump_time, slice->run->info.dump_time);
 		/* Remember the slices we are compacting. */
 		if (task->first_slice == NULL)
 			task->first_slice = slice;
@@ -1694,8 +2406,10 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 			break;
 	}
 	assert(n == 0);
-	assert(new_run->dump_lsn >= 0);
-	if (range->compaction_priority == range->slice_count)
+	assert(dump_lsn >= 0);
+	bool is_last_level = (range->compaction_skip +
+			      range->compaction_priority == range->slice_count);
+	if (is_last_level)
 		dump_count -= slice->run->dump_count;
 	/*
 	 * Do not update dumps_per_compaction in case compaction
@@ -1703,17 +2417,21 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	 * such as splitting/coalescing ranges for no good reason.
 	 */
 	if (range->needs_compaction)
-		new_run->dump_count = slice->run->dump_count;
-	else
-		new_run->dump_count = dump_count;
+		dump_count = slice->run->dump_count;
 
-	range->needs_compaction = false;
+	if (vy_task_compaction_split(task) != 0)
+		goto err_parts;
+	if (vy_task_compaction_prepare(task, is_last_level, dump_lsn,
+				       dump_count, dump_time) != 0)
+		goto err_parts;
+	for (int i = 0; i < task->subtask_count; i++) {
+		if (vy_task_compaction_prepare(task->subtasks[i],
+					       is_last_level, dump_lsn,
+					       dump_count, dump_time) != 0)
+			goto err_parts;
+	}
 
-	task->range = range;
-	task->new_run = new_run;
-	task->wi = wi;
-	task->bloom_fpr = lsm->opts.bloom_fpr;
-	task->page_size = lsm->opts.page_size;
+	range->needs_compaction = false;
 
 	/*
 	 * Remove the range we are going to compact from the heap
@@ -1722,17 +2440,19 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	vy_range_heap_delete(&lsm->range_heap, range);
 	vy_scheduler_update_lsm(scheduler, lsm);
 
-	say_info("%s: started compacting range %s, runs %d/%d",
+	say_info("%s: started compacting range %s, runs %d/%d, parts %d",
 		 vy_lsm_name(lsm), vy_range_str(range),
-                 range->compaction_priority, range->slice_count);
+                 range->compaction_priority, range->slice_count,
+		 task->parts_in_progress);
 	*p_task = task;
 	return 0;
 
-err_wi_sub:
-	task->wi->iface->close(wi);
-err_wi:
-	vy_run_discard(new_run);
-err_run:
+err_parts:
+	vy_task_compaction_discard(task);
+	for (int i = 0; i < task->subtask_count; i++) {
+		vy_task_compaction_discard(task->subtasks[i]);
+		vy_worker_pool_put(task->subtasks[i]->worker);
+	}
 	vy_task_delete(task);
 err_task:
 	diag_log();
@@ -1953,6 +2673,26 @@ fail:
 
 }
 
+/**
+ * Account a part of a task processed by a worker thread.
+ * If it was the last part of the task, return the task so
+ * that it can be completed, otherwise return NULL. Errors
+ * are propagated from parts to the task.
+ */
+static struct vy_task *
+vy_task_collect_part(struct vy_task *part)
+{
+	struct vy_task *task = part->parent != NULL ? part->parent : part;
+	if (part != task && part->is_failed && !task->is_failed) {
+		diag_move(&part->diag, &task->diag);
+		task->is_failed = true;
+	}
+	assert(task->parts_in_progress > 0);
+	if (--task->parts_in_progress > 0)
+		return NULL;
+	return task;
+}
+
 static int
 vy_task_complete(struct vy_task *task)
 {
@@ -2011,11 +2751,18 @@ vy_scheduler_f(va_list va)
 		/* Complete and delete all processed tasks. */
 		stailq_foreach_entry_safe(task, next, &processed_tasks,
 					  in_processed) {
+			vy_worker_pool_put(task->worker);
+			/*
+			 * A task split in parts can't be completed
+			 * until all its parts have been processed.
+			 */
+			task = vy_task_collect_part(task);
+			if (task == NULL)
+				continue;
 			if (vy_task_complete(task) != 0)
 				tasks_failed++;
 			else
 				tasks_done++;
-			vy_worker_pool_put(task->worker);
 			vy_task_delete(task);
 		}
 		/*
@@ -2048,6 +2795,12 @@ vy_scheduler_f(va_list va)
 		}
 
 		/* Queue the task for execution. */
+		for (int i = 0; i < task->subtask_count; i++) {
+			struct vy_task *subtask = task->subtasks[i];
+			cmsg_init(&subtask->cmsg, vy_task_execute_route);
+			cpipe_push(&subtask->worker->worker_pipe,
+				   &subtask->cmsg);
+		}
 		cmsg_init(&task->cmsg, vy_task_execute_route);
 		cpipe_push(&task->worker->worker_pipe, &task->cmsg);
 
@@ -77,6 +77,16 @@ struct vy_scheduler {
 	struct vy_worker_pool dump_pool;
 	/** Pool of threads for performing background compactions. */
 	struct vy_worker_pool compaction_pool;
+	/**
+	 * Max number of parts compaction of a range may be split
+	 * in to be merged by idle compaction threads in parallel.
+	 */
+	int max_subcompactions;
+	/**
+	 * Max number of parts dump of an LSM tree may be split
+	 * in to be written by idle dump threads in parallel.
+	 */
+	int max_subdumps;
 	/** Queue of processed tasks, linked by vy_task::in_processed. */
 	struct stailq processed_tasks;
 	/**
@@ -101,6 +101,15 @@ struct vy_run_iterator_stat {
 	 * of disk reads.
 	 */
 	struct vy_disk_stmt_counter read;
+	/** Statistics of reading pages ahead on sequential scans. */
+	struct {
+		/** Number of pages read ahead. */
+		int64_t pages;
+		/** Number of pages read ahead and used by the iterator. */
+		int64_t hit;
+		/** Number of pages read ahead in vain. */
+		int64_t waste;
+	} readahead;
 };
 
 /** TX write set iterator statistics. */
@@ -199,6 +208,11 @@ struct vy_cache_stat {
 	 * due to memory shortage.
 	 */
 	struct vy_stmt_counter evict;
+	/**
+	 * Number of statements moved to the protected
+	 * segment of the cache on a repeated access.
+	 */
+	struct vy_stmt_counter promote;
 };
 
 /** Transaction statistics. */
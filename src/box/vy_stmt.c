@@ -51,6 +51,8 @@
 enum vy_stmt_meta_key {
 	/** Statement flags. */
 	VY_STMT_FLAGS = 0x01,
+	/** Blob reference: [blob_id, offset, size]. */
+	VY_STMT_BLOB = 0x02,
 };
 
 /**
@@ -69,6 +71,12 @@ vy_stmt_persistent_flags(const struct tuple *stmt, bool is_primary)
 	 */
 	mask &= ~VY_STMT_UPDATE;
 
+	/*
+	 * A blob reference is stored in the statement metadata
+	 * rather than in flags, see vy_stmt_meta_encode().
+	 */
+	mask &= ~VY_STMT_BLOB_REF;
+
 	if (!is_primary) {
 		/*
 		 * Do not store VY_STMT_DEFERRED_DELETE flag in
@@ -491,6 +499,39 @@ vy_stmt_new_surrogate_delete_from_key(const char *key, struct key_def *cmp_def,
 					      cmp_def, format);
 }
 
+/**
+ * Create a REPLACE or INSERT statement that stores its tuple
+ * in a blob file. The statement has key fields only, with
+ * the blob reference appended to its data.
+ * @sa struct vy_blob_ref.
+ */
+static struct tuple *
+vy_stmt_new_blob_ref(const char *key, enum iproto_type type,
+		     const struct key_def *cmp_def,
+		     struct tuple_format *format,
+		     const struct vy_blob_ref *ref)
+{
+	assert(type == IPROTO_REPLACE || type == IPROTO_INSERT);
+	struct tuple *surrogate = vy_stmt_new_surrogate_from_key(key, type,
+							cmp_def, format);
+	if (surrogate == NULL)
+		return NULL;
+	uint32_t bsize = surrogate->bsize;
+	struct tuple *stmt = vy_stmt_alloc(format, bsize + sizeof(*ref));
+	if (stmt == NULL)
+		goto out;
+	/* Copy both data and field_map. */
+	char *dst = (char *)stmt + sizeof(struct vy_stmt);
+	char *src = (char *)surrogate + sizeof(struct vy_stmt);
+	memcpy(dst, src, format->field_map_size + bsize);
+	memcpy(dst + format->field_map_size + bsize, ref, sizeof(*ref));
+	vy_stmt_set_type(stmt, type);
+	vy_stmt_set_flags(stmt, VY_STMT_BLOB_REF);
+out:
+	tuple_unref(surrogate);
+	return stmt;
+}
+
 struct tuple *
 vy_stmt_new_surrogate_delete_raw(struct tuple_format *format,
 				 const char *src_data, const char *src_data_end)
@@ -652,20 +693,32 @@ vy_stmt_extract_key_raw(const char *data, const char *data_end,
  */
 static int
 vy_stmt_meta_encode(const struct tuple *stmt, struct request *request,
-		    bool is_primary)
+		    bool is_primary, const struct vy_blob_ref *ref)
 {
 	uint8_t flags = vy_stmt_persistent_flags(stmt, is_primary);
-	if (flags == 0)
+	uint32_t map_size = (flags != 0) + (ref != NULL);
+	if (map_size == 0)
 		return 0; /* nothing to encode */
 
-	size_t len = mp_sizeof_map(1) * 2 * mp_sizeof_uint(UINT64_MAX);
+	size_t len = mp_sizeof_map(map_size) + 2 * mp_sizeof_uint(UINT64_MAX) +
+		     mp_sizeof_uint(VY_STMT_BLOB) + mp_sizeof_array(3) +
+		     3 * mp_sizeof_uint(UINT64_MAX);
 	char *buf = region_alloc(&fiber()->gc, len);
 	if (buf == NULL)
 		return -1;
 	char *pos = buf;
-	pos = mp_encode_map(pos, 1);
-	pos = mp_encode_uint(pos, VY_STMT_FLAGS);
-	pos = mp_encode_uint(pos, flags);
+	pos = mp_encode_map(pos, map_size);
+	if (flags != 0) {
+		pos = mp_encode_uint(pos, VY_STMT_FLAGS);
+		pos = mp_encode_uint(pos, flags);
+	}
+	if (ref != NULL) {
+		pos = mp_encode_uint(pos, VY_STMT_BLOB);
+		pos = mp_encode_array(pos, 3);
+		pos = mp_encode_uint(pos, ref->blob_id);
+		pos = mp_encode_uint(pos, ref->offset);
+		pos = mp_encode_uint(pos, ref->size);
+	}
 	assert(pos <= buf + len);
 
 	request->tuple_meta = buf;
@@ -689,7 +742,7 @@ vy_stmt_meta_decode(struct request *request, struct tuple *stmt)
 		switch (key) {
 		case VY_STMT_FLAGS: {
 			uint64_t flags = mp_decode_uint(&data);
-			vy_stmt_set_flags(stmt, flags);
+			vy_stmt_set_flags(stmt, vy_stmt_flags(stmt) | flags);
 			break;
 		}
 		default:
@@ -698,6 +751,37 @@ vy_stmt_meta_decode(struct request *request, struct tuple *stmt)
 	}
 }
 
+/**
+ * Look up a blob reference in statement meta data.
+ * Returns true and fills @ref if found.
+ */
+static bool
+vy_stmt_meta_decode_blob_ref(struct request *request,
+			     struct vy_blob_ref *ref)
+{
+	const char *data = request->tuple_meta;
+	if (data == NULL)
+		return false;
+
+	uint32_t size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < size; i++) {
+		uint64_t key = mp_decode_uint(&data);
+		if (key != VY_STMT_BLOB) {
+			mp_next(&data);
+			continue;
+		}
+		memset(ref, 0, sizeof(*ref));
+		ref->fd = -1;
+		if (mp_decode_array(&data) < 3)
+			return false;
+		ref->blob_id = mp_decode_uint(&data);
+		ref->offset = mp_decode_uint(&data);
+		ref->size = mp_decode_uint(&data);
+		return true;
+	}
+	return false;
+}
+
 int
 vy_stmt_encode_primary(const struct tuple *value, struct key_def *key_def,
 		       uint32_t space_id, struct xrow_header *xrow)
@@ -724,6 +808,7 @@ vy_stmt_encode_primary(const struct tuple *value, struct key_def *key_def,
 		break;
 	case IPROTO_INSERT:
 	case IPROTO_REPLACE:
+		assert(!vy_stmt_is_blob_ref(value));
 		request.tuple = tuple_data_range(value, &size);
 		request.tuple_end = request.tuple + size;
 		break;
@@ -737,7 +822,7 @@ vy_stmt_encode_primary(const struct tuple *value, struct key_def *key_def,
 	default:
 		unreachable();
 	}
-	if (vy_stmt_meta_encode(value, &request, true) != 0)
+	if (vy_stmt_meta_encode(value, &request, true, NULL) != 0)
 		return -1;
 	xrow->bodycnt = xrow_encode_dml(&request, xrow->body);
 	if (xrow->bodycnt < 0)
@@ -769,7 +854,7 @@ vy_stmt_encode_secondary(const struct tuple *value, struct key_def *cmp_def,
 		request.key = extracted;
 		request.key_end = extracted + size;
 	}
-	if (vy_stmt_meta_encode(value, &request, false) != 0)
+	if (vy_stmt_meta_encode(value, &request, false, NULL) != 0)
 		return -1;
 	xrow->bodycnt = xrow_encode_dml(&request, xrow->body);
 	if (xrow->bodycnt < 0)
@@ -778,6 +863,34 @@ vy_stmt_encode_secondary(const struct tuple *value, struct key_def *cmp_def,
 		return 0;
 }
 
+int
+vy_stmt_encode_blob_ref(const struct tuple *value, struct key_def *cmp_def,
+			const struct vy_blob_ref *ref,
+			struct xrow_header *xrow)
+{
+	memset(xrow, 0, sizeof(*xrow));
+	enum iproto_type type = vy_stmt_type(value);
+	assert(type == IPROTO_REPLACE || type == IPROTO_INSERT);
+	xrow->type = type;
+	xrow->lsn = vy_stmt_lsn(value);
+
+	struct request request;
+	memset(&request, 0, sizeof(request));
+	request.type = type;
+	uint32_t size;
+	const char *extracted = tuple_extract_key(value, cmp_def, &size);
+	if (extracted == NULL)
+		return -1;
+	request.tuple = extracted;
+	request.tuple_end = extracted + size;
+	if (vy_stmt_meta_encode(value, &request, true, ref) != 0)
+		return -1;
+	xrow->bodycnt = xrow_encode_dml(&request, xrow->body);
+	if (xrow->bodycnt < 0)
+		return -1;
+	return 0;
+}
+
 struct tuple *
 vy_stmt_decode(struct xrow_header *xrow, const struct key_def *key_def,
 	       struct tuple_format *format, bool is_primary)
@@ -791,6 +904,7 @@ vy_stmt_decode(struct xrow_header *xrow, const struct key_def *key_def,
 	const char *key;
 	(void) key;
 	struct iovec ops;
+	struct vy_blob_ref ref;
 	switch (request.type) {
 	case IPROTO_DELETE:
 		/* extract key */
@@ -800,7 +914,11 @@ vy_stmt_decode(struct xrow_header *xrow, const struct key_def *key_def,
 		break;
 	case IPROTO_INSERT:
 	case IPROTO_REPLACE:
-		if (is_primary) {
+		if (is_primary &&
+		    vy_stmt_meta_decode_blob_ref(&request, &ref)) {
+			stmt = vy_stmt_new_blob_ref(request.tuple, request.type,
+						    key_def, format, &ref);
+		} else if (is_primary) {
 			stmt = vy_stmt_new_with_ops(format, request.tuple,
 						    request.tuple_end,
 						    NULL, 0, request.type);
@@ -850,6 +968,13 @@ vy_stmt_snprint(char *buf, int size, const struct tuple *stmt)
 		SNPRINT(total, mp_snprint, buf, size,
 			vy_stmt_upsert_ops(stmt, &mp_size));
 	}
+	if (vy_stmt_is_blob_ref(stmt)) {
+		const struct vy_blob_ref *ref = vy_stmt_blob_ref(stmt);
+		SNPRINT(total, snprintf, buf, size, ", blob=%lld:%llu:%u",
+			(long long)ref->blob_id,
+			(unsigned long long)ref->offset,
+			(unsigned)ref->size);
+	}
 	SNPRINT(total, snprintf, buf, size, ", lsn=%lld)",
 		(long long) vy_stmt_lsn(stmt));
 	return total;
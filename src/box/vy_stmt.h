@@ -105,11 +105,51 @@ enum {
 	 * compaction. It is never written to disk.
 	 */
 	VY_STMT_UPDATE			= 1 << 2,
+	/**
+	 * This flag is set for REPLACE and INSERT statements read
+	 * from a run that store the tuple in a blob file (see
+	 * index_opts::blob_threshold). Such a statement only has
+	 * key fields, while a reference to the full tuple is
+	 * appended to its data, see struct vy_blob_ref. The flag
+	 * is never written to disk - the reference is stored in
+	 * the statement metadata instead.
+	 */
+	VY_STMT_BLOB_REF		= 1 << 3,
 	/**
 	 * Bit mask of all statement flags.
 	 */
 	VY_STMT_FLAGS_ALL = (VY_STMT_DEFERRED_DELETE | VY_STMT_SKIP_READ |
-			     VY_STMT_UPDATE),
+			     VY_STMT_UPDATE | VY_STMT_BLOB_REF),
+};
+
+/**
+ * Reference to a tuple stored in a blob file.
+ *
+ * Blob files are append-only files that contain MessagePack
+ * tuples written one after another. A blob file is identified
+ * by the ID of the run that created it. Each run that refers
+ * to a blob file has its own hard link to it so that the file
+ * is removed when the last run using it is deleted.
+ */
+struct PACKED vy_blob_ref {
+	/** ID of the blob file. */
+	int64_t blob_id;
+	/** Offset of the tuple in the blob file. */
+	uint64_t offset;
+	/** Size of the tuple. */
+	uint32_t size;
+	/*
+	 * The members below aren't stored on disk. They are
+	 * filled in when the statement is read from a run.
+	 */
+	/** ID of the run the statement was read from. */
+	int64_t run_id;
+	/** Descriptor of the blob file, owned by the run. */
+	int fd;
+	/** Size of the blob file. */
+	uint64_t blob_size;
+	/** Number of bytes of the blob file used by the run. */
+	uint64_t run_bytes;
 };
 
 /**
@@ -219,6 +259,27 @@ vy_stmt_set_n_upserts(struct tuple *stmt, uint8_t n)
 	*((uint8_t *)stmt - 1) = n;
 }
 
+/** Return true if the statement refers to a blob file. */
+static inline bool
+vy_stmt_is_blob_ref(const struct tuple *stmt)
+{
+	return (vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) != 0;
+}
+
+/**
+ * Return the blob reference stored in a statement.
+ * The statement must be flagged with VY_STMT_BLOB_REF.
+ */
+static inline struct vy_blob_ref *
+vy_stmt_blob_ref(const struct tuple *stmt)
+{
+	assert(vy_stmt_is_blob_ref(stmt));
+	assert(stmt->bsize > sizeof(struct vy_blob_ref));
+	return (struct vy_blob_ref *)((char *)tuple_data(stmt) +
+				      stmt->bsize -
+				      sizeof(struct vy_blob_ref));
+}
+
 /**
  * Duplicate the statememnt.
  *
@@ -644,9 +705,30 @@ int
 vy_stmt_encode_secondary(const struct tuple *value, struct key_def *cmp_def,
 			 struct xrow_header *xrow);
 
+/**
+ * Encode a REPLACE or INSERT statement whose tuple is stored
+ * in a blob file as xrow_header. Only key parts are written
+ * to the xrow, with the blob reference stored in the metadata.
+ *
+ * @param value statement to encode
+ * @param cmp_def key definition, including primary key parts
+ * @param ref reference to the tuple in a blob file
+ * @param xrow[out] xrow to fill
+ *
+ * @retval 0 if OK
+ * @retval -1 if error
+ */
+int
+vy_stmt_encode_blob_ref(const struct tuple *value, struct key_def *cmp_def,
+			const struct vy_blob_ref *ref,
+			struct xrow_header *xrow);
+
 /**
  * Reconstruct vinyl tuple info and data from xrow
  *
+ * If the xrow refers to a blob file, the statement returned
+ * is flagged with VY_STMT_BLOB_REF and carries key parts only.
+ *
  * @retval stmt on success
  * @retval NULL on error
  */
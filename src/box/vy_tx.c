@@ -657,8 +657,12 @@ vy_tx_prepare(struct vy_tx *tx)
 		if (v->is_overwritten)
 			continue;
 
-		/* Skip statements which don't change this secondary key. */
-		if (lsm->index_id > 0 &&
+		/*
+		 * Skip statements which don't change this secondary
+		 * key. A covering index stores all fields so it must
+		 * see every change.
+		 */
+		if (!vy_lsm_is_covering(lsm) &&
 		    key_update_can_be_skipped(lsm->key_def->column_mask,
 					      v->column_mask))
 			continue;
@@ -1019,7 +1023,8 @@ vy_tx_set_with_colmask(struct vy_tx *tx, struct vy_lsm *lsm,
 		v->column_mask |= old->column_mask;
 	}
 
-	if (lsm->index_id > 0 && vy_stmt_type(stmt) == IPROTO_REPLACE &&
+	if (!vy_lsm_is_covering(lsm) &&
+	    vy_stmt_type(stmt) == IPROTO_REPLACE &&
 	    old != NULL && vy_stmt_type(old->stmt) == IPROTO_DELETE) {
 		/*
 		 * The column mask of an update operation may have a bit
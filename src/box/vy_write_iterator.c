@@ -173,13 +173,22 @@ struct vy_write_iterator {
 	/* There is no LSM tree level older than the one we're writing to. */
 	bool is_last_level;
 	/**
-	 * Set if this iterator is for a primary index.
-	 * Not all implementation are applicable to the primary
-	 * key and its tuple format is different.
+	 * Set if this iterator is for a primary index or
+	 * a covering secondary index. Not all implementation
+	 * are applicable to such indexes and their tuple
+	 * format is different.
 	 */
 	bool is_primary;
 	/** Deferred DELETE handler. */
 	struct vy_deferred_delete_handler *deferred_delete_handler;
+	/** Set if expired tuples should be dropped. */
+	bool is_expiration_enabled;
+	/** Number of the field storing tuple expiration time. */
+	uint32_t ttl_fieldno;
+	/** Tuples expired by this time are dropped. */
+	double expiration_time;
+	/** Set if dropped tuples must be deleted from secondary indexes. */
+	bool need_expiration_deferred_delete;
 	/**
 	 * Last scanned REPLACE or DELETE statement that was
 	 * inserted into the primary index without deletion
@@ -384,6 +393,21 @@ vy_write_iterator_new(struct key_def *cmp_def, struct tuple_format *format,
 	return &stream->base;
 }
 
+void
+vy_write_iterator_set_expiration(struct vy_stmt_stream *vstream,
+				 uint32_t fieldno, double now,
+				 bool need_deferred_delete)
+{
+	assert(vstream->iface == &vy_slice_stream_iface);
+	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	assert(stream->is_primary && stream->is_last_level);
+	assert(!need_deferred_delete || stream->deferred_delete_handler != NULL);
+	stream->is_expiration_enabled = true;
+	stream->ttl_fieldno = fieldno;
+	stream->expiration_time = now;
+	stream->need_expiration_deferred_delete = need_deferred_delete;
+}
+
 /**
  * Start the search. Must be called after *new* methods and
  * before *next* method.
@@ -450,14 +474,14 @@ vy_write_iterator_close(struct vy_stmt_stream *vstream)
  * @return 0 on success or -1 on error (diag is set).
  */
 NODISCARD int
-vy_write_iterator_new_mem(struct vy_stmt_stream *vstream, struct vy_mem *mem)
+vy_write_iterator_new_mem(struct vy_stmt_stream *vstream, struct vy_mem *mem,
+			  const struct tuple *begin, const struct tuple *end)
 {
 	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
 	struct vy_write_src *src = vy_write_iterator_new_src(stream);
 	if (src == NULL)
 		return -1;
-	vy_mem_stream_open(&src->mem_stream, mem);
-	return 0;
+	return vy_mem_stream_open(&src->mem_stream, mem, begin, end);
 }
 
 /**
@@ -604,10 +628,24 @@ vy_write_iterator_deferred_delete(struct vy_write_iterator *stream,
 	if (stream->deferred_delete_stmt != NULL) {
 		struct vy_deferred_delete_handler *handler =
 				stream->deferred_delete_handler;
-		if (handler != NULL && vy_stmt_type(stmt) != IPROTO_DELETE &&
-		    handler->iface->process(handler, stmt,
-					    stream->deferred_delete_stmt) != 0)
-			return -1;
+		if (handler != NULL && vy_stmt_type(stmt) != IPROTO_DELETE) {
+			/*
+			 * Secondary key parts of the overwritten
+			 * tuple are needed to generate a DELETE.
+			 */
+			struct tuple *old_stmt = stmt;
+			if (vy_stmt_is_blob_ref(stmt)) {
+				old_stmt = vy_stmt_load_blob(stmt, false);
+				if (old_stmt == NULL)
+					return -1;
+			}
+			int rc = handler->iface->process(handler, old_stmt,
+						stream->deferred_delete_stmt);
+			if (old_stmt != stmt)
+				tuple_unref(old_stmt);
+			if (rc != 0)
+				return -1;
+		}
 		vy_stmt_unref_if_possible(stream->deferred_delete_stmt);
 		stream->deferred_delete_stmt = NULL;
 	}
@@ -841,8 +879,17 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct tuple *hint,
 	     vy_stmt_type(hint) != IPROTO_UPSERT))) {
 		assert(!stream->is_last_level || hint == NULL ||
 		       vy_stmt_type(hint) != IPROTO_UPSERT);
-		struct tuple *applied = vy_apply_upsert(h->tuple, hint,
+		/* UPSERT must be applied to the full tuple. */
+		struct tuple *base = hint;
+		if (hint != NULL && vy_stmt_is_blob_ref(hint)) {
+			base = vy_stmt_load_blob(hint, false);
+			if (base == NULL)
+				return -1;
+		}
+		struct tuple *applied = vy_apply_upsert(h->tuple, base,
 				stream->cmp_def, stream->format, false);
+		if (base != hint)
+			tuple_unref(base);
 		if (applied == NULL)
 			return -1;
 		vy_stmt_unref_if_possible(h->tuple);
@@ -851,6 +898,13 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct tuple *hint,
 	/* Squash the rest of UPSERTs. */
 	struct vy_write_history *result = h;
 	h = h->next;
+	if (h != NULL && vy_stmt_is_blob_ref(result->tuple)) {
+		struct tuple *full = vy_stmt_load_blob(result->tuple, false);
+		if (full == NULL)
+			return -1;
+		vy_stmt_unref_if_possible(result->tuple);
+		result->tuple = full;
+	}
 	while (h != NULL) {
 		assert(h->tuple != NULL &&
 		       vy_stmt_type(h->tuple) == IPROTO_UPSERT);
@@ -933,6 +987,61 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct tuple *hint,
 	return 0;
 }
 
+/**
+ * Check if a statement stores a tuple that has expired,
+ * see vy_write_iterator_set_expiration(). If it has, generate
+ * a deferred DELETE for it if required.
+ *
+ * @retval  0 Success, @is_expired is set.
+ * @retval -1 Error loading the tuple from a blob file or
+ *            generating a deferred DELETE.
+ */
+static int
+vy_write_iterator_check_expired(struct vy_write_iterator *stream,
+				struct tuple *stmt, bool *is_expired)
+{
+	*is_expired = false;
+	if (vy_stmt_type(stmt) != IPROTO_REPLACE &&
+	    vy_stmt_type(stmt) != IPROTO_INSERT)
+		return 0;
+	/* A blob reference carries key fields only. */
+	struct tuple *full = stmt;
+	if (vy_stmt_is_blob_ref(stmt)) {
+		full = vy_stmt_load_blob(stmt, false);
+		if (full == NULL)
+			return -1;
+	}
+	int rc = 0;
+	const char *field = tuple_field(full, stream->ttl_fieldno);
+	double value;
+	*is_expired = field != NULL && mp_read_double(&field, &value) == 0 &&
+		      value <= stream->expiration_time;
+	if (*is_expired && stream->need_expiration_deferred_delete) {
+		/*
+		 * The DELETE gets the LSN following the one of
+		 * the expired tuple so that it purges the tuple
+		 * from secondary indexes, but not a newer REPLACE
+		 * of the same key, because a deferred DELETE loses
+		 * to a REPLACE with the same LSN, see heap_less().
+		 * Only its LSN is used, so key fields will do.
+		 */
+		struct tuple *delete =
+			vy_stmt_new_surrogate_delete(stream->format, full);
+		if (delete != NULL) {
+			vy_stmt_set_lsn(delete, vy_stmt_lsn(stmt) + 1);
+			struct vy_deferred_delete_handler *handler =
+					stream->deferred_delete_handler;
+			rc = handler->iface->process(handler, full, delete);
+			tuple_unref(delete);
+		} else {
+			rc = -1;
+		}
+	}
+	if (full != stmt)
+		tuple_unref(full);
+	return rc;
+}
+
 /**
  * Split the current key into a sequence of read view
  * statements. @sa struct vy_write_iterator comment for details
@@ -985,6 +1094,21 @@ vy_write_iterator_build_read_views(struct vy_write_iterator *stream, int *count)
 		++*count;
 		hint = rv->tuple;
 	}
+	/* Optimization 6: drop an expired tuple. */
+	if (stream->is_expiration_enabled && *count == 1 &&
+	    stream->read_views[0].tuple != NULL) {
+		bool is_expired;
+		if (vy_write_iterator_check_expired(stream,
+				stream->read_views[0].tuple,
+				&is_expired) != 0)
+			goto error;
+		if (is_expired) {
+			vy_stmt_unref_if_possible(stream->read_views[0].tuple);
+			stream->read_views[0].tuple = NULL;
+			stream->rv_used_count = 0;
+			*count = 0;
+		}
+	}
 	region_truncate(region, used);
 	return 0;
 error:
@@ -190,6 +190,18 @@
  * also turn the first INSERT in the resulting key's history to a
  * REPLACE in case the oldest statement among all sources is not
  * an INSERT.
+ *
+ * ---------------------------------------------------------------
+ * Optimization #6: when merging the last level of the primary
+ * LSM tree of a space with a TTL field, drop a key if its only
+ * version is a REPLACE or INSERT that has expired and isn't
+ * visible to any open read view (see
+ * vy_write_iterator_set_expiration()). There is no older version
+ * of the key that could show through, so this is equivalent to
+ * a DELETE purged by optimization #1. Secondary indexes don't
+ * store expiration time, so the dropped tuple is passed to the
+ * deferred DELETE handler, which generates DELETEs for them,
+ * just like for an overwritten tuple.
  */
 
 struct vy_write_iterator;
@@ -240,7 +252,8 @@ struct vy_deferred_delete_handler {
  * use vy_write_iterator_add_* functions.
  * @param cmp_def - key definition for tuple compare.
  * @param format - dormat to allocate new REPLACE and DELETE tuples from vy_run.
- * @param LSM tree is_primary - set if this iterator is for a primary index.
+ * @param LSM tree is_primary - set if this iterator is for a primary index
+ * or a covering secondary index, which stores full tuples.
  * @param is_last_level - there is no older level than the one we're writing to.
  * @param read_views - Opened read views.
  * @param handler - Deferred DELETE handler or NULL if no deferred DELETEs is
@@ -255,11 +268,25 @@ vy_write_iterator_new(struct key_def *cmp_def, struct tuple_format *format,
 		      struct vy_deferred_delete_handler *handler);
 
 /**
- * Add a mem as a source to the iterator.
+ * Make the iterator drop tuples that expired by @now, i.e. store
+ * a number less than or equal to @now in field @fieldno. Must be
+ * called before the iteration is started and only for the last
+ * level of a primary index. If @need_deferred_delete is set, a
+ * deferred DELETE is generated for each dropped tuple.
+ */
+void
+vy_write_iterator_set_expiration(struct vy_stmt_stream *stream,
+				 uint32_t fieldno, double now,
+				 bool need_deferred_delete);
+
+/**
+ * Add a mem as a source to the iterator. Only statements within
+ * [@begin, @end) are fed to the iterator, NULL means unbounded.
  * @return 0 on success, -1 on error (diag is set).
  */
 NODISCARD int
-vy_write_iterator_new_mem(struct vy_stmt_stream *stream, struct vy_mem *mem);
+vy_write_iterator_new_mem(struct vy_stmt_stream *stream, struct vy_mem *mem,
+			  const struct tuple *begin, const struct tuple *end);
 
 /**
  * Add a run slice as a source to the iterator.
@@ -32,6 +32,7 @@
 
 #include "vclock.h"
 #include "fiber.h"
+#include "fiber_cond.h"
 #include "fio.h"
 #include "errinj.h"
 #include "error.h"
@@ -54,8 +55,17 @@ enum {
 	 * latency. 1 MB seems to be a well balanced choice.
 	 */
 	WAL_FALLOCATE_LEN = 1024 * 1024,
+	/**
+	 * Max size of disk space to preallocate for the spare
+	 * WAL file, see wal_spare_f(). The actual size is also
+	 * limited by wal_max_size.
+	 */
+	WAL_SPARE_LEN = 16 * WAL_FALLOCATE_LEN,
 };
 
+/** Name of the spare WAL file, relative to wal_dir. */
+static const char wal_spare_name[] = "xlog.spare";
+
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
 
 int wal_dir_lock = -1;
@@ -142,6 +152,23 @@ struct wal_writer
 	bool checkpoint_triggered;
 	/** The current WAL file. */
 	struct xlog current_wal;
+	/**
+	 * Path to the spare WAL file. To take file creation and
+	 * disk space allocation off the write path, an empty WAL
+	 * file with some disk space preallocated is created in
+	 * background so that WAL rotation only needs to write
+	 * the header to it and rename it.
+	 */
+	char spare_path[PATH_MAX];
+	/**
+	 * Size of disk space preallocated for the spare WAL
+	 * file or 0 if the spare file isn't ready yet.
+	 */
+	size_t spare_size;
+	/** Fiber that creates the spare WAL file. */
+	struct fiber *spare_fiber;
+	/** Signaled when the spare WAL file is used up. */
+	struct fiber_cond spare_cond;
 	/**
 	 * Used if there was a WAL I/O error and we need to
 	 * keep adding all incoming requests to the rollback
@@ -355,6 +382,11 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid);
 	xlog_clear(&writer->current_wal);
+	snprintf(writer->spare_path, sizeof(writer->spare_path), "%s/%s",
+		 wal_dirname, wal_spare_name);
+	writer->spare_size = 0;
+	writer->spare_fiber = NULL;
+	fiber_cond_create(&writer->spare_cond);
 	if (wal_mode == WAL_FSYNC)
 		writer->wal_dir.open_wflags |= O_SYNC;
 
@@ -378,6 +410,7 @@ static void
 wal_writer_destroy(struct wal_writer *writer)
 {
 	xdir_destroy(&writer->wal_dir);
+	fiber_cond_destroy(&writer->spare_cond);
 }
 
 /** WAL writer thread routine. */
@@ -740,8 +773,21 @@ wal_opt_rotate(struct wal_writer *writer)
 	if (xlog_is_open(&writer->current_wal))
 		return 0;
 
-	if (xdir_create_xlog(&writer->wal_dir, &writer->current_wal,
-			     &writer->vclock) != 0) {
+	int rc;
+	if (writer->spare_size > 0) {
+		rc = xdir_create_xlog_from_spare(&writer->wal_dir,
+						 &writer->current_wal,
+						 &writer->vclock,
+						 writer->spare_path,
+						 writer->spare_size);
+		/* Prepare a new spare file for the next rotation. */
+		writer->spare_size = 0;
+		fiber_cond_signal(&writer->spare_cond);
+	} else {
+		rc = xdir_create_xlog(&writer->wal_dir, &writer->current_wal,
+				      &writer->vclock);
+	}
+	if (rc != 0) {
 		diag_log();
 		return -1;
 	}
@@ -796,6 +842,17 @@ retry:
 	}
 	if (errno != ENOSPC)
 		goto error;
+	if (writer->spare_size > 0) {
+		/*
+		 * Release disk space reserved for the next WAL
+		 * before deleting any files needed by consumers.
+		 * The spare file won't be recreated until the
+		 * next rotation.
+		 */
+		unlink(writer->spare_path);
+		writer->spare_size = 0;
+		goto retry;
+	}
 	if (!xdir_has_garbage(&writer->wal_dir, gc_lsn))
 		goto error;
 
@@ -1063,6 +1120,38 @@ done:
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
 
+static ssize_t
+wal_create_spare_cb(va_list ap)
+{
+	const char *path = va_arg(ap, const char *);
+	size_t size = va_arg(ap, size_t);
+	return xlog_create_spare(path, size);
+}
+
+/**
+ * Background fiber that keeps the spare WAL file ready for
+ * the next rotation. The file is created and preallocated in
+ * a coio thread so as not to stall WAL writes.
+ */
+static int
+wal_spare_f(va_list ap)
+{
+	struct wal_writer *writer = va_arg(ap, struct wal_writer *);
+	while (!fiber_is_cancelled()) {
+		if (writer->spare_size == 0) {
+			size_t size = MIN(writer->wal_max_size,
+					  (int64_t)WAL_SPARE_LEN);
+			if (coio_call(wal_create_spare_cb,
+				      writer->spare_path, size) == 0)
+				writer->spare_size = size;
+			else
+				diag_log(); /* retry on the next rotation */
+		}
+		fiber_cond_wait(&writer->spare_cond);
+	}
+	return 0;
+}
+
 /** WAL writer main loop.  */
 static int
 wal_writer_f(va_list ap)
@@ -1073,6 +1162,17 @@ wal_writer_f(va_list ap)
 	/** Initialize eio in this thread */
 	coio_enable();
 
+	if (writer->wal_mode != WAL_NONE) {
+		writer->spare_fiber = fiber_new("wal_spare", wal_spare_f);
+		if (writer->spare_fiber != NULL) {
+			fiber_set_joinable(writer->spare_fiber, true);
+			fiber_start(writer->spare_fiber, writer);
+		} else {
+			/* Not critical, proceed without it. */
+			diag_log();
+		}
+	}
+
 	struct cbus_endpoint endpoint;
 	cbus_endpoint_create(&endpoint, "wal", fiber_schedule_cb, fiber());
 	/*
@@ -1084,6 +1184,16 @@ wal_writer_f(va_list ap)
 
 	cbus_loop(&endpoint);
 
+	if (writer->spare_fiber != NULL) {
+		fiber_cancel(writer->spare_fiber);
+		fiber_join(writer->spare_fiber);
+		writer->spare_fiber = NULL;
+	}
+	if (writer->spare_size > 0) {
+		unlink(writer->spare_path);
+		writer->spare_size = 0;
+	}
+
 	/*
 	 * Create a new empty WAL on shutdown so that we don't
 	 * have to rescan the last WAL to find the instance vclock.
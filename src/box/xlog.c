@@ -91,15 +91,6 @@ enum {
 
 /* {{{ struct xlog_meta */
 
-enum {
-	/*
-	 * The maximum length of xlog meta
-	 *
-	 * @sa xlog_meta_parse()
-	 */
-	XLOG_META_LEN_MAX = 1024 + VCLOCK_STR_LEN_MAX
-};
-
 #define INSTANCE_UUID_KEY "Instance"
 #define INSTANCE_UUID_KEY_V12 "Server"
 #define VCLOCK_KEY "VClock"
@@ -313,6 +304,30 @@ xlog_meta_parse(struct xlog_meta *meta, const char **data,
 	return 0;
 }
 
+int
+xlog_meta_set_instance_uuid(char *data, const char *data_end,
+			    const struct tt_uuid *instance_uuid)
+{
+	struct xlog_meta meta;
+	const char *end = data;
+	ssize_t rc = xlog_meta_parse(&meta, &end, data_end);
+	if (rc > 0)
+		diag_set(XlogError, "xlog meta is truncated");
+	if (rc != 0)
+		return -1;
+	static const char key[] = "\n" INSTANCE_UUID_KEY ": ";
+	char *val = (char *)memmem(data, end - data, key, strlen(key));
+	if (val == NULL) {
+		diag_set(XlogError, "xlog meta has no instance UUID");
+		return -1;
+	}
+	val += strlen(key);
+	/* The text form of a UUID has a fixed length. */
+	assert(val + UUID_STR_LEN < end && val[UUID_STR_LEN] == '\n');
+	memcpy(val, tt_uuid_str(instance_uuid), UUID_STR_LEN);
+	return 0;
+}
+
 /* struct xlog }}} */
 
 /* {{{ struct xdir */
@@ -797,9 +812,18 @@ xlog_destroy(struct xlog *xlog)
 	xlog->fd = -1;
 }
 
-int
-xlog_create(struct xlog *xlog, const char *name, int flags,
-	    const struct xlog_meta *meta)
+/**
+ * Create a new xlog file. If @spare is not NULL, try to take
+ * over the given spare file, which is supposed to have been
+ * created with xlog_create_spare() and have @spare_size bytes
+ * of disk space preallocated, instead of creating a new file.
+ * Fall back on creating a new file if the spare file can't be
+ * used for some reason.
+ */
+static int
+xlog_create_impl(struct xlog *xlog, const char *name, int flags,
+		 const struct xlog_meta *meta, const char *spare,
+		 size_t spare_size)
 {
 	char meta_buf[XLOG_META_LEN_MAX];
 	int meta_len;
@@ -833,7 +857,26 @@ xlog_create(struct xlog *xlog, const char *name, int flags,
 	 * may think that this is a corrupt file and stop
 	 * replication.
 	 */
-	xlog->fd = open(xlog->filename, flags, 0644);
+	xlog->fd = -1;
+	if (spare != NULL) {
+		/*
+		 * The spare file is empty so it's safe to
+		 * rename it to .inprogress: readers will
+		 * never see it as a valid xlog.
+		 */
+		if (rename(spare, xlog->filename) == 0) {
+			xlog->fd = open(xlog->filename,
+					flags & ~(O_CREAT | O_EXCL));
+			if (xlog->fd < 0)
+				unlink(xlog->filename);
+		}
+		if (xlog->fd < 0) {
+			say_syserror("failed to use spare file '%s'", spare);
+			spare_size = 0;
+		}
+	}
+	if (xlog->fd < 0)
+		xlog->fd = open(xlog->filename, flags, 0644);
 	if (xlog->fd < 0) {
 		say_syserror("open, [%s]", xlog->filename);
 		diag_set(SystemError, "failed to create file '%s'",
@@ -856,6 +899,8 @@ xlog_create(struct xlog *xlog, const char *name, int flags,
 	}
 
 	xlog->offset = meta_len; /* first log starts after meta */
+	if (spare_size > (size_t)meta_len)
+		xlog->allocated = spare_size - meta_len;
 	return 0;
 err_write:
 	close(xlog->fd);
@@ -866,6 +911,49 @@ err:
 	return -1;
 }
 
+int
+xlog_create(struct xlog *xlog, const char *name, int flags,
+	    const struct xlog_meta *meta)
+{
+	return xlog_create_impl(xlog, name, flags, meta, NULL, 0);
+}
+
+int
+xlog_create_spare(const char *name, size_t size)
+{
+	/*
+	 * Don't use the .inprogress suffix: such files are
+	 * removed on recovery, which may run concurrently.
+	 */
+	char tmp[PATH_MAX];
+	snprintf(tmp, sizeof(tmp), "%s.tmp", name);
+	int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to create file '%s'", tmp);
+		return -1;
+	}
+#ifdef HAVE_FALLOCATE
+	/* See the comment in xlog_fallocate(). */
+	if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, size) != 0 &&
+	    errno != ENOSYS && errno != EOPNOTSUPP) {
+		diag_set(SystemError, "%s: can't allocate disk space", tmp);
+		goto err;
+	}
+#else
+	(void)size;
+#endif /* HAVE_FALLOCATE */
+	if (rename(tmp, name) != 0) {
+		diag_set(SystemError, "failed to rename '%s' file", tmp);
+		goto err;
+	}
+	close(fd);
+	return 0;
+err:
+	close(fd);
+	unlink(tmp);
+	return -1;
+}
+
 int
 xlog_open(struct xlog *xlog, const char *name)
 {
@@ -965,10 +1053,6 @@ int
 xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 		 const struct vclock *vclock)
 {
-	int64_t signature = vclock_sum(vclock);
-	assert(signature >= 0);
-	assert(!tt_uuid_is_nil(dir->instance_uuid));
-
 	/*
 	 * For WAL dir: store vclock of the previous xlog file
 	 * to check for gaps on recovery.
@@ -977,12 +1061,26 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	if (dir->type == XLOG && !vclockset_empty(&dir->index))
 		prev_vclock = vclockset_last(&dir->index);
 
+	return xdir_create_xlog_with_prev(dir, xlog, vclock, prev_vclock);
+}
+
+static int
+xdir_create_xlog_impl(struct xdir *dir, struct xlog *xlog,
+		      const struct vclock *vclock,
+		      const struct vclock *prev_vclock,
+		      const char *spare, size_t spare_size)
+{
+	int64_t signature = vclock_sum(vclock);
+	assert(signature >= 0);
+	assert(!tt_uuid_is_nil(dir->instance_uuid));
+
 	struct xlog_meta meta;
 	xlog_meta_create(&meta, dir->filetype, dir->instance_uuid,
 			 vclock, prev_vclock);
 
 	char *filename = xdir_format_filename(dir, signature, NONE);
-	if (xlog_create(xlog, filename, dir->open_wflags, &meta) != 0)
+	if (xlog_create_impl(xlog, filename, dir->open_wflags, &meta,
+			     spare, spare_size) != 0)
 		return -1;
 
 	/* Inherit xdir settings. */
@@ -1004,6 +1102,28 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	return 0;
 }
 
+int
+xdir_create_xlog_with_prev(struct xdir *dir, struct xlog *xlog,
+			   const struct vclock *vclock,
+			   const struct vclock *prev_vclock)
+{
+	return xdir_create_xlog_impl(dir, xlog, vclock, prev_vclock,
+				     NULL, 0);
+}
+
+int
+xdir_create_xlog_from_spare(struct xdir *dir, struct xlog *xlog,
+			    const struct vclock *vclock,
+			    const char *spare, size_t spare_size)
+{
+	const struct vclock *prev_vclock = NULL;
+	if (dir->type == XLOG && !vclockset_empty(&dir->index))
+		prev_vclock = vclockset_last(&dir->index);
+
+	return xdir_create_xlog_impl(dir, xlog, vclock, prev_vclock,
+				     spare, spare_size);
+}
+
 ssize_t
 xlog_fallocate(struct xlog *log, size_t len)
 {
@@ -1496,7 +1616,11 @@ xlog_atfork(struct xlog *xlog)
 
 /* {{{ struct xlog_cursor */
 
-#define XLOG_READ_AHEAD		(1 << 14)
+/*
+ * Read files in big chunks: xlog files are read sequentially,
+ * and a bigger chunk means fewer system calls per transaction.
+ */
+#define XLOG_READ_AHEAD		(1 << 17)
 
 /**
  * Ensure that at least count bytes are in read buffer
@@ -1954,6 +2078,17 @@ xlog_cursor_openfd(struct xlog_cursor *i, int fd, const char *name)
 	i->fd = fd;
 	ibuf_create(&i->rbuf, &cord()->slabc,
 		    XLOG_TX_AUTOCOMMIT_THRESHOLD << 1);
+#ifdef HAVE_POSIX_FADVISE
+	/*
+	 * Let the kernel know that the file is going to be read
+	 * sequentially so that it reads ahead more aggressively.
+	 */
+	int err = posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	if (err != 0) {
+		/* posix_fadvise() returns an error, errno isn't set. */
+		say_error("posix_fadvise, fd=%i: %s", fd, strerror(err));
+	}
+#endif /* HAVE_POSIX_FADVISE */
 
 	ssize_t rc;
 	/*
@@ -260,6 +260,15 @@ xdir_add_vclock(struct xdir *xdir, const struct vclock *vclock);
 
 /* {{{ xlog meta */
 
+enum {
+	/*
+	 * The maximum length of xlog meta
+	 *
+	 * @sa xlog_meta_parse()
+	 */
+	XLOG_META_LEN_MAX = 1024 + VCLOCK_STR_LEN_MAX
+};
+
 /**
  * A xlog meta info
  */
@@ -300,6 +309,21 @@ xlog_meta_create(struct xlog_meta *meta, const char *filetype,
 		 const struct vclock *vclock,
 		 const struct vclock *prev_vclock);
 
+/**
+ * Overwrite the instance UUID stored in the meta of an xlog
+ * file, e.g. when the file is copied from another instance.
+ *
+ * @param data Beginning of the file.
+ * @param data_end End of the data, at least the whole meta.
+ * @param instance_uuid UUID to store.
+ *
+ * @retval  0 Success.
+ * @retval -1 Meta is invalid or doesn't fit in @a data.
+ */
+int
+xlog_meta_set_instance_uuid(char *data, const char *data_end,
+			    const struct tt_uuid *instance_uuid);
+
 /* }}} */
 
 /**
@@ -418,6 +442,45 @@ int
 xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 		 const struct vclock *vclock);
 
+/**
+ * Same as xdir_create_xlog(), but store the given @prev_vclock
+ * in the file meta rather than the vclock of the last file in
+ * the directory. Used by memtx to refer a delta snapshot to the
+ * base snapshot it was made against.
+ */
+int
+xdir_create_xlog_with_prev(struct xdir *dir, struct xlog *xlog,
+			   const struct vclock *vclock,
+			   const struct vclock *prev_vclock);
+
+/**
+ * Same as xdir_create_xlog(), but try to take over the given
+ * spare file created with xlog_create_spare() instead of
+ * creating a new file. The first @spare_size bytes of the spare
+ * file are supposed to be preallocated so that the writer can
+ * append that much data without calling xlog_fallocate().
+ * If the spare file can't be used, a new file is created.
+ */
+int
+xdir_create_xlog_from_spare(struct xdir *dir, struct xlog *xlog,
+			    const struct vclock *vclock,
+			    const char *spare, size_t spare_size);
+
+/**
+ * Create an empty file that can later be turned into a new
+ * xlog with xdir_create_xlog_from_spare() and preallocate
+ * @size bytes of disk space for it. The file size is left
+ * zero so that the file is never mistaken for a valid xlog.
+ * The file is prepared under a temporary name and renamed when
+ * ready so that it never shows up half-allocated. If the file
+ * already exists, it is replaced.
+ *
+ * @retval 0 for success
+ * @retval -1 if error
+ */
+int
+xlog_create_spare(const char *name, size_t size);
+
 /**
  * Create new xlog writer based on fd.
  * @param fd            file descriptor
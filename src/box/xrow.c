@@ -502,11 +502,20 @@ iproto_prepare_header(struct obuf *buf, struct obuf_svp *svp, size_t size)
 void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t schema_version, uint32_t count)
+{
+	iproto_reply_select_with_tail(buf, svp, sync, schema_version,
+				      count, 0);
+}
+
+void
+iproto_reply_select_with_tail(struct obuf *buf, struct obuf_svp *svp,
+			      uint64_t sync, uint32_t schema_version,
+			      uint32_t count, size_t tail_size)
 {
 	char *pos = (char *) obuf_svp_to_ptr(buf, svp);
 	iproto_header_encode(pos, IPROTO_OK, sync, schema_version,
 			        obuf_size(buf) - svp->used -
-				IPROTO_HEADER_LEN);
+				IPROTO_HEADER_LEN + tail_size);
 
 	struct iproto_body_bin body = iproto_body_bin;
 	body.v_data_len = mp_bswap_u32(count);
@@ -868,6 +877,104 @@ error:
 	return 0;
 }
 
+int
+xrow_decode_batch(const struct xrow_header *row,
+		  struct batch_request *request)
+{
+	if (row->bodycnt == 0) {
+		diag_set(ClientError, ER_INVALID_MSGPACK,
+			 "missing request body");
+		return -1;
+	}
+
+	assert(row->bodycnt == 1);
+	const char *data = (const char *) row->body[0].iov_base;
+	const char *end = data + row->body[0].iov_len;
+	assert((end - data) > 0);
+
+	if (mp_typeof(*data) != MP_MAP || mp_check_map(data, end) > 0) {
+error:
+		diag_set(ClientError, ER_INVALID_MSGPACK, "packet body");
+		return -1;
+	}
+
+	memset(request, 0, sizeof(*request));
+	request->header = row;
+
+	uint32_t map_size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		if ((end - data) < 1 || mp_typeof(*data) != MP_UINT)
+			goto error;
+
+		uint64_t key = mp_decode_uint(&data);
+		const char *value = data;
+		if (mp_check(&data, end) != 0)
+			goto error;
+
+		switch (key) {
+		case IPROTO_REQUESTS:
+			if (mp_typeof(*value) != MP_ARRAY)
+				goto error;
+			request->requests = value;
+			request->requests_end = data;
+			break;
+		default:
+			continue; /* unknown key */
+		}
+	}
+	if (data != end) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "packet end");
+		return -1;
+	}
+	if (request->requests == NULL) {
+		diag_set(ClientError, ER_MISSING_REQUEST_FIELD,
+			 iproto_key_name(IPROTO_REQUESTS));
+		return -1;
+	}
+	/* Check the structure of batched requests. */
+	data = request->requests;
+	request->request_count = mp_decode_array(&data);
+	for (uint32_t i = 0; i < request->request_count; i++) {
+		if (mp_typeof(*data) != MP_ARRAY ||
+		    mp_decode_array(&data) != 2 ||
+		    mp_typeof(*data) != MP_UINT)
+			goto error;
+		uint64_t type = mp_decode_uint(&data);
+		if (mp_typeof(*data) != MP_MAP)
+			goto error;
+		mp_next(&data);
+		if (type == IPROTO_SELECT || type == IPROTO_NOP ||
+		    !iproto_type_is_dml(type)) {
+			diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+				 (uint32_t) type);
+			return -1;
+		}
+	}
+	assert(data == request->requests_end);
+	return 0;
+}
+
+int
+xrow_decode_batch_item(const char **pos, const char *end,
+		       struct xrow_header *row, struct request *request)
+{
+	const char *data = *pos;
+	assert(data < end);
+	uint32_t size = mp_decode_array(&data);
+	assert(size == 2);
+	(void) size;
+	memset(row, 0, sizeof(*row));
+	row->type = mp_decode_uint(&data);
+	row->bodycnt = 1;
+	row->body[0].iov_base = (void *) data;
+	mp_next(&data);
+	assert(data <= end);
+	(void) end;
+	row->body[0].iov_len = data - (const char *) row->body[0].iov_base;
+	*pos = data;
+	return xrow_decode_dml(row, request, dml_request_key_map(row->type));
+}
+
 int
 xrow_decode_auth(const struct xrow_header *row, struct auth_request *request)
 {
@@ -1084,7 +1191,7 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock)
+		      const struct vclock *vclock, uint32_t compression)
 {
 	memset(row, 0, sizeof(*row));
 	size_t size = XROW_BODY_LEN_MAX + mp_sizeof_vclock(vclock);
@@ -1094,7 +1201,7 @@ xrow_encode_subscribe(struct xrow_header *row,
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 4);
+	data = mp_encode_map(data, compression != 0 ? 5 : 4);
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
@@ -1103,6 +1210,10 @@ xrow_encode_subscribe(struct xrow_header *row,
 	data = mp_encode_vclock(data, vclock);
 	data = mp_encode_uint(data, IPROTO_SERVER_VERSION);
 	data = mp_encode_uint(data, tarantool_version_id());
+	if (compression != 0) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_uint(data, compression);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1114,7 +1225,7 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id)
+		      uint32_t *version_id, uint32_t *compression)
 {
 	if (row->bodycnt == 0) {
 		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
@@ -1170,6 +1281,16 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 			}
 			*version_id = mp_decode_uint(&d);
 			break;
+		case IPROTO_COMPRESSION:
+			if (compression == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_UINT) {
+				diag_set(ClientError, ER_INVALID_MSGPACK,
+					 "invalid COMPRESSION");
+				return -1;
+			}
+			*compression = mp_decode_uint(&d);
+			break;
 		default: skip:
 			mp_next(&d); /* value */
 		}
@@ -1178,7 +1299,8 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 }
 
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 bool join_files)
 {
 	memset(row, 0, sizeof(*row));
 
@@ -1189,10 +1311,14 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 1);
+	data = mp_encode_map(data, join_files ? 2 : 1);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
 	/* Greet the remote replica with our replica UUID */
 	data = xrow_encode_uuid(data, instance_uuid);
+	if (join_files) {
+		data = mp_encode_uint(data, IPROTO_JOIN_FILES);
+		data = mp_encode_bool(data, true);
+	}
 	assert(data <= buf + size);
 
 	row->body[0].iov_base = buf;
@@ -1226,6 +1352,157 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 	return 0;
 }
 
+/**
+ * Decode the optional IPROTO_JOIN_FILES flag of a JOIN request
+ * or a response to it. The body must have been checked with
+ * xrow_decode_subscribe() beforehand.
+ */
+static int
+xrow_decode_join_files(struct xrow_header *row, bool *join_files)
+{
+	*join_files = false;
+	const char *d = (const char *) row->body[0].iov_base;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d); /* key */
+			mp_next(&d); /* value */
+			continue;
+		}
+		if (mp_decode_uint(&d) != IPROTO_JOIN_FILES) {
+			mp_next(&d); /* value */
+			continue;
+		}
+		if (mp_typeof(*d) != MP_BOOL) {
+			diag_set(ClientError, ER_INVALID_MSGPACK,
+				 "invalid JOIN_FILES");
+			return -1;
+		}
+		*join_files = mp_decode_bool(&d);
+	}
+	return 0;
+}
+
+int
+xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		 bool *join_files)
+{
+	if (xrow_decode_subscribe(row, NULL, instance_uuid, NULL,
+				  NULL, NULL) != 0)
+		return -1;
+	return xrow_decode_join_files(row, join_files);
+}
+
+int
+xrow_encode_join_response(struct xrow_header *row,
+			  const struct vclock *vclock, bool join_files)
+{
+	if (!join_files)
+		return xrow_encode_vclock(row, vclock);
+	memset(row, 0, sizeof(*row));
+	size_t size = mp_sizeof_map(2) +
+		      mp_sizeof_uint(IPROTO_VCLOCK) + mp_sizeof_vclock(vclock) +
+		      mp_sizeof_uint(IPROTO_JOIN_FILES) + mp_sizeof_bool(true);
+	char *buf = (char *) region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, 2);
+	data = mp_encode_uint(data, IPROTO_VCLOCK);
+	data = mp_encode_vclock(data, vclock);
+	data = mp_encode_uint(data, IPROTO_JOIN_FILES);
+	data = mp_encode_bool(data, true);
+	assert(data <= buf + size);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = (data - buf);
+	row->bodycnt = 1;
+	row->type = IPROTO_OK;
+	return 0;
+}
+
+int
+xrow_decode_join_response(struct xrow_header *row, struct vclock *vclock,
+			  bool *join_files)
+{
+	if (xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL) != 0)
+		return -1;
+	return xrow_decode_join_files(row, join_files);
+}
+
+int
+xrow_encode_join_file(struct xrow_header *row, const char *name,
+		      uint64_t size)
+{
+	memset(row, 0, sizeof(*row));
+	uint32_t name_len = strlen(name);
+	size_t len = mp_sizeof_map(2) +
+		     mp_sizeof_uint(IPROTO_FILE_NAME) + mp_sizeof_str(name_len) +
+		     mp_sizeof_uint(IPROTO_FILE_SIZE) + mp_sizeof_uint(size);
+	char *buf = (char *) region_alloc(&fiber()->gc, len);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, len, "region_alloc", "buf");
+		return -1;
+	}
+	char *pos = mp_encode_map(buf, 2);
+	pos = mp_encode_uint(pos, IPROTO_FILE_NAME);
+	pos = mp_encode_str(pos, name, name_len);
+	pos = mp_encode_uint(pos, IPROTO_FILE_SIZE);
+	pos = mp_encode_uint(pos, size);
+	assert(pos == buf + len);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = len;
+	row->bodycnt = 1;
+	row->type = IPROTO_JOIN_FILE;
+	return 0;
+}
+
+int
+xrow_decode_join_file(struct xrow_header *row, const char **name,
+		      uint32_t *name_len, uint64_t *size)
+{
+	if (row->bodycnt == 0)
+		goto error;
+	assert(row->bodycnt == 1);
+	const char *d = (const char *) row->body[0].iov_base;
+	const char *end = d + row->body[0].iov_len;
+	const char *tmp = d;
+	if (mp_check(&tmp, end) != 0 || mp_typeof(*d) != MP_MAP)
+		goto error;
+	*name = NULL;
+	bool has_size = false;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d); /* key */
+			mp_next(&d); /* value */
+			continue;
+		}
+		switch (mp_decode_uint(&d)) {
+		case IPROTO_FILE_NAME:
+			if (mp_typeof(*d) != MP_STR)
+				goto error;
+			*name = mp_decode_str(&d, name_len);
+			break;
+		case IPROTO_FILE_SIZE:
+			if (mp_typeof(*d) != MP_UINT)
+				goto error;
+			*size = mp_decode_uint(&d);
+			has_size = true;
+			break;
+		default:
+			mp_next(&d); /* value */
+		}
+	}
+	if (*name == NULL || !has_size)
+		goto error;
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "join file");
+	return -1;
+}
+
 int
 xrow_encode_subscribe_response(struct xrow_header *row,
 			       const struct tt_uuid *replicaset_uuid,
@@ -1255,6 +1532,67 @@ xrow_encode_subscribe_response(struct xrow_header *row,
 	return 0;
 }
 
+int
+xrow_encode_compressed_rows(struct xrow_header *row, const char *data,
+			    uint32_t size)
+{
+	memset(row, 0, sizeof(*row));
+	size_t len = mp_sizeof_map(1) + mp_sizeof_uint(IPROTO_DATA) +
+		     mp_sizeof_binl(size);
+	char *buf = (char *) region_alloc(&fiber()->gc, len);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, len, "region_alloc", "buf");
+		return -1;
+	}
+	char *pos = mp_encode_map(buf, 1);
+	pos = mp_encode_uint(pos, IPROTO_DATA);
+	pos = mp_encode_binl(pos, size);
+	assert(pos == buf + len);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = len;
+	row->body[1].iov_base = (void *) data;
+	row->body[1].iov_len = size;
+	row->bodycnt = 2;
+	row->type = IPROTO_COMPRESSED_ROWS;
+	return 0;
+}
+
+int
+xrow_decode_compressed_rows(struct xrow_header *row, const char **data,
+			    uint32_t *size)
+{
+	if (row->bodycnt == 0)
+		goto error;
+	assert(row->bodycnt == 1);
+	const char *d = (const char *) row->body[0].iov_base;
+	const char *end = d + row->body[0].iov_len;
+	const char *tmp = d;
+	if (mp_check(&tmp, end) != 0 || mp_typeof(*d) != MP_MAP)
+		goto error;
+	*data = NULL;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d); /* key */
+			mp_next(&d); /* value */
+			continue;
+		}
+		if (mp_decode_uint(&d) != IPROTO_DATA) {
+			mp_next(&d); /* value */
+			continue;
+		}
+		if (mp_typeof(*d) != MP_BIN)
+			goto error;
+		*data = mp_decode_bin(&d, size);
+	}
+	if (*data == NULL)
+		goto error;
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "compressed rows");
+	return -1;
+}
+
 void
 xrow_encode_timestamp(struct xrow_header *row, uint32_t replica_id, double tm)
 {
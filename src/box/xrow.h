@@ -52,6 +52,11 @@ enum {
 	IPROTO_HEADER_LEN = 28,
 	/** 7 = sizeof(iproto_body_bin). */
 	IPROTO_SELECT_HEADER_LEN = IPROTO_HEADER_LEN + 7,
+	/**
+	 * Max size of rows packed in a frame of compressed
+	 * replication rows, see xrow_encode_compressed_rows().
+	 */
+	XROW_COMPRESSED_ROWS_MAX = 1024 * 1024,
 };
 
 struct xrow_header {
@@ -226,6 +231,48 @@ struct call_request {
 int
 xrow_decode_call(const struct xrow_header *row, struct call_request *request);
 
+/**
+ * BATCH request: a sequence of DML requests executed in a
+ * single transaction.
+ */
+struct batch_request {
+	/** Request header */
+	const struct xrow_header *header;
+	/** IPROTO_REQUESTS. MessagePack Array. */
+	const char *requests;
+	const char *requests_end;
+	/** Number of requests in the batch. */
+	uint32_t request_count;
+};
+
+/**
+ * Decode BATCH request from a given MessagePack map. All
+ * batched requests are checked to be [type, {body}] pairs,
+ * their bodies are decoded by xrow_decode_batch_item().
+ * @param row request header.
+ * @param[out] request Request to decode to.
+ * @retval  0 on success
+ * @retval -1 on error
+ */
+int
+xrow_decode_batch(const struct xrow_header *row,
+		  struct batch_request *request);
+
+/**
+ * Decode the next DML request of a batch. @a row is filled
+ * so that it can be written to WAL as is: its body refers to
+ * the request body within the batch.
+ * @param[in, out] pos Position in batch_request::requests.
+ * @param end End of batch_request::requests.
+ * @param[out] row Header of the batched request.
+ * @param[out] request Request to decode to.
+ * @retval  0 on success
+ * @retval -1 on error
+ */
+int
+xrow_decode_batch_item(const char **pos, const char *end,
+		       struct xrow_header *row, struct request *request);
+
 /**
  * AUTH request
  */
@@ -295,6 +342,8 @@ xrow_encode_vote(struct xrow_header *row);
  * @param replicaset_uuid Replica set uuid.
  * @param instance_uuid Instance uuid.
  * @param vclock Replication clock.
+ * @param compression Level of compression the replica asks
+ *        the master to apply to the row stream, 0 if none.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
@@ -303,7 +352,7 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock);
+		      const struct vclock *vclock, uint32_t compression);
 
 /**
  * Decode SUBSCRIBE command.
@@ -312,6 +361,7 @@ xrow_encode_subscribe(struct xrow_header *row,
  * @param[out] instance_uuid.
  * @param[out] vclock.
  * @param[out] version_id.
+ * @param[out] compression.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
@@ -319,32 +369,88 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id);
+		      uint32_t *version_id, uint32_t *compression);
 
 /**
  * Encode JOIN command.
  * @param[out] row Row to encode into.
  * @param instance_uuid.
+ * @param join_files Set if the replica wants to receive
+ *        checkpoint files instead of checkpoint rows.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
  */
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid);
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 bool join_files);
 
 /**
  * Decode JOIN command.
  * @param row Row to decode.
  * @param[out] instance_uuid.
+ * @param[out] join_files.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
  */
-static inline int
-xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
-{
-	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL);
-}
+int
+xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		 bool *join_files);
+
+/**
+ * Encode a response to JOIN command.
+ * @param[out] row Row to encode into.
+ * @param vclock Vclock of the checkpoint sent to the replica.
+ * @param join_files Set if checkpoint files are going to be
+ *        sent instead of checkpoint rows.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_join_response(struct xrow_header *row,
+			  const struct vclock *vclock, bool join_files);
+
+/**
+ * Decode a response to JOIN command.
+ * @param row Row to decode.
+ * @param[out] vclock.
+ * @param[out] join_files.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+int
+xrow_decode_join_response(struct xrow_header *row, struct vclock *vclock,
+			  bool *join_files);
+
+/**
+ * Encode the header of a checkpoint file sent on JOIN.
+ * @param[out] row Row to encode into.
+ * @param name Name of the file, relative to the engine directory.
+ * @param size Size of the file.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_join_file(struct xrow_header *row, const char *name,
+		      uint64_t size);
+
+/**
+ * Decode the header of a checkpoint file sent on JOIN.
+ * @param row Row to decode.
+ * @param[out] name Name of the file, not nul-terminated.
+ * @param[out] name_len Length of @a name.
+ * @param[out] size Size of the file.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_join_file(struct xrow_header *row, const char **name,
+		      uint32_t *name_len, uint64_t *size);
 
 /**
  * Encode end of stream command (a response to JOIN command).
@@ -368,7 +474,7 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 static inline int
 xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL);
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL);
 }
 
 /**
@@ -399,9 +505,37 @@ xrow_decode_subscribe_response(struct xrow_header *row,
 			       struct tt_uuid *replicaset_uuid,
 			       struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL);
+	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL,
+				     NULL);
 }
 
+/**
+ * Encode a frame of compressed replication rows.
+ * The frame body references @a data, it isn't copied.
+ * @param[out] row Row to encode into.
+ * @param data Compressed rows.
+ * @param size Size of @a data.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_compressed_rows(struct xrow_header *row, const char *data,
+			    uint32_t size);
+
+/**
+ * Decode a frame of compressed replication rows.
+ * @param row Row to decode.
+ * @param[out] data Compressed rows.
+ * @param[out] size Size of @a data.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_compressed_rows(struct xrow_header *row, const char **data,
+			    uint32_t *size);
+
 /**
  * Encode a heartbeat message.
  * @param row[out] Row to encode into.
@@ -465,6 +599,16 @@ void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t schema_version, uint32_t count);
 
+/**
+ * Same as iproto_reply_select(), but the last @a tail_size bytes
+ * of the result set are not stored in @a buf: they are sent to
+ * the socket right after the buffer contents by the caller.
+ */
+void
+iproto_reply_select_with_tail(struct obuf *buf, struct obuf_svp *svp,
+			      uint64_t sync, uint32_t schema_version,
+			      uint32_t count, size_t tail_size);
+
 /**
  * Encode iproto header with IPROTO_OK response code.
  * @param out Encode to.
@@ -761,10 +905,10 @@ static inline void
 xrow_encode_subscribe_xc(struct xrow_header *row,
 			 const struct tt_uuid *replicaset_uuid,
 			 const struct tt_uuid *instance_uuid,
-			 const struct vclock *vclock)
+			 const struct vclock *vclock, uint32_t compression)
 {
 	if (xrow_encode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock) != 0)
+				  vclock, compression) != 0)
 		diag_raise();
 }
 
@@ -773,27 +917,65 @@ static inline void
 xrow_decode_subscribe_xc(struct xrow_header *row,
 			 struct tt_uuid *replicaset_uuid,
 		         struct tt_uuid *instance_uuid, struct vclock *vclock,
-			 uint32_t *replica_version_id)
+			 uint32_t *replica_version_id, uint32_t *compression)
 {
 	if (xrow_decode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, replica_version_id) != 0)
+				  vclock, replica_version_id,
+				  compression) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_encode_join. */
 static inline void
 xrow_encode_join_xc(struct xrow_header *row,
-		    const struct tt_uuid *instance_uuid)
+		    const struct tt_uuid *instance_uuid, bool join_files)
 {
-	if (xrow_encode_join(row, instance_uuid) != 0)
+	if (xrow_encode_join(row, instance_uuid, join_files) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_decode_join. */
 static inline void
-xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		    bool *join_files)
+{
+	if (xrow_decode_join(row, instance_uuid, join_files) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_join_response. */
+static inline void
+xrow_encode_join_response_xc(struct xrow_header *row,
+			     const struct vclock *vclock, bool join_files)
+{
+	if (xrow_encode_join_response(row, vclock, join_files) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_join_response. */
+static inline void
+xrow_decode_join_response_xc(struct xrow_header *row, struct vclock *vclock,
+			     bool *join_files)
 {
-	if (xrow_decode_join(row, instance_uuid) != 0)
+	if (xrow_decode_join_response(row, vclock, join_files) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_join_file. */
+static inline void
+xrow_encode_join_file_xc(struct xrow_header *row, const char *name,
+			 uint64_t size)
+{
+	if (xrow_encode_join_file(row, name, size) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_join_file. */
+static inline void
+xrow_decode_join_file_xc(struct xrow_header *row, const char **name,
+			 uint32_t *name_len, uint64_t *size)
+{
+	if (xrow_decode_join_file(row, name, name_len, size) != 0)
 		diag_raise();
 }
 
@@ -813,6 +995,24 @@ xrow_decode_vclock_xc(struct xrow_header *row, struct vclock *vclock)
 		diag_raise();
 }
 
+/** @copydoc xrow_encode_compressed_rows. */
+static inline void
+xrow_encode_compressed_rows_xc(struct xrow_header *row, const char *data,
+			       uint32_t size)
+{
+	if (xrow_encode_compressed_rows(row, data, size) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_compressed_rows. */
+static inline void
+xrow_decode_compressed_rows_xc(struct xrow_header *row, const char **data,
+			       uint32_t *size)
+{
+	if (xrow_decode_compressed_rows(row, data, size) != 0)
+		diag_raise();
+}
+
 /** @copydoc xrow_encode_subscribe_response. */
 static inline void
 xrow_encode_subscribe_response_xc(struct xrow_header *row,
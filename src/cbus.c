@@ -354,6 +354,12 @@ cmsg_deliver(struct cmsg *msg)
 	cmsg_dispatch(pipe, msg);
 }
 
+void
+cmsg_forward(struct cmsg *msg)
+{
+	cmsg_dispatch(msg->hop->pipe, msg);
+}
+
 /* }}} cmsg */
 
 /**
@@ -109,6 +109,14 @@ cmsg_init(struct cmsg *msg, const struct cmsg_hop *route)
 void
 cmsg_deliver(struct cmsg *msg);
 
+/**
+ * Dispatch the message to the next hop without calling the
+ * delivery function of the current one: for messages which
+ * have been delivered in some other way, see fiber_pool.
+ */
+void
+cmsg_forward(struct cmsg *msg);
+
 /** A  uni-directional FIFO queue from one cord to another. */
 struct cpipe {
 	/** Staging area for pushed messages */
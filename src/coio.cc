@@ -36,6 +36,11 @@
 #include <stdio.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <unistd.h>
+#include "trivia/config.h"
+#if defined(HAVE_SENDFILE_LINUX)
+#include <sys/sendfile.h>
+#endif /* defined(HAVE_SENDFILE_LINUX) */
 
 #include "sio.h"
 #include "scoped_guard.h"
@@ -504,6 +509,66 @@ coio_writev_timeout(struct ev_io *coio, struct iovec *iov, int iovcnt,
 	return total;
 }
 
+/**
+ * Send @a size bytes of file @a file_fd starting at @a offset
+ * to the socket. Where sendfile(2) is available, the file data
+ * is copied to the socket within the kernel.
+ *
+ * The file is read synchronously, so call it from a thread
+ * that may block on disk, e.g. relay.
+ */
+void
+coio_sendfile(struct ev_io *coio, int file_fd, off_t offset, size_t size)
+{
+	CoioGuard coio_guard(coio);
+#if !defined(HAVE_SENDFILE_LINUX)
+	char buf[16 * 1024];
+	size_t buf_used = 0;
+	size_t buf_pos = 0;
+#endif
+	while (size > 0) {
+#if defined(HAVE_SENDFILE_LINUX)
+		ssize_t nwr = sendfile(coio->fd, file_fd, &offset, size);
+		if (nwr == 0)
+			tnt_raise(IllegalParams, "unexpected end of file");
+		if (nwr < 0 && !sio_wouldblock(errno) && errno != EINTR) {
+			tnt_raise(SocketError, sio_socketname(coio->fd),
+				  "sendfile");
+		}
+#else
+		if (buf_pos == buf_used) {
+			ssize_t nrd = pread(file_fd, buf, MIN(size, sizeof(buf)),
+					    offset);
+			if (nrd < 0)
+				tnt_raise(SystemError, "pread");
+			if (nrd == 0)
+				tnt_raise(IllegalParams,
+					  "unexpected end of file");
+			buf_used = nrd;
+			buf_pos = 0;
+			offset += nrd;
+		}
+		ssize_t nwr = sio_write(coio->fd, buf + buf_pos,
+					buf_used - buf_pos);
+		if (nwr < 0 && !sio_wouldblock(errno))
+			diag_raise();
+		if (nwr > 0)
+			buf_pos += nwr;
+#endif
+		if (nwr > 0) {
+			size -= nwr;
+			continue;
+		}
+		if (! ev_is_active(coio)) {
+			ev_io_set(coio, coio->fd, EV_WRITE);
+			ev_io_start(loop(), coio);
+		}
+		fiber_testcancel();
+		coio_fiber_yield_timeout(coio, TIMEOUT_INFINITY);
+		fiber_testcancel();
+	}
+}
+
 /**
  * Send up to sz bytes to a UDP socket.
  * Return the number of bytes sent.
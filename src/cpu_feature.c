@@ -65,19 +65,162 @@ crc32c_hw_byte(uint32_t crc, unsigned char const *data, unsigned int length)
 }
 
 
+static inline unsigned long
+crc32c_hw_word(unsigned long crc, unsigned long data)
+{
+	__asm__ __volatile__(
+		".byte 0xf2, " REX_PRE "0xf, 0x38, 0xf1, 0xf1;"
+		:"=S"(crc)
+		:"0"(crc), "c"(data)
+	);
+	return crc;
+}
+
+/*
+ * The crc32 instruction has a latency of three cycles, but
+ * a throughput of one instruction per cycle. So to make the
+ * best of it, a long buffer is split into three blocks, which
+ * are checksummed at the same time, in interleaved fashion.
+ * The resulting CRCs are then combined: the CRC of the first
+ * block is shifted through as many zero bytes as there are in
+ * the second block and xor-ed with the CRC of the second block
+ * and so forth. Shifting is done with lookup tables computed
+ * on initialization for the two block sizes we use.
+ *
+ * See Mark Adler's answer at https://stackoverflow.com/a/17646775
+ */
+enum {
+	CRC32C_POLY = 0x82f63b78,
+	CRC32C_LONG = 8192,
+	CRC32C_SHORT = 256,
+};
+
+static uint32_t crc32c_long[4][256];
+static uint32_t crc32c_short[4][256];
+
+/* Multiply a 32x32 matrix over GF(2) by a vector. */
+static uint32_t
+gf2_matrix_times(const uint32_t *mat, uint32_t vec)
+{
+	uint32_t sum = 0;
+	while (vec != 0) {
+		if (vec & 1)
+			sum ^= *mat;
+		vec >>= 1;
+		mat++;
+	}
+	return sum;
+}
+
+static void
+gf2_matrix_square(uint32_t *square, const uint32_t *mat)
+{
+	for (int n = 0; n < 32; n++)
+		square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+/*
+ * Construct the operator that shifts a CRC through @len zero
+ * bytes. @len must be a power of two.
+ */
+static void
+crc32c_zeros_op(uint32_t *even, size_t len)
+{
+	uint32_t odd[32];
+	/* Operator for one zero bit. */
+	odd[0] = CRC32C_POLY;
+	uint32_t row = 1;
+	for (int n = 1; n < 32; n++) {
+		odd[n] = row;
+		row <<= 1;
+	}
+	/* Operator for two zero bits. */
+	gf2_matrix_square(even, odd);
+	/* Operator for four zero bits. */
+	gf2_matrix_square(odd, even);
+	/*
+	 * The first square puts the operator for one zero byte
+	 * to even, the next one puts the operator for two zero
+	 * bytes to odd, and so on until len is exhausted.
+	 */
+	do {
+		gf2_matrix_square(even, odd);
+		len >>= 1;
+		if (len == 0)
+			return;
+		gf2_matrix_square(odd, even);
+		len >>= 1;
+	} while (len != 0);
+	for (int n = 0; n < 32; n++)
+		even[n] = odd[n];
+}
+
+static void
+crc32c_zeros(uint32_t zeros[][256], size_t len)
+{
+	uint32_t op[32];
+	crc32c_zeros_op(op, len);
+	for (uint32_t n = 0; n < 256; n++) {
+		zeros[0][n] = gf2_matrix_times(op, n);
+		zeros[1][n] = gf2_matrix_times(op, n << 8);
+		zeros[2][n] = gf2_matrix_times(op, n << 16);
+		zeros[3][n] = gf2_matrix_times(op, n << 24);
+	}
+}
+
+static inline uint32_t
+crc32c_shift(uint32_t zeros[][256], uint32_t crc)
+{
+	return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+	       zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+void
+crc32c_hw_init(void)
+{
+	crc32c_zeros(crc32c_long, CRC32C_LONG);
+	crc32c_zeros(crc32c_short, CRC32C_SHORT);
+}
+
+/*
+ * Checksum the buffer by triples of blocks of @size bytes
+ * while it is long enough, advancing @buf and @len.
+ */
+static inline uint32_t
+crc32c_hw_blocks(uint32_t crc, const char **buf, unsigned int *len,
+		 unsigned int size, uint32_t zeros[][256])
+{
+	while (*len >= size * 3) {
+		const unsigned long *p0 = (const unsigned long *)*buf;
+		const unsigned long *p1 = (const unsigned long *)(*buf + size);
+		const unsigned long *p2 = (const unsigned long *)(*buf + size * 2);
+		const unsigned long *end = p1;
+		unsigned long crc0 = crc, crc1 = 0, crc2 = 0;
+		do {
+			crc0 = crc32c_hw_word(crc0, *p0++);
+			crc1 = crc32c_hw_word(crc1, *p1++);
+			crc2 = crc32c_hw_word(crc2, *p2++);
+		} while (p0 < end);
+		crc = crc32c_shift(zeros, crc0) ^ crc1;
+		crc = crc32c_shift(zeros, crc) ^ crc2;
+		*buf += size * 3;
+		*len -= size * 3;
+	}
+	return crc;
+}
+
 uint32_t
 crc32c_hw(uint32_t crc, const char *buf, unsigned int len)
 {
+	crc = crc32c_hw_blocks(crc, &buf, &len, CRC32C_LONG, crc32c_long);
+	crc = crc32c_hw_blocks(crc, &buf, &len, CRC32C_SHORT, crc32c_short);
+
 	unsigned int iquotient = len / SCALE_F;
 	unsigned int iremainder = len % SCALE_F;
 	unsigned long *ptmp = (unsigned long *)buf;
 
 	while (iquotient--) {
-		__asm__ __volatile__(
-			".byte 0xf2, " REX_PRE "0xf, 0x38, 0xf1, 0xf1;"
-			:"=S"(crc)
-			:"0"(crc), "c"(*ptmp)
-		);
+		crc = crc32c_hw_word(crc, *ptmp);
 		ptmp++;
 	}
 
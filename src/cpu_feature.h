@@ -53,6 +53,9 @@ bool sse42_enabled_cpu();
  * @return	CRC32 value
  */
 uint32_t crc32c_hw(uint32_t crc, const char *buf, unsigned int len);
+
+/* Initialize lookup tables used by crc32c_hw(). */
+void crc32c_hw_init(void);
 #endif
 
 #endif /* TARANTOOL_CPU_FEATURES_H */
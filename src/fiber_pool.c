@@ -111,6 +111,19 @@ fiber_pool_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
 	cbus_endpoint_fetch(&pool->endpoint, &pool->output);
 
 	struct stailq *output = &pool->output;
+	/*
+	 * Deliver what can be delivered without a fiber switch.
+	 * Stop at the first message needing a worker fiber, so
+	 * that messages are started in the order they arrived.
+	 */
+	while (pool->direct_f != NULL && ! stailq_empty(output)) {
+		struct cmsg *msg = stailq_first_entry(output, struct cmsg,
+						      fifo);
+		if (! pool->direct_f(msg))
+			break;
+		stailq_shift(output);
+		cmsg_forward(msg);
+	}
 	while (! stailq_empty(output)) {
 		struct fiber *f;
 		if (! rlist_empty(&pool->idle)) {
@@ -142,6 +155,12 @@ fiber_pool_set_max_size(struct fiber_pool *pool, int new_max_size)
 	pool->max_size = new_max_size;
 }
 
+void
+fiber_pool_set_direct_f(struct fiber_pool *pool, fiber_pool_direct_f direct_f)
+{
+	pool->direct_f = direct_f;
+}
+
 void
 fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 		  float idle_timeout)
@@ -155,6 +174,7 @@ fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 	ev_timer_again(loop(), &pool->idle_timer);
 	pool->size = 0;
 	pool->max_size = max_pool_size;
+	pool->direct_f = NULL;
 	stailq_create(&pool->output);
 	fiber_cond_create(&pool->worker_cond);
 	/* Join fiber pool to cbus */
@@ -44,6 +44,14 @@ extern "C" {
 /** Period after which an idle fiber in the pool is shut down. */
 enum { FIBER_POOL_IDLE_TIMEOUT = 1 };
 
+/**
+ * Deliver a message right in the endpoint callback, without
+ * switching to a worker fiber. Must not yield. Returns false
+ * if the message needs a worker fiber and has been left intact,
+ * true if the current hop has been delivered.
+ */
+typedef bool (*fiber_pool_direct_f)(struct cmsg *msg);
+
 /**
  * A pool of worker fibers to handle messages,
  * so that each message is handled in its own fiber.
@@ -67,6 +75,11 @@ struct fiber_pool {
 		struct ev_timer idle_timer;
 		/** Condition for worker exit signaling */
 		struct fiber_cond worker_cond;
+		/**
+		 * Optional function to deliver messages without
+		 * a worker fiber, see fiber_pool_set_direct_f().
+		 */
+		fiber_pool_direct_f direct_f;
 	};
 	struct {
 		/** The consumer thread loop. */
@@ -92,6 +105,16 @@ fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 void
 fiber_pool_set_max_size(struct fiber_pool *pool, int new_max_size);
 
+/**
+ * Set a function to deliver messages right in the endpoint
+ * callback. It is tried on messages at the head of the queue
+ * only, so the order of delivery is preserved.
+ * @param pool Fiber pool.
+ * @param direct_f Function to try, NULL to disable.
+ */
+void
+fiber_pool_set_direct_f(struct fiber_pool *pool, fiber_pool_direct_f direct_f);
+
 /**
  * Destroy a fiber pool
  */
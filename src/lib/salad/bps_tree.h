@@ -291,6 +291,18 @@
  * #define BPS_BLOCK_LINEAR_SEARCH
  */
 
+/**
+ * A switch that makes every inner block store the count of elements
+ * in the subtree of each of its children. It costs some inner block
+ * fanout and an update of all the blocks on the path on every insertion
+ * and deletion, but allows to find the offset of an element and an
+ * element by its offset (and thus to count elements in a range) in
+ * logarithmic time (see bps_tree_lower_bound_get_offset,
+ * bps_tree_upper_bound_get_offset and bps_tree_iterator_at).
+ * To turn it on,
+ * #define BPS_INNER_CARD
+ */
+
 /**
  * A switch that enables collection of executions of different
  * branches of code. Used only for debug purposes, I hope you
@@ -303,6 +315,7 @@
 /* {{{ BPS-tree internal settings */
 typedef int16_t bps_tree_pos_t;
 typedef uint32_t bps_tree_block_id_t;
+typedef size_t bps_tree_card_t;
 /* }}} */
 
 /* {{{ Compile time utils */
@@ -373,6 +386,9 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_lower_bound_elem _api_name(lower_bound_elem)
 #define bps_tree_upper_bound_elem _api_name(upper_bound_elem)
 #define bps_tree_approximate_count _api_name(approximate_count)
+#define bps_tree_lower_bound_get_offset _api_name(lower_bound_get_offset)
+#define bps_tree_upper_bound_get_offset _api_name(upper_bound_get_offset)
+#define bps_tree_iterator_at _api_name(iterator_at)
 #define bps_tree_iterator_get_elem _api_name(iterator_get_elem)
 #define bps_tree_iterator_next _api_name(iterator_next)
 #define bps_tree_iterator_prev _api_name(iterator_prev)
@@ -412,6 +428,10 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_collect_path _bps_tree(collect_path)
 #define bps_tree_touch_leaf_path_max_elem _bps_tree(touch_leaf_path_max_elem)
 #define bps_tree_touch_path _bps_tree(touch_path_max_elem)
+#define bps_tree_block_card _bps_tree(block_card)
+#define bps_tree_path_add_card _bps_tree(path_add_card)
+#define bps_tree_inner_update_cards _bps_tree(inner_update_cards)
+#define bps_tree_path_update_cards _bps_tree(path_update_cards)
 #define bps_tree_process_replace _bps_tree(process_replace)
 #define bps_tree_debug_memmove _bps_tree(debug_memmove)
 #define bps_tree_insert_into_leaf _bps_tree(insert_into_leaf)
@@ -770,6 +790,54 @@ static inline struct bps_tree_iterator
 bps_tree_upper_bound_elem(const struct bps_tree *tree, bps_tree_elem_t key,
 			  bool *exact);
 
+#ifdef BPS_INNER_CARD
+/**
+ * @brief Get an iterator to the first element that is greater or
+ * equal than key and the offset of the element in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - pointer to a bool value, that will be set to true if
+ *  and element pointed by the iterator is equal to the key, false otherwise
+ *  Pass NULL if you don't need that info.
+ * @param offset - the count of elements that are less than key
+ *  (the size of the tree if the iterator is invalid).
+ * @return - Lower-bound iterator. Invalid if all elements are less than key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+
+/**
+ * @brief Get an iterator to the first element that is greater than key
+ * and the offset of the element in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - pointer to a bool value, that will be set to true if
+ *  and element pointed by the (!)previous iterator is equal to the key,
+ *  false otherwise. Pass NULL if you don't need that info.
+ * @param offset - the count of elements that are less or equal than key
+ *  (the size of the tree if the iterator is invalid).
+ * @return - Upper-bound iterator. Invalid if all elements are less or equal
+ *  than the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+
+/**
+ * @brief Get an iterator to an element by its offset in the tree,
+ *  i.e. to the element that has exactly offset lesser elements.
+ * @param tree - pointer to a tree
+ * @param offset - offset of the element
+ * @return - Iterator to the element. Invalid if offset is not less
+ *  than the size of the tree.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset);
+#endif
+
 /**
  * @brief Get approximate number of entries that are equal to given key.
  * Accuracy limits:
@@ -920,9 +988,16 @@ enum bps_tree_max_sizes {
 		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block)
 		 - 2 * sizeof(bps_tree_block_id_t) )
 		/ sizeof(bps_tree_elem_t),
+#ifdef BPS_INNER_CARD
+	BPS_TREE_MAX_COUNT_IN_INNER =
+		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block))
+		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t) +
+		   sizeof(bps_tree_card_t)),
+#else
 	BPS_TREE_MAX_COUNT_IN_INNER =
 		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block))
 		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)),
+#endif
 	BPS_TREE_MAX_DEPTH = 16
 };
 
@@ -968,6 +1043,10 @@ struct bps_inner {
 	bps_tree_elem_t elems[BPS_TREE_MAX_COUNT_IN_INNER - 1];
 	/* Corresponding child IDs */
 	bps_tree_block_id_t child_ids[BPS_TREE_MAX_COUNT_IN_INNER];
+#ifdef BPS_INNER_CARD
+	/* Count of elements in the subtree of each child */
+	bps_tree_card_t child_cards[BPS_TREE_MAX_COUNT_IN_INNER];
+#endif
 };
 
 /**
@@ -1178,6 +1257,9 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 			}
 			parents[i]->child_ids[parents[i]->header.size] =
 				insert_id;
+#ifdef BPS_INNER_CARD
+			parents[i]->child_cards[parents[i]->header.size] = 0;
+#endif
 			if (new_id == (bps_tree_block_id_t)-1)
 				break;
 			if (i == depth - 2) {
@@ -1187,6 +1269,11 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 			}
 		}
 
+#ifdef BPS_INNER_CARD
+		for (bps_tree_block_id_t i = 0; i < depth - 1; i++)
+			parents[i]->child_cards[parents[i]->header.size] +=
+				leaf->header.size;
+#endif
 		bps_tree_elem_t insert_value = current[leaf->header.size - 1];
 		for (bps_tree_block_id_t i = 0; i < depth - 1; i++) {
 			parents[i]->header.size++;
@@ -1874,6 +1961,168 @@ bps_tree_upper_bound_elem(const struct bps_tree *tree, bps_tree_elem_t key,
 	return res;
 }
 
+#ifdef BPS_INNER_CARD
+/**
+ * @brief Get an iterator to the first element that is greater or
+ * equal than key and the offset of the element in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - pointer to a bool value, that will be set to true if
+ *  and element pointed by the iterator is equal to the key, false otherwise
+ *  Pass NULL if you don't need that info.
+ * @param offset - the count of elements that are less than key
+ *  (the size of the tree if the iterator is invalid).
+ * @return - Lower-bound iterator. Invalid if all elements are less than key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	*offset = 0;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_ins_point_key(tree, inner->elems,
+						  inner->header.size - 1,
+						  key, exact);
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			*offset += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_ins_point_key(tree, leaf->elems, leaf->header.size,
+					  key, exact);
+	*offset += pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+/**
+ * @brief Get an iterator to the first element that is greater than key
+ * and the offset of the element in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - pointer to a bool value, that will be set to true if
+ *  and element pointed by the (!)previous iterator is equal to the key,
+ *  false otherwise. Pass NULL if you don't need that info.
+ * @param offset - the count of elements that are less or equal than key
+ *  (the size of the tree if the iterator is invalid).
+ * @return - Upper-bound iterator. Invalid if all elements are less or equal
+ *  than the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	*offset = 0;
+	bool exact_test;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_after_ins_point_key(tree, inner->elems,
+							inner->header.size - 1,
+							key, &exact_test);
+		if (exact_test)
+			*exact = true;
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			*offset += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_after_ins_point_key(tree, leaf->elems,
+						leaf->header.size,
+						key, &exact_test);
+	if (exact_test)
+		*exact = true;
+	*offset += pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+/**
+ * @brief Get an iterator to an element by its offset in the tree,
+ *  i.e. to the element that has exactly offset lesser elements.
+ * @param tree - pointer to a tree
+ * @param offset - offset of the element
+ * @return - Iterator to the element. Invalid if offset is not less
+ *  than the size of the tree.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	if (offset >= tree->size) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos = 0;
+		while (offset >= inner->child_cards[pos]) {
+			offset -= inner->child_cards[pos];
+			pos++;
+			assert(pos < inner->header.size);
+		}
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+	assert(offset < (size_t)block->size);
+	res.block_id = block_id;
+	res.pos = (bps_tree_pos_t)offset;
+	return res;
+}
+#endif
+
 /**
  * @brief Get approximate number of entries that are equal to given key.
  * Accuracy limits:
@@ -2418,6 +2667,16 @@ bps_tree_debug_memmove(void *dst_arg, void *src_arg, size_t num,
 				assert(src < ((char *)src_inner->elems) +
 				       (BPS_TREE_MAX_COUNT_IN_INNER - 1) *
 				       sizeof(bps_tree_elem_t));
+#ifdef BPS_INNER_CARD
+			} else if (dst >= ((char *)dst_inner->child_cards)) {
+				assert(dst < ((char *)dst_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(bps_tree_card_t));
+				assert(src >= (char *)src_inner->child_cards);
+				assert(src < ((char *)src_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(bps_tree_card_t));
+#endif
 			} else {
 				assert(dst >= ((char *)dst_inner->child_ids));
 				assert(dst < ((char *)dst_inner->child_ids) +
@@ -2438,6 +2697,17 @@ bps_tree_debug_memmove(void *dst_arg, void *src_arg, size_t num,
 					(BPS_TREE_MAX_COUNT_IN_INNER - 1) *
 					sizeof(bps_tree_elem_t)) {
 				/* nothing to do due to if condition */
+#ifdef BPS_INNER_CARD
+			} else if (dst >= ((char *)dst_inner->child_cards) &&
+				   src >= ((char *)src_inner->child_cards)) {
+				assert(dst <= ((char *)dst_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(bps_tree_card_t));
+				assert(src >= (char *)src_inner->child_cards);
+				assert(src <= ((char *)src_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(bps_tree_card_t));
+#endif
 			} else {
 				assert(dst >= ((char *)dst_inner->child_ids));
 				assert(dst <= ((char *)dst_inner->child_ids) +
@@ -2488,13 +2758,16 @@ bps_tree_insert_into_leaf(struct bps_tree *tree,
 
 /**
  * @breif Insert a child into inner block. There must be enough space.
+ * The card is the count of elements in the child subtree and is
+ * ignored unless BPS_INNER_CARD is defined.
  */
 static inline void
 bps_tree_insert_into_inner(struct bps_tree *tree,
 			   struct bps_inner_path_elem *inner_path_elem,
 			   bps_tree_block_id_t block_id, bps_tree_pos_t pos,
-			   bps_tree_elem_t max_elem)
+			   bps_tree_elem_t max_elem, bps_tree_card_t card)
 {
+	(void) card;
 	/* exclusive behaviuor for debug checks */
 	if (tree->root_id != (bps_tree_block_id_t) -1)
 		inner_path_elem->block = (struct bps_inner *)
@@ -2512,12 +2785,20 @@ bps_tree_insert_into_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(inner->child_ids + pos + 1,
 				  inner->child_ids + pos,
 				  inner->header.size - pos, inner, inner);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(inner->child_cards + pos + 1,
+				  inner->child_cards + pos,
+				  inner->header.size - pos, inner, inner);
+#endif
 	} else {
 		if (pos > 0)
 			inner->elems[pos - 1] = *inner_path_elem->max_elem_copy;
 		*inner_path_elem->max_elem_copy = max_elem;
 	}
 	inner->child_ids[pos] = block_id;
+#ifdef BPS_INNER_CARD
+	inner->child_cards[pos] = card;
+#endif
 
 	inner->header.size++;
 }
@@ -2576,6 +2857,11 @@ bps_tree_delete_from_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(inner->child_ids + pos,
 				  inner->child_ids + pos + 1,
 				  inner->header.size - 1 - pos, inner, inner);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(inner->child_cards + pos,
+				  inner->child_cards + pos + 1,
+				  inner->header.size - 1 - pos, inner, inner);
+#endif
 	} else if (pos > 0) {
 		*inner_path_elem->max_elem_copy = inner->elems[pos - 1];
 	}
@@ -2647,8 +2933,16 @@ bps_tree_move_elems_to_right_inner(struct bps_tree *tree,
 
 	BPS_TREE_DATAMOVE(b->child_ids + num, b->child_ids,
 			  b->header.size, b, b);
+#ifdef BPS_INNER_CARD
+	BPS_TREE_DATAMOVE(b->child_cards + num, b->child_cards,
+			  b->header.size, b, b);
+#endif
 	BPS_TREE_DATAMOVE(b->child_ids, a->child_ids + a->header.size - num,
 			  num, b, a);
+#ifdef BPS_INNER_CARD
+	BPS_TREE_DATAMOVE(b->child_cards, a->child_cards + a->header.size - num,
+			  num, b, a);
+#endif
 
 	if (!move_to_empty)
 		BPS_TREE_DATAMOVE(b->elems + num, b->elems,
@@ -2727,8 +3021,16 @@ bps_tree_move_elems_to_left_inner(struct bps_tree *tree,
 
 	BPS_TREE_DATAMOVE(a->child_ids + a->header.size, b->child_ids,
 			  num, a, b);
+#ifdef BPS_INNER_CARD
+	BPS_TREE_DATAMOVE(a->child_cards + a->header.size, b->child_cards,
+			  num, a, b);
+#endif
 	BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num,
 			  b->header.size - num, b, b);
+#ifdef BPS_INNER_CARD
+	BPS_TREE_DATAMOVE(b->child_cards, b->child_cards + num,
+			  b->header.size - num, b, b);
+#endif
 
 	if (!move_to_empty)
 		a->elems[a->header.size - 1] =
@@ -2828,8 +3130,10 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		struct bps_inner_path_elem *a_inner_path_elem,
 		struct bps_inner_path_elem *b_inner_path_elem,
 		bps_tree_pos_t num, bps_tree_block_id_t block_id,
-		bps_tree_pos_t pos, bps_tree_elem_t max_elem)
+		bps_tree_pos_t pos, bps_tree_elem_t max_elem,
+		bps_tree_card_t card)
 {
+	(void) card;
 	/* exclusive behaviuor for debug checks */
 	if (tree->root_id != (bps_tree_block_id_t) -1) {
 		a_inner_path_elem->block = (struct bps_inner *)
@@ -2851,6 +3155,10 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 	if (!move_to_empty) {
 		BPS_TREE_DATAMOVE(b->child_ids + num, b->child_ids,
 				  b->header.size, b, b);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(b->child_cards + num, b->child_cards,
+				  b->header.size, b, b);
+#endif
 		BPS_TREE_DATAMOVE(b->elems + num, b->elems,
 				  b->header.size - 1, b, b);
 	}
@@ -2861,9 +3169,22 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(b->child_ids,
 				  a->child_ids + a->header.size - num,
 				  num, b, a);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(b->child_cards,
+				  a->child_cards + a->header.size - num,
+				  num, b, a);
+#endif
 		BPS_TREE_DATAMOVE(a->child_ids + pos + 1, a->child_ids + pos,
 				  mid_part_size - num, a, a);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(a->child_cards + pos + 1,
+				  a->child_cards + pos,
+				  mid_part_size - num, a, a);
+#endif
 		a->child_ids[pos] = block_id;
+#ifdef BPS_INNER_CARD
+		a->child_cards[pos] = card;
+#endif
 
 		BPS_TREE_DATAMOVE(b->elems, a->elems + a->header.size - num,
 				  num - 1, b, a);
@@ -2883,9 +3204,22 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(b->child_ids,
 				  a->child_ids + a->header.size - num,
 				  num, b, a);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(b->child_cards,
+				  a->child_cards + a->header.size - num,
+				  num, b, a);
+#endif
 		BPS_TREE_DATAMOVE(a->child_ids + pos + 1, a->child_ids + pos,
 				  mid_part_size - num, a, a);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(a->child_cards + pos + 1,
+				  a->child_cards + pos,
+				  mid_part_size - num, a, a);
+#endif
 		a->child_ids[pos] = block_id;
+#ifdef BPS_INNER_CARD
+		a->child_cards[pos] = card;
+#endif
 
 		BPS_TREE_DATAMOVE(b->elems, a->elems + a->header.size - num,
 				  num - 1, b, a);
@@ -2902,9 +3236,21 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(b->child_ids,
 				  a->child_ids + a->header.size - num + 1,
 				  new_pos, b, a);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(b->child_cards,
+				  a->child_cards + a->header.size - num + 1,
+				  new_pos, b, a);
+#endif
 		b->child_ids[new_pos] = block_id;
+#ifdef BPS_INNER_CARD
+		b->child_cards[new_pos] = card;
+#endif
 		BPS_TREE_DATAMOVE(b->child_ids + new_pos + 1,
 				  a->child_ids + pos, mid_part_size, b, a);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(b->child_cards + new_pos + 1,
+				  a->child_cards + pos, mid_part_size, b, a);
+#endif
 
 		if (pos == a->header.size) {
 			/* +1 */
@@ -3031,8 +3377,9 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 		struct bps_inner_path_elem *a_inner_path_elem,
 		struct bps_inner_path_elem *b_inner_path_elem, bps_tree_pos_t num,
 		bps_tree_block_id_t block_id, bps_tree_pos_t pos,
-		bps_tree_elem_t max_elem)
+		bps_tree_elem_t max_elem, bps_tree_card_t card)
 {
+	(void) card;
 	/* exclusive behaviuor for debug checks */
 	if (tree->root_id != (bps_tree_block_id_t) -1) {
 		a_inner_path_elem->block = (struct bps_inner *)
@@ -3056,12 +3403,29 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 		bps_tree_pos_t new_pos = pos - num; /* Can be 0 */
 		BPS_TREE_DATAMOVE(a->child_ids + a->header.size, b->child_ids,
 				  num, a, b);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(a->child_cards + a->header.size,
+				  b->child_cards,
+				  num, a, b);
+#endif
 		BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num,
 				  new_pos, b, b);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(b->child_cards, b->child_cards + num,
+				  new_pos, b, b);
+#endif
 		b->child_ids[new_pos] = block_id;
+#ifdef BPS_INNER_CARD
+		b->child_cards[new_pos] = card;
+#endif
 		BPS_TREE_DATAMOVE(b->child_ids + new_pos + 1,
 				  b->child_ids + pos,
 				  b->header.size - pos, b, b);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(b->child_cards + new_pos + 1,
+				  b->child_cards + pos,
+				  b->header.size - pos, b, b);
+#endif
 
 		if (!move_to_empty)
 			a->elems[a->header.size - 1] =
@@ -3097,12 +3461,28 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 		bps_tree_pos_t new_pos = a->header.size + pos; /* Can be 0 */
 		BPS_TREE_DATAMOVE(a->child_ids + a->header.size,
 				  b->child_ids, pos, a, b);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(a->child_cards + a->header.size,
+				  b->child_cards, pos, a, b);
+#endif
 		a->child_ids[new_pos] = block_id;
+#ifdef BPS_INNER_CARD
+		a->child_cards[new_pos] = card;
+#endif
 		BPS_TREE_DATAMOVE(a->child_ids + new_pos + 1,
 				  b->child_ids + pos, num - 1 - pos, a, b);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(a->child_cards + new_pos + 1,
+				  b->child_cards + pos, num - 1 - pos, a, b);
+#endif
 		if (!move_all)
 			BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num - 1,
 					  b->header.size - num + 1, b, b);
+#ifdef BPS_INNER_CARD
+			BPS_TREE_DATAMOVE(b->child_cards,
+					  b->child_cards + num - 1,
+					  b->header.size - num + 1, b, b);
+#endif
 
 		if (!move_to_empty)
 			a->elems[a->header.size - 1] =
@@ -3336,11 +3716,98 @@ bps_tree_prepare_new_ext_inner(struct bps_inner_path_elem *path_elem,
 /**
  * bps_tree_process_insert_inner declaration. See definition for details.
  */
+/**
+ * @brief Get the count of elements in the subtree of a block
+ */
+static inline bps_tree_card_t
+bps_tree_block_card(struct bps_block *block)
+{
+	if (block->type == BPS_TREE_BT_LEAF)
+		return block->size;
+	bps_tree_card_t card = 0;
+#ifdef BPS_INNER_CARD
+	struct bps_inner *inner = (struct bps_inner *)block;
+	for (bps_tree_pos_t i = 0; i < inner->header.size; i++)
+		card += inner->child_cards[i];
+#endif
+	return card;
+}
+
+/**
+ * @brief Add a delta to the card of a child of an inner block
+ *  and to the cards of all the blocks on the path up to the root.
+ */
+static inline void
+bps_tree_path_add_card(struct bps_tree *tree,
+		       struct bps_inner_path_elem *inner_path_elem,
+		       bps_tree_pos_t pos, int delta)
+{
+#ifdef BPS_INNER_CARD
+	for (struct bps_inner_path_elem *path = inner_path_elem;
+	     path; pos = path->pos_in_parent, path = path->parent) {
+		path->block = (struct bps_inner *)
+			bps_tree_touch_block(tree, path->block_id);
+		path->block->child_cards[pos] += delta;
+	}
+#else
+	(void) tree;
+	(void) inner_path_elem;
+	(void) pos;
+	(void) delta;
+#endif
+}
+
+/**
+ * @brief Recalculate the cards of a child of an inner block and
+ *  of its siblings that could exchange elements with it during
+ *  rebalancing, i.e. of children in [pos - 2, pos + 2].
+ */
+static inline void
+bps_tree_inner_update_cards(struct bps_tree *tree,
+			    struct bps_inner_path_elem *inner_path_elem,
+			    bps_tree_pos_t pos)
+{
+#ifdef BPS_INNER_CARD
+	inner_path_elem->block = (struct bps_inner *)
+		bps_tree_touch_block(tree, inner_path_elem->block_id);
+	struct bps_inner *inner = inner_path_elem->block;
+	bps_tree_pos_t begin = pos > 2 ? pos - 2 : 0;
+	bps_tree_pos_t end = pos + 3 < inner->header.size ?
+			     pos + 3 : inner->header.size;
+	for (bps_tree_pos_t i = begin; i < end; i++) {
+		struct bps_block *child =
+			bps_tree_restore_block(tree, inner->child_ids[i]);
+		inner->child_cards[i] = bps_tree_block_card(child);
+	}
+#else
+	(void) tree;
+	(void) inner_path_elem;
+	(void) pos;
+#endif
+}
+
+/**
+ * @brief Update the cards of an inner block after rebalancing of
+ *  its children around the given position, and add a delta to the
+ *  cards of the blocks above it.
+ */
+static inline void
+bps_tree_path_update_cards(struct bps_tree *tree,
+			   struct bps_inner_path_elem *inner_path_elem,
+			   bps_tree_pos_t pos, int delta)
+{
+	if (!inner_path_elem)
+		return;
+	bps_tree_inner_update_cards(tree, inner_path_elem, pos);
+	bps_tree_path_add_card(tree, inner_path_elem->parent,
+			       inner_path_elem->pos_in_parent, delta);
+}
+
 static int
 bps_tree_process_insert_inner(struct bps_tree *tree,
 			      struct bps_inner_path_elem *inner_path_elem,
 			      bps_tree_block_id_t block_id, bps_tree_pos_t pos,
-			      bps_tree_elem_t max_elem);
+			      bps_tree_elem_t max_elem, bps_tree_card_t card);
 
 /**
  * Basic inserted into leaf, dealing with spliting, merging and moving data
@@ -3355,6 +3822,8 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 {
 	if (bps_tree_leaf_free_size(leaf_path_elem->block)) {
 		bps_tree_insert_into_leaf(tree, leaf_path_elem, new_elem);
+		bps_tree_path_add_card(tree, leaf_path_elem->parent,
+				       leaf_path_elem->pos_in_parent, 1);
 		BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0x0);
 		*inserted_in_block = leaf_path_elem->block_id;
 		*inserted_in_pos = leaf_path_elem->insertion_point;
@@ -3384,6 +3853,8 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 				bps_tree_insert_and_move_elems_to_left_leaf(tree,
 					&left_ext, leaf_path_elem,
 					move_count, new_elem);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0x1);
 			*inserted_in_block = inserted_ext->block_id;
 			*inserted_in_pos = inserted_ext->insertion_point;
@@ -3395,6 +3866,8 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 				bps_tree_insert_and_move_elems_to_right_leaf(tree,
 					leaf_path_elem, &right_ext,
 					move_count, new_elem);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0x2);
 			*inserted_in_block = inserted_ext->block_id;
 			*inserted_in_pos = inserted_ext->insertion_point;
@@ -3408,6 +3881,8 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 				bps_tree_insert_and_move_elems_to_left_leaf(tree,
 					&left_ext, leaf_path_elem,
 					move_count, new_elem);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0x3);
 			*inserted_in_block = inserted_ext->block_id;
 			*inserted_in_pos = inserted_ext->insertion_point;
@@ -3427,6 +3902,8 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 				bps_tree_insert_and_move_elems_to_left_leaf(tree,
 					&left_ext, leaf_path_elem,
 					move_count, new_elem);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0x4);
 			*inserted_in_block = inserted_ext->block_id;
 			*inserted_in_pos = inserted_ext->insertion_point;
@@ -3440,6 +3917,8 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 				bps_tree_insert_and_move_elems_to_right_leaf(tree,
 					leaf_path_elem, &right_ext,
 					move_count, new_elem);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0x5);
 			*inserted_in_block = inserted_ext->block_id;
 			*inserted_in_pos = inserted_ext->insertion_point;
@@ -3459,6 +3938,8 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 				bps_tree_insert_and_move_elems_to_right_leaf(tree,
 					leaf_path_elem, &right_ext,
 					move_count, new_elem);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0x6);
 			*inserted_in_block = inserted_ext->block_id;
 			*inserted_in_pos = inserted_ext->insertion_point;
@@ -3712,6 +4193,10 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 		new_root->header.size = 2;
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
+#ifdef BPS_INNER_CARD
+		new_root->child_cards[0] = leaf_path_elem->block->header.size;
+		new_root->child_cards[1] = new_leaf->header.size;
+#endif
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -3725,10 +4210,12 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 	*inserted_in_block = inserted_ext->block_id;
 	*inserted_in_pos = inserted_ext->insertion_point;
 	assert(leaf_path_elem->parent);
+	bps_tree_inner_update_cards(tree, leaf_path_elem->parent,
+				    leaf_path_elem->pos_in_parent);
 	BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0xD);
 	return bps_tree_process_insert_inner(tree, leaf_path_elem->parent,
 			new_block_id, new_path_elem.pos_in_parent,
-			new_max_elem);
+			new_max_elem, new_leaf->header.size);
 }
 
 /**
@@ -3739,11 +4226,14 @@ static inline int
 bps_tree_process_insert_inner(struct bps_tree *tree,
 			      struct bps_inner_path_elem *inner_path_elem,
 			      bps_tree_block_id_t block_id,
-			      bps_tree_pos_t pos, bps_tree_elem_t max_elem)
+			      bps_tree_pos_t pos, bps_tree_elem_t max_elem,
+			      bps_tree_card_t card)
 {
 	if (bps_tree_inner_free_size(inner_path_elem->block)) {
 		bps_tree_insert_into_inner(tree, inner_path_elem,
-					   block_id, pos, max_elem);
+					   block_id, pos, max_elem, card);
+		bps_tree_path_add_card(tree, inner_path_elem->parent,
+				       inner_path_elem->pos_in_parent, 1);
 		BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x0);
 		return 0;
 	}
@@ -3766,7 +4256,10 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(left_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_left_inner(tree,
 					&left_ext, inner_path_elem, move_count,
-					block_id, pos, max_elem);
+					block_id, pos, max_elem, card);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x1);
 			return 0;
 		} else if (bps_tree_inner_free_size(right_ext.block) > 0) {
@@ -3774,7 +4267,11 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(right_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_right_inner(tree,
 					inner_path_elem, &right_ext,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem,
+					card);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x2);
 			return 0;
 		}
@@ -3784,7 +4281,11 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(left_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_left_inner(tree,
 					&left_ext, inner_path_elem,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem,
+					card);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x3);
 			return 0;
 		}
@@ -3800,7 +4301,10 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 			move_count = 1 + move_count / 2;
 			bps_tree_insert_and_move_elems_to_left_inner(tree,
 					&left_ext, inner_path_elem, move_count,
-					block_id, pos, max_elem);
+					block_id, pos, max_elem, card);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x4);
 			return 0;
 		}
@@ -3810,7 +4314,11 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(right_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_right_inner(tree,
 					inner_path_elem, &right_ext,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem,
+					card);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x5);
 			return 0;
 		}
@@ -3826,7 +4334,11 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 			move_count = 1 + move_count / 2;
 			bps_tree_insert_and_move_elems_to_right_inner(tree,
 					inner_path_elem, &right_ext,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem,
+					card);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, 1);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x6);
 			return 0;
 		}
@@ -3866,7 +4378,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_right_inner(tree,
 				&left_ext, inner_path_elem, mc2);
 		bps_tree_move_elems_to_left_inner(tree,
@@ -3901,7 +4413,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_right_inner(tree,
 				&left_ext, inner_path_elem, mc2);
 		bps_tree_move_elems_to_right_inner(tree,
@@ -3935,7 +4447,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_left_inner(tree,
 				&new_path_elem, &right_ext, mc2);
 		bps_tree_move_elems_to_left_inner(tree,
@@ -3967,7 +4479,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_right_inner(tree,
 				&left_ext, inner_path_elem, mc2);
 
@@ -3996,7 +4508,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_left_inner(tree,
 				&new_path_elem, &right_ext, mc2);
 
@@ -4024,7 +4536,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 
 		bps_tree_block_id_t new_root_id = (bps_tree_block_id_t)(-1);
 		struct bps_inner *new_root =
@@ -4032,6 +4544,12 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 		new_root->header.size = 2;
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
+#ifdef BPS_INNER_CARD
+		new_root->child_cards[0] =
+			bps_tree_block_card(&inner_path_elem->block->header);
+		new_root->child_cards[1] =
+			bps_tree_block_card(&new_inner->header);
+#endif
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -4040,10 +4558,12 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 		return 0;
 	}
 	assert(inner_path_elem->parent);
+	bps_tree_inner_update_cards(tree, inner_path_elem->parent,
+				    inner_path_elem->pos_in_parent);
 	BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0xD);
 	return bps_tree_process_insert_inner(tree, inner_path_elem->parent,
 			new_block_id, new_path_elem.pos_in_parent,
-			new_max_elem);
+			new_max_elem, bps_tree_block_card(&new_inner->header));
 }
 
 /**
@@ -4065,6 +4585,8 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 
 	if (leaf_path_elem->block->header.size >=
 	    BPS_TREE_MAX_COUNT_IN_LEAF * 2 / 3) {
+		bps_tree_path_add_card(tree, leaf_path_elem->parent,
+				       leaf_path_elem->pos_in_parent, -1);
 		BPS_TREE_BRANCH_TRACE(tree, delete_leaf, 1 << 0x0);
 		return;
 	}
@@ -4090,6 +4612,8 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 				bps_tree_leaf_overmin_size(left_ext.block) / 2;
 			bps_tree_move_elems_to_right_leaf(tree, &left_ext,
 					leaf_path_elem, move_count);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_leaf, 1 << 0x1);
 			return;
 		} else if (bps_tree_leaf_overmin_size(right_ext.block) > 0) {
@@ -4097,6 +4621,8 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 				bps_tree_leaf_overmin_size(right_ext.block) / 2;
 			bps_tree_move_elems_to_left_leaf(tree, leaf_path_elem,
 					&right_ext, move_count);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_leaf, 1 << 0x2);
 			return;
 		}
@@ -4106,6 +4632,8 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 				bps_tree_leaf_overmin_size(left_ext.block) / 2;
 			bps_tree_move_elems_to_right_leaf(tree, &left_ext,
 					leaf_path_elem, move_count);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_leaf, 1 << 0x3);
 			return;
 		}
@@ -4121,6 +4649,8 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 					leaf_path_elem, move_count1);
 			bps_tree_move_elems_to_right_leaf(tree, &left_left_ext,
 					&left_ext, move_count2);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_leaf, 1 << 0x4);
 			return;
 		}
@@ -4131,6 +4661,8 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 				/ 2;
 			bps_tree_move_elems_to_left_leaf(tree, leaf_path_elem,
 					&right_ext, move_count);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_leaf, 1 << 0x5);
 			return;
 		}
@@ -4146,6 +4678,8 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 					&right_ext, move_count1);
 			bps_tree_move_elems_to_left_leaf(tree, &right_ext,
 					&right_right_ext, move_count2);
+			bps_tree_path_update_cards(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_leaf, 1 << 0x6);
 			return;
 		}
@@ -4181,6 +4715,8 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 	} else if (has_left_ext) {
 		if (leaf_path_elem->block->header.size +
 		    left_ext.block->header.size > BPS_TREE_MAX_COUNT_IN_LEAF) {
+			bps_tree_path_add_card(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_leaf, 1 << 0xA);
 			return;
 		}
@@ -4191,6 +4727,8 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 	} else if (has_right_ext) {
 		if (leaf_path_elem->block->header.size +
 		    right_ext.block->header.size > BPS_TREE_MAX_COUNT_IN_LEAF) {
+			bps_tree_path_add_card(tree, leaf_path_elem->parent,
+					leaf_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_leaf, 1 << 0xC);
 			return;
 		}
@@ -4217,6 +4755,9 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 	}
 
 	assert(leaf_path_elem->block->header.size == 0);
+	assert(leaf_path_elem->parent);
+	bps_tree_inner_update_cards(tree, leaf_path_elem->parent,
+				    leaf_path_elem->pos_in_parent);
 
 	struct bps_leaf *leaf = (struct bps_leaf*)leaf_path_elem->block;
 	if (leaf->prev_id == (bps_tree_block_id_t)(-1)) {
@@ -4253,6 +4794,8 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 
 	if (inner_path_elem->block->header.size >=
 	    BPS_TREE_MAX_COUNT_IN_INNER * 2 / 3) {
+		bps_tree_path_add_card(tree, inner_path_elem->parent,
+				       inner_path_elem->pos_in_parent, -1);
 		BPS_TREE_BRANCH_TRACE(tree, delete_inner, 1 << 0x0);
 		return;
 	}
@@ -4277,6 +4820,9 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 				/ 2;
 			bps_tree_move_elems_to_right_inner(tree, &left_ext,
 					inner_path_elem, move_count);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_inner, 1 << 0x1);
 			return;
 		} else if (bps_tree_inner_overmin_size(right_ext.block) > 0) {
@@ -4286,6 +4832,9 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 			bps_tree_move_elems_to_left_inner(tree,
 					inner_path_elem, &right_ext,
 					move_count);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_inner, 1 << 0x2);
 			return;
 		}
@@ -4296,6 +4845,9 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 				/ 2;
 			bps_tree_move_elems_to_right_inner(tree, &left_ext,
 					inner_path_elem, move_count);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_inner, 1 << 0x3);
 			return;
 		}
@@ -4312,6 +4864,9 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 					inner_path_elem, move_count1);
 			bps_tree_move_elems_to_right_inner(tree,
 					&left_left_ext, &left_ext, move_count2);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_inner, 1 << 0x4);
 			return;
 		}
@@ -4323,6 +4878,9 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 			bps_tree_move_elems_to_left_inner(tree,
 					inner_path_elem, &right_ext,
 					move_count);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_inner, 1 << 0x5);
 			return;
 		}
@@ -4339,6 +4897,9 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 					&right_ext, move_count1);
 			bps_tree_move_elems_to_left_inner(tree, &right_ext,
 					&right_right_ext, move_count2);
+			bps_tree_path_update_cards(tree,
+					inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_inner, 1 << 0x6);
 			return;
 		}
@@ -4374,6 +4935,8 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 	} else if (has_left_ext) {
 		if (inner_path_elem->block->header.size +
 		    left_ext.block->header.size > BPS_TREE_MAX_COUNT_IN_INNER) {
+			bps_tree_path_add_card(tree, inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_inner, 1 << 0xA);
 			//throw 1;
 			return;
@@ -4386,6 +4949,8 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 		if (inner_path_elem->block->header.size +
 		    right_ext.block->header.size >
 		    BPS_TREE_MAX_COUNT_IN_INNER) {
+			bps_tree_path_add_card(tree, inner_path_elem->parent,
+					inner_path_elem->pos_in_parent, -1);
 			BPS_TREE_BRANCH_TRACE(tree, delete_inner, 1 << 0xC);
 			//throw 2;
 			return;
@@ -4409,6 +4974,9 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 		return;
 	}
 	assert(inner_path_elem->block->header.size == 0);
+	assert(inner_path_elem->parent);
+	bps_tree_inner_update_cards(tree, inner_path_elem->parent,
+				    inner_path_elem->pos_in_parent);
 
 	bps_tree_dispose_inner(tree, inner_path_elem->block,
 			inner_path_elem->block_id);
@@ -4627,13 +5195,22 @@ bps_tree_debug_check_block(const struct bps_tree *tree, struct bps_block *block,
 				result |= 0x4000000;
 		}
 
-		for (bps_tree_pos_t i = 0; i < block->size; i++)
+		for (bps_tree_pos_t i = 0; i < block->size; i++) {
+			size_t child_count = *calc_count;
 			result |= bps_tree_debug_check_block(tree,
 				bps_tree_restore_block(tree,
 						       inner->child_ids[i]),
 				inner->child_ids[i], level - 1, calc_count,
 				expected_prev_id, expected_this_id,
 				check_fullness_next);
+			child_count = *calc_count - child_count;
+#ifdef BPS_INNER_CARD
+			if (inner->child_cards[i] != child_count)
+				result |= 0x8000000;
+#else
+			(void) child_count;
+#endif
+		}
 		return result;
 	}
 }
@@ -5457,7 +6034,7 @@ bps_tree_debug_check_insert_into_inner(struct bps_tree *tree, bool assertme)
 
 			bps_tree_insert_into_inner(tree, &path_elem,
 				(bps_tree_block_id_t) j, (bps_tree_pos_t) j,
-				ins);
+				ins, 0);
 
 			for (unsigned int k = 0; k <= i; k++) {
 				if (bps_tree_debug_get_elem_inner(&path_elem, k)
@@ -5812,7 +6389,7 @@ bps_tree_debug_check_insert_and_move_to_right_inner(struct bps_tree *tree,
 						tree, &a_path_elem,
 						&b_path_elem,
 						(bps_tree_pos_t) u, ikk,
-						(bps_tree_pos_t) k, ins);
+						(bps_tree_pos_t) k, ins, 0);
 
 					if (a.header.size
 						!= (bps_tree_pos_t) (i - u + 1)) {
@@ -5939,7 +6516,7 @@ bps_tree_debug_check_insert_and_move_to_left_inner(struct bps_tree *tree,
 						tree, &a_path_elem,
 						&b_path_elem,
 						(bps_tree_pos_t) u, ikk,
-						(bps_tree_pos_t) k, ins);
+						(bps_tree_pos_t) k, ins, 0);
 
 					if (a.header.size
 						!= (bps_tree_pos_t) (i + u)) {
@@ -6067,6 +6644,9 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_lower_bound_elem
 #undef bps_tree_upper_bound_elem
 #undef bps_tree_approximate_count
+#undef bps_tree_lower_bound_get_offset
+#undef bps_tree_upper_bound_get_offset
+#undef bps_tree_iterator_at
 #undef bps_tree_iterator_get_elem
 #undef bps_tree_iterator_next
 #undef bps_tree_iterator_prev
@@ -6105,6 +6685,10 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_collect_path
 #undef bps_tree_touch_leaf_path_max_elem
 #undef bps_tree_touch_path
+#undef bps_tree_block_card
+#undef bps_tree_path_add_card
+#undef bps_tree_inner_update_cards
+#undef bps_tree_path_update_cards
 #undef bps_tree_process_replace
 #undef bps_tree_debug_memmove
 #undef bps_tree_insert_into_leaf
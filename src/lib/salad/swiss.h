@@ -0,0 +1,1311 @@
+/*
+ * *No header guard*: the header is allowed to be included twice
+ * with different sets of defines.
+ */
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Open addressing hash table with group probing.
+ *
+ * Slots are split into groups of SWISS_GROUP_SIZE. Every slot has
+ * a control byte that is either EMPTY, DELETED, or holds 7 bits
+ * of the value hash. A lookup compares all control bytes of a
+ * group at once (with SSE2 if available) and looks at a value
+ * only if its 7 bits match, so most mismatches never touch the
+ * value itself. The full 32-bit hash is also kept in the group
+ * and compared before calling the user comparison function.
+ *
+ * The table has the same interface as light.h: values are
+ * addressed by positions, memory is managed by matras and
+ * an iterator may be frozen to see a consistent read view.
+ *
+ * The table is resized incrementally. When it is about to run out
+ * of space, a new table is allocated a few groups per insertion.
+ * When it does run out of space, the new table takes over and each
+ * following modification moves SWISS_MIGRATE_STEP groups of the
+ * old table to the new one. Meanwhile lookups check both tables.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "small/matras.h"
+
+/**
+ * Additional user defined name that appended to prefix 'swiss'
+ *  for all names of structs and functions in this header file.
+ * All names use pattern: swiss<SWISS_NAME>_<name of func/struct>
+ * May be empty, but still have to be defined (just #define SWISS_NAME)
+ * Example:
+ * #define SWISS_NAME _test
+ * ...
+ * struct swiss_test_core hash_table;
+ * swiss_test_create(&hash_table, ...);
+ */
+#ifndef SWISS_NAME
+#error "SWISS_NAME must be defined"
+#endif
+
+/**
+ * Data type that hash table holds.
+ */
+#ifndef SWISS_DATA_TYPE
+#error "SWISS_DATA_TYPE must be defined"
+#endif
+
+/**
+ * Data type that used to for finding values.
+ */
+#ifndef SWISS_KEY_TYPE
+#error "SWISS_KEY_TYPE must be defined"
+#endif
+
+/**
+ * Type of optional third parameter of comparing function.
+ * If not needed, simply use #define SWISS_CMP_ARG_TYPE int
+ */
+#ifndef SWISS_CMP_ARG_TYPE
+#error "SWISS_CMP_ARG_TYPE must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value1, value2 and
+ * optional value that stored in hash table struct.
+ * Third parameter may be simply ignored like that:
+ * #define SWISS_EQUAL(a, b, garb) a == b
+ */
+#ifndef SWISS_EQUAL
+#error "SWISS_EQUAL must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value, key and
+ * optional value that stored in hash table struct.
+ * Third parameter may be simply ignored like that:
+ * #define SWISS_EQUAL_KEY(a, b, garb) a == b
+ */
+#ifndef SWISS_EQUAL_KEY
+#error "SWISS_EQUAL_KEY must be defined"
+#endif
+
+/**
+ * Tools for name substitution:
+ */
+#ifndef CONCAT4
+#define CONCAT4_R(a, b, c, d) a##b##c##d
+#define CONCAT4(a, b, c, d) CONCAT4_R(a, b, c, d)
+#endif
+
+#ifdef _
+#error '_' must be undefinded!
+#endif
+#define SWISS(name) CONCAT4(swiss, SWISS_NAME, _, name)
+
+/*
+ * Definitions that do not depend on the data type.
+ */
+#ifndef SWISS_GROUP_SIZE
+
+/** Number of slots in a group, i.e. probed at once. */
+#define SWISS_GROUP_SIZE 16
+
+enum {
+	/** Control byte of a slot that never held a value. */
+	SWISS_CTRL_EMPTY = 0x80,
+	/** Control byte of a slot which value was deleted. */
+	SWISS_CTRL_DELETED = 0xFE,
+};
+
+/**
+ * Max number of values per group on average. A table is resized
+ * when it gets that full, so probing rarely goes far.
+ */
+enum { SWISS_GROUP_LOAD = 14 };
+
+/**
+ * Number of old table groups moved to a new table per insertion,
+ * deletion or replacement.
+ */
+enum { SWISS_MIGRATE_STEP = 2 };
+
+/**
+ * Number of groups of the next table allocated per insertion,
+ * see SWISS(prepare). The next table is at most twice as large
+ * as the current one and its allocation starts when there is
+ * room for one value per group left, so two groups per insertion
+ * are enough for it to be ready in time.
+ */
+enum { SWISS_PREPARE_STEP = 2 };
+
+/**
+ * Max number of groups in a table. Limits positions of both
+ * tables existing during resize to uint32_t range.
+ */
+enum { SWISS_MAX_GROUPS = 1 << 27 };
+
+/** Mask of slots of the group having the given control byte. */
+static inline uint32_t
+swiss_group_match(const uint8_t *ctrl, uint8_t byte)
+{
+#if defined(__SSE2__)
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	__m128i match = _mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte));
+	return (uint32_t)_mm_movemask_epi8(match);
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++)
+		mask |= (uint32_t)(ctrl[i] == byte) << i;
+	return mask;
+#endif
+}
+
+/** Mask of slots of the group that are empty or deleted. */
+static inline uint32_t
+swiss_group_match_free(const uint8_t *ctrl)
+{
+#if defined(__SSE2__)
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return (uint32_t)_mm_movemask_epi8(group);
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++)
+		mask |= (uint32_t)(ctrl[i] >> 7) << i;
+	return mask;
+#endif
+}
+
+/** Mask of slots of the group that hold a value. */
+static inline uint32_t
+swiss_group_match_full(const uint8_t *ctrl)
+{
+	return ~swiss_group_match_free(ctrl) &
+	       ((1U << SWISS_GROUP_SIZE) - 1);
+}
+
+/**
+ * Spread a 32-bit hash over 64 bits. Upper bits of the product
+ * choose the group, lower ones make the control byte, so both
+ * depend on every bit of the hash even if the hash is weak.
+ */
+static inline uint64_t
+swiss_hash_mix(uint32_t hash)
+{
+	return (uint64_t)hash * 0x9E3779B97F4A7C15ULL;
+}
+
+/** Position of the first group to probe. */
+static inline uint32_t
+swiss_h1(uint64_t mix)
+{
+	return (uint32_t)(mix >> 32);
+}
+
+/** Control byte of a slot holding a value with the hash. */
+static inline uint8_t
+swiss_h2(uint64_t mix)
+{
+	return (uint8_t)(mix >> 25) & 0x7F;
+}
+
+#endif /* SWISS_GROUP_SIZE */
+
+/**
+ * Group of slots, one group per matras block.
+ */
+struct SWISS(group) {
+	union {
+		struct {
+			/* control bytes, see SWISS_CTRL_* */
+			uint8_t ctrl[SWISS_GROUP_SIZE];
+			/* hashes of the values */
+			uint32_t hash[SWISS_GROUP_SIZE];
+			/* the values */
+			SWISS_DATA_TYPE value[SWISS_GROUP_SIZE];
+		};
+		/* Round group size up to nearest power of two. */
+		uint8_t padding[1 << (32 - __builtin_clz(SWISS_GROUP_SIZE *
+				(1 + sizeof(uint32_t) +
+				 sizeof(SWISS_DATA_TYPE)) - 1))];
+	};
+};
+
+/**
+ * Type of functions for memory allocation and deallocation
+ */
+typedef void *(*SWISS(extent_alloc_t))(void *ctx);
+typedef void (*SWISS(extent_free_t))(void *ctx, void *extent);
+
+/**
+ * Array of groups. A hash table has two of them while it is
+ * being resized. Frozen iterators keep a table they look at
+ * alive after the hash table is done with it.
+ */
+struct SWISS(table) {
+	/* dynamic storage for groups */
+	struct matras mtable;
+	/* number of groups, power of two */
+	uint32_t group_count;
+	/* number of allocated groups, less only for the next table */
+	uint32_t alloc_count;
+	/* number of values that may be put to empty slots */
+	uint32_t growth_left;
+	/* reference counter: the hash table and frozen iterators */
+	uint32_t refs;
+};
+
+/**
+ * Main struct for holding hash table
+ */
+struct SWISS(core) {
+	/* count of values in hash table */
+	uint32_t count;
+	/* number of slots in both tables, positions are below that */
+	uint32_t table_size;
+	/* table to insert to, NULL until the first insertion */
+	struct SWISS(table) *table;
+	/* table being moved to the new one, NULL if not resizing */
+	struct SWISS(table) *old_table;
+	/* number of groups of the old table already moved */
+	uint32_t migrated;
+	/* table being allocated to replace the current one or NULL */
+	struct SWISS(table) *next_table;
+
+	/* additional parameter for data comparison */
+	SWISS_CMP_ARG_TYPE arg;
+
+	/* parameters of tables memory */
+	size_t extent_size;
+	SWISS(extent_alloc_t) extent_alloc_func;
+	SWISS(extent_free_t) extent_free_func;
+	void *alloc_ctx;
+};
+
+/**
+ * Iterator, for iterating all values in hash_table.
+ * It also may be used for restoring one value by key.
+ */
+struct SWISS(iterator) {
+	/* Current position on table (ID of a current slot) */
+	uint32_t slotpos;
+	/* Number of moved groups of the old table when frozen */
+	uint32_t migrated;
+	/* Tables pinned by a frozen iterator, NULL if not frozen */
+	struct SWISS(table) *table[2];
+	/* Versions of matras memory for MVCC */
+	struct matras_view view[2];
+};
+
+/**
+ * Special result of swiss_find that means that nothing was found
+ * Must be equal or greater than possible hash table size
+ */
+static const uint32_t SWISS(end) = 0xFFFFFFFF;
+
+/* Functions declaration */
+
+/**
+ * @brief Hash table construction. Fills struct swiss members.
+ * @param ht - pointer to a hash table struct
+ * @param extent_size - size of allocating memory blocks
+ * @param extent_alloc_func - memory blocks allocation function
+ * @param extent_free_func - memory blocks allocation function
+ * @param alloc_ctx - argument passed to memory block allocator
+ * @param arg - optional parameter to save for comparing function
+ */
+static inline void
+SWISS(create)(struct SWISS(core) *ht, size_t extent_size,
+	      SWISS(extent_alloc_t) extent_alloc_func,
+	      SWISS(extent_free_t) extent_free_func,
+	      void *alloc_ctx, SWISS_CMP_ARG_TYPE arg);
+
+/**
+ * @brief Hash table destruction. Frees all allocated memory
+ * that is not used by frozen iterators.
+ * @param ht - pointer to a hash table struct
+ */
+static inline void
+SWISS(destroy)(struct SWISS(core) *ht);
+
+/**
+ * @brief Find a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - value to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(find)(const struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE data);
+
+/**
+ * @brief Find a record with given hash and key
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - key to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(find_key)(const struct SWISS(core) *ht, uint32_t hash, SWISS_KEY_TYPE data);
+
+/**
+ * @brief Insert a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to insert
+ * @param data - value to insert
+ * @return integer ID of inserted record or swiss_end if failed
+ */
+static inline uint32_t
+SWISS(insert)(struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE data);
+
+/**
+ * @brief Replace a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - value to find and replace
+ * @param replaced - pointer to a value that was stored in table before replace
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(replace)(struct SWISS(core) *ht, uint32_t hash,
+	       SWISS_DATA_TYPE data, SWISS_DATA_TYPE *replaced);
+
+/**
+ * @brief Delete a record from a hash table by given record ID
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record. See SWISS(find) for details.
+ * @return 0 if ok, -1 on memory error (only with freezed iterators)
+ */
+static inline int
+SWISS(delete)(struct SWISS(core) *ht, uint32_t slotpos);
+
+/**
+ * @brief Delete a record from a hash table by that value and its hash.
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record. See SWISS(find) for details.
+ * @return 0 if ok, 1 if not found or -1 on memory error
+ * (only with freezed iterators)
+ */
+static inline int
+SWISS(delete_value)(struct SWISS(core) *ht,
+		    uint32_t hash, SWISS_DATA_TYPE value);
+
+/**
+ * @brief Get a value from a desired position
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record
+ *  ID must be vaild, check it by swiss_pos_valid (asserted).
+ */
+static inline SWISS_DATA_TYPE
+SWISS(get)(struct SWISS(core) *ht, uint32_t slotpos);
+
+/**
+ * @brief Determine if posision holds a value
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record
+ *  ID must be in valid range [0, ht->table_size) (asserted).
+ */
+static inline bool
+SWISS(pos_valid)(struct SWISS(core) *ht, uint32_t slotpos);
+
+/**
+ * @brief Number of memory extents used by the hash table
+ * @param ht - pointer to a hash table struct
+ */
+static inline size_t
+SWISS(extent_count)(const struct SWISS(core) *ht);
+
+/**
+ * @brief Set iterator to the beginning of hash table
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ */
+static inline void
+SWISS(iterator_begin)(const struct SWISS(core) *ht, struct SWISS(iterator) *itr);
+
+/**
+ * @brief Set iterator to position determined by key
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @param hash - hash to find
+ * @param data - key to find
+ */
+static inline void
+SWISS(iterator_key)(const struct SWISS(core) *ht, struct SWISS(iterator) *itr,
+		    uint32_t hash, SWISS_KEY_TYPE data);
+
+/**
+ * @brief Get the value that iterator currently points to
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @return poiner to the value or NULL if iteration is complete
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(iterator_get_and_next)(const struct SWISS(core) *ht,
+			     struct SWISS(iterator) *itr);
+
+/**
+ * @brief Freezes state for given iterator. All following hash table modification
+ * will not apply to that iterator iteration. That iterator should be destroyed
+ * with a swiss_iterator_destroy call after usage.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to freeze
+ */
+static inline void
+SWISS(iterator_freeze)(struct SWISS(core) *ht, struct SWISS(iterator) *itr);
+
+/**
+ * @brief Destroy an iterator that was frozen before. Useless for not frozen
+ * iterators.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to destroy
+ */
+static inline void
+SWISS(iterator_destroy)(struct SWISS(core) *ht, struct SWISS(iterator) *itr);
+
+/* Functions definition */
+
+/**
+ * @brief Hash table construction. Fills struct swiss members.
+ * @param ht - pointer to a hash table struct
+ * @param extent_size - size of allocating memory blocks
+ * @param extent_alloc_func - memory blocks allocation function
+ * @param extent_free_func - memory blocks allocation function
+ * @param alloc_ctx - argument passed to memory block allocator
+ * @param arg - optional parameter to save for comparing function
+ */
+static inline void
+SWISS(create)(struct SWISS(core) *ht, size_t extent_size,
+	      SWISS(extent_alloc_t) extent_alloc_func,
+	      SWISS(extent_free_t) extent_free_func,
+	      void *alloc_ctx, SWISS_CMP_ARG_TYPE arg)
+{
+	ht->count = 0;
+	ht->table_size = 0;
+	ht->table = NULL;
+	ht->old_table = NULL;
+	ht->migrated = 0;
+	ht->next_table = NULL;
+	ht->arg = arg;
+	ht->extent_size = extent_size;
+	ht->extent_alloc_func = extent_alloc_func;
+	ht->extent_free_func = extent_free_func;
+	ht->alloc_ctx = alloc_ctx;
+}
+
+/*
+ * Create a table of given number of groups. The groups are not
+ * allocated yet, see SWISS(table_alloc).
+ */
+static inline struct SWISS(table) *
+SWISS(table_new)(struct SWISS(core) *ht, uint32_t group_count)
+{
+	assert((group_count & (group_count - 1)) == 0);
+	struct SWISS(table) *table = (struct SWISS(table) *)
+		malloc(sizeof(*table));
+	if (table == NULL)
+		return NULL;
+	matras_create(&table->mtable, ht->extent_size,
+		      sizeof(struct SWISS(group)), ht->extent_alloc_func,
+		      ht->extent_free_func, ht->alloc_ctx);
+	table->group_count = group_count;
+	table->alloc_count = 0;
+	table->growth_left = group_count * SWISS_GROUP_LOAD;
+	table->refs = 1;
+	return table;
+}
+
+/*
+ * Allocate up to @a step more empty groups of a table that is
+ * not in use yet. Returns 0 if ok, -1 on memory error.
+ */
+static inline int
+SWISS(table_alloc)(struct SWISS(table) *table, uint32_t step)
+{
+	for (; step > 0 && table->alloc_count < table->group_count; step--) {
+		matras_id_t id;
+		struct SWISS(group) *group = (struct SWISS(group) *)
+			matras_alloc(&table->mtable, &id);
+		if (group == NULL)
+			return -1;
+		assert(id == table->alloc_count);
+		memset(group->ctrl, SWISS_CTRL_EMPTY, sizeof(group->ctrl));
+		table->alloc_count++;
+	}
+	return 0;
+}
+
+/*
+ * Drop a reference to a table, free it if it was the last one.
+ */
+static inline void
+SWISS(table_unref)(struct SWISS(table) *table)
+{
+	assert(table->refs > 0);
+	if (--table->refs > 0)
+		return;
+	matras_destroy(&table->mtable);
+	free(table);
+}
+
+/**
+ * @brief Hash table destruction. Frees all allocated memory
+ * that is not used by frozen iterators.
+ * @param ht - pointer to a hash table struct
+ */
+static inline void
+SWISS(destroy)(struct SWISS(core) *ht)
+{
+	if (ht->next_table != NULL)
+		SWISS(table_unref)(ht->next_table);
+	if (ht->old_table != NULL)
+		SWISS(table_unref)(ht->old_table);
+	if (ht->table != NULL)
+		SWISS(table_unref)(ht->table);
+	ht->next_table = NULL;
+	ht->old_table = NULL;
+	ht->table = NULL;
+	ht->count = 0;
+	ht->table_size = 0;
+}
+
+/*
+ * Find the table holding given position and make the position
+ * relative to that table.
+ */
+static inline struct SWISS(table) *
+SWISS(pos_table)(const struct SWISS(core) *ht, uint32_t *slotpos)
+{
+	assert(*slotpos < ht->table_size);
+	uint32_t size = ht->table->group_count * SWISS_GROUP_SIZE;
+	if (*slotpos < size)
+		return ht->table;
+	assert(ht->old_table != NULL);
+	*slotpos -= size;
+	return ht->old_table;
+}
+
+/*
+ * Find a value in one table. Groups below @a migrated have been
+ * moved to another table, so values found there are ignored.
+ * Returns a position relative to the table.
+ */
+static inline uint32_t
+SWISS(table_find)(const struct SWISS(core) *ht,
+		  const struct SWISS(table) *table, uint32_t migrated,
+		  uint32_t hash, SWISS_DATA_TYPE value)
+{
+	(void)ht; /* may be unused by the comparison macro */
+	uint64_t mix = swiss_hash_mix(hash);
+	uint8_t h2 = swiss_h2(mix);
+	uint32_t mask = table->group_count - 1;
+	uint32_t g = swiss_h1(mix) & mask;
+	for (uint32_t step = 1; step <= table->group_count; step++) {
+		const struct SWISS(group) *group = (const struct SWISS(group) *)
+			matras_get(&table->mtable, g);
+		uint32_t match = g < migrated ? 0 :
+				 swiss_group_match(group->ctrl, h2);
+		while (match != 0) {
+			uint32_t i = __builtin_ctz(match);
+			if (group->hash[i] == hash &&
+			    SWISS_EQUAL((group->value[i]), (value), (ht->arg)))
+				return g * SWISS_GROUP_SIZE + i;
+			match &= match - 1;
+		}
+		if (swiss_group_match(group->ctrl, SWISS_CTRL_EMPTY) != 0)
+			return SWISS(end);
+		g = (g + step) & mask;
+	}
+	return SWISS(end);
+}
+
+/*
+ * Same as table_find, but looks for a key.
+ */
+static inline uint32_t
+SWISS(table_find_key)(const struct SWISS(core) *ht,
+		      const struct SWISS(table) *table, uint32_t migrated,
+		      uint32_t hash, SWISS_KEY_TYPE key)
+{
+	(void)ht; /* may be unused by the comparison macro */
+	uint64_t mix = swiss_hash_mix(hash);
+	uint8_t h2 = swiss_h2(mix);
+	uint32_t mask = table->group_count - 1;
+	uint32_t g = swiss_h1(mix) & mask;
+	for (uint32_t step = 1; step <= table->group_count; step++) {
+		const struct SWISS(group) *group = (const struct SWISS(group) *)
+			matras_get(&table->mtable, g);
+		uint32_t match = g < migrated ? 0 :
+				 swiss_group_match(group->ctrl, h2);
+		while (match != 0) {
+			uint32_t i = __builtin_ctz(match);
+			if (group->hash[i] == hash &&
+			    SWISS_EQUAL_KEY((group->value[i]), (key), (ht->arg)))
+				return g * SWISS_GROUP_SIZE + i;
+			match &= match - 1;
+		}
+		if (swiss_group_match(group->ctrl, SWISS_CTRL_EMPTY) != 0)
+			return SWISS(end);
+		g = (g + step) & mask;
+	}
+	return SWISS(end);
+}
+
+/**
+ * @brief Find a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - value to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(find)(const struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE value)
+{
+	if (ht->count == 0)
+		return SWISS(end);
+	uint32_t pos = SWISS(table_find)(ht, ht->table, 0, hash, value);
+	if (pos != SWISS(end) || ht->old_table == NULL)
+		return pos;
+	pos = SWISS(table_find)(ht, ht->old_table, ht->migrated, hash, value);
+	if (pos == SWISS(end))
+		return SWISS(end);
+	return ht->table->group_count * SWISS_GROUP_SIZE + pos;
+}
+
+/**
+ * @brief Find a record with given hash and key
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - key to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(find_key)(const struct SWISS(core) *ht, uint32_t hash, SWISS_KEY_TYPE key)
+{
+	if (ht->count == 0)
+		return SWISS(end);
+	uint32_t pos = SWISS(table_find_key)(ht, ht->table, 0, hash, key);
+	if (pos != SWISS(end) || ht->old_table == NULL)
+		return pos;
+	pos = SWISS(table_find_key)(ht, ht->old_table, ht->migrated,
+				    hash, key);
+	if (pos == SWISS(end))
+		return SWISS(end);
+	return ht->table->group_count * SWISS_GROUP_SIZE + pos;
+}
+
+static inline int
+SWISS(migrate)(struct SWISS(core) *ht, uint32_t step);
+
+/**
+ * @brief Replace a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - value to find and replace
+ * @param replaced - pointer to a value that was stored in table before replace
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(replace)(struct SWISS(core) *ht, uint32_t hash,
+	       SWISS_DATA_TYPE value, SWISS_DATA_TYPE *replaced)
+{
+	/*
+	 * Make progress with the resize, see SWISS(migrate).
+	 * A memory error is not fatal: the groups will be moved
+	 * by a following modification.
+	 */
+	if (ht->old_table != NULL)
+		(void)SWISS(migrate)(ht, SWISS_MIGRATE_STEP);
+	uint32_t slotpos = SWISS(find)(ht, hash, value);
+	if (slotpos == SWISS(end))
+		return SWISS(end);
+	uint32_t pos = slotpos;
+	struct SWISS(table) *table = SWISS(pos_table)(ht, &pos);
+	struct SWISS(group) *group = (struct SWISS(group) *)
+		matras_touch(&table->mtable, pos / SWISS_GROUP_SIZE);
+	if (group == NULL)
+		return SWISS(end);
+	*replaced = group->value[pos % SWISS_GROUP_SIZE];
+	group->value[pos % SWISS_GROUP_SIZE] = value;
+	return slotpos;
+}
+
+/*
+ * Put a value to the first free slot on its probe sequence.
+ * The table must have room for it. Returns a position relative
+ * to the table or swiss_end on memory error.
+ */
+static inline uint32_t
+SWISS(table_insert)(struct SWISS(table) *table, uint32_t hash,
+		    SWISS_DATA_TYPE value)
+{
+	assert(table->growth_left > 0);
+	uint64_t mix = swiss_hash_mix(hash);
+	uint32_t mask = table->group_count - 1;
+	uint32_t g = swiss_h1(mix) & mask;
+	for (uint32_t step = 1; ; step++) {
+		assert(step <= table->group_count);
+		const struct SWISS(group) *group = (const struct SWISS(group) *)
+			matras_get(&table->mtable, g);
+		uint32_t match = swiss_group_match_free(group->ctrl);
+		if (match == 0) {
+			g = (g + step) & mask;
+			continue;
+		}
+		uint32_t i = __builtin_ctz(match);
+		struct SWISS(group) *wgroup = (struct SWISS(group) *)
+			matras_touch(&table->mtable, g);
+		if (wgroup == NULL)
+			return SWISS(end);
+		if (wgroup->ctrl[i] == SWISS_CTRL_EMPTY)
+			table->growth_left--;
+		wgroup->ctrl[i] = swiss_h2(mix);
+		wgroup->hash[i] = hash;
+		wgroup->value[i] = value;
+		return g * SWISS_GROUP_SIZE + i;
+	}
+}
+
+/*
+ * Free a slot of a table. Returns 0 if ok, -1 on memory error.
+ */
+static inline int
+SWISS(table_delete)(struct SWISS(table) *table, uint32_t pos)
+{
+	struct SWISS(group) *group = (struct SWISS(group) *)
+		matras_touch(&table->mtable, pos / SWISS_GROUP_SIZE);
+	if (group == NULL)
+		return -1;
+	uint32_t i = pos % SWISS_GROUP_SIZE;
+	assert(group->ctrl[i] < SWISS_CTRL_EMPTY);
+	if (swiss_group_match(group->ctrl, SWISS_CTRL_EMPTY) != 0) {
+		/*
+		 * A group with an empty slot has never been full,
+		 * so no probe sequence goes through it and the
+		 * slot may become empty again.
+		 */
+		group->ctrl[i] = SWISS_CTRL_EMPTY;
+		table->growth_left++;
+	} else {
+		group->ctrl[i] = SWISS_CTRL_DELETED;
+	}
+	return 0;
+}
+
+/*
+ * Move up to @a step groups of the old table to the new one.
+ * Drops the old table when all its groups are moved. Called on
+ * every insertion, deletion and replacement during a resize, so
+ * workloads that don't insert also get rid of the old table.
+ */
+static inline int
+SWISS(migrate)(struct SWISS(core) *ht, uint32_t step)
+{
+	struct SWISS(table) *old_table = ht->old_table;
+	assert(old_table != NULL);
+	for (; step > 0 && ht->migrated < old_table->group_count; step--) {
+		const struct SWISS(group) *group = (const struct SWISS(group) *)
+			matras_get(&old_table->mtable, ht->migrated);
+		uint32_t moved[SWISS_GROUP_SIZE];
+		uint32_t moved_count = 0;
+		uint32_t match = swiss_group_match_full(group->ctrl);
+		while (match != 0) {
+			uint32_t i = __builtin_ctz(match);
+			uint32_t pos = SWISS(table_insert)(ht->table,
+							   group->hash[i],
+							   group->value[i]);
+			if (pos == SWISS(end)) {
+				/*
+				 * Roll back the group so that no value
+				 * is stored twice. The slots have just
+				 * been touched, so it can't fail.
+				 */
+				while (moved_count > 0) {
+					int rc = SWISS(table_delete)(ht->table,
+						moved[--moved_count]);
+					assert(rc == 0);
+					(void)rc;
+				}
+				return -1;
+			}
+			moved[moved_count++] = pos;
+			match &= match - 1;
+		}
+		ht->migrated++;
+	}
+	if (ht->migrated == old_table->group_count) {
+		ht->old_table = NULL;
+		ht->migrated = 0;
+		ht->table_size = ht->table->group_count * SWISS_GROUP_SIZE;
+		SWISS(table_unref)(old_table);
+	}
+	return 0;
+}
+
+/*
+ * Number of groups of the table to replace the current one with:
+ * twice as many, unless the current table is mostly filled with
+ * deleted slots. Returns 0 if the table can't grow any more.
+ */
+static inline uint32_t
+SWISS(next_group_count)(const struct SWISS(core) *ht)
+{
+	uint32_t group_count = ht->table->group_count;
+	if (ht->count < group_count * SWISS_GROUP_LOAD / 2)
+		return group_count;
+	if (group_count >= SWISS_MAX_GROUPS)
+		return 0;
+	return group_count * 2;
+}
+
+/*
+ * Allocate the table to replace the current one step by step
+ * once the current table is close to running out of empty
+ * slots, so that no insertion has to allocate and initialize
+ * a whole table. See also SWISS_PREPARE_STEP.
+ */
+static inline int
+SWISS(prepare)(struct SWISS(core) *ht)
+{
+	if (ht->next_table == NULL) {
+		if (ht->old_table != NULL ||
+		    ht->table->growth_left > ht->table->group_count)
+			return 0;
+		uint32_t group_count = SWISS(next_group_count)(ht);
+		if (group_count == 0)
+			return 0;
+		ht->next_table = SWISS(table_new)(ht, group_count);
+		if (ht->next_table == NULL)
+			return -1;
+	}
+	return SWISS(table_alloc)(ht->next_table, SWISS_PREPARE_STEP);
+}
+
+/*
+ * Start moving values to the next table when the current one
+ * is out of empty slots.
+ */
+static inline int
+SWISS(grow)(struct SWISS(core) *ht)
+{
+	/*
+	 * The previous resize is complete by now unless migration
+	 * failed with a memory error. Every insertion moves
+	 * SWISS_MIGRATE_STEP groups, so a resize is over after
+	 * group_count / 2 insertions, while the new table is at
+	 * most half full when the resize starts and so it has room
+	 * for group_count * SWISS_GROUP_LOAD / 2 more values. So
+	 * this only finishes a resize stalled by memory errors.
+	 */
+	if (ht->old_table != NULL &&
+	    SWISS(migrate)(ht, ht->old_table->group_count) != 0)
+		return -1;
+	assert(ht->old_table == NULL);
+	uint32_t group_count = SWISS(next_group_count)(ht);
+	if (group_count == 0)
+		return -1;
+	if (ht->next_table != NULL &&
+	    ht->next_table->group_count < group_count) {
+		/* Too many values were inserted since preparation. */
+		SWISS(table_unref)(ht->next_table);
+		ht->next_table = NULL;
+	}
+	if (ht->next_table == NULL) {
+		ht->next_table = SWISS(table_new)(ht, group_count);
+		if (ht->next_table == NULL)
+			return -1;
+	}
+	/* Normally, the table is allocated by now, see SWISS(prepare). */
+	struct SWISS(table) *table = ht->next_table;
+	if (SWISS(table_alloc)(table, table->group_count) != 0)
+		return -1;
+	ht->next_table = NULL;
+	ht->old_table = ht->table;
+	ht->table = table;
+	ht->migrated = 0;
+	ht->table_size = (table->group_count + ht->old_table->group_count) *
+			 SWISS_GROUP_SIZE;
+	return 0;
+}
+
+/**
+ * @brief Insert a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to insert
+ * @param data - value to insert
+ * @return integer ID of inserted record or swiss_end if failed
+ */
+static inline uint32_t
+SWISS(insert)(struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE value)
+{
+	if (ht->table == NULL) {
+		struct SWISS(table) *table = SWISS(table_new)(ht, 1);
+		if (table == NULL)
+			return SWISS(end);
+		if (SWISS(table_alloc)(table, 1) != 0) {
+			SWISS(table_unref)(table);
+			return SWISS(end);
+		}
+		ht->table = table;
+		ht->table_size = SWISS_GROUP_SIZE;
+	}
+	if (ht->old_table != NULL &&
+	    SWISS(migrate)(ht, SWISS_MIGRATE_STEP) != 0)
+		return SWISS(end);
+	if (SWISS(prepare)(ht) != 0)
+		return SWISS(end);
+	if (ht->table->growth_left == 0 && SWISS(grow)(ht) != 0)
+		return SWISS(end);
+	uint32_t slotpos = SWISS(table_insert)(ht->table, hash, value);
+	if (slotpos == SWISS(end))
+		return SWISS(end);
+	ht->count++;
+	return slotpos;
+}
+
+/**
+ * @brief Delete a record from a hash table by given record ID
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record. See SWISS(find) for details.
+ * @return 0 if ok, -1 on memory error (only with freezed iterators)
+ */
+static inline int
+SWISS(delete)(struct SWISS(core) *ht, uint32_t slotpos)
+{
+	struct SWISS(table) *table = SWISS(pos_table)(ht, &slotpos);
+	assert(table == ht->table ||
+	       slotpos / SWISS_GROUP_SIZE >= ht->migrated);
+	if (SWISS(table_delete)(table, slotpos) != 0)
+		return -1;
+	ht->count--;
+	/* Make progress with the resize, see SWISS(replace). */
+	if (ht->old_table != NULL)
+		(void)SWISS(migrate)(ht, SWISS_MIGRATE_STEP);
+	return 0;
+}
+
+/**
+ * @brief Delete a record from a hash table by that value and its hash.
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record. See SWISS(find) for details.
+ * @return 0 if ok, 1 if not found or -1 on memory error
+ * (only with freezed iterators)
+ */
+static inline int
+SWISS(delete_value)(struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE value)
+{
+	uint32_t slotpos = SWISS(find)(ht, hash, value);
+	if (slotpos == SWISS(end))
+		return 1; /* not found */
+	return SWISS(delete)(ht, slotpos);
+}
+
+/**
+ * @brief Get a value from a desired position
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record
+ *  ID must be vaild, check it by swiss_pos_valid (asserted).
+ */
+static inline SWISS_DATA_TYPE
+SWISS(get)(struct SWISS(core) *ht, uint32_t slotpos)
+{
+	assert(SWISS(pos_valid)(ht, slotpos));
+	struct SWISS(table) *table = SWISS(pos_table)(ht, &slotpos);
+	const struct SWISS(group) *group = (const struct SWISS(group) *)
+		matras_get(&table->mtable, slotpos / SWISS_GROUP_SIZE);
+	return group->value[slotpos % SWISS_GROUP_SIZE];
+}
+
+/**
+ * @brief Determine if posision holds a value
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record
+ *  ID must be in valid range [0, ht->table_size) (asserted).
+ */
+static inline bool
+SWISS(pos_valid)(struct SWISS(core) *ht, uint32_t slotpos)
+{
+	struct SWISS(table) *table = SWISS(pos_table)(ht, &slotpos);
+	uint32_t g = slotpos / SWISS_GROUP_SIZE;
+	if (table != ht->table && g < ht->migrated)
+		return false;
+	const struct SWISS(group) *group = (const struct SWISS(group) *)
+		matras_get(&table->mtable, g);
+	return group->ctrl[slotpos % SWISS_GROUP_SIZE] < SWISS_CTRL_EMPTY;
+}
+
+/**
+ * @brief Number of memory extents used by the hash table
+ * @param ht - pointer to a hash table struct
+ */
+static inline size_t
+SWISS(extent_count)(const struct SWISS(core) *ht)
+{
+	size_t count = 0;
+	if (ht->table != NULL)
+		count += matras_extent_count(&ht->table->mtable);
+	if (ht->old_table != NULL)
+		count += matras_extent_count(&ht->old_table->mtable);
+	if (ht->next_table != NULL)
+		count += matras_extent_count(&ht->next_table->mtable);
+	return count;
+}
+
+/**
+ * @brief Set iterator to the beginning of hash table
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ */
+static inline void
+SWISS(iterator_begin)(const struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	(void)ht;
+	itr->slotpos = 0;
+	itr->migrated = 0;
+	itr->table[0] = itr->table[1] = NULL;
+	matras_head_read_view(&itr->view[0]);
+	matras_head_read_view(&itr->view[1]);
+}
+
+/**
+ * @brief Set iterator to position determined by key
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @param hash - hash to find
+ * @param data - key to find
+ */
+static inline void
+SWISS(iterator_key)(const struct SWISS(core) *ht, struct SWISS(iterator) *itr,
+		    uint32_t hash, SWISS_KEY_TYPE data)
+{
+	SWISS(iterator_begin)(ht, itr);
+	itr->slotpos = SWISS(find_key)(ht, hash, data);
+}
+
+/**
+ * @brief Get the value that iterator currently points to
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @return poiner to the value or NULL if iteration is complete
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(iterator_get_and_next)(const struct SWISS(core) *ht,
+			     struct SWISS(iterator) *itr)
+{
+	struct SWISS(table) *table[2];
+	const struct matras_view *view[2];
+	uint32_t migrated;
+	if (itr->table[0] != NULL) {
+		/* Frozen iterator, see the pinned tables. */
+		table[0] = itr->table[0];
+		table[1] = itr->table[1];
+		view[0] = &itr->view[0];
+		view[1] = &itr->view[1];
+		migrated = itr->migrated;
+	} else {
+		table[0] = ht->table;
+		table[1] = ht->old_table;
+		view[0] = table[0] != NULL ? &table[0]->mtable.head : NULL;
+		view[1] = table[1] != NULL ? &table[1]->mtable.head : NULL;
+		migrated = ht->migrated;
+	}
+	uint32_t base = 0;
+	for (int k = 0; k < 2 && table[k] != NULL; k++) {
+		uint32_t size = table[k]->group_count * SWISS_GROUP_SIZE;
+		uint32_t pos = itr->slotpos - base;
+		if (itr->slotpos < base)
+			pos = 0;
+		if (k == 1 && pos < migrated * SWISS_GROUP_SIZE)
+			pos = migrated * SWISS_GROUP_SIZE;
+		while (itr->slotpos != SWISS(end) && pos < size) {
+			uint32_t g = pos / SWISS_GROUP_SIZE;
+			struct SWISS(group) *group = (struct SWISS(group) *)
+				matras_view_get(&table[k]->mtable, view[k], g);
+			uint32_t match = swiss_group_match_full(group->ctrl) &
+					 ~((1U << (pos % SWISS_GROUP_SIZE)) - 1);
+			if (match != 0) {
+				uint32_t i = __builtin_ctz(match);
+				itr->slotpos = base + g * SWISS_GROUP_SIZE + i + 1;
+				return &group->value[i];
+			}
+			pos = (g + 1) * SWISS_GROUP_SIZE;
+		}
+		base += size;
+	}
+	itr->slotpos = SWISS(end);
+	return NULL;
+}
+
+/**
+ * @brief Freezes state for given iterator. All following hash table modification
+ * will not apply to that iterator iteration. That iterator should be destroyed
+ * with a swiss_iterator_destroy call after usage.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to freeze
+ */
+static inline void
+SWISS(iterator_freeze)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	assert(itr->table[0] == NULL);
+	if (ht->table == NULL) {
+		/* Nothing to see now, nothing to see later. */
+		itr->slotpos = SWISS(end);
+		return;
+	}
+	itr->table[0] = ht->table;
+	itr->table[1] = ht->old_table;
+	itr->migrated = ht->migrated;
+	for (int k = 0; k < 2 && itr->table[k] != NULL; k++) {
+		itr->table[k]->refs++;
+		matras_create_read_view(&itr->table[k]->mtable, &itr->view[k]);
+	}
+}
+
+/**
+ * @brief Destroy an iterator that was frozen before. Useless for not frozen
+ * iterators.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to destroy
+ */
+static inline void
+SWISS(iterator_destroy)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	(void)ht;
+	for (int k = 0; k < 2; k++) {
+		if (itr->table[k] == NULL)
+			continue;
+		matras_destroy_read_view(&itr->table[k]->mtable,
+					 &itr->view[k]);
+		SWISS(table_unref)(itr->table[k]);
+		itr->table[k] = NULL;
+	}
+}
+
+/*
+ * Selfcheck of the internal state of one table.
+ */
+static inline int
+SWISS(table_selfcheck)(const struct SWISS(core) *ht,
+		       const struct SWISS(table) *table, uint32_t migrated,
+		       uint32_t *count)
+{
+	int res = 0;
+	if (table->group_count == 0 ||
+	    (table->group_count & (table->group_count - 1)) != 0)
+		res |= 1; /* bad table size */
+	if (table->mtable.head.block_count != table->group_count)
+		res |= 2; /* bad matras size */
+	uint32_t used = 0;
+	uint32_t mask = table->group_count - 1;
+	for (uint32_t g = 0; g < table->group_count; g++) {
+		const struct SWISS(group) *group = (const struct SWISS(group) *)
+			matras_get(&table->mtable, g);
+		for (uint32_t i = 0; i < SWISS_GROUP_SIZE; i++) {
+			uint8_t ctrl = group->ctrl[i];
+			if (ctrl != SWISS_CTRL_EMPTY)
+				used++;
+			if (ctrl == SWISS_CTRL_EMPTY ||
+			    ctrl == SWISS_CTRL_DELETED)
+				continue;
+			if (ctrl >= SWISS_CTRL_EMPTY) {
+				res |= 4; /* bad control byte */
+				continue;
+			}
+			uint64_t mix = swiss_hash_mix(group->hash[i]);
+			if (ctrl != swiss_h2(mix))
+				res |= 8; /* control byte mismatches hash */
+			if (g < migrated)
+				continue;
+			(*count)++;
+			/*
+			 * The value must be reachable: no group
+			 * with an empty slot on its probe sequence.
+			 */
+			uint32_t p = swiss_h1(mix) & mask;
+			for (uint32_t step = 1; p != g; step++) {
+				const struct SWISS(group) *probe =
+					(const struct SWISS(group) *)
+					matras_get(&table->mtable, p);
+				if (swiss_group_match(probe->ctrl,
+						      SWISS_CTRL_EMPTY) != 0 ||
+				    step > table->group_count) {
+					res |= 16; /* value is unreachable */
+					break;
+				}
+				p = (p + step) & mask;
+			}
+			if (SWISS(table_find)(ht, table, migrated,
+					      group->hash[i],
+					      group->value[i]) == SWISS(end))
+				res |= 32; /* value is not found */
+		}
+	}
+	if (table->growth_left + used !=
+	    table->group_count * SWISS_GROUP_LOAD)
+		res |= 64; /* bad growth counter */
+	return res;
+}
+
+/*
+ * Selfcheck of the internal state of hash table. Used only for debugging.
+ * That means that you should not use this function.
+ * If return not zero, something went terribly wrong.
+ */
+static inline int
+SWISS(selfcheck)(const struct SWISS(core) *ht)
+{
+	int res = 0;
+	uint32_t count = 0;
+	uint32_t table_size = 0;
+	if (ht->table != NULL) {
+		res |= SWISS(table_selfcheck)(ht, ht->table, 0, &count);
+		table_size += ht->table->group_count * SWISS_GROUP_SIZE;
+	} else if (ht->old_table != NULL) {
+		res |= 128; /* old table without a new one */
+	}
+	if (ht->old_table != NULL) {
+		res |= SWISS(table_selfcheck)(ht, ht->old_table,
+					      ht->migrated, &count);
+		table_size += ht->old_table->group_count * SWISS_GROUP_SIZE;
+		if (ht->migrated >= ht->old_table->group_count)
+			res |= 256; /* old table is not dropped */
+	}
+	if (count != ht->count)
+		res |= 512; /* bad count */
+	if (table_size != ht->table_size)
+		res |= 1024; /* bad table size */
+	return res;
+}
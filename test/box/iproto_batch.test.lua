@@ -0,0 +1,51 @@
+test_run = require('test_run').new()
+msgpack = require('msgpack')
+json = require('json')
+socket = require('socket')
+--
+-- IPROTO_BATCH executes a list of DML requests in a single
+-- transaction and replies with a tuple or nil for each of them.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.schema.user.grant('guest', 'read,write', 'space', 'test')
+LISTEN = require('uri').parse(box.cfg.listen)
+sock = socket.tcp_connect(LISTEN.host, LISTEN.service)
+greeting = sock:read(128)
+map = {__serialize = 'map'}
+test_run:cmd("setopt delimiter ';'")
+function item(type, body)
+    return {type, setmetatable(body, map)}
+end;
+function batch(sync, items)
+    local header = msgpack.encode(setmetatable({[0x00] = 13,
+                                                [0x01] = sync}, map))
+    local body = msgpack.encode(setmetatable({[0x2c] = items}, map))
+    sock:write(msgpack.encode(#header + #body)..header..body)
+    local len = msgpack.decode(sock:read(5))
+    local data = sock:read(len)
+    local header, pos = msgpack.decode(data)
+    body = msgpack.decode(data, pos)
+    if header[0x00] ~= 0 then
+        return header[0x01], body[0x31]
+    end
+    return header[0x01], json.encode(body[0x30])
+end;
+test_run:cmd("setopt delimiter ''");
+-- INSERT, REPLACE, UPDATE, UPSERT and DELETE.
+batch(1, {item(2, {[0x10] = s.id, [0x21] = {1, 'a'}}), item(2, {[0x10] = s.id, [0x21] = {2, 'b'}}), item(3, {[0x10] = s.id, [0x21] = {1, 'aa'}}), item(4, {[0x10] = s.id, [0x20] = {2}, [0x21] = {{'=', 2, 'bb'}}}), item(9, {[0x10] = s.id, [0x21] = {3, 'c'}, [0x28] = {{'=', 2, 'cc'}}}), item(5, {[0x10] = s.id, [0x20] = {1}})})
+s:select()
+-- A failed request rolls back the whole batch.
+batch(2, {item(2, {[0x10] = s.id, [0x21] = {4, 'd'}}), item(2, {[0x10] = s.id, [0x21] = {2, 'x'}})})
+batch(3, {item(2, {[0x10] = s.id, [0x21] = {5, 'e'}}), item(5, {[0x10] = 12345, [0x20] = {2}})})
+s:select()
+-- Only DML requests can be batched.
+batch(4, {item(2, {[0x10] = s.id, [0x21] = {6, 'f'}}), item(1, {[0x10] = s.id, [0x20] = {}})})
+batch(5, {{2}})
+s:select()
+-- The connection is still usable.
+batch(6, {item(9, {[0x10] = s.id, [0x21] = {3}, [0x28] = {{'=', 2, 'cc'}}})})
+s:select()
+box.stat.BATCH.total >= 4
+sock:close()
+s:drop()
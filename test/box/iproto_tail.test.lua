@@ -0,0 +1,114 @@
+test_run = require('test_run').new()
+net = require('net.box')
+msgpack = require('msgpack')
+fiber = require('fiber')
+socket = require('socket')
+--
+-- A select result set over 64 KB is sent with its tail right
+-- from tuple memory.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+v = box.schema.space.create('test_vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk')
+small = box.schema.space.create('small')
+_ = small:create_index('pk')
+box.schema.user.grant('guest', 'read', 'space', 'test')
+box.schema.user.grant('guest', 'read', 'space', 'test_vinyl')
+box.schema.user.grant('guest', 'read', 'space', 'small')
+for i = 1, 100 do s:insert{i, string.rep(tostring(i % 10), 10000 + i)} end
+for i = 1, 100 do v:insert{i, string.rep(tostring(i % 10), 10000 + i)} end
+for i = 1, 10 do small:insert{i} end
+test_run:cmd("setopt delimiter ';'")
+function encode(tuples)
+    local t = {}
+    for i, tuple in ipairs(tuples) do
+        t[i] = tuple:totable()
+    end
+    return msgpack.encode(t)
+end;
+test_run:cmd("setopt delimiter ''");
+c = net.connect(box.cfg.listen)
+-- The whole result set: 64 KB in the buffer and the tail.
+encode(c.space.test:select()) == encode(s:select())
+-- A tail of a single tuple.
+encode(c.space.test:select({}, {limit = 7})) == encode(s:select({}, {limit = 7}))
+-- Vinyl: the whole result set is sent as a tail.
+encode(c.space.test_vinyl:select()) == encode(v:select())
+--
+-- Replies written to the output buffer after a reply with a
+-- tail are sent after the tail.
+--
+test_run:cmd("setopt delimiter ';'")
+function interleave(count)
+    local expected_big = encode(s:select())
+    local expected_vinyl = encode(v:select())
+    local expected_small = encode(small:select())
+    local errors = {}
+    local done = 0
+    for i = 1, count do
+        fiber.create(function()
+            local ok, res
+            if i % 3 == 0 then
+                ok, res = pcall(c.space.test.select, c.space.test)
+                ok = ok and encode(res) == expected_big
+            elseif i % 3 == 1 then
+                ok, res = pcall(c.space.test_vinyl.select,
+                                c.space.test_vinyl)
+                ok = ok and encode(res) == expected_vinyl
+            else
+                ok, res = pcall(c.space.small.select, c.space.small)
+                ok = ok and encode(res) == expected_small
+            end
+            if not ok then
+                table.insert(errors, i)
+            end
+            done = done + 1
+        end)
+    end
+    while done < count do fiber.sleep(0.01) end
+    return errors
+end;
+test_run:cmd("setopt delimiter ''");
+interleave(60)
+c:ping()
+c:close()
+--
+-- A connection closed while a tail is being sent releases
+-- the tail tuples.
+--
+LISTEN = require('uri').parse(box.cfg.listen)
+test_run:cmd("setopt delimiter ';'")
+function select_request(space_id)
+    local map = {__serialize = 'map'}
+    local header = msgpack.encode(setmetatable({[0x00] = 1, [0x01] = 1},
+                                               map))
+    local body = msgpack.encode(setmetatable({[0x10] = space_id,
+                                              [0x11] = 0,
+                                              [0x12] = 0xFFFFFFFF,
+                                              [0x20] = {}}, map))
+    return msgpack.encode(#header + #body)..header..body
+end;
+function select_and_close(space_id)
+    local sock = socket.tcp_connect(LISTEN.host, LISTEN.service)
+    sock:read(128)
+    -- Read only a part of the reply, so that the rest is
+    -- still pending when the connection is closed.
+    sock:write(select_request(space_id))
+    sock:read(100)
+    sock:close()
+end;
+test_run:cmd("setopt delimiter ''");
+items_used = box.slab.info().items_used
+select_and_close(s.id)
+select_and_close(v.id)
+-- Tuples of the tail are unreferenced and freed on delete.
+for i = 1, 100 do s:delete{i} end
+test_run:wait_cond(function() collectgarbage() return box.slab.info().items_used < items_used - 900000 end)
+-- The server is still serving requests.
+c = net.connect(box.cfg.listen)
+c.space.small:select{3}
+c:close()
+s:drop()
+v:drop()
+small:drop()
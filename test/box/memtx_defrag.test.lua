@@ -0,0 +1,44 @@
+test_run = require('test_run').new()
+
+box.cfg{memtx_defrag_threshold = -1}
+box.cfg{memtx_defrag_threshold = 1}
+
+--
+-- Check that tuple relocation done by the memtx defragmenter
+-- keeps all indexes consistent.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}})
+_ = s:create_index('hash', {type = 'hash', parts = {3, 'string'}})
+for i = 1, 10000 do s:insert{i, 10000 - i, tostring(i), string.rep('x', 100)} end
+for i = 1, 10000, 2 do s:delete(i) end
+-- Tuples referenced from Lua must stay intact.
+t = s:get(2)
+
+stat = box.stat.memtx().defrag
+box.cfg{memtx_defrag_threshold = 0.01}
+test_run:wait_cond(function() return box.stat.memtx().defrag.passes > stat.passes end)
+box.cfg{memtx_defrag_threshold = 0}
+box.stat.memtx().defrag.passes - stat.passes
+-- All tuples but the one referenced from Lua were relocated.
+box.stat.memtx().defrag.relocated - stat.relocated >= 4999
+
+t[1], t[2], t[3], t[4] == string.rep('x', 100)
+s:count()
+s.index.sk:count()
+s.index.hash:count()
+test_run:cmd("setopt delimiter ';'")
+ok = true;
+for i = 2, 10000, 2 do
+    local tuple = s:get(i)
+    if tuple == nil or s.index.sk:get(10000 - i) ~= tuple or
+       s.index.hash:get(tostring(i)) ~= tuple or
+       tuple[4] ~= string.rep('x', 100) then
+        ok = false
+        break
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+ok
+s:drop()
@@ -0,0 +1,34 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Tuples of a memtx space with ttl_field set are deleted in
+-- background once the time stored in the field has passed.
+--
+s = box.schema.space.create('test', {ttl_field = 'x'})
+s = box.schema.space.create('test', {ttl_field = 2})
+pk = s:create_index('pk')
+exp = s:create_index('exp', {parts = {{2, 'number', is_nullable = true}}, unique = false})
+
+-- Expired tuples are deleted in batches.
+now = fiber.time()
+for i = 1, 300 do s:insert{i, i % 2 == 0 and now - 1 or now + 3600} end
+test_run:wait_cond(function() return s:count() == 150 end)
+#exp:select({now}, {iterator = 'LE'})
+
+-- Tuples without expiration time never expire.
+_ = s:insert{1000}
+_ = s:insert{1001, fiber.time() + 0.1}
+test_run:wait_cond(function() return s:get(1001) == nil end)
+s:get(1000)
+s:count()
+
+-- Nothing expires without a TREE index on the TTL field.
+s2 = box.schema.space.create('test2', {ttl_field = 2})
+_ = s2:create_index('pk')
+_ = s2:insert{1, fiber.time() - 1}
+fiber.sleep(1.5)
+s2:count()
+
+s2:drop()
+s:drop()
@@ -0,0 +1,39 @@
+--
+-- Per-space memory accounting and quotas in memtx.
+--
+s = box.schema.space.create('test', {memory_quota = -1})
+s = box.schema.space.create('test', {engine = 'vinyl', memory_quota = 1024 * 1024})
+s = box.schema.space.create('test', {memory_quota = 1024 * 1024})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}})
+
+stat = s.index.pk:stat()
+stat.space.memory_quota
+stat.space.tuples
+stat.space.memory == s.index.pk:bsize() + s.index.sk:bsize()
+s.index.sk:stat().space
+
+for i = 1, 100 do s:insert{i, i, string.rep('x', 100)} end
+stat = s.index.pk:stat()
+stat.space.tuples > s:bsize()
+stat.space.memory == stat.space.tuples + s.index.pk:bsize() + s.index.sk:bsize()
+
+-- Inserts are rejected once the quota is exceeded.
+ok, err = nil
+for i = 101, 100000 do ok, err = pcall(s.insert, s, {i, i, string.rep('x', 100)}) if not ok then break end end
+ok
+err.code == box.error.SPACE_MEMORY_QUOTA
+s.index.pk:stat().space.memory <= 1024 * 1024
+count = s:count()
+s.index.sk:count() == count
+
+-- Updates that don't grow a tuple and deletes are still allowed.
+s:update(1, {{'=', 3, 'y'}})[3]
+s:delete(2)[1]
+s:insert{100001, 100001, string.rep('x', 100)} ~= nil
+s:count() == count
+
+-- The quota can be changed on the fly.
+box.space._space:update(s.id, {{'=', 6, {memory_quota = 0}}}) ~= nil
+s:insert{100002, 100002, string.rep('x', 100)} ~= nil
+s:drop()
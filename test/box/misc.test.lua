@@ -67,6 +67,7 @@ test_run:cmd("setopt delimiter ';'")
 for k, v in pairs(box.stat()) do
     table.insert(t, k)
 end;
+table.sort(t);
 for k, v in pairs(box.stat().DELETE) do
     table.insert(t, k)
 end;
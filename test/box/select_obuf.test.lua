@@ -0,0 +1,74 @@
+test_run = require('test_run').new()
+net = require('net.box')
+msgpack = require('msgpack')
+--
+-- A SELECT from a memtx space over iproto encodes tuples
+-- straight into the output buffer. Check it returns the same
+-- as the port path used by local selects and vinyl spaces,
+-- including results which do not fit in the output buffer
+-- as a whole and end with a tail of referenced tuples.
+--
+m = box.schema.space.create('memtx', {engine = 'memtx'})
+_ = m:create_index('pk')
+_ = m:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+v = box.schema.space.create('vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk')
+_ = v:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 100 do m:insert{i, i % 7, string.rep('x', i * 100)} v:insert{i, i % 7, string.rep('x', i * 100)} end
+box.schema.user.grant('guest', 'read', 'space', 'memtx')
+box.schema.user.grant('guest', 'read', 'space', 'vinyl')
+c = net.connect(box.cfg.listen)
+test_run:cmd("setopt delimiter ';'")
+function encode(tuples)
+    local t = {}
+    for i, tuple in ipairs(tuples) do
+        t[i] = tuple:totable()
+    end
+    return msgpack.encode(t)
+end;
+function check(index, key, opts)
+    local expected = encode(m.index[index]:select(key, opts))
+    local results = {
+        encode(c.space.memtx.index[index]:select(key, opts)),
+        encode(v.index[index]:select(key, opts)),
+        encode(c.space.vinyl.index[index]:select(key, opts)),
+    }
+    for _, r in ipairs(results) do
+        if r ~= expected then
+            return false
+        end
+    end
+    return true
+end;
+iterators = {'EQ', 'REQ', 'GE', 'GT', 'LE', 'LT', 'ALL'};
+offsets = {0, 1, 5, 50, 200};
+limits = {0, 1, 10, 1000};
+keys = {pk = {{}, {50}, {101}}, sk = {{}, {3}, {7}}};
+failed = {};
+for index, index_keys in pairs(keys) do
+    for _, key in ipairs(index_keys) do
+        for _, iterator in ipairs(iterators) do
+            for _, offset in ipairs(offsets) do
+                for _, limit in ipairs(limits) do
+                    local opts = {iterator = iterator, offset = offset,
+                                  limit = limit}
+                    -- ALL does not accept a key in vinyl.
+                    if iterator ~= 'ALL' or #key == 0 then
+                        local ok, res = pcall(check, index, key, opts)
+                        if not ok or not res then
+                            table.insert(failed, {index, key, opts})
+                        end
+                    end
+                end
+            end
+        end
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+failed
+-- Without a limit.
+check('pk', {}, {iterator = 'GE', offset = 10})
+check('sk', {2}, {offset = 3})
+c:close()
+m:drop()
+v:drop()
@@ -0,0 +1,48 @@
+--
+-- TREE index counts tuples in a key range and skips the offset
+-- of a select without iterating over the skipped tuples.
+--
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 1000 do s:insert{i, i % 10} end
+
+pk:count(500, {iterator = 'GE'})
+pk:count(500, {iterator = 'GT'})
+pk:count(500, {iterator = 'LE'})
+pk:count(500, {iterator = 'LT'})
+pk:count(500, {iterator = 'EQ'})
+pk:count(5000, {iterator = 'EQ'})
+sk:count(3)
+sk:count(3, {iterator = 'REQ'})
+sk:count(3, {iterator = 'GT'})
+sk:count(3, {iterator = 'LT'})
+sk:count()
+
+pk:select({}, {offset = 997})
+pk:select({}, {iterator = 'LE', offset = 997})
+pk:select(500, {iterator = 'LT', offset = 2, limit = 2})
+pk:select(500, {iterator = 'GT', offset = 497})
+sk:select(3, {offset = 98})
+sk:select(3, {iterator = 'REQ', offset = 98})
+sk:select(3, {offset = 100})
+
+iterators = {'EQ', 'REQ', 'GE', 'GT', 'LE', 'LT', 'ALL'}
+function check_offset(index, key) local ok = true for _, it in ipairs(iterators) do local all = index:select(key, {iterator = it}) for offset = 0, #all + 1, 7 do local res = index:select(key, {iterator = it, offset = offset}) if #res ~= math.max(#all - offset, 0) then ok = false end for i = 1, #res do if res[i][1] ~= all[i + offset][1] then ok = false end end end end return ok end
+function check_count(index, key) local ok = true for _, it in ipairs(iterators) do if it ~= 'ALL' and index:count(key, {iterator = it}) ~= #index:select(key, {iterator = it}) then ok = false end end return ok end
+
+check_offset(pk, 500)
+check_offset(sk, 3)
+check_count(pk, 500)
+check_count(sk, 3)
+
+-- Counts are kept up to date on deletion.
+for i = 1, 1000, 3 do s:delete{i} end
+pk:count(500, {iterator = 'LE'})
+sk:count(3)
+check_offset(pk, 500)
+check_offset(sk, 3)
+check_count(pk, 500)
+check_count(sk, 3)
+
+s:drop()
@@ -0,0 +1,56 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+box.cfg{replication_compression = -1}
+box.cfg.replication_compression
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+--
+-- The replica asks the master to compress the stream on
+-- SUBSCRIBE, so reconnect to apply the new level.
+--
+test_run:cmd("switch replica")
+replication = box.cfg.replication
+box.cfg{replication_compression = 3}
+box.cfg{replication = ''}
+box.cfg{replication = replication}
+box.info.replication[1].upstream.status
+test_run:cmd("switch default")
+-- A big batch of compressible rows, then small ones.
+box.begin() for i = 1, 10000 do s:insert{i, string.rep('x', 100)} end box.commit()
+for i = 10001, 10010 do s:insert{i} end
+_ = test_run:wait_vclock('replica', test_run:get_vclock('default'))
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get{5000}
+box.space.test:get{10005}
+box.info.replication[1].upstream.status
+-- Reconnect: the master starts a new stream, so must the replica.
+box.cfg{replication = ''}
+box.cfg{replication = replication}
+test_run:cmd("switch default")
+for i = 10011, 10020 do s:insert{i, string.rep('z', 100)} end
+_ = test_run:wait_vclock('replica', test_run:get_vclock('default'))
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get{10015}
+box.info.replication[1].upstream.status
+-- Switch compression off.
+box.cfg{replication_compression = 0}
+box.cfg{replication = ''}
+box.cfg{replication = replication}
+test_run:cmd("switch default")
+for i = 1, 10000 do s:update(i, {{'=', 2, string.rep('y', 100)}}) end
+_ = test_run:wait_vclock('replica', test_run:get_vclock('default'))
+test_run:cmd("switch replica")
+box.space.test:get{5000}
+box.info.replication[1].upstream.status
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+box.schema.user.revoke('guest', 'replication')
+s:drop()
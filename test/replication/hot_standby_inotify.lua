@@ -0,0 +1,14 @@
+#!/usr/bin/env tarantool
+
+require('console').listen(os.getenv('ADMIN'))
+box.cfg({
+    listen              = os.getenv("MASTER"),
+    memtx_memory        = 107374182,
+    custom_proc_title   = "hot_standby",
+    wal_dir             = "master",
+    memtx_dir           = "master",
+    vinyl_dir           = "master",
+    hot_standby         = true,
+    -- Follow the WAL by file system events only.
+    wal_dir_rescan_delay = 1000,
+})
@@ -0,0 +1,30 @@
+test_run = require('test_run').new()
+--
+-- Hot standby follows the WAL by file system events. Check it
+-- keeps up with WAL rotations, including removal of the file
+-- it watches by garbage collection, without falling back on
+-- the periodic rescan of the WAL dir.
+--
+default_checkpoint_count = box.cfg.checkpoint_count
+box.cfg{checkpoint_count = 1}
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+test_run:cmd("create server hot_standby with script='replication/hot_standby_inotify.lua', rpl_master=default")
+test_run:cmd("start server hot_standby")
+test_run:cmd("switch hot_standby")
+test_run = require('test_run').new()
+test_run:wait_cond(function() return box.space.test ~= nil end, 10)
+test_run:cmd("switch default")
+for i = 1, 5 do for j = 1, 10 do s:insert{i * 10 + j} end box.snapshot() test_run:wait_lsn('hot_standby', 'default') end
+s:insert{100}
+test_run:cmd("switch hot_standby")
+vclock = test_run:get_vclock('default')
+test_run:wait_cond(function() return box.info.vclock[1] == vclock[1] end, 10)
+box.space.test:count()
+box.space.test:get{100}
+test_run:cmd("switch default")
+test_run:cmd("stop server hot_standby")
+test_run:cmd("cleanup server hot_standby")
+test_run:cmd("delete server hot_standby")
+s:drop()
+box.cfg{checkpoint_count = default_checkpoint_count}
@@ -0,0 +1,26 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+--
+-- Initial join rows are sent in batches of up to 1 MB. Check
+-- a replica joins correctly when the data takes many batches
+-- and rows come close to the batch size.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+for i = 1, 20000 do s:insert{i, string.rep('x', i % 100)} end
+for i = 1, 5 do s:insert{20000 + i, string.rep('y', 200000 * i)} end
+for i = 20006, 30000 do s:insert{i} end
+box.snapshot()
+checksum = "local crc = require('digest').crc32.new() for _, t in box.space.test:pairs() do crc:update(require('msgpack').encode(t)) end return crc:result()"
+master_checksum = loadstring(checksum)()
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:eval('replica', 'return box.space.test:count()')
+test_run:eval('replica', checksum)[1] == master_checksum
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+box.schema.user.revoke('guest', 'replication')
+s:drop()
@@ -0,0 +1,59 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+box.cfg.replication_join_files
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 1000 do s:insert{i, i % 10} end
+box.snapshot()
+-- Rows written after the checkpoint are sent on final join.
+for i = 1001, 1100 do s:insert{i, i % 10} end
+s:delete{1}
+--
+-- The replica asks for checkpoint files on initial join
+-- and recovers from them.
+--
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_join_files.lua'")
+test_run:cmd("start server replica")
+test_run:grep_log('replica', 'checkpoint files received') ~= nil
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test.index.sk:count(5)
+box.space.test:get{1}
+box.space.test:get{1100}
+box.info.replication[1].upstream.status
+box.snapshot()
+test_run:cmd("switch default")
+s:insert{1101, 1}
+-- The replica restarts from its own checkpoint.
+test_run:cmd("restart server replica")
+_ = test_run:wait_vclock('replica', test_run:get_vclock('default'))
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get{1101}
+box.info.replication[1].upstream.status
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cleanup_cluster()
+--
+-- The master sends rows if a replica local space has data.
+--
+l = box.schema.space.create('local', {is_local = true})
+_ = l:create_index('pk')
+_ = l:insert{1}
+test_run:cmd("start server replica")
+test_run:grep_log('default', 'because of replica local data') ~= nil
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space['local']:count()
+box.info.replication[1].upstream.status
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+box.schema.user.revoke('guest', 'replication')
+s:drop()
+l:drop()
@@ -60,6 +60,27 @@ compare(type_t a, type_t b);
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
 
+/* tree for inner_card_check test */
+#define BPS_TREE_NAME card_tree
+#define BPS_TREE_BLOCK_SIZE 128 /* value is to low specially for tests */
+#define BPS_TREE_EXTENT_SIZE 2048 /* value is to low specially for tests */
+#define BPS_TREE_COMPARE(a, b, arg) compare(a, b)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) compare(a, b)
+#define bps_tree_elem_t type_t
+#define bps_tree_key_t type_t
+#define bps_tree_arg_t int
+#define BPS_INNER_CARD
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+#undef BPS_INNER_CARD
+
 /* tree for approximate_count test */
 #define BPS_TREE_NAME approx
 #define BPS_TREE_BLOCK_SIZE 128 /* value is to low specially for tests */
@@ -771,6 +792,94 @@ approximate_count()
 	footer();
 }
 
+/**
+ * Check that offsets of all the values in [0, range] found by
+ * lower and upper bound and elements found by offset match the
+ * contents of the tree.
+ */
+static int
+inner_card_check_offsets(card_tree *tree, const bool *present, type_t range)
+{
+	int err_count = 0;
+	if (card_tree_debug_check(tree))
+		err_count++;
+	size_t offset = 0;
+	for (type_t i = 0; i <= range; i++) {
+		bool is_present = i < range && present[i];
+		size_t lower, upper;
+		bool exact;
+		card_tree_lower_bound_get_offset(tree, i, &exact, &lower);
+		card_tree_upper_bound_get_offset(tree, i, NULL, &upper);
+		if (lower != offset || exact != is_present ||
+		    upper != offset + is_present)
+			err_count++;
+		if (!is_present)
+			continue;
+		card_tree_iterator itr = card_tree_iterator_at(tree, offset);
+		type_t *elem = card_tree_iterator_get_elem(tree, &itr);
+		if (elem == NULL || *elem != i)
+			err_count++;
+		offset++;
+	}
+	if (offset != card_tree_size(tree))
+		err_count++;
+	card_tree_iterator itr = card_tree_iterator_at(tree, offset);
+	if (!card_tree_iterator_is_invalid(&itr))
+		err_count++;
+	return err_count;
+}
+
+static void
+inner_card_check()
+{
+	header();
+	srand(0);
+
+	const type_t range = 2000;
+	bool present[range];
+	memset(present, 0, sizeof(present));
+
+	card_tree tree;
+	card_tree_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+	int err_count = 0;
+	for (int i = 0; i < 40000; i++) {
+		type_t value = rand() % range;
+		if (i < 20000 ? rand() % 3 != 0 : rand() % 3 == 0) {
+			card_tree_insert(&tree, value, NULL);
+			present[value] = true;
+		} else {
+			card_tree_delete(&tree, value);
+			present[value] = false;
+		}
+		if (i % 500 == 0)
+			err_count += inner_card_check_offsets(&tree, present,
+							      range);
+	}
+	err_count += inner_card_check_offsets(&tree, present, range);
+	printf("Error count after modifications: %d\n", err_count);
+	card_tree_destroy(&tree);
+
+	type_t arr[range];
+	size_t count = 0;
+	for (type_t i = 0; i < range; i++) {
+		present[i] = i % 3 != 0;
+		if (present[i])
+			arr[count++] = i;
+	}
+	card_tree_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+	card_tree_build(&tree, arr, count);
+	err_count = inner_card_check_offsets(&tree, present, range);
+	for (type_t i = 0; i < range; i += 2) {
+		card_tree_delete(&tree, i);
+		present[i] = false;
+	}
+	err_count += inner_card_check_offsets(&tree, present, range);
+	printf("Error count after build: %d\n", err_count);
+	card_tree_destroy(&tree);
+
+	footer();
+}
+
 static void
 insert_get_iterator()
 {
@@ -803,6 +912,7 @@ main(void)
 	printing_test();
 	white_box_test();
 	approximate_count();
+	inner_card_check();
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 	insert_get_iterator();
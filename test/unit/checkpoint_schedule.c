@@ -17,7 +17,7 @@ int
 main()
 {
 	header();
-	plan(38);
+	plan(42);
 
 	srand(time(NULL));
 	double now = rand();
@@ -89,6 +89,33 @@ main()
 		   interval);
 	}
 
+	struct checkpoint_recovery_stat stat = {
+		.checkpoint_load_time = 0,
+		.wal_replay_rate = 0,
+		.checkpoint_time = 0,
+		.wal_write_rate = 0,
+	};
+	is(checkpoint_recovery_wal_threshold(&stat, 60),
+	   60LL * CHECKPOINT_WAL_REPLAY_RATE_DEFAULT,
+	   "recovery time threshold - default replay rate");
+
+	stat.checkpoint_load_time = 20;
+	stat.wal_replay_rate = 100 * 1024 * 1024;
+	is(checkpoint_recovery_wal_threshold(&stat, 60),
+	   40LL * 100 * 1024 * 1024,
+	   "recovery time threshold - checkpoint load time");
+
+	stat.checkpoint_time = 10;
+	stat.wal_write_rate = 50 * 1024 * 1024;
+	is(checkpoint_recovery_wal_threshold(&stat, 60),
+	   40LL * 100 * 1024 * 1024 - 10LL * 50 * 1024 * 1024,
+	   "recovery time threshold - WAL written during checkpoint");
+
+	stat.checkpoint_load_time = 100;
+	is(checkpoint_recovery_wal_threshold(&stat, 60),
+	   CHECKPOINT_WAL_THRESHOLD_MIN,
+	   "recovery time threshold - target can't be met");
+
 	check_plan();
 	footer();
 
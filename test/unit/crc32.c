@@ -0,0 +1,90 @@
+#include "unit.h"
+#include "crc32.h"
+#include <third_party/crc32.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* CRC32C with the standard initial value and final xor. */
+static uint32_t
+crc32c_std(const char *buf, unsigned int len)
+{
+	return crc32_calc(0xFFFFFFFF, buf, len) ^ 0xFFFFFFFF;
+}
+
+/* Test vectors from RFC 3720, B.4. */
+static void
+test_vectors(void)
+{
+	header();
+	plan(6);
+
+	char buf[32];
+	is(crc32c_std("", 0), 0x00000000, "empty");
+	is(crc32c_std("123456789", 9), 0xE3069283, "check value");
+	memset(buf, 0, sizeof(buf));
+	is(crc32c_std(buf, sizeof(buf)), 0x8A9136AA, "32 bytes of zeroes");
+	memset(buf, 0xFF, sizeof(buf));
+	is(crc32c_std(buf, sizeof(buf)), 0x62A8AB43, "32 bytes of ones");
+	for (unsigned i = 0; i < sizeof(buf); i++)
+		buf[i] = i;
+	is(crc32c_std(buf, sizeof(buf)), 0x46DD794E, "32 incrementing bytes");
+	for (unsigned i = 0; i < sizeof(buf); i++)
+		buf[i] = 31 - i;
+	is(crc32c_std(buf, sizeof(buf)), 0x113FDB5C, "32 decrementing bytes");
+
+	check_plan();
+	footer();
+}
+
+/*
+ * Compare with the software implementation on buffers long
+ * enough to be checksummed by blocks, at different offsets
+ * and lengths, in one go and piecewise.
+ */
+static void
+test_long(void)
+{
+	header();
+
+	unsigned int lengths[] = {
+		1, 7, 8, 255, 256, 767, 768, 769, 1000,
+		3 * 8192 - 1, 3 * 8192, 3 * 8192 + 1, 100000, 1000000,
+	};
+	int count = sizeof(lengths) / sizeof(lengths[0]);
+	plan(count * 2);
+
+	unsigned int size = 1000000 + 8;
+	char *buf = malloc(size);
+	fail_unless(buf != NULL);
+	srand(1);
+	for (unsigned int i = 0; i < size; i++)
+		buf[i] = rand();
+
+	for (int i = 0; i < count; i++) {
+		unsigned int len = lengths[i];
+		const char *data = buf + i % 8;
+		uint32_t expected = crc32c(0xFFFFFFFF, data, len);
+		is(crc32_calc(0xFFFFFFFF, data, len), expected,
+		   "length %u, offset %d", len, i % 8);
+		unsigned int half = len / 2;
+		uint32_t crc = crc32_calc(0xFFFFFFFF, data, half);
+		crc = crc32_calc(crc, data + half, len - half);
+		is(crc, expected, "length %u in two parts", len);
+	}
+
+	free(buf);
+	check_plan();
+	footer();
+}
+
+int
+main(void)
+{
+	crc32_init();
+	plan(2);
+	test_vectors();
+	test_long();
+	return check_plan();
+}
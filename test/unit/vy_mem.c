@@ -1,4 +1,6 @@
 #include <trivia/config.h>
+#include <pthread.h>
+#include <string.h>
 #include "memory.h"
 #include "fiber.h"
 #include "vy_history.h"
@@ -323,6 +325,113 @@ test_iterator_restore_after_insertion()
 	footer();
 }
 
+/** Reads a mem stream from a separate thread. */
+struct stream_reader {
+	struct vy_mem_stream *stream;
+	/** Statements read so far. */
+	struct tuple *stmts[10];
+	/** Number of statements read so far. */
+	int count;
+	/** Number of statements to read. */
+	int limit;
+};
+
+static void *
+stream_reader_f(void *arg)
+{
+	struct stream_reader *reader = arg;
+	struct vy_stmt_stream *stream = &reader->stream->base;
+	for (; reader->count < reader->limit; reader->count++) {
+		struct tuple **stmt = &reader->stmts[reader->count];
+		if (stream->iface->next(stream, stmt) != 0)
+			*stmt = NULL;
+	}
+	return NULL;
+}
+
+static void
+test_stream_read_view(void)
+{
+	header();
+
+	plan(5);
+
+	uint32_t fields[] = { 0 };
+	uint32_t types[] = { FIELD_TYPE_UNSIGNED };
+	struct key_def *key_def = box_key_def_new(fields, types, 1);
+	assert(key_def != NULL);
+	struct vy_mem *mem = create_test_mem(key_def);
+
+	const struct tuple *stmts[10];
+	for (int i = 0; i < 10; i++) {
+		struct vy_stmt_template templ =
+			STMT_TEMPLATE(100 + i, REPLACE, i * 2);
+		stmts[i] = vy_mem_insert_template(mem, &templ);
+		vy_mem_commit_stmt(mem, stmts[i]);
+	}
+
+	/* Stream [4, 14): must return statements 4, 6, 8, 10, 12. */
+	struct vy_stmt_template begin_templ = STMT_TEMPLATE(0, SELECT, 4);
+	struct vy_stmt_template end_templ = STMT_TEMPLATE(0, SELECT, 14);
+	struct tuple *begin = vy_new_simple_stmt(mem->format, &begin_templ);
+	struct tuple *end = vy_new_simple_stmt(mem->format, &end_templ);
+	struct vy_mem_stream stream;
+	is(vy_mem_stream_open(&stream, mem, begin, end), 0, "stream open");
+	tuple_unref(begin);
+	tuple_unref(end);
+
+	/* Read the first statement from another thread. */
+	struct stream_reader reader;
+	memset(&reader, 0, sizeof(reader));
+	reader.stream = &stream;
+	reader.limit = 1;
+	pthread_t thread;
+	pthread_create(&thread, NULL, stream_reader_f, &reader);
+	pthread_join(thread, NULL);
+
+	/*
+	 * Read the rest while this thread modifies the tree:
+	 * inserts new statements in between the old ones and
+	 * past the end of the stream, enough to split tree blocks,
+	 * and rolls some of them back.
+	 */
+	reader.limit = 6;
+	pthread_create(&thread, NULL, stream_reader_f, &reader);
+	for (int i = 0; i < 1000; i++) {
+		struct vy_stmt_template templ =
+			STMT_TEMPLATE(200 + i, REPLACE, i * 2 + 1);
+		const struct tuple *stmt = vy_mem_insert_template(mem, &templ);
+		if (i % 2 == 0)
+			vy_mem_rollback_stmt(mem, stmt);
+		else
+			vy_mem_commit_stmt(mem, stmt);
+	}
+	pthread_join(thread, NULL);
+
+	/* The stream must only see the statements in its read view. */
+	bool is_ok = true;
+	for (int i = 0; i < 5; i++) {
+		if (reader.stmts[i] != stmts[i + 2])
+			is_ok = false;
+	}
+	ok(is_ok, "stream content");
+	ok(reader.stmts[5] == NULL, "stream end");
+
+	ok(!rlist_empty(&mem->views), "read view is alive");
+	stream.base.iface->close(&stream.base);
+	struct vy_stmt_template templ = STMT_TEMPLATE(300, REPLACE, 5000);
+	vy_mem_insert_template(mem, &templ);
+	ok(rlist_empty(&mem->views), "released read view is destroyed");
+
+	vy_mem_delete(mem);
+	key_def_delete(key_def);
+
+	fiber_gc();
+	footer();
+
+	check_plan();
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -330,6 +439,7 @@ main(int argc, char *argv[])
 
 	test_basic();
 	test_iterator_restore_after_insertion();
+	test_stream_read_view();
 
 	vy_iterator_C_test_finish();
 	return 0;
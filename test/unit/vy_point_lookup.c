@@ -24,7 +24,7 @@ write_run(struct vy_run *run, const char *dir_name,
 	if (vy_run_writer_create(&writer, run, dir_name,
 				 lsm->space_id, lsm->index_id,
 				 lsm->cmp_def, lsm->key_def,
-				 4096, 0.1) != 0)
+				 lsm->index_id == 0, 4096, 0.1, 0) != 0)
 		goto fail;
 
 	if (wi->iface->start(wi) != 0)
@@ -195,7 +195,7 @@ test_basic()
 	struct vy_stmt_stream *write_stream
 		= vy_write_iterator_new(pk->cmp_def, pk->disk_format,
 					true, true, &read_views, NULL);
-	vy_write_iterator_new_mem(write_stream, run_mem);
+	vy_write_iterator_new_mem(write_stream, run_mem, NULL, NULL);
 	struct vy_run *run = vy_run_new(&run_env, 1);
 	isnt(run, NULL, "vy_run_new");
 
@@ -226,7 +226,7 @@ test_basic()
 	write_stream
 		= vy_write_iterator_new(pk->cmp_def, pk->disk_format,
 					true, true, &read_views, NULL);
-	vy_write_iterator_new_mem(write_stream, run_mem);
+	vy_write_iterator_new_mem(write_stream, run_mem, NULL, NULL);
 	run = vy_run_new(&run_env, 2);
 	isnt(run, NULL, "vy_run_new");
 
@@ -109,7 +109,7 @@ compare_write_iterator_results(const struct vy_stmt_template *content,
 				   is_last_level, &rv_list,
 				   is_primary ? &handler.base : NULL);
 	fail_if(wi == NULL);
-	fail_if(vy_write_iterator_new_mem(wi, mem) != 0);
+	fail_if(vy_write_iterator_new_mem(wi, mem, NULL, NULL) != 0);
 
 	struct tuple *ret;
 	fail_if(wi->iface->start(wi) != 0);
@@ -0,0 +1,128 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+fio = require('fio')
+
+--
+-- Key-value separation: tuples at least blob_threshold bytes
+-- long are stored in blob files while runs keep references.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {blob_threshold = -1})
+pk = s:create_index('pk', {blob_threshold = 100})
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+s.index.pk.options.blob_threshold
+sk.options.blob_threshold
+
+path = fio.pathjoin(box.cfg.vinyl_dir, tostring(s.id), tostring(pk.id))
+function blob_count() return #fio.glob(fio.pathjoin(path, '*.blob')) end
+
+big = string.rep('x', 200)
+for i = 1, 10 do s:replace{i, i * 10, i % 2 == 0 and big or 'small'} end
+box.snapshot()
+blob_count()
+
+-- Point lookups and scans load tuples from the blob file.
+s:get(1)
+s:get(2)[3] == big
+sk:select(20)[1][3] == big
+#s:select()
+s:select({}, {iterator = 'GE', limit = 2})[2][3] == big
+
+-- UPSERTs, updates and deletes over separated tuples.
+s:upsert({4, 40, 'x'}, {{'=', 3, 'upserted'}})
+s:update(6, {{'=', 2, 61}})[2]
+s:delete(8)
+box.snapshot()
+s:get(4)
+s:get(6)[3] == big
+s:get(8)
+sk:select(61)[1][1]
+
+-- Compaction keeps references and merges UPSERTs into
+-- separated tuples.
+pk:compact()
+while pk:stat().disk.compaction.count == 0 do fiber.sleep(0.01) end
+s:get(4)
+s:get(6)[3] == big
+s:get(10)[3] == big
+#s:select()
+blob_count() > 0
+
+-- Separated tuples survive restart.
+test_run:cmd('restart server default')
+fiber = require('fiber')
+s = box.space.test
+pk = s.index.pk
+big = string.rep('x', 200)
+s:get(2)[3] == big
+s:get(4)
+s.index.sk:select(100)[1][3] == big
+
+-- Disabling separation moves tuples back to runs on compaction.
+pk:alter{blob_threshold = 0}
+s.index.pk.options.blob_threshold
+_ = s:replace{11, 110, big}
+box.snapshot()
+pk:compact()
+while pk:stat().disk.compaction.count == 0 do fiber.sleep(0.01) end
+s:get(2)[3] == big
+s:get(11)[3] == big
+#s:select()
+
+s:drop()
+
+--
+-- Compaction moves tuples out of a blob file that is mostly
+-- garbage so that the file is removed by garbage collection.
+--
+fio = require('fio')
+box.cfg{checkpoint_count = 1}
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {blob_threshold = 100, run_count_per_level = 10})
+path = fio.pathjoin(box.cfg.vinyl_dir, tostring(s.id), tostring(pk.id))
+function blob_files() return fio.glob(fio.pathjoin(path, '*.blob')) end
+function is_own(f) local run, blob = f:match('(%d+)%.(%d+)%.blob$') return run == blob end
+big = string.rep('x', 200)
+for i = 1, 10 do s:replace{i, big} end
+box.snapshot()
+files = blob_files()
+#files
+is_own(files[1])
+old_file = files[1]
+
+-- The blob file is mostly garbage after the deletes, but the
+-- run they were compacted with uses it in full so the new run
+-- links it.
+for i = 1, 6 do s:delete(i) end
+box.snapshot()
+pk:compact()
+while pk:stat().disk.compaction.count < 1 do fiber.sleep(0.01) end
+_ = s:replace{11, 'y'}
+box.snapshot()
+while fio.path.exists(old_file) do fiber.sleep(0.01) end
+files = blob_files()
+#files
+is_own(files[1])
+linked_file = files[1]
+
+-- The new run uses less than a half of the blob file so the
+-- next compaction moves the tuples to its own blob file.
+pk:compact()
+while pk:stat().disk.compaction.count < 2 do fiber.sleep(0.01) end
+_ = s:replace{12, 'z'}
+box.snapshot()
+while fio.path.exists(linked_file) do fiber.sleep(0.01) end
+files = blob_files()
+#files
+is_own(files[1])
+#s:select()
+s:get(7)[2] == big
+s:get(10)[2] == big
+
+-- The new blob file is used after restart.
+test_run:cmd('restart server default')
+s = box.space.test
+big = string.rep('x', 200)
+s:get(7)[2] == big
+#s:select()
+s:drop()
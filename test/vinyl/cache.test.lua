@@ -398,3 +398,39 @@ s.index.i2:count()
 box.stat.vinyl().memory.tuple_cache -- should be about 200 KB
 s:drop()
 box.cfg{vinyl_cache = vinyl_cache}
+
+--
+-- A range scan doesn't evict statements that were read more
+-- than once from the cache.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 1000 * 1000}
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk')
+pad = string.rep('x', 1000)
+for i = 1, 3000 do s:replace{i, pad} end
+box.snapshot()
+-- Warm up hot keys.
+for i = 1, 50 do s:get{i} end
+st1 = pk:stat()
+for i = 1, 50 do s:get{i} end
+st2 = pk:stat()
+st2.cache.get.rows - st1.cache.get.rows
+st2.cache.promote.rows - st1.cache.promote.rows
+-- Scan the space, which is much bigger than the cache.
+box.begin() count = #s:select() box.commit()
+count
+st3 = pk:stat()
+st3.cache.evict.rows - st2.cache.evict.rows > 0
+st3.cache.promote.rows - st2.cache.promote.rows
+-- Hot keys are still in the cache.
+for i = 1, 50 do s:get{i} end
+st4 = pk:stat()
+st4.cache.get.rows - st3.cache.get.rows
+st4.disk.iterator.lookup - st3.disk.iterator.lookup
+-- Keys read only by the scan were evicted.
+for i = 51, 100 do s:get{i} end
+st5 = pk:stat()
+st5.disk.iterator.lookup - st4.disk.iterator.lookup > 0
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
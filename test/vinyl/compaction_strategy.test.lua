@@ -0,0 +1,82 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Compaction strategy is configured per index.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compaction_strategy = 'foo'})
+s:create_index('pk', {compaction_strategy = 'time_window', compaction_window = 0})
+pk = s:create_index('pk')
+pk.options.compaction_strategy
+pk:alter{compaction_strategy = 'leveled'}
+s.index.pk.options.compaction_strategy
+s.index.pk.options.compaction_window
+pk:alter{compaction_strategy = 'time_window', compaction_window = 3600}
+s.index.pk.options.compaction_strategy
+s.index.pk.options.compaction_window
+s:drop()
+
+function dump(s, n) for i = 1, n do s:replace{i, i} end box.snapshot() end
+
+--
+-- Tiered compaction keeps up to run_count_per_level runs
+-- per level.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {run_count_per_level = 10})
+dump(s, 100)
+st = pk:stat()
+st.amplification.write, st.amplification.read, st.amplification.space
+dump(s, 10)
+dump(s, 10)
+pk:stat().run_count
+pk:stat().disk.compaction.count
+pk:stat().amplification.read
+s:drop()
+
+--
+-- Leveled compaction merges run_count_per_level dumps into
+-- the next level or, if it is much bigger, into a new level.
+-- A level that outgrows run_size_ratio of the next level is
+-- merged into it while upper levels are left alone.
+--
+function fill(s, first, last) for i = first, last do s:replace{i, i} end box.snapshot() end
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {run_count_per_level = 2, run_size_ratio = 4, compaction_strategy = 'leveled'})
+fill(s, 1, 2000)
+fill(s, 2001, 2100)
+pk:stat().disk.compaction.count
+fill(s, 2101, 2200)
+test_run:wait_cond(function() return pk:stat().disk.compaction.count > 0 end)
+pk:stat().run_count
+pk:stat().disk.compaction.input.rows
+pk:alter{run_size_ratio = 20}
+fill(s, 2201, 2300)
+test_run:wait_cond(function() return pk:stat().disk.compaction.count > 1 end)
+pk:stat().run_count
+pk:stat().disk.compaction.input.rows
+s:count()
+s:drop()
+
+--
+-- Time window compaction never merges runs dumped within
+-- different windows.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {compaction_strategy = 'time_window', compaction_window = 1})
+dump(s, 10)
+fiber.sleep(1.1)
+dump(s, 10)
+fiber.sleep(1.1)
+dump(s, 10)
+pk:stat().run_count
+pk:stat().disk.compaction.count
+pk:stat().amplification.read
+
+-- Manual compaction still merges all runs.
+pk:compact()
+test_run:wait_cond(function() return pk:stat().disk.compaction.count > 0 end)
+pk:stat().run_count
+s:select()
+s:drop()
@@ -0,0 +1,58 @@
+test_run = require('test_run').new()
+
+--
+-- Covering secondary indexes store full tuples and are read
+-- without looking up the primary index.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false, covering = true})
+sk.options.covering
+pk.options.covering
+
+s:insert{1, 10, 'a'}
+s:insert{2, 20, 'b'}
+s:insert{3, 10, 'c'}
+
+lookup = pk:stat().lookup
+sk:select(10)
+sk:select(20)
+pk:stat().lookup - lookup
+
+-- Updates of non-indexed fields must reach the covering index.
+s:update(1, {{'=', 3, 'aa'}})
+s:replace{2, 20, 'bb'}
+sk:select()
+box.snapshot()
+lookup = pk:stat().lookup
+sk:select()
+pk:stat().lookup - lookup
+
+-- Deletes must not leave stale tuples behind.
+s:delete(3)
+s:replace{1, 30, 'aaa'}
+sk:select()
+box.snapshot()
+sk:select()
+
+-- Changing the option rebuilds the index.
+s.index.sk:alter{covering = false}
+s.index.sk.options.covering
+s.index.sk:select()
+s.index.sk:alter{covering = true}
+s.index.sk.options.covering
+s.index.sk:select()
+
+-- Covering index can be built on a non-empty space.
+sk2 = s:create_index('sk2', {parts = {3, 'string'}, covering = true})
+sk2:select()
+
+s:drop()
+
+-- Only vinyl supports covering indexes.
+s = box.schema.space.create('test', {engine = 'memtx'})
+pk = s:create_index('pk')
+s:create_index('sk', {parts = {2, 'unsigned'}, covering = true})
+pk:alter{covering = true}
+s:create_index('sk', {parts = {2, 'unsigned'}, covering = false}) ~= nil
+s:drop()
@@ -0,0 +1,82 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Page index and bloom filter of a big run are split in
+-- partitions loaded on demand to the metadata cache.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {page_size = 128, range_size = 1024 * 1024})
+pad = string.rep('x', 20)
+for i = 1, 1000 do s:replace{i * 2, pad} end
+box.snapshot()
+pk:stat().disk.pages > 64
+pk:stat().disk.rows
+
+-- Nothing is loaded until the run is read.
+box.stat.vinyl().memory.meta_cache
+
+test_run:cmd("setopt delimiter ';'")
+function check_get()
+    for i = 1, 1000 do
+        if s:get(i * 2) == nil then return false end
+    end
+    return true
+end;
+function check_select()
+    return #s:select() == 1000 and
+           s:select(1001, {iterator = 'GE', limit = 1})[1][1] == 1002 and
+           s:select(1001, {iterator = 'LE', limit = 1})[1][1] == 1000 and
+           s:select(2000, {iterator = 'GT'})[1] == nil and
+           s:select(2, {iterator = 'LT'})[1] == nil and
+           s:select(1500, {iterator = 'EQ'})[1][1] == 1500
+end;
+test_run:cmd("setopt delimiter ''");
+
+check_get()
+check_select()
+meta_cache = box.stat.vinyl().memory.meta_cache
+meta_cache > 0
+
+-- Lookups of absent keys are filtered by partition blooms.
+hit = pk:stat().disk.iterator.bloom.hit
+for i = 1, 100 do assert(s:get(i * 2 + 1) == nil) end
+pk:stat().disk.iterator.bloom.hit - hit > 80
+
+-- Shrinking the quota evicts the cache, but reads still work.
+box.cfg{vinyl_meta_cache = 0}
+box.stat.vinyl().memory.meta_cache
+check_get()
+check_select()
+box.stat.vinyl().memory.meta_cache < meta_cache / 2
+box.cfg{vinyl_meta_cache = 128 * 1024 * 1024}
+box.cfg{vinyl_cache = vinyl_cache}
+
+-- Partitions are loaded from disk after restart.
+test_run:cmd('restart server default')
+fiber = require('fiber')
+s = box.space.test
+pk = s.index.pk
+pad = string.rep('x', 20)
+box.stat.vinyl().memory.meta_cache
+#s:select()
+s:get(1000)
+s:get(1001)
+box.stat.vinyl().memory.meta_cache > 0
+
+-- Compaction reads partitions privately in a worker thread.
+for i = 1, 1000, 3 do s:replace{i * 2, 'y'} end
+box.snapshot()
+pk:compact()
+while pk:stat().disk.compaction.count == 0 do fiber.sleep(0.01) end
+pk:stat().run_count
+pk:stat().disk.rows
+s:get(2)
+s:get(4)[2] == pad
+#s:select()
+s:select(1001, {iterator = 'LE', limit = 2})
+
+s:drop()
@@ -0,0 +1,48 @@
+test_run = require('test_run').new()
+
+--
+-- Run iterator reads pages ahead on sequential scans.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {page_size = 128, range_size = 1024 * 1024})
+pad = string.rep('x', 20)
+for i = 1, 1000 do s:replace{i, pad} end
+box.snapshot()
+pk:stat().disk.pages > 64
+
+function readahead() return pk:stat().disk.iterator.readahead end
+
+-- Point lookups don't read pages ahead.
+for i = 1, 1000, 10 do assert(s:get(i) ~= nil) end
+readahead()
+
+-- Forward scan.
+#s:select()
+st = readahead()
+st.pages > 0
+st.hit > 0
+st.pages == st.hit + st.waste
+
+-- Backward scan.
+#s:select({}, {iterator = 'LE'})
+readahead().hit > st.hit
+st = readahead()
+st.pages == st.hit + st.waste
+
+-- Pages read ahead beyond the end of an interrupted scan
+-- are wasted.
+s:select({}, {limit = 500})[500][1]
+readahead().waste > st.waste
+st = readahead()
+st.pages == st.hit + st.waste
+
+-- Scan results are not affected by reading ahead.
+s:select({500}, {iterator = 'GE', limit = 400})[400][1]
+s:select({500}, {iterator = 'LT', limit = 400})[400][1]
+s:select({500}, {iterator = 'GT', limit = 400})[400][1]
+
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
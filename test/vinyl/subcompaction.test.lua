@@ -0,0 +1,57 @@
+test_run = require('test_run').new()
+digest = require('digest')
+
+--
+-- Compaction of a big range can be split in parts merged
+-- in parallel by different threads. The range is split at
+-- part boundaries.
+--
+box.cfg{vinyl_max_subcompactions = 0}
+box.cfg.vinyl_max_subcompactions
+box.cfg{vinyl_max_subcompactions = 2}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {page_size = 1024, range_size = 64 * 1024, run_count_per_level = 100})
+
+test_run:cmd("setopt delimiter ';'")
+function dump()
+    for i = 1, 1000 do
+        s:replace{i, digest.urandom(100)}
+    end
+    box.snapshot()
+end;
+function check()
+    local t = s:select()
+    if #t ~= 1000 then
+        return false
+    end
+    for i = 1, 1000 do
+        if t[i][1] ~= i then
+            return false
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+
+dump()
+pk:stat().range_count -- 1
+
+-- The second run triggers major compaction.
+dump()
+test_run:wait_cond(function() return pk:stat().disk.compaction.count == 1 end, 10)
+pk:stat().range_count -- 2
+pk:stat().run_count -- 2
+check()
+
+-- Check that the space can be recovered after subcompaction.
+test_run:cmd('restart server default')
+s = box.space.test
+pk = s.index.pk
+box.cfg.vinyl_max_subcompactions
+pk:stat().range_count -- 2
+s:count()
+s:select(1)[1][1]
+s:select(1000)[1][1]
+
+s:drop()
@@ -0,0 +1,7 @@
+#!/usr/bin/env tarantool
+
+box.cfg{
+    vinyl_write_threads = 8, -- 2 dump threads, 6 compaction threads
+}
+
+require('console').listen(os.getenv('ADMIN'))
@@ -0,0 +1,85 @@
+test_run = require('test_run').new()
+
+--
+-- Dump of a big in-memory tree can be split in parts written
+-- in parallel by different threads. The tree is split at range
+-- boundaries, each part writes a run of its own.
+--
+box.cfg{vinyl_max_subdumps = 0}
+box.cfg.vinyl_max_subdumps
+
+-- Deploy a new server, because we need more than one dump thread.
+test_run:cmd("create server test with script='vinyl/subdump.lua'")
+test_run:cmd('start server test')
+test_run:cmd('switch test')
+
+digest = require('digest')
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {page_size = 1024, range_size = 64 * 1024, run_count_per_level = 100})
+
+test_run:cmd("setopt delimiter ';'")
+function dump(step)
+    for i = 1, 1000, step do
+        s:replace{i, digest.urandom(100)}
+    end
+    box.snapshot()
+end;
+function check()
+    local t = s:select()
+    if #t ~= 1000 then
+        return false
+    end
+    for i = 1, 1000 do
+        if t[i][1] ~= i then
+            return false
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- Make two ranges.
+box.cfg{vinyl_max_subcompactions = 2}
+dump(1)
+dump(1)
+test_run:wait_cond(function() return pk:stat().disk.compaction.count == 1 end, 10)
+pk:stat().range_count -- 2
+pk:stat().run_count -- 2
+
+-- Without subdumps one run is sliced between the ranges.
+dump(10)
+pk:stat().run_count -- 3
+pk:stat().disk.dump.count -- 3
+
+-- With subdumps each range gets a run of its own.
+box.cfg{vinyl_max_subdumps = 2}
+dump(10)
+pk:stat().run_count -- 5
+pk:stat().disk.dump.count -- 4
+check()
+
+-- Tiny dumps are not split.
+s:replace{1, 'x'}
+box.snapshot()
+pk:stat().run_count -- 6
+s:get(1)
+
+-- Check that the space can be recovered after subdump.
+test_run:cmd('switch default')
+test_run:cmd('stop server test')
+test_run:cmd('start server test')
+test_run:cmd('switch test')
+s = box.space.test
+pk = s.index.pk
+pk:stat().range_count -- 2
+pk:stat().run_count -- 6
+s:count()
+s:get(1)
+s:select(1000)[1][1]
+
+s:drop()
+
+test_run:cmd('switch default')
+test_run:cmd('stop server test')
+test_run:cmd('cleanup server test')
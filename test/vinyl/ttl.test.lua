@@ -0,0 +1,52 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Expired tuples of a space with ttl_field set are dropped
+-- when the last level of the primary index is compacted.
+--
+s = box.schema.space.create('test', {engine = 'vinyl', ttl_field = 3})
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}})
+function ids(t) local r = {} for _, v in ipairs(t) do table.insert(r, v[1]) end return r end
+
+-- Covering secondary indexes are not supported.
+s:create_index('sk2', {parts = {2, 'unsigned'}, covering = true})
+
+now = fiber.time()
+for i = 1, 10 do s:replace{i, i * 10, i % 2 == 0 and now - 1 or now + 3600} end
+_ = s:replace{11, 110}
+box.snapshot()
+pk:stat().disk.rows
+pk:compact()
+test_run:wait_cond(function() return pk:stat().disk.compaction.count > 0 end)
+pk:stat().disk.rows
+ids(s:select())
+-- Dangling secondary index entries are skipped.
+ids(sk:select())
+-- Deferred DELETEs purge them on secondary index compaction.
+box.snapshot()
+sk:compact()
+test_run:wait_cond(function() return sk:stat().disk.compaction.count > 0 end)
+sk:stat().disk.rows
+sk:len() == pk:len()
+sk:len()
+ids(sk:select())
+
+-- Tuples that expire after dump are dropped by major compaction.
+_ = s:replace{12, 120, fiber.time() + 0.5}
+box.snapshot()
+s:get(12) ~= nil
+fiber.sleep(0.6)
+pk:compact()
+test_run:wait_cond(function() return pk:stat().disk.compaction.count > 1 end)
+s:get(12)
+sk:get(120)
+pk:stat().disk.rows
+box.snapshot()
+sk:compact()
+test_run:wait_cond(function() return sk:stat().disk.compaction.count > 1 end)
+sk:len() == pk:len()
+sk:len()
+
+s:drop()
@@ -0,0 +1,119 @@
+test_run = require('test_run').new()
+test_run:cmd('restart server default with cleanup=1')
+test_run = require('test_run').new()
+fio = require('fio')
+xlog = require('xlog')
+test_run:cmd("setopt delimiter ';'")
+-- Snapshot files, with signatures replaced by labels.
+labels = {};
+function snapshot(label)
+    box.snapshot()
+    labels[box.info.signature] = label
+end;
+function snaps()
+    local result = {}
+    for _, path in ipairs(fio.glob(fio.pathjoin(box.cfg.memtx_dir,
+                                                '*.snap'))) do
+        local name = fio.basename(path)
+        local signature = tonumber(name:match('^(%d+)%.'))
+        if labels[signature] ~= nil then
+            name = labels[signature]..name:sub(21)
+        end
+        table.insert(result, name)
+    end
+    table.sort(result)
+    return result
+end;
+function wait_snaps(expected)
+    test_run:wait_cond(function()
+        return table.concat(snaps(), ' ') == expected
+    end)
+    return snaps()
+end;
+-- Number of rows of user spaces in a snapshot file.
+function user_rows(name)
+    local count = 0
+    for _, row in xlog.pairs(fio.pathjoin(box.cfg.memtx_dir, name)) do
+        if row.BODY.space_id ~= nil and
+           row.BODY.space_id >= box.schema.SYSTEM_ID_MAX then
+            count = count + 1
+        end
+    end
+    return count
+end;
+function snap_name(label, suffix)
+    for signature, l in pairs(labels) do
+        if l == label then
+            return string.format('%020d%s', signature, suffix)
+        end
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+--
+-- Spaces are written to chunk files in parallel threads.
+--
+box.cfg{memtx_checkpoint_threads = 3, checkpoint_count = 1}
+for i = 1, 4 do s = box.schema.space.create('test' .. i) s:create_index('pk') for j = 1, 100 * i do s:insert{j} end end
+snapshot('S0')
+wait_snaps('S0.1.snap S0.2.snap S0.snap')
+user_rows(snap_name('S0', '.1.snap')) > 0
+user_rows(snap_name('S0', '.2.snap')) > 0
+user_rows(snap_name('S0', '.snap')) + user_rows(snap_name('S0', '.1.snap')) + user_rows(snap_name('S0', '.2.snap'))
+--
+-- Recovery reads all chunks.
+--
+test_run:cmd('restart server default')
+box.space.test1:count()
+box.space.test2:count()
+box.space.test3:count()
+box.space.test4:count()
+test_run = require('test_run').new()
+fio = require('fio')
+test_run:cmd("setopt delimiter ';'")
+labels = {};
+function snapshot(label)
+    box.snapshot()
+    labels[box.info.signature] = label
+end;
+function snaps()
+    local result = {}
+    for _, path in ipairs(fio.glob(fio.pathjoin(box.cfg.memtx_dir,
+                                                '*.snap'))) do
+        local name = fio.basename(path)
+        local signature = tonumber(name:match('^(%d+)%.'))
+        if labels[signature] ~= nil then
+            name = labels[signature]..name:sub(21)
+        end
+        table.insert(result, name)
+    end
+    table.sort(result)
+    return result
+end;
+function wait_snaps(expected)
+    test_run:wait_cond(function()
+        return table.concat(snaps(), ' ') == expected
+    end)
+    return snaps()
+end;
+test_run:cmd("setopt delimiter ''");
+--
+-- Garbage collection removes chunks along with the main file.
+--
+box.cfg{memtx_checkpoint_threads = 2, checkpoint_count = 1}
+box.space.test1:insert{1000}
+snapshot('S1')
+wait_snaps('S1.1.snap S1.snap')
+--
+-- Chunks of snapshots which main file is missing are removed
+-- on startup.
+--
+dir = box.cfg.memtx_dir
+chunk = fio.pathjoin(dir, fio.basename(fio.glob(fio.pathjoin(dir, '*.1.snap'))[1]))
+fio.copyfile(chunk, fio.pathjoin(dir, string.format('%020d.1.snap', 1)))
+fio.copyfile(chunk, fio.pathjoin(dir, string.format('%020d.2.snap', box.info.signature + 100)))
+#fio.glob(fio.pathjoin(dir, '*.snap'))
+test_run:cmd('restart server default')
+fio = require('fio')
+#fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snap'))
+box.space.test1:count()
+for i = 1, 4 do box.space['test' .. i]:drop() end
@@ -0,0 +1,97 @@
+test_run = require('test_run').new()
+test_run:cmd('restart server default with cleanup=1')
+test_run = require('test_run').new()
+fio = require('fio')
+test_run:cmd("setopt delimiter ';'")
+-- Snapshot labels by signature.
+labels = {};
+function snapshot(label)
+    box.snapshot()
+    labels[box.info.signature] = label
+end;
+function snap_path(label)
+    for signature, l in pairs(labels) do
+        if l == label then
+            return fio.pathjoin(box.cfg.memtx_dir,
+                                string.format('%020d.snap', signature))
+        end
+    end
+end;
+function is_delta(label)
+    local f = fio.open(snap_path(label))
+    local header = f:read(1024)
+    f:close()
+    return header:find('PrevVClock') ~= nil
+end;
+function label(path)
+    local signature = tonumber(fio.basename(path, '.snap'))
+    return labels[signature] or fio.basename(path)
+end;
+function snaps()
+    local result = {}
+    for _, path in ipairs(fio.glob(fio.pathjoin(box.cfg.memtx_dir,
+                                                '*.snap'))) do
+        table.insert(result, label(path))
+    end
+    table.sort(result)
+    return result
+end;
+function wait_snaps(expected)
+    test_run:wait_cond(function()
+        return table.concat(snaps(), ' ') == expected
+    end)
+    return snaps()
+end;
+test_run:cmd("setopt delimiter ''");
+box.cfg{checkpoint_count = 2}
+low = box.schema.space.create('low', {id = 100})
+_ = low:create_index('pk')
+high = box.schema.space.create('high')
+_ = high:create_index('pk')
+for i = 1, 10 do low:insert{i} high:insert{i} end
+snapshot('S0')
+box.cfg{memtx_checkpoint_delta_max = 2}
+low:replace{1, 'S1'}
+snapshot('S1')
+is_delta('S0')
+is_delta('S1')
+wait_snaps('S0 S1')
+--
+-- Backup lists the base of a delta snapshot.
+--
+files = box.backup.start()
+backup = {}
+for _, path in ipairs(files) do if path:match('%.snap$') then table.insert(backup, label(path)) end end
+table.sort(backup)
+backup
+box.backup.stop()
+--
+-- Garbage collection keeps the base of the oldest checkpoint
+-- in use.
+--
+high:replace{1, 'S2'}
+snapshot('S2')
+is_delta('S2')
+wait_snaps('S0 S1 S2')
+-- Every memtx_checkpoint_delta_max deltas a new base is made.
+-- The previous base is kept while a delta refers to it.
+low:replace{2, 'S3'}
+snapshot('S3')
+is_delta('S3')
+wait_snaps('S0 S1 S2 S3')
+low:replace{3, 'S4'}
+snapshot('S4')
+is_delta('S4')
+wait_snaps('S3 S4')
+--
+-- A user space with an id below the system range goes to
+-- the delta, while the system spaces it depends on are loaded
+-- from the base. It must be recovered after them.
+--
+test_run:cmd('restart server default')
+box.space.low.id
+box.space.low:select{}
+box.space.high:select{1}
+box.space.high:count()
+box.space.low:drop()
+box.space.high:drop()
@@ -0,0 +1,47 @@
+test_run = require('test_run').new()
+fio = require('fio')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+--
+-- The WAL thread keeps a preallocated spare file ready for
+-- WAL rotation. The file is empty until it's used.
+--
+spare = fio.pathjoin(box.cfg.wal_dir, 'xlog.spare')
+test_run:wait_cond(function() return fio.path.exists(spare) end)
+fio.stat(spare).size
+inode = fio.stat(spare).inode
+test_run:cmd("setopt delimiter ';'")
+function count_xlogs(inode)
+    local count = 0
+    for _, path in ipairs(fio.glob(fio.pathjoin(box.cfg.wal_dir,
+                                                '*.xlog'))) do
+        if fio.stat(path).inode == inode then
+            count = count + 1
+        end
+    end
+    return count
+end;
+test_run:cmd("setopt delimiter ''");
+count_xlogs(inode)
+--
+-- On rotation, the spare file is renamed to the new WAL and
+-- a new spare file is created in background.
+--
+box.cfg.rows_per_wal
+for i = 1, 20 do s:replace{i} end
+count_xlogs(inode)
+test_run:wait_cond(function() local st = fio.stat(spare) return st ~= nil and st.inode ~= inode end)
+fio.stat(spare).size
+s:drop()
+--
+-- The spare file is removed on shutdown.
+--
+test_run:cmd("create server spare with script='xlog/xlog.lua'")
+test_run:cmd("start server spare")
+dir = test_run:eval('spare', "require('fio').abspath(box.cfg.wal_dir)")[1]
+spare = fio.pathjoin(dir, 'xlog.spare')
+test_run:wait_cond(function() return fio.path.exists(spare) end)
+test_run:cmd("stop server spare")
+fio.path.exists(spare)
+test_run:cmd("cleanup server spare")
+test_run:cmd("delete server spare")